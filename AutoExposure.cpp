@@ -0,0 +1,289 @@
+/** @file       AutoExposure.cpp
+ *  @brief      Camera exposure from white and black frame histograms and per pixel fusion of two exposures
+ */
+#include <cmath>
+#include "AutoExposure.h"
+#include "FrameAcquisition.h"
+
+dlp::ReturnCode MeasureExposure(dlp::Image          *white,
+                                dlp::Image          *black,
+                                const unsigned char &minimum_contrast,
+                                ExposureMeasurement *measurement){
+    dlp::ReturnCode ret;
+
+    if(!white || !black || !measurement)        return ret.AddError(AUTO_EXPOSURE_NULL_POINTER);
+    if(white->isEmpty() || black->isEmpty())    return ret.AddError(AUTO_EXPOSURE_IMAGE_EMPTY);
+
+    unsigned int columns, rows;
+    unsigned int black_columns, black_rows;
+    white->GetColumns(&columns);
+    white->GetRows(&rows);
+    black->GetColumns(&black_columns);
+    black->GetRows(&black_rows);
+    if((columns != black_columns) || (rows != black_rows)) return ret.AddError(AUTO_EXPOSURE_RESOLUTION_MISMATCH);
+
+    cv::Mat white_data;
+    cv::Mat black_data;
+    white->Unsafe_GetOpenCVData(&white_data);
+    black->Unsafe_GetOpenCVData(&black_data);
+
+    unsigned long long histogram[256] = {0};
+    unsigned long long dark = 0;
+    for(unsigned int y = 0; y < rows; y++){
+        const unsigned char *white_row = white_data.ptr<unsigned char>(y);
+        const unsigned char *black_row = black_data.ptr<unsigned char>(y);
+        for(unsigned int x = 0; x < columns; x++){
+            histogram[white_row[x]]++;
+            if((white_row[x] <= black_row[x]) || ((white_row[x] - black_row[x]) < minimum_contrast)) dark++;
+        }
+    }
+
+    const unsigned long long pixels    = (unsigned long long) columns * rows;
+    const unsigned long long highlight = (unsigned long long)(AUTO_EXPOSURE_HIGHLIGHT_PERCENTILE * pixels);
+
+    unsigned long long count = 0;
+    measurement->white_highlight = 255;
+    for(unsigned int level = 0; level < 256; level++){
+        count += histogram[level];
+        if(count >= highlight){
+            measurement->white_highlight = level;
+            break;
+        }
+    }
+    measurement->saturated_fraction = (double) histogram[255] / pixels;
+    measurement->dark_fraction      = (double) dark / pixels;
+
+    return ret;
+}
+
+double GetExposureScale(const ExposureMeasurement &measurement, const unsigned char &target_level){
+    if(measurement.saturated_fraction > AUTO_EXPOSURE_SATURATED_FRACTION) return 0.5;
+    if(measurement.white_highlight == 0) return 16.0;
+
+    double scale = (double) target_level / measurement.white_highlight;
+    if((scale < 1.0) && (measurement.dark_fraction > AUTO_EXPOSURE_DARK_FRACTION)) scale = 1.0;
+    if(scale > 16.0)        scale = 16.0;
+    if(scale < (1.0 / 16))  scale = 1.0 / 16;
+    return scale;
+}
+
+CameraExposure ScaleExposure(const CameraExposure &exposure,
+                             const double         &scale,
+                             const float          &maximum_shutter_ms,
+                             const float          &maximum_gain_db){
+    CameraExposure scaled;
+
+    // Total exposure as a shutter time at unity gain
+    const double total_ms = exposure.shutter_ms * std::pow(10.0, exposure.gain_db / 20.0) * scale;
+
+    scaled.shutter_ms = (float)((total_ms < maximum_shutter_ms) ? total_ms : maximum_shutter_ms);
+    scaled.gain_db    = 0;
+    if((scaled.shutter_ms > 0) && (total_ms > scaled.shutter_ms)){
+        scaled.gain_db = (float)(20.0 * std::log10(total_ms / scaled.shutter_ms));
+        if(scaled.gain_db > maximum_gain_db) scaled.gain_db = maximum_gain_db;
+    }
+
+    return scaled;
+}
+
+dlp::ReturnCode GetCameraExposure(dlp::Camera *camera, CameraExposure *exposure){
+    dlp::ReturnCode ret;
+
+    if(!camera || !exposure) return ret.AddError(AUTO_EXPOSURE_NULL_POINTER);
+
+    dlp::PG_FlyCap2_C *camera_pg = dynamic_cast<dlp::PG_FlyCap2_C*>(camera);
+    if(!camera_pg) return ret.AddError(AUTO_EXPOSURE_CAMERA_NOT_SUPPORTED);
+
+    dlp::Parameters camera_settings;
+    dlp::PG_FlyCap2_C::Parameters::ShutterTime shutter;
+    dlp::PG_FlyCap2_C::Parameters::Gain        gain;
+    camera_pg->GetSetup(&camera_settings);
+    camera_settings.Get(&shutter);
+    camera_settings.Get(&gain);
+
+    exposure->shutter_ms = shutter.Get();
+    exposure->gain_db    = gain.Get();
+
+    return ret;
+}
+
+dlp::ReturnCode SetCameraExposure(dlp::Camera *camera, const CameraExposure &exposure){
+    dlp::ReturnCode ret;
+
+    if(!camera) return ret.AddError(AUTO_EXPOSURE_NULL_POINTER);
+
+    dlp::PG_FlyCap2_C *camera_pg = dynamic_cast<dlp::PG_FlyCap2_C*>(camera);
+    if(!camera_pg) return ret.AddError(AUTO_EXPOSURE_CAMERA_NOT_SUPPORTED);
+
+    dlp::Parameters exposure_settings;
+    exposure_settings.Set(dlp::PG_FlyCap2_C::Parameters::AutoExposure(false));
+    exposure_settings.Set(dlp::PG_FlyCap2_C::Parameters::ShutterTime(exposure.shutter_ms));
+    exposure_settings.Set(dlp::PG_FlyCap2_C::Parameters::Gain(exposure.gain_db));
+
+    return camera_pg->Setup(exposure_settings);
+}
+
+dlp::ReturnCode AdjustCameraExposure(dlp::Camera         *camera,
+                                     dlp::DLP_Platform   *projector,
+                                     const unsigned char &target_level,
+                                     const float         &maximum_shutter_ms,
+                                     const float         &maximum_gain_db,
+                                     CameraExposure      *exposure){
+    dlp::ReturnCode ret;
+
+    if(!camera || !projector || !exposure) return ret.AddError(AUTO_EXPOSURE_NULL_POINTER);
+
+    ret = GetCameraExposure(camera,exposure);
+    if(ret.hasErrors()) return ret;
+
+    for(unsigned int iAdjust = 0; iAdjust < AUTO_EXPOSURE_MAXIMUM_ADJUSTMENTS; iAdjust++){
+        dlp::Image white_frame;
+        dlp::Image black_frame;
+
+        if(!camera->isStarted()) camera->Start();
+
+        projector->ProjectSolidWhitePattern();
+        dlp::Time::Sleep::Milliseconds(100);
+        GetMonochromeFrame(camera,false,&white_frame);
+
+        projector->ProjectSolidBlackPattern();
+        dlp::Time::Sleep::Milliseconds(100);
+        GetMonochromeFrame(camera,false,&black_frame);
+
+        ExposureMeasurement measurement;
+        ret = MeasureExposure(&white_frame,&black_frame,AUTO_EXPOSURE_MINIMUM_CONTRAST,&measurement);
+        if(ret.hasErrors()) return ret;
+
+        const double scale = GetExposureScale(measurement,target_level);
+        if(std::fabs(scale - 1.0) < AUTO_EXPOSURE_TOLERANCE) break;
+
+        const CameraExposure scaled = ScaleExposure(*exposure,scale,maximum_shutter_ms,maximum_gain_db);
+
+        // Nothing left to change at the shutter and gain limits
+        if((scaled.shutter_ms == exposure->shutter_ms) && (scaled.gain_db == exposure->gain_db)) break;
+
+        // The shutter is only changed while the camera is stopped
+        camera->Stop();
+        ret = SetCameraExposure(camera,scaled);
+        if(ret.hasErrors()) return ret;
+        *exposure = scaled;
+    }
+
+    return ret;
+}
+
+static bool isDecoded(dlp::DisparityMap *disparity_map, const bool &used, const unsigned int &x, const unsigned int &y){
+    if(!used) return true;
+    if(disparity_map->isEmpty()) return false;
+
+    int value;
+    disparity_map->Unsafe_GetPixel(x,y,&value);
+    return value >= 0;
+}
+
+static void CopyDisparity(dlp::DisparityMap *source, dlp::DisparityMap *target, const bool &invalid){
+    unsigned int columns, rows;
+    dlp::Pattern::Orientation orientation;
+    source->GetColumns(&columns);
+    source->GetRows(&rows);
+    source->GetOrientation(&orientation);
+
+    target->Create(columns,rows,orientation);
+    for(unsigned int y = 0; y < rows; y++){
+        for(unsigned int x = 0; x < columns; x++){
+            int value = dlp::DisparityMap::INVALID_PIXEL;
+            if(!invalid) source->Unsafe_GetPixel(x,y,&value);
+            target->Unsafe_SetPixel(x,y,value);
+        }
+    }
+}
+
+dlp::ReturnCode FuseExposureDecodes(dlp::DisparityMap *column_disparity,
+                                    dlp::DisparityMap *row_disparity,
+                                    dlp::Image        *confidence,
+                                    dlp::DisparityMap *fused_column_disparity,
+                                    dlp::DisparityMap *fused_row_disparity,
+                                    dlp::Image        *fused_confidence){
+    dlp::ReturnCode ret;
+
+    if(!column_disparity || !row_disparity || !confidence ||
+       !fused_column_disparity || !fused_row_disparity || !fused_confidence) return ret.AddError(AUTO_EXPOSURE_NULL_POINTER);
+    if(confidence->isEmpty()) return ret.AddError(AUTO_EXPOSURE_CONFIDENCE_MISSING);
+
+    // The first decode is copied as is
+    if(fused_column_disparity->isEmpty() && fused_row_disparity->isEmpty()){
+        if(!column_disparity->isEmpty()) CopyDisparity(column_disparity,fused_column_disparity,false);
+        if(!row_disparity->isEmpty())    CopyDisparity(row_disparity,fused_row_disparity,false);
+        cv::Mat data;
+        confidence->GetOpenCVData(&data);
+        fused_confidence->Create(data);
+        return ret;
+    }
+
+    const bool use_columns = !column_disparity->isEmpty() || !fused_column_disparity->isEmpty();
+    const bool use_rows    = !row_disparity->isEmpty()    || !fused_row_disparity->isEmpty();
+
+    // A direction only this exposure decoded starts out invalid in the fused map
+    if(use_columns && fused_column_disparity->isEmpty()) CopyDisparity(column_disparity,fused_column_disparity,true);
+    if(use_rows    && fused_row_disparity->isEmpty())    CopyDisparity(row_disparity,fused_row_disparity,true);
+
+    unsigned int columns, rows;
+    if(use_columns){
+        fused_column_disparity->GetColumns(&columns);
+        fused_column_disparity->GetRows(&rows);
+    }
+    else{
+        fused_row_disparity->GetColumns(&columns);
+        fused_row_disparity->GetRows(&rows);
+    }
+
+    // Every map taking part must match the fused resolution
+    dlp::DisparityMap *maps[3] = {column_disparity, row_disparity, fused_row_disparity};
+    for(unsigned int iMap = 0; iMap < 3; iMap++){
+        if(maps[iMap]->isEmpty()) continue;
+        unsigned int map_columns, map_rows;
+        maps[iMap]->GetColumns(&map_columns);
+        maps[iMap]->GetRows(&map_rows);
+        if((map_columns != columns) || (map_rows != rows)) return ret.AddError(AUTO_EXPOSURE_RESOLUTION_MISMATCH);
+    }
+
+    unsigned int confidence_columns, confidence_rows;
+    unsigned int fused_confidence_columns, fused_confidence_rows;
+    confidence->GetColumns(&confidence_columns);
+    confidence->GetRows(&confidence_rows);
+    fused_confidence->GetColumns(&fused_confidence_columns);
+    fused_confidence->GetRows(&fused_confidence_rows);
+    if((confidence_columns != columns) || (confidence_rows != rows) ||
+       (fused_confidence_columns != columns) || (fused_confidence_rows != rows)) return ret.AddError(AUTO_EXPOSURE_RESOLUTION_MISMATCH);
+
+    cv::Mat confidence_data;
+    cv::Mat fused_confidence_data;
+    confidence->Unsafe_GetOpenCVData(&confidence_data);
+    fused_confidence->Unsafe_GetOpenCVData(&fused_confidence_data);
+
+    for(unsigned int y = 0; y < rows; y++){
+        for(unsigned int x = 0; x < columns; x++){
+            if(!isDecoded(column_disparity,use_columns,x,y) || !isDecoded(row_disparity,use_rows,x,y)) continue;
+
+            const unsigned char score       = confidence_data.ptr<unsigned char>(y)[x];
+            const unsigned char fused_score = fused_confidence_data.ptr<unsigned char>(y)[x];
+
+            if(isDecoded(fused_column_disparity,use_columns,x,y) &&
+               isDecoded(fused_row_disparity,use_rows,x,y) &&
+               (score <= fused_score)) continue;
+
+            int value;
+            if(use_columns){
+                column_disparity->Unsafe_GetPixel(x,y,&value);
+                fused_column_disparity->Unsafe_SetPixel(x,y,value);
+            }
+            if(use_rows){
+                row_disparity->Unsafe_GetPixel(x,y,&value);
+                fused_row_disparity->Unsafe_SetPixel(x,y,value);
+            }
+            fused_confidence_data.ptr<unsigned char>(y)[x] = score;
+        }
+    }
+
+    return ret;
+}
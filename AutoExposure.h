@@ -0,0 +1,88 @@
+/** @file       AutoExposure.h
+ *  @brief      Camera exposure from white and black frame histograms and per pixel fusion of two exposures
+ */
+#ifndef __AUTO_EXPOSURE_H_
+#define __AUTO_EXPOSURE_H_
+
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define AUTO_EXPOSURE_NULL_POINTER              "AUTO_EXPOSURE_NULL_POINTER"
+#define AUTO_EXPOSURE_IMAGE_EMPTY               "AUTO_EXPOSURE_IMAGE_EMPTY"
+#define AUTO_EXPOSURE_RESOLUTION_MISMATCH       "AUTO_EXPOSURE_RESOLUTION_MISMATCH"
+#define AUTO_EXPOSURE_CAMERA_NOT_SUPPORTED      "AUTO_EXPOSURE_CAMERA_NOT_SUPPORTED"
+#define AUTO_EXPOSURE_CONFIDENCE_MISSING        "AUTO_EXPOSURE_CONFIDENCE_MISSING"
+
+// Fraction of the white frame pixels at or below the highlight level
+#define AUTO_EXPOSURE_HIGHLIGHT_PERCENTILE      0.99
+
+// More of the white frame at full scale than this is treated as clipped and
+// the exposure is halved since the true highlight level is unknown
+#define AUTO_EXPOSURE_SATURATED_FRACTION        0.01
+
+// Exposure scales within this of 1 are not applied
+#define AUTO_EXPOSURE_TOLERANCE                 0.1
+
+// White to black difference a pixel needs to decode, and the fraction of the
+// frame below it at which the exposure is no longer lowered for the highlight
+#define AUTO_EXPOSURE_MINIMUM_CONTRAST          16
+#define AUTO_EXPOSURE_DARK_FRACTION             0.25
+
+#define AUTO_EXPOSURE_MAXIMUM_ADJUSTMENTS       4
+
+// White and black frame histogram figures of a scan target
+struct ExposureMeasurement{
+    unsigned char white_highlight;
+    double        saturated_fraction;
+    double        dark_fraction;        // Pixels with less white to black contrast than the minimum
+};
+
+// Shutter in milliseconds and gain in dB as set on the camera
+struct CameraExposure{
+    float shutter_ms;
+    float gain_db;
+};
+
+dlp::ReturnCode MeasureExposure(dlp::Image          *white,
+                                dlp::Image          *black,
+                                const unsigned char &minimum_contrast,
+                                ExposureMeasurement *measurement);
+
+// Scale of the exposure which brings the white highlight to target_level.
+// Clipping always lowers the exposure, an unclipped highlight above the
+// target only lowers it while at most AUTO_EXPOSURE_DARK_FRACTION of the
+// pixels lack contrast, as they would lose what little they have.
+double GetExposureScale(const ExposureMeasurement &measurement, const unsigned char &target_level);
+
+// Scales the total exposure, raising the shutter up to maximum_shutter_ms
+// before adding gain up to maximum_gain_db, and dropping gain first
+CameraExposure ScaleExposure(const CameraExposure &exposure,
+                             const double         &scale,
+                             const float          &maximum_shutter_ms,
+                             const float          &maximum_gain_db);
+
+// Only the Point Grey camera exposes shutter and gain settings
+dlp::ReturnCode GetCameraExposure(dlp::Camera *camera, CameraExposure *exposure);
+dlp::ReturnCode SetCameraExposure(dlp::Camera *camera, const CameraExposure &exposure);
+
+// Projects white and black, measures the frames, and scales the camera
+// exposure until the white highlight is within tolerance of target_level.
+// The camera is left stopped when the exposure was changed.
+dlp::ReturnCode AdjustCameraExposure(dlp::Camera         *camera,
+                                     dlp::DLP_Platform   *projector,
+                                     const unsigned char &target_level,
+                                     const float         &maximum_shutter_ms,
+                                     const float         &maximum_gain_db,
+                                     CameraExposure      *exposure);
+
+// Keeps, per pixel, the decode of whichever exposure has the higher
+// confidence, or the one that decoded at all. Exposures can only be ranked
+// by their confidence, so a decode without one is rejected. The first call
+// copies the decode into the empty fused maps.
+dlp::ReturnCode FuseExposureDecodes(dlp::DisparityMap *column_disparity,
+                                    dlp::DisparityMap *row_disparity,
+                                    dlp::Image        *confidence,
+                                    dlp::DisparityMap *fused_column_disparity,
+                                    dlp::DisparityMap *fused_row_disparity,
+                                    dlp::Image        *fused_confidence);
+
+#endif
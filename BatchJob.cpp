@@ -0,0 +1,159 @@
+/** @file       BatchJob.cpp
+ *  @brief      Headless batch scan job from command line arguments or a job file
+ */
+#include <cstdlib>
+#include "BatchJob.h"
+
+dlp::ReturnCode SetBatchOperation(const std::string &operation, BatchScanJob *job){
+    dlp::ReturnCode ret;
+
+    if(operation == "scan"){
+        job->use_vertical   = true;
+        job->use_horizontal = true;
+    }
+    else if(operation == "scan_vertical"){
+        job->use_vertical   = true;
+        job->use_horizontal = false;
+    }
+    else if(operation == "scan_horizontal"){
+        job->use_vertical   = false;
+        job->use_horizontal = true;
+    }
+    else{
+        ret.AddError(BATCH_JOB_OPERATION_INVALID);
+    }
+
+    return ret;
+}
+
+std::string GetBatchUsage(const std::string &program){
+    return "Usage: " + program + " [--headless] [--job FILE] [--config FILE]\n"
+           "       [--operation scan|scan_vertical|scan_horizontal] [--views N]\n"
+           "       [--turn-ms N] [--output DIRECTORY] [--upload-firmware] [--resume]\n"
+           "       [--daemon] [--pipe NAME]";
+}
+
+dlp::ReturnCode LoadBatchJobFile(const std::string &job_file, BatchScanJob *job){
+    dlp::ReturnCode ret;
+    dlp::Parameters job_settings;
+
+    if(job_settings.Load(job_file).hasErrors()) return ret.AddError(BATCH_JOB_FILE_LOAD_FAILED);
+
+    BatchJob::Operation         operation;
+    BatchJob::Views             views(job->views);
+    BatchJob::TurnTime          turn_time(job->turn_time_ms);
+    BatchJob::OutputDirectory   output_directory(job->output_directory);
+    BatchJob::UploadFirmware    upload_firmware(job->upload_firmware);
+    BatchJob::Resume            resume(job->resume);
+
+    // Entries missing from the file keep their current values
+    if(!job_settings.Get(&operation).hasErrors()){
+        ret = SetBatchOperation(operation.Get(),job);
+        if(ret.hasErrors()) return ret;
+    }
+    job_settings.Get(&views);
+    job_settings.Get(&turn_time);
+    job_settings.Get(&output_directory);
+    job_settings.Get(&upload_firmware);
+    job_settings.Get(&resume);
+
+    job->views            = views.Get();
+    job->turn_time_ms     = turn_time.Get();
+    job->output_directory = output_directory.Get();
+    job->upload_firmware  = upload_firmware.Get();
+    job->resume           = resume.Get();
+
+    if(job->views == 0) ret.AddError(BATCH_JOB_VIEWS_INVALID);
+
+    return ret;
+}
+
+dlp::ReturnCode ParseBatchArguments(int argc, char *argv[], BatchScanJob *job){
+    dlp::ReturnCode ret;
+
+    job->headless         = false;
+    job->daemon           = false;
+    job->pipe_name        = "";
+    job->config_file      = "DLP_LightCrafter_4500_3D_Scan_Application_Config.txt";
+    job->use_vertical     = true;
+    job->use_horizontal   = true;
+    job->views            = BatchJob::Views().Get();
+    job->turn_time_ms     = BatchJob::TurnTime().Get();
+    job->output_directory = BatchJob::OutputDirectory().Get();
+    job->upload_firmware  = BatchJob::UploadFirmware().Get();
+    job->resume           = BatchJob::Resume().Get();
+
+    // The job file is applied first so the other arguments override it
+    for(int iArg = 1; iArg < argc; iArg++){
+        if(std::string(argv[iArg]) != "--job") continue;
+        if(iArg + 1 >= argc) return ret.AddError(BATCH_JOB_ARGUMENT_MISSING_VALUE);
+        ret = LoadBatchJobFile(argv[iArg + 1],job);
+        if(ret.hasErrors()) return ret;
+        job->headless = true;
+    }
+
+    for(int iArg = 1; iArg < argc; iArg++){
+        const std::string argument = argv[iArg];
+
+        if(argument == "--headless"){
+            job->headless = true;
+            continue;
+        }
+        if(argument == "--upload-firmware"){
+            job->upload_firmware = true;
+            continue;
+        }
+        if(argument == "--resume"){
+            job->resume = true;
+            continue;
+        }
+        if(argument == "--daemon"){
+            job->headless = true;
+            job->daemon   = true;
+            continue;
+        }
+
+        // Every other argument takes a value
+        if(iArg + 1 >= argc) return ret.AddError(BATCH_JOB_ARGUMENT_MISSING_VALUE);
+        const std::string value = argv[++iArg];
+
+        if(argument == "--job"){
+            // Already applied
+        }
+        else if(argument == "--config"){
+            job->config_file = value;
+        }
+        else if(argument == "--operation"){
+            ret = SetBatchOperation(value,job);
+            if(ret.hasErrors()) return ret;
+        }
+        else if(argument == "--views"){
+            job->views = std::strtoul(value.c_str(),NULL,10);
+            if(job->views == 0) return ret.AddError(BATCH_JOB_VIEWS_INVALID);
+        }
+        else if(argument == "--turn-ms"){
+            job->turn_time_ms = std::strtoul(value.c_str(),NULL,10);
+        }
+        else if(argument == "--output"){
+            job->output_directory = value;
+        }
+        else if(argument == "--pipe"){
+            job->pipe_name = value;
+        }
+        else{
+            return ret.AddError(BATCH_JOB_ARGUMENT_UNKNOWN);
+        }
+    }
+
+    AppendDirectorySeparator(&job->output_directory);
+
+    return ret;
+}
+
+void AppendDirectorySeparator(std::string *directory){
+    // Output sub-directories are appended to the output directory
+    const std::string &output = *directory;
+    if(!output.empty() && (output[output.size() - 1] != '/') && (output[output.size() - 1] != '\\')){
+        *directory += "/";
+    }
+}
@@ -0,0 +1,77 @@
+/** @file       BatchJob.h
+ *  @brief      Headless batch scan job from command line arguments or a job file
+ */
+#ifndef __BATCH_JOB_H_
+#define __BATCH_JOB_H_
+
+#include <string>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define BATCH_JOB_ARGUMENT_UNKNOWN          "BATCH_JOB_ARGUMENT_UNKNOWN"
+#define BATCH_JOB_ARGUMENT_MISSING_VALUE    "BATCH_JOB_ARGUMENT_MISSING_VALUE"
+#define BATCH_JOB_FILE_LOAD_FAILED          "BATCH_JOB_FILE_LOAD_FAILED"
+#define BATCH_JOB_OPERATION_INVALID         "BATCH_JOB_OPERATION_INVALID"
+#define BATCH_JOB_VIEWS_INVALID             "BATCH_JOB_VIEWS_INVALID"
+
+// Process exit codes of a batch run
+#define BATCH_EXIT_SUCCESS                  0
+#define BATCH_EXIT_INVALID_JOB              1
+#define BATCH_EXIT_INVALID_CONFIG           2
+#define BATCH_EXIT_CONNECTION_FAILED        3
+#define BATCH_EXIT_PREPARE_FAILED           4
+#define BATCH_EXIT_SCAN_FAILED              5
+
+namespace BatchJob{
+
+// Job file entries, the command line arguments override them
+DLP_NEW_PARAMETERS_ENTRY(Operation,         "BATCH_OPERATION",          std::string,    "scan");
+DLP_NEW_PARAMETERS_ENTRY(Views,             "BATCH_VIEWS",              unsigned int,   1);
+DLP_NEW_PARAMETERS_ENTRY(TurnTime,          "BATCH_TURN_TIME_MS",       unsigned int,   0);
+DLP_NEW_PARAMETERS_ENTRY(OutputDirectory,   "BATCH_OUTPUT_DIRECTORY",   std::string,    "output/");
+DLP_NEW_PARAMETERS_ENTRY(UploadFirmware,    "BATCH_UPLOAD_FIRMWARE",    bool,           false);
+DLP_NEW_PARAMETERS_ENTRY(Resume,            "BATCH_RESUME",             bool,           false);
+
+}
+
+// A batch run prepares the projector from the existing calibration data and
+// scans without prompts, preview frames, or viewer windows
+struct BatchScanJob{
+    bool         headless;
+    std::string  config_file;
+    bool         use_vertical;
+    bool         use_horizontal;
+    unsigned int views;
+    unsigned int turn_time_ms;
+    std::string  output_directory;
+    bool         upload_firmware;
+    bool         resume;
+    bool         daemon;
+    std::string  pipe_name;
+};
+
+// Sets the scan directions from scan, scan_vertical, or scan_horizontal
+dlp::ReturnCode SetBatchOperation(const std::string &operation, BatchScanJob *job);
+
+// Usage text for the batch arguments
+std::string GetBatchUsage(const std::string &program);
+
+// Reads --job FILE first and then applies the other arguments over it:
+//   --headless             run the job instead of the menu
+//   --config FILE          application configuration file
+//   --operation OPERATION  scan, scan_vertical, or scan_horizontal
+//   --views N              views to scan, one turntable step each
+//   --turn-ms N            turntable step time
+//   --output DIRECTORY     receives scan_data/ and scan_images/
+//   --upload-firmware      upload the pattern firmware before scanning
+//   --resume               resume an unfinished checkpointed session of the same job
+//   --daemon               keep the devices open and take jobs from a named pipe
+//   --pipe NAME            named pipe of the daemon
+dlp::ReturnCode ParseBatchArguments(int argc, char *argv[], BatchScanJob *job);
+
+// Applies the entries of a job file over the job
+dlp::ReturnCode LoadBatchJobFile(const std::string &job_file, BatchScanJob *job);
+
+// Appends a trailing / unless the directory is empty or already ends in one
+void AppendDirectorySeparator(std::string *directory);
+
+#endif
@@ -0,0 +1,304 @@
+/** @file       BitPlane.cpp
+ *  @brief      1 bit per pixel packed images and binarized capture sequences
+ */
+#include <cstring>
+#include <fstream>
+#include "BitPlane.h"
+
+#if defined(__SSE2__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#define BIT_PLANE_SIMD
+#include <emmintrin.h>  // Included for SSE2 compares and movemask
+#endif
+
+#define WORDS_PER_ALIGNMENT (BIT_PLANE_ALIGNMENT_BYTES / sizeof(unsigned long long))
+
+// Packed capture file identifier and version
+static const char PACKED_CAPTURE_MAGIC[8] = {'D','L','P','B','I','T','S','1'};
+
+// Mask of the used bits in the last word of a row
+static unsigned long long LastWordMask(const unsigned int &columns){
+    const unsigned int used = columns % BIT_PLANE_WORD_BITS;
+    return (used == 0) ? ~0ULL : ((1ULL << used) - 1);
+}
+
+BitPlane::BitPlane(){
+    this->columns_       = 0;
+    this->rows_          = 0;
+    this->words_per_row_ = 0;
+    this->offset_        = 0;
+}
+
+BitPlane::BitPlane(const BitPlane &plane){
+    this->columns_       = 0;
+    this->rows_          = 0;
+    this->words_per_row_ = 0;
+    this->offset_        = 0;
+    (*this) = plane;
+}
+
+BitPlane& BitPlane::operator=(const BitPlane &plane){
+    if(this == &plane) return (*this);
+
+    if(plane.isEmpty()){
+        this->Clear();
+        return (*this);
+    }
+
+    // The source alignment offset may not hold for this buffer so copy by row
+    this->Create(plane.columns_,plane.rows_);
+    memcpy(this->GetRow(0),plane.GetRow(0),(size_t) this->rows_ * this->words_per_row_ * sizeof(unsigned long long));
+
+    return (*this);
+}
+
+void BitPlane::Create(const unsigned int &columns, const unsigned int &rows, const bool &value){
+    const unsigned int used_words = (columns + BIT_PLANE_WORD_BITS - 1) / BIT_PLANE_WORD_BITS;
+
+    this->columns_       = columns;
+    this->rows_          = rows;
+    this->words_per_row_ = (unsigned int)(((used_words + WORDS_PER_ALIGNMENT - 1) / WORDS_PER_ALIGNMENT) * WORDS_PER_ALIGNMENT);
+
+    // Over allocate so the first row can be moved to an aligned address
+    this->buffer_.assign((size_t) this->rows_ * this->words_per_row_ + WORDS_PER_ALIGNMENT,0);
+
+    const size_t address    = (size_t) &this->buffer_[0];
+    const size_t misaligned = address % BIT_PLANE_ALIGNMENT_BYTES;
+    this->offset_ = misaligned ? (BIT_PLANE_ALIGNMENT_BYTES - misaligned) / sizeof(unsigned long long) : 0;
+
+    if(value && (used_words > 0)){
+        for(unsigned int y = 0; y < this->rows_; y++){
+            unsigned long long *row = this->GetRow(y);
+            for(unsigned int w = 0; w < used_words; w++) row[w] = ~0ULL;
+            row[used_words - 1] = LastWordMask(columns);
+        }
+    }
+}
+
+void BitPlane::Clear(){
+    this->columns_       = 0;
+    this->rows_          = 0;
+    this->words_per_row_ = 0;
+    this->offset_        = 0;
+    std::vector<unsigned long long>().swap(this->buffer_);
+}
+
+bool BitPlane::isEmpty() const{
+    return this->buffer_.empty();
+}
+
+unsigned int BitPlane::GetColumns() const{
+    return this->columns_;
+}
+
+unsigned int BitPlane::GetRows() const{
+    return this->rows_;
+}
+
+unsigned int BitPlane::GetWordsPerRow() const{
+    return this->words_per_row_;
+}
+
+unsigned long long BitPlane::GetByteCount() const{
+    return (unsigned long long) this->buffer_.size() * sizeof(unsigned long long);
+}
+
+unsigned long long* BitPlane::GetRow(const unsigned int &row){
+    return &this->buffer_[this->offset_ + (size_t) row * this->words_per_row_];
+}
+
+const unsigned long long* BitPlane::GetRow(const unsigned int &row) const{
+    return &this->buffer_[this->offset_ + (size_t) row * this->words_per_row_];
+}
+
+bool BitPlane::GetBit(const unsigned int &x, const unsigned int &y) const{
+    return ((this->GetRow(y)[x / BIT_PLANE_WORD_BITS] >> (x % BIT_PLANE_WORD_BITS)) & 1) != 0;
+}
+
+void BitPlane::SetBit(const unsigned int &x, const unsigned int &y, const bool &value){
+    unsigned long long &word = this->GetRow(y)[x / BIT_PLANE_WORD_BITS];
+    const unsigned long long bit = 1ULL << (x % BIT_PLANE_WORD_BITS);
+    if(value) word |=  bit;
+    else      word &= ~bit;
+}
+
+void ThresholdRowToBits(const unsigned char *pixels,
+                        const unsigned char *reference,
+                        const unsigned int  &columns,
+                        const unsigned char &margin,
+                        unsigned long long  *bits,
+                        unsigned long long  *margin_valid){
+    unsigned int x = 0;
+
+#ifdef BIT_PLANE_SIMD
+    // Unsigned compare through a signed compare after flipping the sign bits
+    const __m128i sign       = _mm_set1_epi8((char) 0x80);
+    const __m128i margin_vec = _mm_set1_epi8((char) margin);
+    const __m128i zero       = _mm_setzero_si128();
+
+    for(; x + BIT_PLANE_WORD_BITS <= columns; x += BIT_PLANE_WORD_BITS){
+        unsigned long long word_bits  = 0;
+        unsigned long long word_valid = 0;
+
+        for(unsigned int i = 0; i < BIT_PLANE_WORD_BITS; i += 16){
+            const __m128i a = _mm_loadu_si128((const __m128i*)(pixels    + x + i));
+            const __m128i b = _mm_loadu_si128((const __m128i*)(reference + x + i));
+
+            const __m128i greater = _mm_cmpgt_epi8(_mm_xor_si128(a,sign),_mm_xor_si128(b,sign));
+            word_bits |= (unsigned long long)(unsigned int) _mm_movemask_epi8(greater) << i;
+
+            // |a - b| > margin
+            const __m128i diff    = _mm_or_si128(_mm_subs_epu8(a,b),_mm_subs_epu8(b,a));
+            const __m128i invalid = _mm_cmpeq_epi8(_mm_subs_epu8(diff,margin_vec),zero);
+            word_valid |= (unsigned long long)(unsigned int)(~_mm_movemask_epi8(invalid) & 0xFFFF) << i;
+        }
+
+        bits[x / BIT_PLANE_WORD_BITS] = word_bits;
+        if(margin_valid) margin_valid[x / BIT_PLANE_WORD_BITS] &= word_valid;
+    }
+#endif
+
+    for(; x < columns; x += BIT_PLANE_WORD_BITS){
+        const unsigned int count = (columns - x < BIT_PLANE_WORD_BITS) ? (columns - x) : BIT_PLANE_WORD_BITS;
+        unsigned long long word_bits  = 0;
+        unsigned long long word_valid = 0;
+
+        for(unsigned int i = 0; i < count; i++){
+            const int diff = (int) pixels[x + i] - (int) reference[x + i];
+            if(diff > 0)                                    word_bits  |= 1ULL << i;
+            if((diff > margin) || (-diff > margin))         word_valid |= 1ULL << i;
+        }
+
+        bits[x / BIT_PLANE_WORD_BITS] = word_bits;
+        if(margin_valid) margin_valid[x / BIT_PLANE_WORD_BITS] &= word_valid;
+    }
+}
+
+PackedCaptureSequence::PackedCaptureSequence(){
+    this->columns_ = 0;
+    this->rows_    = 0;
+}
+
+dlp::ReturnCode PackedCaptureSequence::Create(const unsigned int &columns, const unsigned int &rows){
+    dlp::ReturnCode ret;
+
+    this->columns_ = columns;
+    this->rows_    = rows;
+    this->valid_.Create(columns,rows,true);
+    this->planes_.clear();
+
+    return ret;
+}
+
+void PackedCaptureSequence::Clear(){
+    this->columns_ = 0;
+    this->rows_    = 0;
+    this->valid_.Clear();
+    std::vector<BitPlane>().swap(this->planes_);
+}
+
+dlp::ReturnCode PackedCaptureSequence::AddBitPlane(const BitPlane &plane){
+    dlp::ReturnCode ret;
+
+    if((plane.GetColumns() != this->columns_) ||
+       (plane.GetRows()    != this->rows_)){
+        return ret.AddError(PACKED_CAPTURE_RESOLUTION_MISMATCH);
+    }
+
+    this->planes_.push_back(plane);
+    return ret;
+}
+
+unsigned int PackedCaptureSequence::GetCount() const{
+    return (unsigned int) this->planes_.size();
+}
+
+unsigned int PackedCaptureSequence::GetColumns() const{
+    return this->columns_;
+}
+
+unsigned int PackedCaptureSequence::GetRows() const{
+    return this->rows_;
+}
+
+unsigned long long PackedCaptureSequence::GetByteCount() const{
+    unsigned long long bytes = this->valid_.GetByteCount();
+    for(size_t i = 0; i < this->planes_.size(); i++) bytes += this->planes_[i].GetByteCount();
+    return bytes;
+}
+
+BitPlane* PackedCaptureSequence::GetValidMask(){
+    return &this->valid_;
+}
+
+const BitPlane* PackedCaptureSequence::GetValidMask() const{
+    return &this->valid_;
+}
+
+const BitPlane* PackedCaptureSequence::GetBitPlane(const unsigned int &index) const{
+    if(index >= this->planes_.size()) return NULL;
+    return &this->planes_[index];
+}
+
+// Writes the used words of each row
+static void WriteBitPlane(std::ofstream &file, const BitPlane &plane){
+    const size_t row_bytes = ((plane.GetColumns() + BIT_PLANE_WORD_BITS - 1) / BIT_PLANE_WORD_BITS) * sizeof(unsigned long long);
+    for(unsigned int y = 0; y < plane.GetRows(); y++){
+        file.write((const char*) plane.GetRow(y),row_bytes);
+    }
+}
+
+static bool ReadBitPlane(std::ifstream &file, BitPlane *plane){
+    const size_t row_bytes = ((plane->GetColumns() + BIT_PLANE_WORD_BITS - 1) / BIT_PLANE_WORD_BITS) * sizeof(unsigned long long);
+    for(unsigned int y = 0; y < plane->GetRows(); y++){
+        if(!file.read((char*) plane->GetRow(y),row_bytes)) return false;
+    }
+    return true;
+}
+
+dlp::ReturnCode PackedCaptureSequence::Save(const std::string &filename) const{
+    dlp::ReturnCode ret;
+
+    if(this->valid_.isEmpty()) return ret.AddError(PACKED_CAPTURE_EMPTY);
+
+    std::ofstream file(filename.c_str(),std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file.is_open()) return ret.AddError(PACKED_CAPTURE_FILE_OPEN_FAILED);
+
+    const unsigned int header[3] = {this->columns_, this->rows_, this->GetCount()};
+    file.write(PACKED_CAPTURE_MAGIC,sizeof(PACKED_CAPTURE_MAGIC));
+    file.write((const char*) header,sizeof(header));
+
+    WriteBitPlane(file,this->valid_);
+    for(size_t i = 0; i < this->planes_.size(); i++) WriteBitPlane(file,this->planes_[i]);
+
+    return ret;
+}
+
+dlp::ReturnCode PackedCaptureSequence::Load(const std::string &filename){
+    dlp::ReturnCode ret;
+
+    std::ifstream file(filename.c_str(),std::ios::in | std::ios::binary);
+    if(!file.is_open()) return ret.AddError(PACKED_CAPTURE_FILE_OPEN_FAILED);
+
+    char         magic[sizeof(PACKED_CAPTURE_MAGIC)];
+    unsigned int header[3];
+    if(!file.read(magic,sizeof(magic)) ||
+       (memcmp(magic,PACKED_CAPTURE_MAGIC,sizeof(magic)) != 0) ||
+       !file.read((char*) header,sizeof(header))){
+        return ret.AddError(PACKED_CAPTURE_FILE_INVALID);
+    }
+
+    this->Create(header[0],header[1]);
+    if(!ReadBitPlane(file,&this->valid_)) return ret.AddError(PACKED_CAPTURE_FILE_INVALID);
+
+    BitPlane plane;
+    plane.Create(header[0],header[1]);
+    for(unsigned int i = 0; i < header[2]; i++){
+        if(!ReadBitPlane(file,&plane)){
+            this->Clear();
+            return ret.AddError(PACKED_CAPTURE_FILE_INVALID);
+        }
+        this->planes_.push_back(plane);
+    }
+
+    return ret;
+}
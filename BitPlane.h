@@ -0,0 +1,92 @@
+/** @file       BitPlane.h
+ *  @brief      1 bit per pixel packed images and binarized capture sequences
+ */
+#ifndef __BIT_PLANE_H_
+#define __BIT_PLANE_H_
+
+#include <string>
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define BIT_PLANE_ALIGNMENT_BYTES   64  // Rows start on cache line boundaries
+#define BIT_PLANE_WORD_BITS         64
+
+#define PACKED_CAPTURE_EMPTY                "PACKED_CAPTURE_EMPTY"
+#define PACKED_CAPTURE_RESOLUTION_MISMATCH  "PACKED_CAPTURE_RESOLUTION_MISMATCH"
+#define PACKED_CAPTURE_INDEX_OUT_OF_RANGE   "PACKED_CAPTURE_INDEX_OUT_OF_RANGE"
+#define PACKED_CAPTURE_FILE_OPEN_FAILED     "PACKED_CAPTURE_FILE_OPEN_FAILED"
+#define PACKED_CAPTURE_FILE_INVALID         "PACKED_CAPTURE_FILE_INVALID"
+
+// Packed 1 bpp image. Pixel x of a row is bit (x % 64) of word (x / 64) and
+// every row starts on a 64 byte boundary so rows can be processed with
+// aligned SIMD loads. Padding bits past the last column are always zero.
+class BitPlane{
+public:
+    BitPlane();
+    BitPlane(const BitPlane &plane);
+    BitPlane& operator=(const BitPlane &plane);
+
+    void Create(const unsigned int &columns, const unsigned int &rows, const bool &value = false);
+    void Clear();
+    bool isEmpty() const;
+
+    unsigned int GetColumns() const;
+    unsigned int GetRows() const;
+    unsigned int GetWordsPerRow() const;
+    unsigned long long GetByteCount() const;
+
+    unsigned long long*       GetRow(const unsigned int &row);
+    const unsigned long long* GetRow(const unsigned int &row) const;
+
+    bool GetBit(const unsigned int &x, const unsigned int &y) const;
+    void SetBit(const unsigned int &x, const unsigned int &y, const bool &value);
+
+private:
+    unsigned int columns_;
+    unsigned int rows_;
+    unsigned int words_per_row_;    // Padded to the alignment
+    size_t       offset_;           // First aligned word in buffer_
+    std::vector<unsigned long long> buffer_;
+};
+
+// Packs one row of pixels into bits where pixel > reference. If margin_valid
+// is not NULL its bits are cleared where |pixel - reference| <= margin.
+void ThresholdRowToBits(const unsigned char *pixels,
+                        const unsigned char *reference,
+                        const unsigned int  &columns,
+                        const unsigned char &margin,
+                        unsigned long long  *bits,
+                        unsigned long long  *margin_valid);
+
+// Binarized Gray code captures: a validity mask plus one bit plane per
+// pattern, about 1/8 the size of the 8-bit captures. Saved files keep only
+// the used words of each row.
+class PackedCaptureSequence{
+public:
+    PackedCaptureSequence();
+
+    dlp::ReturnCode Create(const unsigned int &columns, const unsigned int &rows);
+    void Clear();
+
+    dlp::ReturnCode AddBitPlane(const BitPlane &plane);
+
+    unsigned int    GetCount() const;
+    unsigned int    GetColumns() const;
+    unsigned int    GetRows() const;
+    unsigned long long GetByteCount() const;
+
+    BitPlane*       GetValidMask();
+    const BitPlane* GetValidMask() const;
+    const BitPlane* GetBitPlane(const unsigned int &index) const;
+
+    dlp::ReturnCode Save(const std::string &filename) const;
+    dlp::ReturnCode Load(const std::string &filename);
+
+private:
+    unsigned int          columns_;
+    unsigned int          rows_;
+    BitPlane              valid_;
+    std::vector<BitPlane> planes_;
+};
+
+#endif
@@ -9,11 +9,36 @@
 #include <stdlib.h>
 #include <string>       // Included for std::string
 #include <thread>       // Included for std::thread
-#include <functional>   // Included for std::ref
+#include <functional>   // Included for std::ref and std::function
+#include <typeinfo>     // Included for typeid
+#include <fstream>      // Included for std::ifstream
+#include <ctime>        // Included for std::strftime
 #include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
 //#include "dlp_platforms/lightcrafter_4500/dlpc350_api.hpp"
 //#include <fstream>
 #include <iostream>
+#include "FrameAcquisition.h"   // Included for fused monochrome frame acquisition
+#include "StreamingGrayCode.h"  // Included for incremental Gray code decoding
+#include "ScanParameters.h"     // Included for scan options
+#include "ScanMask.h"           // Included for the shadow mask scan region
+#include "DecodeConfidence.h"   // Included for confidence filtering of decoded pixels
+#include "MultiFrequencyPhase.h" // Included for heterodyne phase shifting
+#include "HighSpeedCapture.h"   // Included for high speed pattern timing
+#include "PatternCache.h"       // Included for cached pattern sequences
+#include "FirmwarePacking.h"    // Included for parallel firmware image packing
+#include "PatternTimeline.h"    // Included for timestamped pattern display
+#include "FrameAlignment.h"     // Included for timestamped frame alignment
+#include "PatternSlots.h"       // Included for re-capturing missing patterns
+#include "AutoExposure.h"       // Included for adaptive camera exposure
+#include "BatchJob.h"           // Included for headless batch scanning
+#include "ScanSession.h"        // Included for geometry kept across scans
+#include "ScanDaemon.h"         // Included for the scan job pipe
+#include "ScanTrace.h"          // Included for per-stage scan timing
+#include "PointCloudFile.h"     // Included for PLY point cloud files
+#include "MemoryLedger.h"       // Included for per-stage memory accounting
+#include "ScanArchive.h"        // Included for the session scan archive
+#include "FrameCodec.h"         // Included for lossless capture image files
+#include "ScanCheckpoint.h"     // Included for resuming multi-view sessions
 //using namespace std;
 
 
@@ -95,6 +120,8 @@ void PrepareProjectorPatterns( dlp::DLP_Platform    *projector,
                                dlp::StructuredLight *structured_light_horizontal,
                                const std::string    &structured_light_horizontal_settings_file,
                                const bool            previously_prepared,
+                               dlp::Camera          *camera,
+                               dlp::Parameters      *scan_settings,
                                unsigned int         *total_pattern_count){
 
     dlp::ReturnCode ret;
@@ -129,6 +156,35 @@ void PrepareProjectorPatterns( dlp::DLP_Platform    *projector,
         return;
     }
 
+    // Check that structured light module pointers are valid
+    if(!structured_light_vertical)   return;
+    if(!structured_light_horizontal) return;
+
+    // The patterns only change with the settings and modules they are
+    // generated from and the projector resolution
+    unsigned int projector_columns;
+    unsigned int projector_rows;
+    projector->GetColumns(&projector_columns);
+    projector->GetRows(&projector_rows);
+
+    unsigned long long pattern_key = PATTERN_CACHE_HASH_SEED;
+    HashFile(projector_calib_settings_file, &pattern_key);
+    HashFile(structured_light_vertical_settings_file, &pattern_key);
+    HashFile(structured_light_horizontal_settings_file, &pattern_key);
+    pattern_key = HashString(typeid(*structured_light_vertical).name(), pattern_key);
+    pattern_key = HashString(typeid(*structured_light_horizontal).name(), pattern_key);
+    pattern_key = HashBytes(&projector_columns, sizeof(projector_columns), pattern_key);
+    pattern_key = HashBytes(&projector_rows, sizeof(projector_rows), pattern_key);
+
+    ScanParameters::PatternCacheDirectory pattern_cache_directory;
+    scan_settings->Get(&pattern_cache_directory);
+
+    PatternCache pattern_cache;
+    pattern_cache.SetDirectory(pattern_cache_directory.Get());
+
+    bool cached = !pattern_cache.Load(pattern_key, &all_patterns).hasErrors();
+    if(cached) dlp::CmdLine::Print("Using cached patterns ", HashToString(pattern_key), "...");
+
     // Load projector calibration settings
     dlp::CmdLine::Print("Loading projector calibration settings...");
     if(projector_calib_settings.Load(projector_calib_settings_file).hasErrors()){
@@ -156,26 +212,24 @@ void PrepareProjectorPatterns( dlp::DLP_Platform    *projector,
         return;
     }
 
-    // Create the calibration image and convert to monochrome
-    dlp::CmdLine::Print("Generating projector calibration board...");
-    dlp::Image   projector_calibration_board_image;
-    projector_calib.GenerateCalibrationBoard(&projector_calibration_board_image);
-    projector_calibration_board_image.ConvertToMonochrome();
-
-    // Create calibration pattern
-    dlp::CmdLine::Print("Generating projector calibration pattern...");
-    dlp::Pattern calib_pattern;
-    calib_pattern.bitdepth  = dlp::Pattern::Bitdepth::MONO_1BPP;
-    calib_pattern.color     = dlp::Pattern::Color::WHITE;
-    calib_pattern.data_type = dlp::Pattern::DataType::IMAGE_DATA;
-    calib_pattern.image_data.Create(projector_calibration_board_image);
-
-    // Add the calibration pattern to the calibration pattern sequence
-    calibration_patterns.Add(calib_pattern);
-
-    // Setup the strucutred light patterns
-    if(!structured_light_vertical)   return;
-    if(!structured_light_horizontal) return;
+    if(!cached){
+        // Create the calibration image and convert to monochrome
+        dlp::CmdLine::Print("Generating projector calibration board...");
+        dlp::Image   projector_calibration_board_image;
+        projector_calib.GenerateCalibrationBoard(&projector_calibration_board_image);
+        projector_calibration_board_image.ConvertToMonochrome();
+
+        // Create calibration pattern
+        dlp::CmdLine::Print("Generating projector calibration pattern...");
+        dlp::Pattern calib_pattern;
+        calib_pattern.bitdepth  = dlp::Pattern::Bitdepth::MONO_1BPP;
+        calib_pattern.color     = dlp::Pattern::Color::WHITE;
+        calib_pattern.data_type = dlp::Pattern::DataType::IMAGE_DATA;
+        calib_pattern.image_data.Create(projector_calibration_board_image);
+
+        // Add the calibration pattern to the calibration pattern sequence
+        calibration_patterns.Add(calib_pattern);
+    }
 
     // Load the vertical structured light settings
     dlp::CmdLine::Print("Loading vertical structured light settings...");
@@ -202,29 +256,146 @@ void PrepareProjectorPatterns( dlp::DLP_Platform    *projector,
     dlp::CmdLine::Print("Setting up horizontal structured light module...");
     dlp::CmdLine::Print(structured_light_horizontal->Setup(structured_light_horizontal_settings).ToString());
 
-    // Generate the pattern sequence
-    dlp::CmdLine::Print("Generating vertical structured light module patterns...");
-    structured_light_vertical->GeneratePatternSequence(&vertical_patterns);
+    if(!cached){
+        // Generate the pattern sequence
+        dlp::CmdLine::Print("Generating vertical structured light module patterns...");
+        structured_light_vertical->GeneratePatternSequence(&vertical_patterns);
+
+        dlp::CmdLine::Print("Generating horizontal structured light module patterns...");
+        structured_light_horizontal->GeneratePatternSequence(&horizontal_patterns);
+
+        // Combine all of the pattern sequences
+        dlp::CmdLine::Print("Combining all patterns for projector...");
+        all_patterns.Add(calibration_patterns);
+        all_patterns.Add(vertical_patterns);
+        all_patterns.Add(horizontal_patterns);
 
-    dlp::CmdLine::Print("Generating horizontal structured light module patterns...");
-    structured_light_horizontal->GeneratePatternSequence(&horizontal_patterns);
+        dlp::CmdLine::Print("Caching patterns ", HashToString(pattern_key), "...");
+        ret = pattern_cache.Save(pattern_key, all_patterns);
+        if(ret.hasErrors()) dlp::CmdLine::Print("Patterns NOT cached: ", ret.ToString());
+    }
 
-    // Combine all of the pattern sequences
-    dlp::CmdLine::Print("Combining all patterns for projector...");
-    all_patterns.Add(calibration_patterns);
-    all_patterns.Add(vertical_patterns);
-    all_patterns.Add(horizontal_patterns);
+    // The firmware only needs to be uploaded if it holds different patterns
+    bool firmware_current = previously_prepared;
+    if(!firmware_current && pattern_cache.isProjectorCurrent(pattern_key)){
+        dlp::CmdLine::Print("Projector firmware already holds these patterns, skipping upload...");
+        firmware_current = true;
+    }
+
+    // Pack the firmware images on every core and upload them here, the
+    // sequence preparation then only programs the pattern LUT. Built firmware
+    // is kept in the cache so a changed projector only needs the upload.
+    ScanParameters::ParallelFirmwarePacking parallel_firmware_packing;
+    ScanParameters::FirmwarePackingThreads  firmware_packing_threads;
+    scan_settings->Get(&parallel_firmware_packing);
+    scan_settings->Get(&firmware_packing_threads);
+
+    // The SDK programs its own LUT for the uploaded images, so patterns it
+    // would lay out differently are left to its own packing
+    dlp::LCr4500 *lcr4500 = dynamic_cast<dlp::LCr4500*>(projector);
+    bool packed_layout = false;
+    if(!firmware_current && parallel_firmware_packing.Get() && lcr4500){
+        ret = CheckFirmwareLayout(all_patterns);
+        if(ret.hasErrors()) dlp::CmdLine::Print("Pattern layout differs from the SDK's, the SDK will upload the firmware: ", ret.ToString());
+        else                packed_layout = true;
+    }
+
+    if(packed_layout){
+        dlp::Time::Chronograph   firmware_timer;
+        std::vector<std::string> image_files;
+        const std::string firmware_file = pattern_cache.GetDirectory() + "firmware_" + HashToString(pattern_key) + ".bin";
+
+        ret = dlp::ReturnCode();
+        firmware_timer.Reset();
+        if(!std::ifstream(firmware_file.c_str()).good()){
+            dlp::CmdLine::Print("Packing firmware images...");
+            ret = PackFirmwareImages(all_patterns,
+                                     pattern_cache.GetDirectory() + "firmware_image_",
+                                     firmware_packing_threads.Get(),
+                                     &image_files);
+            dlp::CmdLine::Print("Firmware images packed in...\t\t\t", firmware_timer.Lap(), "ms");
+
+            // Built next to the cached firmware and moved over it once complete,
+            // so an interrupted build never leaves a firmware file to upload
+            if(!ret.hasErrors()){
+                const std::string building_file = firmware_file + ".tmp";
+                ret = lcr4500->CreateFirmware(building_file, image_files);
+                if(!ret.hasErrors() && !MoveFileExA(building_file.c_str(), firmware_file.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)){
+                    ret.AddError(FIRMWARE_PACKING_FIRMWARE_NOT_SAVED);
+                }
+                if(ret.hasErrors()) DeleteFileA(building_file.c_str());
+                dlp::CmdLine::Print("Firmware built in...\t\t\t\t", firmware_timer.Lap(), "ms");
+            }
+        }
+
+        if(!ret.hasErrors()){
+            dlp::CmdLine::Print("Uploading firmware...");
+            lcr4500->SetDebugEnable(true);
+            ret = lcr4500->UploadFirmware(firmware_file);
+            lcr4500->SetDebugEnable(false);
+            dlp::CmdLine::Print("Firmware uploaded in...\t\t\t\t", firmware_timer.Lap(), "ms");
+
+            // A firmware the projector rejects is built again next time
+            if(ret.hasErrors()) DeleteFileA(firmware_file.c_str());
+        }
+
+        if(ret.hasErrors()){
+            dlp::CmdLine::Print("Parallel firmware preparation FAILED, the SDK will upload the firmware: ");
+            dlp::CmdLine::Print(ret.ToString());
+        }
+        else{
+            firmware_current = true;
+            pattern_cache.SetProjectorKey(pattern_key);
+        }
+    }
 
 
     // If previously_prepared is false, the module should assume that the projector has NOT been prepared previously
     // This is important for the LightCrafter 4500 since the images are stored in the firmware
     // Therefore firmware must be uploaded to prepare the projector, but this only needs to occur once
     dlp::Parameters force_preparation;
-    force_preparation.Set(dlp::DLP_Platform::Parameters::SequencePrepared(previously_prepared));
+    force_preparation.Set(dlp::DLP_Platform::Parameters::SequencePrepared(firmware_current));
+
+    // High speed mode runs the sequence at the shortest period the patterns
+    // allow and the projector triggers each camera exposure
+    ScanParameters::HighSpeedMode   high_speed_mode;
+    ScanParameters::HighSpeedPeriod high_speed_period;
+    scan_settings->Get(&high_speed_mode);
+    scan_settings->Get(&high_speed_period);
+    bool high_speed_timing = false;
+    if(high_speed_mode.Get()){
+        dlp::Parameters high_speed_settings;
+        unsigned int    period_us = 0;
+
+        dlp::CmdLine::Print("Setting up high speed pattern timing...");
+        ret = SetHighSpeedTiming(all_patterns, high_speed_period.Get(), &high_speed_settings, &period_us);
+        if(ret.hasWarnings()) dlp::CmdLine::Print(ret.ToString());
+
+        if(!ret.hasErrors()){
+            dlp::CmdLine::Print("Pattern period...\t\t\t\t", period_us, "us");
+
+            // The projector may only run as fast as the camera can follow
+            ret = SetupTriggeredCamera(camera, period_us);
+            if(ret.hasErrors()){
+                dlp::CmdLine::Print("Camera can NOT keep up with the high speed pattern period, using default timing: ");
+                dlp::CmdLine::Print(ret.ToString());
+            }
+            else{
+                force_preparation.Set(dlp::DLP_Platform::Parameters::SequenceExposure(period_us));
+                force_preparation.Set(dlp::DLP_Platform::Parameters::SequencePeriod(period_us));
+                high_speed_timing = true;
+            }
+        }
+        else{
+            dlp::CmdLine::Print("High speed timing FAILED, using default timing: ");
+            dlp::CmdLine::Print(ret.ToString());
+        }
+    }
+
     projector->Setup(force_preparation);
 
     // If the firmware needs to be uploaded, display debug messages so progress can be observed
-    projector->SetDebugEnable(!previously_prepared);
+    projector->SetDebugEnable(!firmware_current);
 
 
     // Prepare projector
@@ -236,7 +407,15 @@ void PrepareProjectorPatterns( dlp::DLP_Platform    *projector,
         dlp::CmdLine::Print("Projector prepare sequence FAILED: ");
         dlp::CmdLine::Print(ret.ToString());
         (*total_pattern_count) = 0;
+        high_speed_timing = false;
     }
+    else if(!firmware_current){
+        // Record what the projector holds so the next start can skip the upload
+        pattern_cache.SetProjectorKey(pattern_key);
+    }
+
+    // Scans only take the projector period when the high speed timing was applied
+    scan_settings->Set(ScanParameters::HighSpeedTiming(high_speed_timing));
 
     dlp::CmdLine::Print("Projector prepared");
     (*total_pattern_count) = all_patterns.GetCount();
@@ -246,7 +425,8 @@ void CalibrateCamera(dlp::Camera       *camera,
                      const std::string &camera_calib_settings_file,
                      const std::string &camera_calib_data_file,
                      const std::string &camera_calib_image_file_names,
-                     dlp::DLP_Platform *projector){
+                     dlp::DLP_Platform *projector,
+                     const std::string &image_format){
     dlp::ReturnCode ret;
 
     dlp::CmdLine::Print();
@@ -388,7 +568,7 @@ void CalibrateCamera(dlp::Camera       *camera,
 
         // Add the calibraiton board image
         bool success = false;
-        camera_printed_board.ConvertToMonochrome(); // Convert the image to monochrome
+        ConvertToMonochromeWithSum(&camera_printed_board,NULL); // Convert the image to monochrome
         camera_calib.AddCalibrationBoard(camera_printed_board,&success);
 
         // Update the status
@@ -397,7 +577,7 @@ void CalibrateCamera(dlp::Camera       *camera,
         // Display message
         if(success){
             dlp::CmdLine::Print("Calibration board successfully added! Captured " + dlp::Number::ToString(boards_success) + " of "  + dlp::Number::ToString(boards_required));
-            camera_printed_board.Save(camera_calib_image_file_names + dlp::Number::ToString(boards_success) + ".bmp");
+            SaveImageFile(camera_printed_board, camera_calib_image_file_names + dlp::Number::ToString(boards_success), image_format);
         }
         else{
             dlp::CmdLine::Print("\nCalibration board NOT found! Please check the following:");
@@ -440,7 +620,8 @@ void CalibrateSystem(dlp::Camera       *camera,
                      dlp::DLP_Platform *projector,
                      const std::string &projector_calib_settings_file,
                      const std::string &projector_calib_data_file,
-                     const std::string &calib_image_file_names){
+                     const std::string &calib_image_file_names,
+                     const std::string &image_format){
 
     dlp::ReturnCode ret;
 
@@ -630,7 +811,7 @@ void CalibrateSystem(dlp::Camera       *camera,
 
             // Add the calibration board image
             bool success;
-            camera_printed_board.ConvertToMonochrome();
+            ConvertToMonochromeWithSum(&camera_printed_board,NULL);
             camera_calib.AddCalibrationBoard(camera_printed_board,&success);
 
             // Update the status
@@ -639,13 +820,13 @@ void CalibrateSystem(dlp::Camera       *camera,
             // Display message
             if(success){
                 dlp::CmdLine::Print("Camera calibration board successfully added! Captured " + dlp::Number::ToString(cam_boards_success) + " of " + dlp::Number::ToString(cam_boards_required));
-                camera_printed_board.Save(calib_image_file_names + "camera_" + dlp::Number::ToString(cam_boards_success) + ".bmp");
+                SaveImageFile(camera_printed_board, calib_image_file_names + "camera_" + dlp::Number::ToString(cam_boards_success), image_format);
 
                 // Get the projector calibration capture now
                 projector->DisplayPatternInSequence(0,true);
                 dlp::Time::Sleep::Milliseconds(250);
 
-                camera->GetFrame(&projector_camera_combo);
+                GetMonochromeFrame(camera,false,&projector_camera_combo);
                 camera_view.Update(projector_camera_combo);
                 camera_view.WaitForKey(1,&return_key);
 
@@ -653,15 +834,13 @@ void CalibrateSystem(dlp::Camera       *camera,
                 projector->ProjectSolidBlackPattern();
                 dlp::Time::Sleep::Milliseconds(250);
 
-                camera->GetFrame(&projector_black);
+                GetMonochromeFrame(camera,false,&projector_black);
                 camera_view.Update(projector_black);
                 camera_view.WaitForKey(1,&return_key);
 
 
                 // Add the printed and combination boards
                 dlp::Image projector_pattern;
-                projector_camera_combo.ConvertToMonochrome();
-                projector_black.ConvertToMonochrome();
 
                 projector_calib.RemovePrinted_AddProjectedBoard(camera_printed_board,
                                                                 projector_black,
@@ -677,8 +856,8 @@ void CalibrateSystem(dlp::Camera       *camera,
 //				proj_boards_success++;	//zk  test
                 if(success){
                     dlp::CmdLine::Print("Projector calibration board successfully added! Captured "  + dlp::Number::ToString(proj_boards_success) + " of " + dlp::Number::ToString(proj_boards_required));
-                    projector_pattern.Save(calib_image_file_names + "projector_pattern_" + dlp::Number::ToString(proj_boards_success) +".bmp");
-                    projector_camera_combo.Save(calib_image_file_names + "projector_camera_combo_" + dlp::Number::ToString(proj_boards_success) +".bmp");
+                    SaveImageFile(projector_pattern, calib_image_file_names + "projector_pattern_" + dlp::Number::ToString(proj_boards_success), image_format);
+                    SaveImageFile(projector_camera_combo, calib_image_file_names + "projector_camera_combo_" + dlp::Number::ToString(proj_boards_success), image_format);
                 }
                 else{
                     dlp::CmdLine::Print("Projector calibration board NOT found! Please check the following:");
@@ -690,8 +869,8 @@ void CalibrateSystem(dlp::Camera       *camera,
                     dlp::CmdLine::Print("- The calibration board is well illuminated");
                     dlp::CmdLine::Print("- The calibration board is in focus");
                     dlp::CmdLine::Print();
-					projector_pattern.Save(calib_image_file_names + "projector_failed_pattern_" + dlp::Number::ToString(proj_boards_success) + ".bmp");
-					projector_camera_combo.Save(calib_image_file_names + "projector_camera_failed_combo_" + dlp::Number::ToString(proj_boards_success) + ".bmp");
+					SaveImageFile(projector_pattern, calib_image_file_names + "projector_failed_pattern_" + dlp::Number::ToString(proj_boards_success), image_format);
+					SaveImageFile(projector_camera_combo, calib_image_file_names + "projector_camera_failed_combo_" + dlp::Number::ToString(proj_boards_success), image_format);
                     // Remove the most recently added camera calibration board
                     camera_calib.RemoveLastCalibrationBoard();
                     camera_calib.GetCalibrationProgress(&cam_boards_success,&cam_boards_required);
@@ -805,6 +984,107 @@ void CalibrateSystem(dlp::Camera       *camera,
     return;
 }
 
+// Moves the frames now in pattern order out of the slots, the first
+// vertical_count patterns are vertical and the rest horizontal. Streaming
+// decoders consume them right away, otherwise they are added to the scans.
+// Spilled frames are only kept as their saved file, which the decoders load.
+// Saved frames go to the archive instead of an image file when there is one,
+// image files are written by the frame writer in its format. A capture the
+// streaming decoder rejects fails the view, later frames are not decoded.
+void TakePatternFrames(PatternSlots           *slots,
+                       const unsigned int     &vertical_count,
+                       const bool             &streaming,
+                       StreamingGrayCode      *streaming_vertical,
+                       StreamingGrayCode      *streaming_horizontal,
+                       dlp::Capture::Sequence *vertical_scan,
+                       dlp::Capture::Sequence *horizontal_scan,
+                       const bool             &save_images,
+                       const bool             &spill,
+                       ScanArchive            *archive,
+                       FrameWriter            *frame_writer,
+                       const std::string      &images_directory,
+                       bool                   *decode_failed){
+    dlp::Image   frame;
+    unsigned int pattern;
+
+    while(slots->TakeNext(&frame,&pattern)){
+        const std::string image_base = images_directory + "scan_capture_" + dlp::Number::ToString(pattern);
+        const std::string image_file = image_base + ".bmp";
+        if(save_images && archive) archive->AppendImage(SCAN_ARCHIVE_CHUNK_CAPTURE, pattern, frame);
+        if(spill)                          frame.Save(image_file);
+        else if(save_images && !archive)   frame_writer->Save(frame, image_base);
+
+        if(streaming){
+            if(!*decode_failed){
+                dlp::ReturnCode decode_return;
+                if(pattern < vertical_count) decode_return = streaming_vertical->AddCapture(&frame);
+                else                         decode_return = streaming_horizontal->AddCapture(&frame);
+                if(decode_return.hasErrors()){
+                    dlp::CmdLine::Print("Pattern ", pattern, " NOT decoded: ", decode_return.ToString());
+                    *decode_failed = true;
+                }
+            }
+        }
+        else{
+            dlp::Capture capture;
+            if(spill){
+                capture.image_file = image_file;
+                capture.data_type  = dlp::Capture::DataType::IMAGE_FILE;
+            }
+            else{
+                capture.image_data = frame;
+                capture.data_type  = dlp::Capture::DataType::IMAGE_DATA;
+            }
+            if(pattern < vertical_count) vertical_scan->Add(capture);
+            else                         horizontal_scan->Add(capture);
+        }
+        frame.Clear();
+    }
+}
+
+// Turns the table one step of 360 / data[0] degrees and waits for it to
+// settle. False when the step was not sent or not acknowledged.
+bool TurnTurntable(HANDLE hcom, char *data, const int &stop_time_ms){
+	DWORD dwWrittenLen = 0;
+	const BOOL bWriteStat = WriteFile(hcom,data,1,&dwWrittenLen,NULL);
+	if(!bWriteStat)
+        {
+         dlp::CmdLine::Print("ʧ ");
+        }
+
+	_sleep(1000);
+
+	char str[2];
+	char aa,bb;
+	DWORD wCount;//ȡֽ		 
+	BOOL bReadStat;		 
+	bReadStat=ReadFile(hcom,str,1,&wCount,NULL);
+	if(!bReadStat)
+        {
+         dlp::CmdLine::Print("ȡʧ ");
+        }
+	// A short read is the port timing out without an answer
+	if(!bReadStat || (wCount != 1)){
+		dlp::CmdLine::Print("Turntable did NOT answer");
+		return false;
+	}
+	aa=str[0];
+//	bb=str[1];
+	dlp::CmdLine::Print(":",aa);		
+//	dlp::CmdLine::Print(":",bb);
+	_sleep(stop_time_ms*8/((int)(data[0])));
+	return bWriteStat && bReadStat && (wCount == 1);
+}
+
+// Calls a function when it goes out of scope, so it runs on every return
+class ScopeExit{
+public:
+    ScopeExit(const std::function<void()> &function) : function_(function){}
+    ~ScopeExit(){ this->function_(); }
+private:
+    std::function<void()> function_;
+};
+
 void ScanObject(dlp::Camera          *camera,
                 const bool           &cam_proj_hw_synchronized,
                 const std::string    &camera_calib_data_file,
@@ -816,36 +1096,37 @@ void ScanObject(dlp::Camera          *camera,
                 const bool           &use_horizontal,
                 const std::string    &geometry_settings_file,
                 const bool           &continuous_scanning,
+                const dlp::Parameters &scan_settings,
 				int					 scan_times=1,
-				int					 stop_time_ms=0	){
+				int					 stop_time_ms=0,
+				unsigned int		 *views_saved=NULL,
+				ScanSession			 *session=NULL	){
 
 
 				
 		//ɨ
-		char t[10];
-		std::cout<<"һתΣ" << std::endl;
-		std::cin >> t;
-		scan_times=atoi(t);
+		// Batch runs take the view count from the job
+		ScanParameters::Headless headless;
+		scan_settings.Get(&headless);
+		if (!headless.Get()){
+			char t[10];
+			std::cout<<"һתΣ" << std::endl;
+			std::cin >> t;
+			scan_times=atoi(t);
+		}
 				
     //д
 	//zk_uart_test
 		dlp::CmdLine::Print("ӵƬ ");
 	
+		// The turntable port stays open in the session between scans
+		ScanSession local_session;
+		if (!session) session = &local_session;
 	    HANDLE hcom;
-		hcom = CreateFile("COM4",GENERIC_READ | GENERIC_WRITE,0,NULL,OPEN_EXISTING 
-								,FILE_ATTRIBUTE_NORMAL,NULL);
-		if (hcom == INVALID_HANDLE_VALUE)
+		if (session->OpenTurntable("COM4", stop_time_ms, &hcom).hasErrors())
 		{
 			dlp::CmdLine::Print("ʧ ");
 		}
-		SetupComm(hcom,1024,1024);
-		DCB dcb;
-		GetCommState(hcom,&dcb);
-		dcb.BaudRate = 4800;
-		dcb.ByteSize = 8;
-		dcb.Parity = 0;
-		dcb.StopBits = 1;
-		SetCommState(hcom,&dcb);
 
 	    char data[2];
 		data[0]=(char)scan_times;
@@ -887,84 +1168,27 @@ void ScanObject(dlp::Camera          *camera,
         }
     }
 
-    // Check that calibrations are complete
-    dlp::Calibration::Data calibration_data_camera;
-    dlp::Calibration::Data calibration_data_projector;
-
-
+    // Calibration data and geometry are only loaded when the session does
+    // not already hold them for these files
     dlp::CmdLine::Print("Loading camera and projector calibration data...");
-    calibration_data_camera.Load(camera_calib_data_file);
-    calibration_data_projector.Load(projector_calib_data_file);
-
-    if(!calibration_data_camera.isComplete()){
-        dlp::CmdLine::Print("Camera calibration is NOT complete! \n");
-        return;
-    }
-
-    if(!calibration_data_camera.isCamera()){
-        dlp::CmdLine::Print("Camera calibration is NOT from a camera calibration! \n");
-        return;
-    }
-
-    if(!calibration_data_projector.isComplete()){
-        dlp::CmdLine::Print("Projector calibration is NOT complete! \n");
+    dlp::ReturnCode session_return = session->PrepareGeometry(camera, projector, camera_calib_data_file, projector_calib_data_file, geometry_settings_file);
+    if(session_return.hasErrors()){
+        dlp::CmdLine::Print("Camera and projector geometry NOT constructed: ", session_return.ToString());
+        if(session_return.ContainsError(SCAN_SESSION_CAMERA_RESOLUTION_MISMATCH) ||
+           session_return.ContainsError(SCAN_SESSION_PROJECTOR_RESOLUTION_MISMATCH)){
+            dlp::CmdLine::Print("Please use the calibration files for this specific camera and projector!");
+            if(!headless.Get()) dlp::CmdLine::PressEnterToContinue("Press ENTER to continue...");
+        }
         return;
     }
 
-    if(calibration_data_projector.isCamera()){
-        dlp::CmdLine::Print("Projector calibration is NOT from a projector calibration! \n");
-        return;
-    }
+    dlp::Geometry &scanner_geometry = session->GetGeometry();
+    unsigned int   camera_viewport  = session->GetCameraViewport();
 
-    // Check that the camera resolution matches the camera calibration data resolution
-    unsigned int calibration_camera_rows;
-    unsigned int calibration_camera_columns;
     unsigned int camera_rows;
     unsigned int camera_columns;
-    calibration_data_camera.GetModelResolution(&calibration_camera_columns,&calibration_camera_rows);
     camera->GetColumns(&camera_columns);
     camera->GetRows(&camera_rows);
-
-    if((calibration_camera_columns != camera_columns) ||
-       (calibration_camera_rows    != camera_rows)){
-        dlp::CmdLine::Print("\nThe camera calibration data model resolution and camera resolution do NOT match!");
-        dlp::CmdLine::Print("Please use the calibration files for this specific camera!");
-        std::cout << "Camera resolution from Calibration File  - (" << calibration_camera_columns << "," << calibration_camera_rows << ") " << "Actual Camera resolution - (" << camera_columns << "," << camera_rows << ") " << std::endl;
-        dlp::CmdLine::PressEnterToContinue("Press ENTER to continue...");
-        return;
-    }
-
-
-    // Check that the projector resolution matches the projector calibration data resolution
-    unsigned int calibration_projector_rows;
-    unsigned int calibration_projector_columns;
-    unsigned int projector_rows;
-    unsigned int projector_columns;
-    calibration_data_projector.GetModelResolution(&calibration_projector_columns,&calibration_projector_rows);
-    projector->GetColumns(&projector_columns);
-    projector->GetRows(&projector_rows);
-
-    if((calibration_projector_columns != projector_columns) ||
-       (calibration_projector_rows    != projector_rows)){
-        dlp::CmdLine::Print("\nThe projector calibration data model resolution and projector resolution do NOT match!");
-        dlp::CmdLine::Print("Please use the calibration files for this specific projector!");
-        std::cout << "Projector resolution from Calibration File  - (" << calibration_projector_columns << "," << calibration_projector_rows << ") " << "Actual Camera resolution - (" << projector_columns << "," << projector_rows << ") " << std::endl;
-        dlp::CmdLine::PressEnterToContinue("Press ENTER to continue...");
-        return;
-    }
-
-    dlp::Parameters geometry_settings;
-	dlp::Geometry scanner_geometry;
-    geometry_settings.Load(geometry_settings_file);
-    scanner_geometry.Setup(geometry_settings);
-
-	unsigned int camera_viewport;
-
-	dlp::CmdLine::Print("Constructing the camera and projector geometry...");
-		
-	scanner_geometry.SetDebugEnable(false);
-	scanner_geometry.SetOriginView(calibration_data_projector);
-	scanner_geometry.AddView(calibration_data_camera, &camera_viewport);
 	
     // Variables for viewers during the scan
     dlp::Point::Cloud::Window view_point_cloud;
@@ -973,10 +1197,193 @@ void ScanObject(dlp::Camera          *camera,
     int scan_count = 0;
     std::atomic_bool continue_scanning(true);
     dlp::Time::Chronograph  timer;
-    dlp::Capture::Sequence  capture_scan;
     dlp::Point::Cloud       point_cloud;
     dlp::Image depth_map;
     dlp::Image color_map;
+    dlp::Image confidence_map;
+
+    // Scan options
+    ScanParameters::PackedCaptureArchive packed_capture_archive;
+    ScanParameters::ShadowMaskContrast   shadow_mask_contrast;
+    ScanParameters::MinimumConfidence    minimum_confidence;
+    ScanParameters::SaveConfidence       save_confidence;
+    ScanParameters::SavePly              save_ply;
+    ScanParameters::BatchedPatternDisplay batched_pattern_display;
+    ScanParameters::TimestampAlignment   timestamp_alignment;
+    scan_settings.Get(&packed_capture_archive);
+    scan_settings.Get(&shadow_mask_contrast);
+    scan_settings.Get(&minimum_confidence);
+    scan_settings.Get(&save_confidence);
+    scan_settings.Get(&save_ply);
+    scan_settings.Get(&batched_pattern_display);
+    scan_settings.Get(&timestamp_alignment);
+
+    // Missing and saturated patterns are re-captured one at a time
+    ScanParameters::MaximumRecaptures         maximum_recaptures;
+    ScanParameters::RecaptureSaturatedPercent recapture_saturated_percent;
+    scan_settings.Get(&maximum_recaptures);
+    scan_settings.Get(&recapture_saturated_percent);
+
+    // Camera exposure set from the target before each scan
+    ScanParameters::AutoExposure       auto_exposure;
+    ScanParameters::AutoExposureTarget auto_exposure_target;
+    ScanParameters::MaximumGain        maximum_gain;
+    ScanParameters::DualExposureRatio  dual_exposure_ratio;
+    scan_settings.Get(&auto_exposure);
+    scan_settings.Get(&auto_exposure_target);
+    scan_settings.Get(&maximum_gain);
+    scan_settings.Get(&dual_exposure_ratio);
+
+    // Scan results are saved here
+    ScanParameters::DataDirectory   data_directory;
+    ScanParameters::ImagesDirectory images_directory;
+    scan_settings.Get(&data_directory);
+    scan_settings.Get(&images_directory);
+
+    // Results are also published to shared memory for local consumers
+    ScanParameters::ResultChannelName     result_channel_name;
+    ScanParameters::ResultChannelSegments result_channel_segments;
+    scan_settings.Get(&result_channel_name);
+    scan_settings.Get(&result_channel_segments);
+
+    ResultChannel *result_channel = NULL;
+    if(!result_channel_name.Get().empty()){
+        dlp::ReturnCode channel_return = session->OpenResultChannel(result_channel_name.Get(),
+                                                                    result_channel_segments.Get(),
+                                                                    camera_columns,
+                                                                    camera_rows,
+                                                                    &result_channel);
+        if(channel_return.hasErrors()) dlp::CmdLine::Print("Result channel NOT opened: ", channel_return.ToString());
+    }
+
+    // Stage spans of every view, saved with the scan data when the routine returns
+    ScanParameters::TraceScan trace_scan;
+    scan_settings.Get(&trace_scan);
+    ScanTrace scan_trace;
+    scan_trace.SetEnabled(trace_scan.Get());
+
+    // Bytes held by the scan buffers, with the budget that spills captures to disk
+    ScanParameters::MemoryBudget memory_budget;
+    ScanParameters::MemoryReport memory_report;
+    scan_settings.Get(&memory_budget);
+    scan_settings.Get(&memory_report);
+    MemoryLedger memory_ledger;
+    memory_ledger.SetBudget((unsigned long long) memory_budget.Get() * 1048576);
+
+    // Saved on every return as failed scans are the ones the reports are needed
+    // for. Stage timing and memory of all views, files of an earlier scan are
+    // replaced like the views are.
+    ScopeExit save_scan_reports([&](){
+        if(scan_trace.isEnabled() && (scan_trace.GetSpanCount() > 0)){
+            dlp::ReturnCode trace_return = scan_trace.SaveChromeTrace(data_directory.Get() + "scan_trace.json");
+            if(!trace_return.hasErrors()) trace_return = scan_trace.SaveMetrics(data_directory.Get() + "scan_metrics.csv");
+            if(trace_return.hasErrors()) dlp::CmdLine::Print("Scan trace NOT saved: ", trace_return.ToString());
+        }
+        if(memory_report.Get()){
+            dlp::ReturnCode memory_return = memory_ledger.SaveReport(data_directory.Get() + "scan_memory.csv");
+            if(memory_return.hasErrors()) dlp::CmdLine::Print("Memory report NOT saved: ", memory_return.ToString());
+        }
+    });
+
+    // A multi-view session which stopped part way through resumes at its first
+    // unsaved view, with the table turned there and its archive appended to
+    ScanParameters::CheckpointScans checkpoint_scans;
+    ScanParameters::ResumeScans     resume_scans;
+    scan_settings.Get(&checkpoint_scans);
+    scan_settings.Get(&resume_scans);
+    const std::string checkpoint_file = data_directory.Get() + SCAN_CHECKPOINT_FILE;
+    ScanCheckpoint checkpoint;
+    std::string    checkpoint_settings;
+    bool resume_session = false;
+    if(checkpoint_scans.Get()){
+        // The job is its settings, without the ones which only say how it was
+        // started, the calibration and geometry it uses, and the scan modules
+        dlp::Parameters job_settings = scan_settings;
+        job_settings.Set(ScanParameters::Headless(false));
+        job_settings.Set(ScanParameters::ResumeScans(false));
+        const std::string job_settings_file = data_directory.Get() + SCAN_CHECKPOINT_SETTINGS_FILE;
+        job_settings.Save(job_settings_file);
+
+        unsigned long long job_key = PATTERN_CACHE_HASH_SEED;
+        HashFile(job_settings_file, &job_key);
+        HashFile(camera_calib_data_file, &job_key);
+        HashFile(projector_calib_data_file, &job_key);
+        HashFile(geometry_settings_file, &job_key);
+        job_key = HashString(typeid(*structured_light_vertical).name(), job_key);
+        job_key = HashString(typeid(*structured_light_horizontal).name(), job_key);
+        job_key = HashBytes(&use_vertical, sizeof(use_vertical), job_key);
+        job_key = HashBytes(&use_horizontal, sizeof(use_horizontal), job_key);
+        checkpoint_settings = HashToString(job_key);
+    }
+    if(checkpoint_scans.Get() && !checkpoint.Load(checkpoint_file).hasErrors() &&
+       checkpoint.isJob(data_directory.Get(), checkpoint_settings) &&
+       (checkpoint.GetViewCount() == (unsigned int) scan_times) && (checkpoint.GetNextView() > 1) && !checkpoint.isComplete()){
+        dlp::CmdLine::Print("Unfinished scan session found, ", checkpoint.GetNextView() - 1, " of ", scan_times, " views scanned");
+
+        // Headless jobs never resume unless they ask to
+        resume_session = resume_scans.Get();
+        if(!headless.Get()){
+            std::string answer;
+            std::cout << "Resume it (y/n)? " << std::endl;
+            std::cin >> answer;
+            resume_session = !answer.empty() && ((answer[0] == 'y') || (answer[0] == 'Y'));
+        }
+    }
+
+    // One archive per session holds the data of every view
+    ScanParameters::ArchiveScans       archive_scans;
+    ScanParameters::ArchiveCompression archive_compression;
+    scan_settings.Get(&archive_scans);
+    scan_settings.Get(&archive_compression);
+    ScanArchive  scan_archive;
+    ScanArchive *archive = NULL;
+    std::string  archive_file;
+    if(archive_scans.Get()){
+        char session_time[32];
+        const std::time_t now = std::time(NULL);
+        std::strftime(session_time, sizeof(session_time), "%Y%m%d_%H%M%S", std::localtime(&now));
+
+        archive_file = data_directory.Get() + "scan_" + session_time + ".dlpa";
+        if(resume_session && !checkpoint.GetArchiveFile().empty()) archive_file = checkpoint.GetArchiveFile();
+        dlp::ReturnCode archive_return = scan_archive.Open(archive_file);
+        if(archive_return.hasErrors()){
+            dlp::CmdLine::Print("Scan archive NOT opened: ", archive_return.ToString());
+        }
+        else{
+            scan_archive.SetCompression(archive_compression.Get());
+            archive = &scan_archive;
+        }
+    }
+
+    if(resume_session){
+        const unsigned int resume_steps = checkpoint.GetResumeSteps();
+        dlp::CmdLine::Print("Turning the table ", resume_steps, " steps from ", checkpoint.GetTableAngle(), " degrees...");
+        for(unsigned int iStep = 0; iStep < resume_steps; iStep++){
+            if(!TurnTurntable(hcom, data, stop_time_ms)){
+                dlp::CmdLine::Print("Turntable NOT turned! Exiting scan routine...");
+                return;
+            }
+            checkpoint.TurnTable();
+            dlp::ReturnCode checkpoint_return = checkpoint.Save(checkpoint_file);
+            if(checkpoint_return.hasErrors()) dlp::CmdLine::Print("Scan checkpoint NOT saved: ", checkpoint_return.ToString());
+        }
+
+        // The loop numbers views from data[0], which stays the session's view count
+        scan_times -= checkpoint.GetNextView() - 1;
+        if(views_saved) *views_saved += (unsigned int) checkpoint.GetSavedViews().size();
+        dlp::CmdLine::Print("Resuming the scan session at view ", checkpoint.GetNextView(), "...");
+    }
+    else{
+        checkpoint.Start(scan_times, data_directory.Get(), checkpoint_settings, archive ? archive_file : "");
+    }
+
+    // Saved captures are encoded on their own threads while the next ones arrive
+    ScanParameters::ImageFormat  image_format;
+    ScanParameters::ImageThreads image_threads;
+    scan_settings.Get(&image_format);
+    scan_settings.Get(&image_threads);
+    FrameWriter frame_writer;
+    frame_writer.Start(image_format.Get(), image_threads.Get());
 
 
     // Get the camera frame rate (This assumes the camera triggers the projector!)
@@ -985,6 +1392,20 @@ void ScanObject(dlp::Camera          *camera,
 
     // Determine the total scan time
     unsigned int period_us = 1000000 / frame_rate;
+
+    // In high speed mode the projector sets the pace and triggers the camera,
+    // unless preparing the projector fell back to the default timing
+    ScanParameters::HighSpeedMode   high_speed_mode;
+    ScanParameters::HighSpeedTiming high_speed_timing;
+    scan_settings.Get(&high_speed_mode);
+    scan_settings.Get(&high_speed_timing);
+    if(high_speed_mode.Get() && high_speed_timing.Get()){
+        dlp::Parameters projector_settings;
+        dlp::DLP_Platform::Parameters::SequencePeriod sequence_period;
+        projector->GetSetup(&projector_settings);
+        projector_settings.Get(&sequence_period);
+        if(sequence_period.Get() > 0) period_us = sequence_period.Get();
+    }
     unsigned int vertical_pattern_count   = structured_light_vertical->GetTotalPatternCount();
     unsigned int horizontal_pattern_count = structured_light_horizontal->GetTotalPatternCount();
     unsigned int capture_time = 0;
@@ -1010,9 +1431,11 @@ void ScanObject(dlp::Camera          *camera,
     dlp::Image          camera_frame;
     dlp::Image::Window  camera_view;
 
-    // Open the camera view
-    dlp::CmdLine::Print("\nPlace the scanning target within the view of the camera and projector. \nPress SPACE or ESC from window when ready to scan...");
-    camera_view.Open("Place Target in View - press SPACE or ESC to scan");
+    // Open the camera view, batch runs scan the target as placed
+    if(!headless.Get()){
+        dlp::CmdLine::Print("\nPlace the scanning target within the view of the camera and projector. \nPress SPACE or ESC from window when ready to scan...");
+        camera_view.Open("Place Target in View - press SPACE or ESC to scan");
+    }
 
     // Start capturing images from the camera
     if(camera->Start().hasErrors()){
@@ -1025,7 +1448,7 @@ void ScanObject(dlp::Camera          *camera,
 
     // Wait for the space bar or ESC key to be pressed before scanning
     unsigned int return_key = 0;
-    while(return_key != ' '){
+    while(!headless.Get() && (return_key != ' ')){
         camera_frame.Clear();               // Clear the image object
         camera->GetFrame(&camera_frame);    // Grab the latest camera frame
         camera_view.Update(camera_frame);   // Display the image
@@ -1034,291 +1457,598 @@ void ScanObject(dlp::Camera          *camera,
     }
 
     // Close the image window
-    camera_view.Close();
+    if(camera_view.isOpen()) camera_view.Close();
 
 
-    // Display the instructions to use the point cloud viewer
-    dlp::CmdLine::Print();
-    dlp::CmdLine::Print("Point Cloud Viewer Operation:");
-    dlp::CmdLine::Print("i/I = Zoom in");
-    dlp::CmdLine::Print("o/O = Zoom out");
-    dlp::CmdLine::Print("s/S = Save point cloud xyz file");
-    dlp::CmdLine::Print("a/A = Auto-rotate the point cloud");
-    dlp::CmdLine::Print("c/C = Turn point cloud color on/off");
-    dlp::CmdLine::Print("\nNOTE: Press ESC key to quit the scan routine");
-    dlp::CmdLine::Print();
-//    dlp::CmdLine::PressEnterToContinue("Press ENTER after reading the above instructions...");
+    if(!headless.Get()){
+        // Display the instructions to use the point cloud viewer
+        dlp::CmdLine::Print();
+        dlp::CmdLine::Print("Point Cloud Viewer Operation:");
+        dlp::CmdLine::Print("i/I = Zoom in");
+        dlp::CmdLine::Print("o/O = Zoom out");
+        dlp::CmdLine::Print("s/S = Save point cloud xyz file");
+        dlp::CmdLine::Print("a/A = Auto-rotate the point cloud");
+        dlp::CmdLine::Print("c/C = Turn point cloud color on/off");
+        dlp::CmdLine::Print("\nNOTE: Press ESC key to quit the scan routine");
+        dlp::CmdLine::Print();
+//        dlp::CmdLine::PressEnterToContinue("Press ENTER after reading the above instructions...");
 
 
-    // Open the point cloud viewer
-    view_point_cloud.Open("Point Cloud Viewer (color based on z value) - press ESC to stop scanning...",600,400);
+        // Open the point cloud viewer
+        view_point_cloud.Open("Point Cloud Viewer (color based on z value) - press ESC to stop scanning...",600,400);
+    }
 
     // Enter the scanning loop
 	while (scan_times){
 
 		dlp::CmdLine::Print("\nStarting scan ", scan_count, "...");
+		const int view_scan_count = scan_count;
+		scan_trace.SetView((int)(data[0])+1-scan_times);
+		memory_ledger.BeginView((int)(data[0])+1-scan_times);
+		if (archive) archive->SetView((int)(data[0])+1-scan_times);
 
 		dlp::Capture::Sequence vertical_scan;
 		dlp::Capture::Sequence horizontal_scan;
 
-		//Peform images capture when both camera and projector are connected
-		//via HW trigger signal for synchronization
-		if (cam_proj_hw_synchronized == true) {
+		// Modules that decode incrementally consume each frame as it is retrieved
+		// instead of holding the whole capture sequence
+		StreamingGrayCode *streaming_vertical   = dynamic_cast<StreamingGrayCode*>(structured_light_vertical);
+		StreamingGrayCode *streaming_horizontal = dynamic_cast<StreamingGrayCode*>(structured_light_horizontal);
+		bool streaming = (!use_vertical || streaming_vertical) && (!use_horizontal || streaming_horizontal);
+		unsigned int vertical_captured   = 0;
+		unsigned int horizontal_captured = 0;
 
-			// Start capturing images from the camera
-			if (camera->Start().hasErrors()){
-				dlp::CmdLine::Print("Could NOT start camera! \n");
-				return;
-			}
-
-			// Give camera time to start capturing images
-			dlp::Time::Sleep::Milliseconds(100);
+		dlp::DisparityMap column_disparity;
+		dlp::DisparityMap row_disparity;
+		dlp::Point::Cloud point_cloud_new;
 
-			// Scan the object
-			dlp::ReturnCode sequence_return;
-			sequence_return = projector->StartPatternSequence(pattern_start, pattern_count, false);
-			if (sequence_return.hasErrors()){
-				dlp::CmdLine::Print("Sequence failed! Exiting scan routine...");
-				if (camera->Stop().hasErrors()){
-					dlp::CmdLine::Print("Camera failed to stop! Exiting scan routine...");
-				}
-				dlp::CmdLine::Print("Sequence failed..." + sequence_return.ToString());
-				return;
+		// Bring the white highlight of the target to the exposure target so
+		// dark or shiny targets do not need a rescan
+		CameraExposure scan_exposure;
+		unsigned int   exposure_count = 1;
+		const float    maximum_shutter_ms = HIGH_SPEED_SHUTTER_DUTY * period_us / 1000.0f;
+		if (auto_exposure.Get() || (dual_exposure_ratio.Get() > 0)){
+			dlp::ReturnCode exposure_return;
+			if (auto_exposure.Get()){
+				timer.Lap();
+				const unsigned int exposure_span = scan_trace.Begin("exposure");
+				exposure_return = AdjustCameraExposure(camera, projector, (unsigned char)auto_exposure_target.Get(), maximum_shutter_ms, maximum_gain.Get(), &scan_exposure);
+				scan_trace.End(exposure_span);
+				dlp::CmdLine::Print("Camera exposure set in...\t\t\t", timer.Lap(), "ms");
 			}
-
-			timer.Reset();
-
-			// Wait for the sequence to finish and add a little extra time
-			// to account for the sequence validation time required
-			dlp::Time::Sleep::Microseconds(capture_time + 10 * period_us);
-
-			// Stop grabbing images from the camera
-			if (camera->Stop().hasErrors()){
-				dlp::CmdLine::Print("Camera failed to stop! Exiting scan routine...");
-				return;
+			else{
+				exposure_return = GetCameraExposure(camera, &scan_exposure);
 			}
-			dlp::CmdLine::Print("Pattern sequence capture completed in...\t", timer.Lap(), "ms");
-			projector->StopPatternSequence();
 
-			// Grab all of the images from the buffer to find the pattern sequence
-			bool            min_images = false;
-			dlp::ReturnCode ret;
-			dlp::Capture    capture;
-			dlp::Image      capture_image;
+			if (exposure_return.hasErrors()){
+				dlp::CmdLine::Print("Camera exposure NOT adjusted: ", exposure_return.ToString());
+			}
+			else{
+				dlp::CmdLine::Print("Camera shutter and gain...\t\t\t", scan_exposure.shutter_ms, "ms ", scan_exposure.gain_db, "dB");
 
-			unsigned int iPattern = 0;
+				// The exposures are fused by the confidence the modules rate their decode with
+				const bool rated = (!use_vertical   || dynamic_cast<DecodeConfidence*>(structured_light_vertical)) &&
+				                   (!use_horizontal || dynamic_cast<DecodeConfidence*>(structured_light_horizontal));
+				if ((dual_exposure_ratio.Get() > 0) && !rated) dlp::CmdLine::Print("Dual exposure needs decode confidence, capturing one exposure...");
+				else if (dual_exposure_ratio.Get() > 0)        exposure_count = 2;
+			}
+		}
 
-			std::vector<double> capture_sums;
+		// With two exposures each is captured and decoded in full and the
+		// decodes are fused per pixel by confidence
+		dlp::DisparityMap fused_column_disparity;
+		dlp::DisparityMap fused_row_disparity;
+		dlp::Image        fused_confidence;
+		unsigned int      fused_vertical_captured   = 0;
+		unsigned int      fused_horizontal_captured = 0;
+
+		// A decoder error in either exposure fails the view like missing patterns do
+		bool decode_failed = false;
+
+		for (unsigned int iExposure = 0; iExposure < exposure_count; iExposure++){
+
+			if (iExposure > 0){
+				if (camera->isStarted()) camera->Stop();
+				SetCameraExposure(camera, ScaleExposure(scan_exposure, dual_exposure_ratio.Get(), maximum_shutter_ms, maximum_gain.Get()));
+				vertical_scan.Clear();
+				horizontal_scan.Clear();
+				dlp::CmdLine::Print("Capturing second exposure...");
+			}
 
-			while (!min_images){
+			if (streaming){
+				dlp::ReturnCode begin_return;
+				if (use_vertical)                              begin_return = streaming_vertical->BeginDecode(camera_columns, camera_rows);
+				if (use_horizontal && !begin_return.hasErrors()) begin_return = streaming_horizontal->BeginDecode(camera_columns, camera_rows);
+				if (begin_return.hasErrors()){
+					dlp::CmdLine::Print("Streaming decode NOT started: ", begin_return.ToString());
+					decode_failed = true;
+				}
+			}
 
-				capture_image.Clear();
+			// Mask background and shadow pixels for modules that decode the whole
+			// frame, the streaming modules mask with their own reference patterns
+			ScanRegion scan_region;
+			if (!streaming && (shadow_mask_contrast.Get() > 0)){
+				dlp::Image white_reference;
+				dlp::Image black_reference;
+				BitPlane   contrast_mask;
 
-				ret = camera->GetFrameBuffered(&capture_image);
-				iPattern++;
-				capture_image.ConvertToMonochrome();
-				if (ret.hasErrors()){
-					min_images = true;
-				}
-				else{
+				if (!camera->isStarted()) camera->Start();
 
-					double sum = 0;
-					capture_image.GetSum(&sum);
-					capture_sums.push_back(sum);
+				projector->ProjectSolidWhitePattern();
+				dlp::Time::Sleep::Milliseconds(100);
+				GetMonochromeFrame(camera, false, &white_reference);
 
-					// Add the frame to the sequence
-					capture.image_data = capture_image;
-					capture.data_type = dlp::Capture::DataType::IMAGE_DATA;
-					capture_scan.Add(capture);
-					capture_image.Clear();
-					capture.image_data.Clear();
+				projector->ProjectSolidBlackPattern();
+				dlp::Time::Sleep::Milliseconds(100);
+				GetMonochromeFrame(camera, false, &black_reference);
 
+				// Contrasts above full scale mask every pixel, so they are clamped to it
+				const unsigned char contrast = (shadow_mask_contrast.Get() > 255) ? 255 : (unsigned char)shadow_mask_contrast.Get();
+				if (!ComputeContrastMask(&white_reference, &black_reference, contrast, &contrast_mask).hasErrors()){
+					scan_region.Build(contrast_mask);
+					dlp::CmdLine::Print("Scan region covers...\t\t\t\t", 100 * scan_region.GetCoverage(), "%");
 				}
-
 			}
 
-			dlp::CmdLine::Print("Images retreived from buffer in...\t\t", timer.Lap(), "ms");
-
-			// Find  the first pattern and the seperate the vertical and horizontal patterns
+			// Frames are held by pattern index and taken out in pattern order, so a
+			// missed or saturated pattern can be re-captured on its own below
+			PatternSlots pattern_slots;
+			const bool save_captures = !streaming || !packed_capture_archive.Get();
+
+			// Streaming decoders hold packed planes only, full frames which would
+			// not fit in the memory budget are spilled to their saved files
+			memory_ledger.BeginStage("capture");
+			const unsigned long long capture_bytes = (unsigned long long)((use_vertical ? vertical_pattern_count : 0) +
+			                                                              (use_horizontal ? horizontal_pattern_count : 0)) * camera_columns * camera_rows;
+			const bool spill_captures = !streaming && memory_ledger.isOverBudget(capture_bytes);
+			if (spill_captures) dlp::CmdLine::Print("Memory budget exceeded, spilling captures to disk...");
+			pattern_slots.Reset(pattern_count, recapture_saturated_percent.Get());
+
+			// The white reference leading each streaming Gray code direction is
+			// bright by design, only the coded patterns are checked for saturation
+			if (use_vertical && streaming_vertical)     pattern_slots.ExemptFromSaturation(0);
+			if (use_horizontal && streaming_horizontal) pattern_slots.ExemptFromSaturation(use_vertical ? vertical_pattern_count : 0);
 			vertical_scan.Clear();
 			horizontal_scan.Clear();
 
-			bool first_pattern_found = false;
-			unsigned int capture_offset = 0;
-			unsigned int vertical_patterns_added = 0;
-			unsigned int horizontal_patterns_added = 0;
-			double previous_sum = 0;
+			//Peform images capture when both camera and projector are connected
+			//via HW trigger signal for synchronization
+			if (cam_proj_hw_synchronized == true) {
+
+				// High speed sequences trigger each exposure from the projector, the
+				// camera runs free again for the re-captures and previews after it
+				const bool      camera_triggered = high_speed_mode.Get() && high_speed_timing.Get();
+				dlp::Parameters free_running_settings;
+				if (camera_triggered){
+					dlp::ReturnCode trigger_return = StartTriggeredCamera(camera, period_us, &free_running_settings);
+					if (trigger_return.hasErrors()){
+						dlp::CmdLine::Print("Camera trigger NOT set up! Exiting scan routine...");
+						dlp::CmdLine::Print(trigger_return.ToString());
+						return;
+					}
+				}
+				ScopeExit restore_camera([&](){
+					if (camera_triggered) RestoreCamera(camera, free_running_settings);
+				});
+
+				// Start capturing images from the camera
+				if (camera->Start().hasErrors()){
+					dlp::CmdLine::Print("Could NOT start camera! \n");
+					return;
+				}
+
+				// Give camera time to start capturing images
+				dlp::Time::Sleep::Milliseconds(100);
 
-			timer.Lap();
+				// Retrieve and timestamp the frames while the sequence runs, frames
+				// retrieved before the sequence is started are pre-roll and dropped
+				FrameGrabber frame_grabber;
+				if (timestamp_alignment.Get() && frame_grabber.Start(camera, GetTimestampMicroseconds()).hasErrors()){
+					dlp::CmdLine::Print("Frame grabber failed to start, aligning by brightness...");
+				}
 
-			for (unsigned int iScan = 0; iScan < capture_scan.GetCount(); iScan++){
+				// Scan the object
+				const unsigned int capture_span = scan_trace.Begin("capture");
+				dlp::ReturnCode sequence_return;
+				sequence_return = projector->StartPatternSequence(pattern_start, pattern_count, false);
+				unsigned long long sequence_start_us = GetTimestampMicroseconds();
+				if (sequence_return.hasErrors()){
+					frame_grabber.Stop();
+					dlp::CmdLine::Print("Sequence failed! Exiting scan routine...");
+					if (camera->Stop().hasErrors()){
+						dlp::CmdLine::Print("Camera failed to stop! Exiting scan routine...");
+					}
+					dlp::CmdLine::Print("Sequence failed..." + sequence_return.ToString());
+					return;
+				}
 
-				// Calculate the average for the image to determine if the pattern started
-				if (!first_pattern_found){
+				timer.Reset();
 
-					// Retrieve the image sum value
-					double sum = capture_sums.at(iScan);
+				// Wait for the sequence to finish and add a little extra time
+				// to account for the sequence validation time required
+				dlp::Time::Sleep::Microseconds(capture_time + 10 * period_us);
+				frame_grabber.Stop();
 
-					if (iScan == 0){
-						previous_sum = sum;
+				// Stop grabbing images from the camera
+				if (camera->Stop().hasErrors()){
+					dlp::CmdLine::Print("Camera failed to stop! Exiting scan routine...");
+					return;
+				}
+				dlp::CmdLine::Print("Pattern sequence capture completed in...\t", timer.Lap(), "ms");
+				projector->StopPatternSequence();
+				scan_trace.End(capture_span);
+				const unsigned int drain_span = scan_trace.Begin("drain");
+
+				// Grab all of the images from the buffer to find the pattern sequence
+				bool            min_images = false;
+				dlp::ReturnCode ret;
+				dlp::Image      capture_image;
+
+				unsigned int iPattern = 0;
+
+				bool first_pattern_found = false;
+				unsigned int capture_offset = 0;
+				double previous_sum = 0;
+
+				// Frames already retrieved by the grabber come first. The first
+				// pattern is the first frame retrieved after the sequence started,
+				// unless the first brightness step is on another frame. Driver
+				// buffering delays retrieval, so the step is trusted over the
+				// timestamps when both are found.
+				std::vector<TimestampedFrame> &grabbed_frames = frame_grabber.GetFrames();
+				if (!grabbed_frames.empty()){
+					int       first_frame = AlignByTimestamp(grabbed_frames, sequence_start_us, pattern_count);
+					const int step_frame  = AlignByBrightness(grabbed_frames, frame_grabber.GetPrerollSum(), pattern_count);
+					if ((first_frame < 0) || ((step_frame >= 0) && (step_frame != first_frame))){
+						dlp::CmdLine::Print("Frame timestamps do not match the sequence, aligning by brightness...");
+						first_frame = step_frame;
+					}
+					if (first_frame >= 0){
+						first_pattern_found = true;
+						capture_offset = first_frame;
 					}
-					else if (previous_sum != 0)
-					{
-						// If the percent error is greater than 10% the first pattern has been found
-						if (sum > (previous_sum * 1.1)){
-							first_pattern_found = true;
-							capture_offset = iScan;
+					else{
+						previous_sum = grabbed_frames.back().sum;
+					}
+
+					for (unsigned int iFrame = 0; iFrame < grabbed_frames.size(); iFrame++){
+						if (first_pattern_found && (iFrame >= capture_offset)){
+							pattern_slots.Set(iFrame - capture_offset, &grabbed_frames[iFrame].image);
+							TakePatternFrames(&pattern_slots, use_vertical ? vertical_pattern_count : 0, streaming,
+							                  streaming_vertical, streaming_horizontal, &vertical_scan, &horizontal_scan, save_captures, spill_captures, archive, &frame_writer, images_directory.Get(), &decode_failed);
 						}
-						previous_sum = sum;
+						grabbed_frames[iFrame].image.Clear();
 					}
+					iPattern = grabbed_frames.size();
+					grabbed_frames.clear();
 				}
 
-				if (first_pattern_found){
-					if ((capture_offset + pattern_count) < capture_scan.GetCount()){
-
-						dlp::Capture temp;
-						capture_scan.Get(iScan, &temp);
+				while (!min_images){
 
+					capture_image.Clear();
 
-						if (use_vertical && (vertical_patterns_added < vertical_pattern_count)){
-							// Add vertical patterns
-							vertical_scan.Add(temp);
-							temp.image_data.Save("output/scan_images/scan_capture_" + dlp::Number::ToString(iScan - capture_offset) + ".bmp");
-							vertical_patterns_added++;
-						}
-						else if (use_horizontal && (horizontal_patterns_added < horizontal_pattern_count)){
-							// Add horizontal patterns
-							horizontal_scan.Add(temp);
-							temp.image_data.Save("output/scan_images/scan_capture_" + dlp::Number::ToString(iScan - capture_offset) + ".bmp");
-							horizontal_patterns_added++;
+					// Convert to monochrome and sum the frame in a single pass
+					double sum = 0;
+					ret = GetMonochromeFrame(camera, true, &capture_image, &sum);
+					iPattern++;
+					if (ret.hasErrors()){
+						min_images = true;
+					}
+					else{
+
+						// If the frame is 10% brighter than the one before it the
+						// first pattern has been found
+						if (!first_pattern_found){
+							if (previous_sum == 0){
+								previous_sum = sum;
+							}
+							else{
+								if (sum > (previous_sum * 1.1)){
+									first_pattern_found = true;
+									capture_offset = iPattern - 1;
+								}
+								previous_sum = sum;
+							}
 						}
 
-						temp.image_data.Clear();
+						// Frames past the end of the sequence are rejected by the slots
+						if (first_pattern_found){
+							pattern_slots.Set(iPattern - 1 - capture_offset, &capture_image);
+							TakePatternFrames(&pattern_slots, use_vertical ? vertical_pattern_count : 0, streaming,
+							                  streaming_vertical, streaming_horizontal, &vertical_scan, &horizontal_scan, save_captures, spill_captures, archive, &frame_writer, images_directory.Get(), &decode_failed);
+						}
+						capture_image.Clear();
 					}
 				}
-			}
-		}
-		else {
-			//Perform images capture with camera is in free running mode i.e.,
-			//if they are not synchronized via HW trigger signal
-			// Project a black screen
-			projector->ProjectSolidBlackPattern();
-			dlp::Time::Sleep::Milliseconds(100);
-
-			// Start capturing images from the camera
-			if (camera->Start().hasErrors()){
-				dlp::CmdLine::Print("Could NOT start camera! \n");
-				return;
-			}
 
-			timer.Reset();
+				dlp::CmdLine::Print("Images retreived from buffer in...\t\t", timer.Lap(), "ms");
+				scan_trace.AddCounter(drain_span, SCAN_TRACE_COUNTER_FRAMES, iPattern - 1);
+				scan_trace.AddCounter(drain_span, SCAN_TRACE_COUNTER_BYTES, (unsigned long long)(iPattern - 1) * camera_columns * camera_rows);
+				scan_trace.End(drain_span);
+			}
+			else {
+				//Perform images capture with camera is in free running mode i.e.,
+				//if they are not synchronized via HW trigger signal
+				// Project a black screen
+				projector->ProjectSolidBlackPattern();
+				dlp::Time::Sleep::Milliseconds(100);
 
-			// Grab all of the images from the buffer to find the pattern sequence
-			bool            min_images = false;
-			dlp::ReturnCode ret;
-			dlp::Capture    capture;
-			dlp::Image      capture_image;
+				// Start capturing images from the camera
+				if (camera->Start().hasErrors()){
+					dlp::CmdLine::Print("Could NOT start camera! \n");
+					return;
+				}
 
-			unsigned int iPattern = 0;
+				timer.Reset();
+				const unsigned int capture_span = scan_trace.Begin("capture");
 
-			while (!min_images){
+				// Grab all of the images from the buffer to find the pattern sequence
+				bool            min_images = false;
+				dlp::ReturnCode ret;
+				dlp::Image      capture_image;
 
-				capture_image.Clear();
+				unsigned int iPattern = 0;
 
-				// Display each pattern
-				projector->DisplayPatternInSequence(pattern_start + iPattern, true);
-				iPattern++;
+				// Batched display starts the whole sub-sequence once on the projector's
+				// own timing and matches frames to patterns by when they were grabbed
+				if (batched_pattern_display.Get()){
+					dlp::Parameters projector_settings;
+					dlp::DLP_Platform::Parameters::SequencePeriod sequence_period;
+					projector->GetSetup(&projector_settings);
+					projector_settings.Get(&sequence_period);
 
-				dlp::Time::Sleep::Milliseconds(100);
+					// A frame must be exposed and delivered while its pattern is shown, with
+					// a frame period either side for the error of the time line's start
+					const unsigned long long frame_period_us = (unsigned long long)(1000000 / frame_rate);
+					double black_sum = 0;
+					capture_image.Clear();
+					if (sequence_period.Get() < 4 * frame_period_us){
+						dlp::CmdLine::Print("Pattern period too short for batched display, displaying each pattern...");
+					}
+					else if (GetMonochromeFrame(camera, false, &capture_image, &black_sum).hasErrors() || (black_sum <= 0)){
+						dlp::CmdLine::Print("Black screen NOT captured, displaying each pattern...");
+					}
+					else if (!projector->StartPatternSequence(pattern_start, pattern_count, false).hasErrors()){
+						// The projector validates the sequence before showing it, so the time
+						// line starts from the first frame brighter than the black screen
+						// rather than from when the start command returned. Until then the
+						// deadline allows for the validation like the triggered capture does.
+						const unsigned long long started = GetTimestampMicroseconds();
+						unsigned long long deadline = started + (pattern_count + 10) * sequence_period.Get();
+						PatternTimeline timeline;
+						bool stamped = false;
+
+						// Each frame goes to the pattern it was exposed under, so a missed pattern
+						// window only leaves that pattern for the re-capture below
+						std::vector<bool> pattern_matched(pattern_count, false);
+						while ((iPattern < pattern_count) && (GetTimestampMicroseconds() < deadline)){
+							capture_image.Clear();
+							double sum = 0;
+							if (GetMonochromeFrame(camera, false, &capture_image, &sum).hasErrors()) continue;
+
+							// The latest frame was exposed within the last two frame periods
+							const unsigned long long grabbed = GetTimestampMicroseconds();
+							int matched = 0;
+							if (!stamped){
+								if (sum <= black_sum * FRAME_ALIGNMENT_BRIGHTNESS_STEP) continue;
+
+								// The first pattern came on during this frame's exposure
+								timeline.Start(pattern_count, sequence_period.Get(), grabbed - frame_period_us);
+								deadline = timeline.GetEndTime() + 2 * frame_period_us;
+								stamped  = true;
+							}
+							else{
+								matched = timeline.GetPatternDuring(grabbed - 3 * frame_period_us, grabbed + frame_period_us);
+								if (matched < 0) continue;
+							}
+
+							if (!pattern_slots.Set(matched, &capture_image).hasErrors() && !pattern_matched[matched]){
+								pattern_matched[matched] = true;
+								iPattern++;
+							}
+							TakePatternFrames(&pattern_slots, use_vertical ? vertical_pattern_count : 0, streaming,
+							                  streaming_vertical, streaming_horizontal, &vertical_scan, &horizontal_scan, save_captures, spill_captures, archive, &frame_writer, images_directory.Get(), &decode_failed);
+							capture_image.Clear();
+						}
 
-				// Grab the most recent camera image
-				ret = camera->GetFrame(&capture_image);
-				capture_image.ConvertToMonochrome();
+						projector->StopPatternSequence();
+						dlp::CmdLine::Print("Patterns matched to frames...\t\t\t", iPattern, "/", pattern_count);
 
-				if (ret.hasErrors()){
-					// Check if the buffer is empty
-					if (ret.ContainsError(OPENCV_CAM_IMAGE_BUFFER_EMPTY)){
+						// Every pattern has been displayed once
 						min_images = true;
 					}
 				}
-				else{
-					// Add the frame to the sequence
-					capture.image_data = capture_image;
-					capture.data_type = dlp::Capture::DataType::IMAGE_DATA;
-					capture_scan.Add(capture);
+
+				while (!min_images){
+
 					capture_image.Clear();
-					capture.image_data.Clear();
-				}
 
-				if (iPattern == pattern_count) min_images = true;
-			}
+					// Display each pattern
+					projector->DisplayPatternInSequence(pattern_start + iPattern, true);
+					iPattern++;
 
-			dlp::CmdLine::Print("Pattern sequence capture completed in...\t", timer.Lap(), "ms");
+					dlp::Time::Sleep::Milliseconds(100);
 
-			// Restart the camera so that the white pattern will display during processing
-			projector->ProjectSolidWhitePattern();
-			camera->Start();
+					// Grab the most recent camera image
+					ret = GetMonochromeFrame(camera, false, &capture_image);
 
-			// Find  the first pattern and the seperate the vertical and horizontal patterns
-			vertical_scan.Clear();
-			horizontal_scan.Clear();
+					if (ret.hasErrors()){
+						// Check if the buffer is empty
+						if (ret.ContainsError(OPENCV_CAM_IMAGE_BUFFER_EMPTY)){
+							min_images = true;
+						}
+					}
+					else{
+						// Frames arrive in pattern order
+						pattern_slots.Set(iPattern - 1, &capture_image);
+						TakePatternFrames(&pattern_slots, use_vertical ? vertical_pattern_count : 0, streaming,
+						                  streaming_vertical, streaming_horizontal, &vertical_scan, &horizontal_scan, save_captures, spill_captures, archive, &frame_writer, images_directory.Get(), &decode_failed);
+						capture_image.Clear();
+					}
 
-			unsigned int capture_offset = 0;
-			unsigned int vertical_patterns_added = 0;
-			unsigned int horizontal_patterns_added = 0;
+					if (iPattern == pattern_count) min_images = true;
+				}
 
-			timer.Lap();
+				dlp::CmdLine::Print("Pattern sequence capture completed in...\t", timer.Lap(), "ms");
+				scan_trace.AddCounter(capture_span, SCAN_TRACE_COUNTER_FRAMES, iPattern);
+				scan_trace.AddCounter(capture_span, SCAN_TRACE_COUNTER_BYTES, (unsigned long long) iPattern * camera_columns * camera_rows);
+				scan_trace.End(capture_span);
 
-			for (unsigned int iScan = 0; iScan < capture_scan.GetCount(); iScan++){
-				dlp::Capture temp;
-				capture_scan.Get(iScan, &temp);
+				// Restart the camera so that the white pattern will display during processing
+				projector->ProjectSolidWhitePattern();
+				camera->Start();
+			}
 
-				if (use_vertical && (vertical_patterns_added < vertical_pattern_count)){
-					// Add vertical patterns
-					vertical_scan.Add(temp);
-					temp.image_data.Save("output/scan_images/scan_capture_" + dlp::Number::ToString(iScan - capture_offset) + ".bmp");
-					vertical_patterns_added++;
-				}
-				else if (use_horizontal && (horizontal_patterns_added < horizontal_pattern_count)){
-					// Add horizontal patterns
-					horizontal_scan.Add(temp);
-					temp.image_data.Save("output/scan_images/scan_capture_" + dlp::Number::ToString(iScan - capture_offset) + ".bmp");
-					horizontal_patterns_added++;
+			// Display and capture the patterns which were missed or saturated one at
+			// a time, too many missing patterns means the view needs a full rescan
+			const unsigned int sort_span = scan_trace.Begin("sort");
+			std::vector<unsigned int> missing_patterns = pattern_slots.GetMissing();
+			if (!missing_patterns.empty() && (missing_patterns.size() <= maximum_recaptures.Get())){
+				dlp::CmdLine::Print("Re-capturing missing patterns...\t\t", missing_patterns.size());
+				timer.Lap();
+				const unsigned int recapture_span = scan_trace.Begin("recapture");
+				scan_trace.AddCounter(recapture_span, SCAN_TRACE_COUNTER_FRAMES, missing_patterns.size());
+
+				if (!camera->isStarted()) camera->Start();
+
+				dlp::Image recapture_image;
+				for (unsigned int iMissing = 0; iMissing < missing_patterns.size(); iMissing++){
+					projector->DisplayPatternInSequence(pattern_start + missing_patterns.at(iMissing), true);
+					dlp::Time::Sleep::Milliseconds(100);
+
+					recapture_image.Clear();
+					if (GetMonochromeFrame(camera, false, &recapture_image).hasErrors()) continue;
+					pattern_slots.Set(missing_patterns.at(iMissing), &recapture_image);
 				}
+				recapture_image.Clear();
+				projector->ProjectSolidWhitePattern();
+
+				// Splice the re-captured frames in and decode everything after them
+				TakePatternFrames(&pattern_slots, use_vertical ? vertical_pattern_count : 0, streaming,
+				                  streaming_vertical, streaming_horizontal, &vertical_scan, &horizontal_scan, save_captures, spill_captures, archive, &frame_writer, images_directory.Get(), &decode_failed);
+				dlp::CmdLine::Print("Patterns re-captured in...\t\t\t", timer.Lap(), "ms");
+				scan_trace.End(recapture_span);
+			}
+
+			dlp::CmdLine::Print("Patterns sorted in...\t\t\t\t", timer.Lap(), "ms");
+			scan_trace.End(sort_span);
 
-				temp.image_data.Clear();
+			if (streaming){
+				if (use_vertical)   vertical_captured   = streaming_vertical->GetCapturesAdded();
+				if (use_horizontal) horizontal_captured = streaming_horizontal->GetCapturesAdded();
+				memory_ledger.Set(MEMORY_BUFFER_PACKED, (use_vertical   ? streaming_vertical->GetPackedCaptures().GetByteCount()   : 0) +
+				                                        (use_horizontal ? streaming_horizontal->GetPackedCaptures().GetByteCount() : 0));
+			}
+			else{
+				vertical_captured   = vertical_scan.GetCount();
+				horizontal_captured = horizontal_scan.GetCount();
+				memory_ledger.Set(MEMORY_BUFFER_CAPTURES, MemoryLedger::GetBytes(vertical_scan) + MemoryLedger::GetBytes(horizontal_scan));
+			}
+			memory_ledger.BeginStage("decode");
+
+			column_disparity.Clear();
+			row_disparity.Clear();
+
+			if (use_vertical && (vertical_pattern_count == vertical_captured)){
+				timer.Lap();
+				const unsigned int decode_span = scan_trace.Begin("decode_vertical");
+				scan_trace.AddCounter(decode_span, SCAN_TRACE_COUNTER_FRAMES, vertical_captured);
+				dlp::ReturnCode decode_return;
+				if (streaming) decode_return = streaming_vertical->EndDecode(&column_disparity);
+				else decode_return = structured_light_vertical->DecodeCaptureSequence(&vertical_scan, &column_disparity);
+				if (decode_return.hasErrors()){
+					dlp::CmdLine::Print("Vertical patterns NOT decoded: ", decode_return.ToString());
+					column_disparity.Clear();
+					decode_failed = true;
+				}
+				if (scan_region.GetRows() > 0) ApplyScanRegion(scan_region, &column_disparity);
+				memory_ledger.Set(MEMORY_BUFFER_DISPARITY, MemoryLedger::GetBytes(column_disparity));
+
+				// The frames are not needed once decoded
+				vertical_scan.Clear();
+				memory_ledger.Set(MEMORY_BUFFER_CAPTURES, MemoryLedger::GetBytes(horizontal_scan));
+				scan_trace.End(decode_span);
+				dlp::CmdLine::Print("Vertical patterns decoded in...\t\t\t", timer.Lap(), "ms");
 			}
 
-		}
 
-		capture_scan.Clear();
-		dlp::CmdLine::Print("Patterns sorted in...\t\t\t\t", timer.Lap(), "ms");
+			if (use_horizontal && (horizontal_pattern_count == horizontal_captured)){
+				timer.Lap();
+				const unsigned int decode_span = scan_trace.Begin("decode_horizontal");
+				scan_trace.AddCounter(decode_span, SCAN_TRACE_COUNTER_FRAMES, horizontal_captured);
+				dlp::ReturnCode decode_return;
+				if (streaming) decode_return = streaming_horizontal->EndDecode(&row_disparity);
+				else decode_return = structured_light_horizontal->DecodeCaptureSequence(&horizontal_scan, &row_disparity);
+				if (decode_return.hasErrors()){
+					dlp::CmdLine::Print("Horizontal patterns NOT decoded: ", decode_return.ToString());
+					row_disparity.Clear();
+					decode_failed = true;
+				}
+				if (scan_region.GetRows() > 0) ApplyScanRegion(scan_region, &row_disparity);
+				memory_ledger.Set(MEMORY_BUFFER_DISPARITY, MemoryLedger::GetBytes(column_disparity) + MemoryLedger::GetBytes(row_disparity));
 
-		dlp::DisparityMap column_disparity;
-		dlp::DisparityMap row_disparity;
-		dlp::Point::Cloud point_cloud_new;
+				horizontal_scan.Clear();
+				memory_ledger.Set(MEMORY_BUFFER_CAPTURES, 0);
+				scan_trace.End(decode_span);
+				dlp::CmdLine::Print("Horizontal patterns decoded in...\t\t", timer.Lap(), "ms");
+			}
 
-		column_disparity.Clear();
-		row_disparity.Clear();
+			// Confidence of the decoded pixels, the lower of both directions
+			confidence_map.Clear();
+			DecodeConfidence *rated_vertical   = dynamic_cast<DecodeConfidence*>(structured_light_vertical);
+			DecodeConfidence *rated_horizontal = dynamic_cast<DecodeConfidence*>(structured_light_horizontal);
+			if (use_vertical && rated_vertical && !column_disparity.isEmpty()){
+				dlp::Image confidence;
+				if (!rated_vertical->GetConfidenceMap(&confidence).hasErrors()) CombineConfidence(&confidence, &confidence_map);
+			}
+			if (use_horizontal && rated_horizontal && !row_disparity.isEmpty()){
+				dlp::Image confidence;
+				if (!rated_horizontal->GetConfidenceMap(&confidence).hasErrors()) CombineConfidence(&confidence, &confidence_map);
+			}
+
+			memory_ledger.Set(MEMORY_BUFFER_CONFIDENCE, MemoryLedger::GetBytes(confidence_map));
 
-		if (use_vertical && (vertical_pattern_count == vertical_scan.GetCount())){
-			timer.Lap();
-			structured_light_vertical->DecodeCaptureSequence(&vertical_scan, &column_disparity);
-			dlp::CmdLine::Print("Vertical patterns decoded in...\t\t\t", timer.Lap(), "ms");
+			if (exposure_count > 1){
+				dlp::ReturnCode fuse_return = FuseExposureDecodes(&column_disparity, &row_disparity, &confidence_map, &fused_column_disparity, &fused_row_disparity, &fused_confidence);
+				if (fuse_return.hasErrors()) dlp::CmdLine::Print("Exposure NOT fused: ", fuse_return.ToString());
+				if (vertical_captured   > fused_vertical_captured)   fused_vertical_captured   = vertical_captured;
+				if (horizontal_captured > fused_horizontal_captured) fused_horizontal_captured = horizontal_captured;
+			}
 		}
 
+		if (exposure_count > 1){
+			column_disparity   = fused_column_disparity;
+			row_disparity      = fused_row_disparity;
+			confidence_map     = fused_confidence;
+			vertical_captured   = fused_vertical_captured;
+			horizontal_captured = fused_horizontal_captured;
 
-		if (use_horizontal && (horizontal_pattern_count == horizontal_scan.GetCount())){
-			timer.Lap();
-			structured_light_horizontal->DecodeCaptureSequence(&horizontal_scan, &row_disparity);
-			dlp::CmdLine::Print("Horizontal patterns decoded in...\t\t", timer.Lap(), "ms");
+			// Back to the first exposure for the next scan
+			if (camera->isStarted()) camera->Stop();
+			SetCameraExposure(camera, scan_exposure);
 		}
 
-		if (use_vertical && (!use_horizontal)){
+		// Drop low confidence pixels before they are triangulated
+		if ((minimum_confidence.Get() > 0) && !confidence_map.isEmpty()){
+			const unsigned char minimum = (unsigned char)((minimum_confidence.Get() > 255) ? 255 : minimum_confidence.Get());
+			unsigned long long removed_columns = 0;
+			unsigned long long removed_rows    = 0;
+			if (!column_disparity.isEmpty()) FilterDisparityByConfidence(&confidence_map, minimum, &column_disparity, &removed_columns);
+			if (!row_disparity.isEmpty())    FilterDisparityByConfidence(&confidence_map, minimum, &row_disparity, &removed_rows);
+			dlp::CmdLine::Print("Low confidence pixels removed...\t\t", removed_columns + removed_rows);
+		}
+
+		const unsigned int triangulate_span = scan_trace.Begin("triangulate");
+		memory_ledger.BeginStage("triangulate");
+		if (decode_failed){
+			dlp::CmdLine::Print("Patterns NOT decoded. Please rescan. \n");
+		}
+		else if (use_vertical && (!use_horizontal)){
 			// Use vertical patterns only
 
 			// Check that there are enough patterns to decode
-			if (vertical_pattern_count != vertical_scan.GetCount()){
+			if (vertical_pattern_count != vertical_captured){
 				dlp::CmdLine::Print("NOT enough images. Scans may have been too dark. Please rescan. \n");
 			}
 			else{
@@ -1332,7 +2062,7 @@ void ScanObject(dlp::Camera          *camera,
 			// Use horizontal patterns only
 
 			// Check that there are enough patterns to decode
-			if (horizontal_pattern_count != horizontal_scan.GetCount()){
+			if (horizontal_pattern_count != horizontal_captured){
 				dlp::CmdLine::Print("NOT enough images. Scans may have been too dark. Please rescan. \n");
 			}
 			else{
@@ -1346,8 +2076,8 @@ void ScanObject(dlp::Camera          *camera,
 			// Use both vertical and horizontal
 
 			// Check that there are enough patterns to decode
-			if ((structured_light_vertical->GetTotalPatternCount() != vertical_scan.GetCount()) ||
-				(structured_light_horizontal->GetTotalPatternCount() != horizontal_scan.GetCount())){
+			if ((structured_light_vertical->GetTotalPatternCount() != vertical_captured) ||
+				(structured_light_horizontal->GetTotalPatternCount() != horizontal_captured)){
 				dlp::CmdLine::Print("NOT enough images. Scans may have been too dark. Please rescan. \n");
 			}
 			else{
@@ -1358,17 +2088,40 @@ void ScanObject(dlp::Camera          *camera,
 			}
 		}
 
+		if (scan_count > view_scan_count) scan_trace.AddCounter(triangulate_span, SCAN_TRACE_COUNTER_POINTS, point_cloud.GetCount());
+		scan_trace.End(triangulate_span);
+		memory_ledger.Set(MEMORY_BUFFER_POINT_CLOUD, MemoryLedger::GetBytes(point_cloud));
+		memory_ledger.Set(MEMORY_BUFFER_DEPTH_MAP, MemoryLedger::GetBytes(depth_map));
+
+		// Publish the reconstruction before any file is written
+		if (result_channel && (scan_count > view_scan_count)){
+			const unsigned int publish_span = scan_trace.Begin("publish");
+			dlp::ReturnCode ret_channel = result_channel->Publish(point_cloud, &depth_map, (int)(data[0])+1-scan_times);
+			if (ret_channel.hasErrors()) dlp::CmdLine::Print("Result NOT published: ", ret_channel.ToString());
+			scan_trace.AddCounter(publish_span, SCAN_TRACE_COUNTER_POINTS, point_cloud.GetCount());
+			scan_trace.End(publish_span);
+		}
+
 		// Update viewers
-		view_point_cloud.Update(point_cloud);
+		if (view_point_cloud.isOpen()) view_point_cloud.Update(point_cloud);
 
 		// Check if the point cloud viewer is open or the scan should
 		// only be performed once
 
+		// The decoded maps are archived before they are cleared
+		if (archive){
+			if (!column_disparity.isEmpty()) archive->AppendDisparityMap(SCAN_ARCHIVE_CHUNK_COLUMN_DISPARITY, column_disparity);
+			if (!row_disparity.isEmpty())    archive->AppendDisparityMap(SCAN_ARCHIVE_CHUNK_ROW_DISPARITY, row_disparity);
+			if (!confidence_map.isEmpty())   archive->AppendImage(SCAN_ARCHIVE_CHUNK_CONFIDENCE, 0, confidence_map);
+		}
+
 		// Clear variables
 		vertical_scan.Clear();
 		horizontal_scan.Clear();
 		column_disparity.Clear();
 		row_disparity.Clear();
+		memory_ledger.Set(MEMORY_BUFFER_CAPTURES, 0);
+		memory_ledger.Set(MEMORY_BUFFER_DISPARITY, 0);
 
 
 		// Wait for the view to close
@@ -1388,16 +2141,70 @@ void ScanObject(dlp::Camera          *camera,
 		unsigned int save_data = 0;
 		//if(!dlp::CmdLine::Get(save_data,"Select option: ")) save_data = 0;
 		save_data = 1;//zk
+		std::vector<std::string> view_outputs;
 		if (save_data == 1){
 			std::string file_time = dlp::Number::ToString((int)(data[0])+1-scan_times);//zk
+			const unsigned int save_span = scan_trace.Begin("save");
+			scan_trace.AddCounter(save_span, SCAN_TRACE_COUNTER_POINTS, point_cloud.GetCount());
+			memory_ledger.BeginStage("save");
 
 			dlp::CmdLine::Print();
 			dlp::CmdLine::Print("Saving depth color map...");
 			dlp::Geometry::ConvertDistanceMapToColor(depth_map, &color_map);
-			color_map.Save("output/scan_data/" + file_time + "_color_map.bmp");
+			memory_ledger.Set(MEMORY_BUFFER_COLOR_MAP, MemoryLedger::GetBytes(color_map));
+			if (archive) archive->AppendImage(SCAN_ARCHIVE_CHUNK_COLOR_MAP, 0, color_map);
+			else         color_map.Save(data_directory.Get() + file_time + "_color_map.bmp");
+			view_outputs.push_back(archive ? archive_file : data_directory.Get() + file_time + "_color_map.bmp");
+			color_map.Clear();
+			memory_ledger.Set(MEMORY_BUFFER_COLOR_MAP, 0);
 
 			dlp::CmdLine::Print("Saving point cloud...");
-			point_cloud.SaveXYZ("output/scan_data/" + file_time + "_point_cloud.xyz", ' ');
+			if (archive){
+				dlp::ReturnCode ret_archive;
+				if (!depth_map.isEmpty()) ret_archive = archive->AppendImage(SCAN_ARCHIVE_CHUNK_DEPTH_MAP, 0, depth_map);
+				if (!ret_archive.hasErrors()) ret_archive = archive->AppendPointCloud(point_cloud);
+				if (!ret_archive.hasErrors()) ret_archive = archive->Flush();
+				if (ret_archive.hasErrors()) dlp::CmdLine::Print("Scan archive NOT updated: ", ret_archive.ToString());
+			}
+			else{
+				point_cloud.SaveXYZ(data_directory.Get() + file_time + "_point_cloud.xyz", ' ');
+				view_outputs.push_back(data_directory.Get() + file_time + "_point_cloud.xyz");
+			}
+			if (save_ply.Get()){
+				dlp::ReturnCode ret_ply = SavePLY(data_directory.Get() + file_time + "_point_cloud.ply", point_cloud, true);
+				if (ret_ply.hasErrors()) dlp::CmdLine::Print("PLY point cloud NOT saved: ", ret_ply.ToString());
+				else                     view_outputs.push_back(data_directory.Get() + file_time + "_point_cloud.ply");
+			}
+			if (views_saved && (scan_count > view_scan_count)) (*views_saved)++;
+
+			if (save_confidence.Get() && !confidence_map.isEmpty()){
+				dlp::CmdLine::Print("Saving point confidence...");
+				dlp::ReturnCode ret_confidence = SaveXYZConfidence(data_directory.Get() + file_time + "_point_cloud.xyzc", point_cloud, &depth_map, &confidence_map, ' ');
+				if (ret_confidence.hasErrors()) dlp::CmdLine::Print("Point confidence NOT saved: ", ret_confidence.ToString());
+				else                            view_outputs.push_back(data_directory.Get() + file_time + "_point_cloud.xyzc");
+			}
+
+			if (streaming && packed_capture_archive.Get()){
+				dlp::CmdLine::Print("Saving packed captures...");
+				if (use_vertical)   streaming_vertical->GetPackedCaptures().Save(images_directory.Get() + file_time + "_vertical.bits");
+				if (use_horizontal) streaming_horizontal->GetPackedCaptures().Save(images_directory.Get() + file_time + "_horizontal.bits");
+			}
+			scan_trace.End(save_span);
+		}
+
+		// Every capture of the view is on disk before the table turns
+		unsigned long long frame_bytes = 0;
+		unsigned long long file_bytes  = 0;
+		dlp::ReturnCode frame_return = frame_writer.Finish(&frame_bytes, &file_bytes);
+		if (frame_return.hasErrors()) dlp::CmdLine::Print("Scan captures NOT saved: ", frame_return.ToString());
+		if (file_bytes > 0) dlp::CmdLine::Print("Scan capture files...\t\t\t\t", file_bytes / 1024, "KB, ", (float) frame_bytes / file_bytes, "x smaller than frames");
+		dlp::CmdLine::Print("Scan buffer high-water mark...\t\t\t", memory_ledger.GetViewPeak() / 1048576, "MB");
+
+		// The view is done before the table turns, a restart resumes after it
+		if (checkpoint_scans.Get()){
+			checkpoint.FinishView((int)(data[0])+1-scan_times, (save_data == 1) && (scan_count > view_scan_count), view_outputs);
+			dlp::ReturnCode checkpoint_return = checkpoint.Save(checkpoint_file);
+			if (checkpoint_return.hasErrors()) dlp::CmdLine::Print("Scan checkpoint NOT saved: ", checkpoint_return.ToString());
 		}
 
 		if (camera->Stop().hasErrors()){
@@ -1407,45 +2214,73 @@ void ScanObject(dlp::Camera          *camera,
 		scan_times--;
 		dlp::CmdLine::Print("תȴ...");
 		
-		DWORD dwWrittenLen = 0;
-		if(!WriteFile(hcom,data,1,&dwWrittenLen,NULL))
-        {
-         dlp::CmdLine::Print("ʧ ");
-        }
-
-		_sleep(1000);
-
-		char str[2];
-		char aa,bb;
-		DWORD wCount;//ȡֽ		 
-		BOOL bReadStat;		 
-		bReadStat=ReadFile(hcom,str,1,&wCount,NULL);
-		if(!bReadStat)
-        {
-         dlp::CmdLine::Print("ȡʧ ");
-        }
-		aa=str[0];
-	//	bb=str[1];
-		dlp::CmdLine::Print(":",aa);		
-	//	dlp::CmdLine::Print(":",bb);
-		_sleep(stop_time_ms*8/((int)(data[0])));
+		const unsigned int turntable_span = scan_trace.Begin("turntable");
+		const bool turned = TurnTurntable(hcom, data, stop_time_ms);
+		scan_trace.End(turntable_span);
+
+		// The following views would be scanned at the wrong angle, the
+		// checkpoint stays at the last view the table reached
+		if (!turned){
+			dlp::CmdLine::Print("Turntable NOT turned! Exiting scan routine...");
+			break;
+		}
+		if (checkpoint_scans.Get()){
+			checkpoint.TurnTable();
+			dlp::ReturnCode checkpoint_return = checkpoint.Save(checkpoint_file);
+			if (checkpoint_return.hasErrors()) dlp::CmdLine::Print("Scan checkpoint NOT saved: ", checkpoint_return.ToString());
+		}
 	}
     // Close the viewers
-    view_point_cloud.Close();
+    if(view_point_cloud.isOpen()) view_point_cloud.Close();
+
+    // A finished session starts from its first view next time
+    if(checkpoint_scans.Get() && checkpoint.isComplete()){
+        DeleteFileA(checkpoint_file.c_str());
+        DeleteFileA((data_directory.Get() + SCAN_CHECKPOINT_SETTINGS_FILE).c_str());
+    }
 
-    // Clear the geometry module to release memory
-    scanner_geometry.Clear();
+    if(archive){
+        const unsigned int archive_chunks = scan_archive.GetEntryCount();
+        dlp::ReturnCode archive_return = scan_archive.Close();
+        if(archive_return.hasErrors()) dlp::CmdLine::Print("Scan archive NOT closed: ", archive_return.ToString());
+        else                           dlp::CmdLine::Print("Scan archive saved with ", archive_chunks, " chunks");
+    }
+
+    // The geometry module is released with a local session, a caller's
+    // session keeps it for the next scan
 
     return;
 }
 
-int main()
+// Creates the output directory of a batch or daemon job and points the scan
+// data and images settings below it
+void SetBatchOutputDirectory(const std::string &output_directory, dlp::Parameters *settings){
+    const std::string data_directory   = output_directory + "scan_data/";
+    const std::string images_directory = output_directory + "scan_images/";
+    if(!output_directory.empty()) CreateDirectoryA(output_directory.c_str(), NULL);
+    CreateDirectoryA(data_directory.c_str(), NULL);
+    CreateDirectoryA(images_directory.c_str(), NULL);
+
+    settings->Set(ScanParameters::DataDirectory(data_directory));
+    settings->Set(ScanParameters::ImagesDirectory(images_directory));
+}
+
+int main(int argc, char *argv[])
 {
+    // Command line arguments or a job file select a headless batch run
+    BatchScanJob batch_job;
+    dlp::ReturnCode batch_return = ParseBatchArguments(argc, argv, &batch_job);
+    if(batch_return.hasErrors()){
+        dlp::CmdLine::Print("Invalid batch job: ", batch_return.ToString());
+        dlp::CmdLine::Print(GetBatchUsage(argv[0]));
+        return BATCH_EXIT_INVALID_JOB;
+    }
+
     // Configuration Parameter Definitions
 
     //Camera type: 0 - Generic OpenCV camera, 1 - PointGrey, ...
     DLP_NEW_PARAMETERS_ENTRY(CameraType,         "CAMERA_TYPE",  int, -1);
-    //Algorithm type: 0 - Graycode, 1 - Hybrid ThreePhase, ...
+    //Algorithm type: 0 - Graycode, 1 - Hybrid ThreePhase, 2 - Multi-frequency phase, ...
     DLP_NEW_PARAMETERS_ENTRY(AlgorithmType,      "ALGORITHM_TYPE",  int, -1);
 
     DLP_NEW_PARAMETERS_ENTRY(ConnectIdProjector,           "CONNECT_ID_PROJECTOR",  std::string, "0");
@@ -1460,14 +2295,13 @@ int main()
     DLP_NEW_PARAMETERS_ENTRY(ConfigFileStructuredLight2,    "CONFIG_FILE_STRUCTURED_LIGHT_2",       std::string, "config/algorithm_horizontal.txt");
 
     DLP_NEW_PARAMETERS_ENTRY(ContinuousScanning,            "CONTINUOUS_SCANNING", bool, false);
+    DLP_NEW_PARAMETERS_ENTRY(StreamingDecode,               "STREAMING_DECODE",    bool, false);
 
     DLP_NEW_PARAMETERS_ENTRY(CalibDataFileProjector,        "CALIBRATION_DATA_FILE_PROJECTOR",      std::string, "calibration/data/projector.xml");
     DLP_NEW_PARAMETERS_ENTRY(CalibDataFileCamera,           "CALIBRATION_DATA_FILE_CAMERA",         std::string, "calibration/data/camera.xml");
     DLP_NEW_PARAMETERS_ENTRY(DirCalibData,                  "DIRECTORY_CALIBRATION_DATA",                   std::string, "calibration/data/");
     DLP_NEW_PARAMETERS_ENTRY(DirCameraCalibImageOutput,     "DIRECTORY_CAMERA_CALIBRATION_IMAGE_OUTPUT",    std::string, "calibration/camera_images/");
     DLP_NEW_PARAMETERS_ENTRY(DirSystemCalibImageOutput,     "DIRECTORY_SYSTEM_CALIBRATION_IMAGE_OUTPUT",    std::string, "calibration/system_images/");
-    DLP_NEW_PARAMETERS_ENTRY(DirScanDataOutput,             "DIRECTORY_SCAN_DATA_OUTPUT",                   std::string, "output/scan_data/");
-    DLP_NEW_PARAMETERS_ENTRY(DirScanImagesOutput,           "DIRECTORY_SCAN_IMAGES_OUTPUT",                 std::string, "output/scan_images/");
     DLP_NEW_PARAMETERS_ENTRY(OutputNameImageCameraCalibBoard, "OUTPUT_NAME_IMAGE_CAMERA_CALIBRATION_BOARD", std::string, "camera_calibration_board");
     DLP_NEW_PARAMETERS_ENTRY(OutputNameImageCameraCalib,    "OUTPUT_NAME_IMAGE_CAMERA_CALIBRATION", std::string, "camera_calibration_capture_");
     DLP_NEW_PARAMETERS_ENTRY(OutputNameImageSystemCalib,    "OUTPUT_NAME_IMAGE_SYSTEM_CALIBRATION", std::string, "system_calibration_capture_");
@@ -1491,14 +2325,13 @@ int main()
     ConfigFileStructuredLight2  config_file_structured_light_2;
 
     ContinuousScanning          continuous_scanning;
+    StreamingDecode             streaming_decode;
 
     CalibDataFileProjector      calib_data_file_projector;
     CalibDataFileCamera         calib_data_file_camera;
     DirCalibData                dir_calib_data;
     DirCameraCalibImageOutput   dir_camera_calib_image_output;
     DirSystemCalibImageOutput   dir_system_calib_image_output;
-    DirScanDataOutput           dir_scan_data_output;
-    DirScanImagesOutput         dir_scan_images_output;
 
     OutputNameImageCameraCalibBoard output_name_image_camera_calib_board;
     OutputNameImageCameraCalib  output_name_image_camera_calib;
@@ -1509,7 +2342,7 @@ int main()
 
     // Load the settings
     dlp::Parameters settings;
-    settings.Load("DLP_LightCrafter_4500_3D_Scan_Application_Config.txt");
+    settings.Load(batch_job.config_file);
 
     // Retrieve the settings
     settings.Get(&algorithm_type);
@@ -1524,19 +2357,29 @@ int main()
     settings.Get(&config_file_structured_light_1);
     settings.Get(&config_file_structured_light_2);
     settings.Get(&continuous_scanning);
+    settings.Get(&streaming_decode);
     settings.Get(&calib_data_file_projector);
     settings.Get(&calib_data_file_camera);
     settings.Get(&dir_calib_data);
     settings.Get(&dir_camera_calib_image_output);
     settings.Get(&dir_system_calib_image_output);
-    settings.Get(&dir_scan_data_output);
-    settings.Get(&dir_scan_images_output);
     settings.Get(&output_name_image_camera_calib_board);
     settings.Get(&output_name_image_camera_calib);
     settings.Get(&output_name_image_system_calib);
     settings.Get(&output_name_image_depthmap);
     settings.Get(&output_name_xyz_pointcloud);
 
+    // Batch runs write everything below the job output directory
+    if(batch_job.headless){
+        settings.Set(ScanParameters::Headless(true));
+        settings.Set(ScanParameters::ResumeScans(batch_job.resume));
+        SetBatchOutputDirectory(batch_job.output_directory, &settings);
+    }
+
+    // Calibration images are saved in the same format as scan captures
+    ScanParameters::ImageFormat image_format;
+    settings.Get(&image_format);
+
     // System Variables
     dlp::OpenCV_Cam     camera_cv;
     dlp::PG_FlyCap2_C   camera_pg;
@@ -1544,18 +2387,36 @@ int main()
     dlp::GrayCode       algo_gray_code_horz;
     dlp::ThreePhase     algo_three_phase_vert;
     dlp::ThreePhase     algo_three_phase_horz;
+    StreamingGrayCode   algo_streaming_gray_code_vert;
+    StreamingGrayCode   algo_streaming_gray_code_horz;
+    MultiFrequencyPhase algo_multi_frequency_phase_vert;
+    MultiFrequencyPhase algo_multi_frequency_phase_horz;
     dlp::LCr4500        projector;
     unsigned int total_pattern_count = 0;
 
+    // Gray code modules, the streaming modules decode frames as they are captured
+    dlp::StructuredLight *gray_code_vert = &algo_gray_code_vert;
+    dlp::StructuredLight *gray_code_horz = &algo_gray_code_horz;
+    if(streaming_decode.Get()){
+        gray_code_vert = &algo_streaming_gray_code_vert;
+        gray_code_horz = &algo_streaming_gray_code_horz;
+    }
+
+    // Camera used for preparing high speed capture
+    dlp::Camera *camera = &camera_cv;
+    if(camera_type.Get() == 1) camera = &camera_pg;
+
     // Validate the Camera and Algorithm types are within supported list
     if(camera_type.Get() > 1) {
         dlp::CmdLine::Print("Unsupported CAMERA_TYPE set in the configuration file. Modify DLP_LightCrafter_3D_Scan_Application_Config.txt");
+        if(batch_job.headless) return BATCH_EXIT_INVALID_CONFIG;
         dlp::CmdLine::Print("Press any key to exit...");
         std::cin.get();
         return -1;
     }
-    if(algorithm_type.Get() > 1) {
+    if(algorithm_type.Get() > 2) {
         dlp::CmdLine::Print("Unsupported ALGORITHM_TYPE set in the configuration file. Modify DLP_LightCrafter_3D_Scan_Application_Config.txt");
+        if(batch_job.headless) return BATCH_EXIT_INVALID_CONFIG;
         dlp::CmdLine::Print("Press any key to exit...");
         std::cin.get();
         return -1;
@@ -1583,6 +2444,106 @@ int main()
         //  unreachable code
     }
 
+    // Batch run: prepare the projector from the existing calibration data,
+    // scan the job views, and report the result as the exit code. The daemon
+    // prepares once and then scans every job received on its pipe with the
+    // same devices and geometry.
+    if(batch_job.headless){
+        int exit_code = BATCH_EXIT_SUCCESS;
+
+        dlp::StructuredLight *batch_vertical   = gray_code_vert;
+        dlp::StructuredLight *batch_horizontal = gray_code_horz;
+        if(algorithm_type.Get() == 1) {
+            batch_vertical   = &algo_three_phase_vert;
+            batch_horizontal = &algo_three_phase_horz;
+        } else if(algorithm_type.Get() == 2) {
+            batch_vertical   = &algo_multi_frequency_phase_vert;
+            batch_horizontal = &algo_multi_frequency_phase_horz;
+        }
+
+        if(!projector.isConnected() || !camera->isConnected()){
+            exit_code = BATCH_EXIT_CONNECTION_FAILED;
+        }
+        else{
+            PrepareProjectorPatterns(&projector,
+                                     config_file_calib_projector.Get(),
+                                     batch_vertical,
+                                     config_file_structured_light_1.Get(),
+                                     batch_horizontal,
+                                     config_file_structured_light_2.Get(),
+                                     !batch_job.upload_firmware,
+                                     camera,
+                                     &settings,
+                                     &total_pattern_count);
+
+            if(!batch_vertical->isSetup() || !batch_horizontal->isSetup()){
+                exit_code = BATCH_EXIT_PREPARE_FAILED;
+            }
+            else if(!batch_job.daemon){
+                unsigned int views_saved = 0;
+                ScanObject(camera,
+                           camera_type.Get() == 1,
+                           calib_data_file_camera.Get(),
+                           &projector,
+                           calib_data_file_projector.Get(),
+                           batch_vertical,
+                           batch_horizontal,
+                           batch_job.use_vertical,
+                           batch_job.use_horizontal,
+                           config_file_geometry.Get(),
+                           false,
+                           settings,
+                           batch_job.views,
+                           batch_job.turn_time_ms,
+                           &views_saved);
+
+                dlp::CmdLine::Print("Views saved...\t\t\t\t\t", views_saved, "/", batch_job.views);
+                if(views_saved != batch_job.views) exit_code = BATCH_EXIT_SCAN_FAILED;
+            }
+            else{
+                ScanSession scan_session;
+                ScanDaemon  daemon;
+                DaemonJob   job;
+
+                daemon.Start(batch_job.pipe_name, batch_job);
+                dlp::CmdLine::Print("Waiting for scan jobs...");
+
+                while(daemon.WaitForJob(&job)){
+                    dlp::CmdLine::Print("Scan job ", job.id, "...\t\t\t\t\t", job.scan.views, " views");
+                    SetBatchOutputDirectory(job.scan.output_directory, &settings);
+                    settings.Set(ScanParameters::ResumeScans(job.scan.resume));
+
+                    unsigned int views_saved = 0;
+                    ScanObject(camera,
+                               camera_type.Get() == 1,
+                               calib_data_file_camera.Get(),
+                               &projector,
+                               calib_data_file_projector.Get(),
+                               batch_vertical,
+                               batch_horizontal,
+                               job.scan.use_vertical,
+                               job.scan.use_horizontal,
+                               config_file_geometry.Get(),
+                               false,
+                               settings,
+                               job.scan.views,
+                               job.scan.turn_time_ms,
+                               &views_saved,
+                               &scan_session);
+
+                    dlp::CmdLine::Print("Views saved...\t\t\t\t\t", views_saved, "/", job.scan.views);
+                    daemon.FinishJob(job.id, views_saved, (views_saved == job.scan.views) ? BATCH_EXIT_SUCCESS : BATCH_EXIT_SCAN_FAILED);
+                }
+
+                daemon.Stop();
+            }
+        }
+
+        camera->Disconnect();
+        projector.Disconnect();
+        return exit_code;
+    }
+
     // Program menu
     int menu_select = 0;
 
@@ -1683,11 +2644,13 @@ int main()
             if(algorithm_type.Get() == 0) {
                 PrepareProjectorPatterns(&projector,
                                          config_file_calib_projector.Get(),
-                                         &algo_gray_code_vert,
+                                         gray_code_vert,
                                          config_file_structured_light_1.Get(),
-                                         &algo_gray_code_horz,
+                                         gray_code_horz,
                                          config_file_structured_light_2.Get(),
                                          false,    // Firmware will be uploaded
+                                         camera,
+                                         &settings,
                                          &total_pattern_count);
             } else if(algorithm_type.Get() == 1) {
                 PrepareProjectorPatterns(&projector,
@@ -1697,8 +2660,21 @@ int main()
                                          &algo_three_phase_horz,
                                          config_file_structured_light_2.Get(),
                                          false,    // Firmware will be uploaded
+                                         camera,
+                                         &settings,
                                          &total_pattern_count);
 
+            } else if(algorithm_type.Get() == 2) {
+                PrepareProjectorPatterns(&projector,
+                                         config_file_calib_projector.Get(),
+                                         &algo_multi_frequency_phase_vert,
+                                         config_file_structured_light_1.Get(),
+                                         &algo_multi_frequency_phase_horz,
+                                         config_file_structured_light_2.Get(),
+                                         false,    // Firmware will be uploaded
+                                         camera,
+                                         &settings,
+                                         &total_pattern_count);
             } else {
                 //  unreachable code
             }
@@ -1708,11 +2684,13 @@ int main()
             if(algorithm_type.Get() == 0) {
                 PrepareProjectorPatterns(&projector,
                                          config_file_calib_projector.Get(),
-                                         &algo_gray_code_vert,
+                                         gray_code_vert,
                                          config_file_structured_light_1.Get(),
-                                         &algo_gray_code_horz,
+                                         gray_code_horz,
                                          config_file_structured_light_2.Get(),
                                          true, // Firmware will NOT be uploaded
+                                         camera,
+                                         &settings,
                                          &total_pattern_count);
             } else if(algorithm_type.Get() == 1) {
                 PrepareProjectorPatterns(&projector,
@@ -1722,8 +2700,21 @@ int main()
                                          &algo_three_phase_horz,
                                          config_file_structured_light_2.Get(),
                                          true, // Firmware will NOT be uploaded
+                                         camera,
+                                         &settings,
                                          &total_pattern_count);
 
+            } else if(algorithm_type.Get() == 2) {
+                PrepareProjectorPatterns(&projector,
+                                         config_file_calib_projector.Get(),
+                                         &algo_multi_frequency_phase_vert,
+                                         config_file_structured_light_1.Get(),
+                                         &algo_multi_frequency_phase_horz,
+                                         config_file_structured_light_2.Get(),
+                                         true, // Firmware will NOT be uploaded
+                                         camera,
+                                         &settings,
+                                         &total_pattern_count);
             } else {
                 //  unreachable code
             }
@@ -1735,14 +2726,16 @@ int main()
                                 calib_data_file_camera.Get(),
                                 dir_camera_calib_image_output.Get() +
                                 output_name_image_camera_calib.Get(),
-                                &projector);
+                                &projector,
+                                image_format.Get());
             } else if(camera_type.Get() == 1) {
                 CalibrateCamera(&camera_pg,
                                 config_file_calib_camera.Get(),
                                 calib_data_file_camera.Get(),
                                 dir_camera_calib_image_output.Get() +
                                 output_name_image_camera_calib.Get(),
-                                &projector);
+                                &projector,
+                                image_format.Get());
             } else {
                 //  unreachable code
             }
@@ -1756,7 +2749,8 @@ int main()
                                 config_file_calib_projector.Get(),
                                 calib_data_file_projector.Get(),
                                 dir_system_calib_image_output.Get() +
-                                output_name_image_system_calib.Get());
+                                output_name_image_system_calib.Get(),
+                                image_format.Get());
             } else if(camera_type.Get() == 1) {
                 CalibrateSystem(&camera_pg,
                                 config_file_calib_camera.Get(),
@@ -1765,7 +2759,8 @@ int main()
                                 config_file_calib_projector.Get(),
                                 calib_data_file_projector.Get(),
                                 dir_system_calib_image_output.Get() +
-                                output_name_image_system_calib.Get());
+                                output_name_image_system_calib.Get(),
+                                image_format.Get());
             } else {
                 //  unreachable code
             }
@@ -1779,12 +2774,13 @@ int main()
                                calib_data_file_camera.Get(),
                                &projector,
                                calib_data_file_projector.Get(),
-                               &algo_gray_code_vert,
-                               &algo_gray_code_horz,
+                               gray_code_vert,
+                               gray_code_horz,
                                true,
                                false,
                                config_file_geometry.Get(),
-                               continuous_scanning.Get());
+                               continuous_scanning.Get(),
+                               settings);
                 } else if(algorithm_type.Get() == 1) {
                     ScanObject(&camera_cv,
                                false,
@@ -1796,7 +2792,21 @@ int main()
                                true,
                                false,
                                config_file_geometry.Get(),
-                               continuous_scanning.Get());
+                               continuous_scanning.Get(),
+                               settings);
+                } else if(algorithm_type.Get() == 2) {
+                    ScanObject(&camera_cv,
+                               false,
+                               calib_data_file_camera.Get(),
+                               &projector,
+                               calib_data_file_projector.Get(),
+                               &algo_multi_frequency_phase_vert,
+                               &algo_multi_frequency_phase_horz,
+                               true,
+                               false,
+                               config_file_geometry.Get(),
+                               continuous_scanning.Get(),
+                               settings);
                 } else {
                     //  unreachable code
                 }
@@ -1807,12 +2817,13 @@ int main()
                                    calib_data_file_camera.Get(),
                                    &projector,
                                    calib_data_file_projector.Get(),
-                                   &algo_gray_code_vert,
-                                   &algo_gray_code_horz,
+                                   gray_code_vert,
+                                   gray_code_horz,
                                    true,
                                    false,
                                    config_file_geometry.Get(),
-                                   continuous_scanning.Get());
+                                   continuous_scanning.Get(),
+                                   settings);
                     } else if(algorithm_type.Get() == 1) {
                         ScanObject(&camera_pg,
                                    true,
@@ -1824,7 +2835,21 @@ int main()
                                    true,
                                    false,
                                    config_file_geometry.Get(),
-                                   continuous_scanning.Get());
+                                   continuous_scanning.Get(),
+                                   settings);
+                    } else if(algorithm_type.Get() == 2) {
+                        ScanObject(&camera_pg,
+                                   true,
+                                   calib_data_file_camera.Get(),
+                                   &projector,
+                                   calib_data_file_projector.Get(),
+                                   &algo_multi_frequency_phase_vert,
+                                   &algo_multi_frequency_phase_horz,
+                                   true,
+                                   false,
+                                   config_file_geometry.Get(),
+                                   continuous_scanning.Get(),
+                                   settings);
                     } else {
                         //  unreachable code
                     }
@@ -1840,12 +2865,13 @@ int main()
                                calib_data_file_camera.Get(),
                                &projector,
                                calib_data_file_projector.Get(),
-                               &algo_gray_code_vert,
-                               &algo_gray_code_horz,
+                               gray_code_vert,
+                               gray_code_horz,
                                false,
                                true,
                                config_file_geometry.Get(),
-                               continuous_scanning.Get());
+                               continuous_scanning.Get(),
+                               settings);
                 } else if(algorithm_type.Get() == 1) {
                     ScanObject(&camera_cv,
                                false,
@@ -1857,7 +2883,21 @@ int main()
                                false,
                                true,
                                config_file_geometry.Get(),
-                               continuous_scanning.Get());
+                               continuous_scanning.Get(),
+                               settings);
+                } else if(algorithm_type.Get() == 2) {
+                    ScanObject(&camera_cv,
+                               false,
+                               calib_data_file_camera.Get(),
+                               &projector,
+                               calib_data_file_projector.Get(),
+                               &algo_multi_frequency_phase_vert,
+                               &algo_multi_frequency_phase_horz,
+                               false,
+                               true,
+                               config_file_geometry.Get(),
+                               continuous_scanning.Get(),
+                               settings);
                 } else {
                     //  unreachable code
                 }
@@ -1868,12 +2908,13 @@ int main()
                                calib_data_file_camera.Get(),
                                &projector,
                                calib_data_file_projector.Get(),
-                               &algo_gray_code_vert,
-                               &algo_gray_code_horz,
+                               gray_code_vert,
+                               gray_code_horz,
                                false,
                                true,
                                config_file_geometry.Get(),
-                               continuous_scanning.Get());
+                               continuous_scanning.Get(),
+                               settings);
                 } else if(algorithm_type.Get() == 1) {
                     ScanObject(&camera_pg,
                                true,
@@ -1885,7 +2926,21 @@ int main()
                                false,
                                true,
                                config_file_geometry.Get(),
-                               continuous_scanning.Get());
+                               continuous_scanning.Get(),
+                               settings);
+                } else if(algorithm_type.Get() == 2) {
+                    ScanObject(&camera_pg,
+                               true,
+                               calib_data_file_camera.Get(),
+                               &projector,
+                               calib_data_file_projector.Get(),
+                               &algo_multi_frequency_phase_vert,
+                               &algo_multi_frequency_phase_horz,
+                               false,
+                               true,
+                               config_file_geometry.Get(),
+                               continuous_scanning.Get(),
+                               settings);
                 } else {
                     //  unreachable code
                 }
@@ -1901,12 +2956,13 @@ int main()
 						calib_data_file_camera.Get(),
 						&projector,
 						calib_data_file_projector.Get(),
-						&algo_gray_code_vert,
-						&algo_gray_code_horz,
+						gray_code_vert,
+						gray_code_horz,
 						true,
 						true,
 						config_file_geometry.Get(),
 						continuous_scanning.Get(),
+						settings,
 						8,
 						3000
 						);
@@ -1924,6 +2980,24 @@ int main()
                                true,
                                config_file_geometry.Get(),
                                continuous_scanning.Get(),
+                               settings,
+							   8,
+							   5000
+							   );
+//					_sleep(5 * 1000);
+                } else if(algorithm_type.Get() == 2) {
+					ScanObject(&camera_cv,
+                               false,
+                               calib_data_file_camera.Get(),
+                               &projector,
+                               calib_data_file_projector.Get(),
+                               &algo_multi_frequency_phase_vert,
+                               &algo_multi_frequency_phase_horz,
+                               true,
+                               true,
+                               config_file_geometry.Get(),
+                               continuous_scanning.Get(),
+                               settings,
 							   8,
 							   5000
 							   );
@@ -1938,12 +3012,13 @@ int main()
                                    calib_data_file_camera.Get(),
                                    &projector,
                                    calib_data_file_projector.Get(),
-                                   &algo_gray_code_vert,
-                                   &algo_gray_code_horz,
+                                   gray_code_vert,
+                                   gray_code_horz,
                                    true,
                                    true,
                                    config_file_geometry.Get(),
-                                   continuous_scanning.Get());
+                                   continuous_scanning.Get(),
+                                   settings);
                     } else if(algorithm_type.Get() == 1) {
                         ScanObject(&camera_pg,
                                    true,
@@ -1955,7 +3030,21 @@ int main()
                                    true,
                                    true,
                                    config_file_geometry.Get(),
-                                   continuous_scanning.Get());
+                                   continuous_scanning.Get(),
+                                   settings);
+                    } else if(algorithm_type.Get() == 2) {
+                        ScanObject(&camera_pg,
+                                   true,
+                                   calib_data_file_camera.Get(),
+                                   &projector,
+                                   calib_data_file_projector.Get(),
+                                   &algo_multi_frequency_phase_vert,
+                                   &algo_multi_frequency_phase_horz,
+                                   true,
+                                   true,
+                                   config_file_geometry.Get(),
+                                   continuous_scanning.Get(),
+                                   settings);
                     } else {
                         //  unreachable code
                     }
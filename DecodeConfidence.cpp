@@ -0,0 +1,141 @@
+/** @file       DecodeConfidence.cpp
+ *  @brief      Per pixel decode confidence and confidence based point filtering
+ */
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include "DecodeConfidence.h"
+
+dlp::ReturnCode CombineConfidence(dlp::Image *confidence, dlp::Image *combined){
+    dlp::ReturnCode ret;
+
+    if(!confidence || !combined) return ret.AddError(DECODE_CONFIDENCE_NULL_POINTER);
+    if(confidence->isEmpty())    return ret.AddError(DECODE_CONFIDENCE_NOT_AVAILABLE);
+
+    cv::Mat data;
+    if(combined->isEmpty()){
+        confidence->GetOpenCVData(&data);
+        combined->Create(data);
+        return ret;
+    }
+
+    unsigned int columns, rows;
+    unsigned int combined_columns, combined_rows;
+    confidence->GetColumns(&columns);
+    confidence->GetRows(&rows);
+    combined->GetColumns(&combined_columns);
+    combined->GetRows(&combined_rows);
+    if((columns != combined_columns) || (rows != combined_rows)) return ret.AddError(DECODE_CONFIDENCE_RESOLUTION_MISMATCH);
+
+    cv::Mat combined_data;
+    confidence->Unsafe_GetOpenCVData(&data);
+    combined->Unsafe_GetOpenCVData(&combined_data);
+
+    for(unsigned int y = 0; y < rows; y++){
+        const unsigned char *source = data.ptr<unsigned char>(y);
+        unsigned char       *target = combined_data.ptr<unsigned char>(y);
+        for(unsigned int x = 0; x < columns; x++){
+            if(source[x] < target[x]) target[x] = source[x];
+        }
+    }
+
+    return ret;
+}
+
+dlp::ReturnCode FilterDisparityByConfidence(dlp::Image          *confidence,
+                                            const unsigned char &minimum,
+                                            dlp::DisparityMap   *disparity_map,
+                                            unsigned long long  *removed){
+    dlp::ReturnCode ret;
+
+    if(!confidence || !disparity_map) return ret.AddError(DECODE_CONFIDENCE_NULL_POINTER);
+    if(confidence->isEmpty())         return ret.AddError(DECODE_CONFIDENCE_NOT_AVAILABLE);
+
+    unsigned int columns, rows;
+    unsigned int disparity_columns, disparity_rows;
+    confidence->GetColumns(&columns);
+    confidence->GetRows(&rows);
+    disparity_map->GetColumns(&disparity_columns);
+    disparity_map->GetRows(&disparity_rows);
+    if((columns != disparity_columns) || (rows != disparity_rows)) return ret.AddError(DECODE_CONFIDENCE_RESOLUTION_MISMATCH);
+
+    cv::Mat data;
+    confidence->Unsafe_GetOpenCVData(&data);
+
+    unsigned long long count = 0;
+    for(unsigned int y = 0; y < rows; y++){
+        const unsigned char *row = data.ptr<unsigned char>(y);
+        for(unsigned int x = 0; x < columns; x++){
+            if(row[x] >= minimum) continue;
+
+            int value;
+            disparity_map->Unsafe_GetPixel(x,y,&value);
+            if(value < 0) continue;     // Already invalid or empty
+
+            disparity_map->Unsafe_SetPixel(x,y,dlp::DisparityMap::INVALID_PIXEL);
+            count++;
+        }
+    }
+
+    if(removed) (*removed) = count;
+    return ret;
+}
+
+dlp::ReturnCode SaveXYZConfidence(const std::string       &filename,
+                                  const dlp::Point::Cloud &point_cloud,
+                                  dlp::Image              *depth_map,
+                                  dlp::Image              *confidence,
+                                  const char              &delimiter){
+    dlp::ReturnCode ret;
+
+    if(!depth_map || !confidence) return ret.AddError(DECODE_CONFIDENCE_NULL_POINTER);
+    if(confidence->isEmpty())     return ret.AddError(DECODE_CONFIDENCE_NOT_AVAILABLE);
+
+    unsigned int columns, rows;
+    unsigned int depth_columns, depth_rows;
+    confidence->GetColumns(&columns);
+    confidence->GetRows(&rows);
+    depth_map->GetColumns(&depth_columns);
+    depth_map->GetRows(&depth_rows);
+    if((columns != depth_columns) || (rows != depth_rows)) return ret.AddError(DECODE_CONFIDENCE_RESOLUTION_MISMATCH);
+
+    dlp::Image::Format format;
+    depth_map->GetDataFormat(&format);
+    if((format != dlp::Image::Format::MONO_FLOAT) &&
+       (format != dlp::Image::Format::MONO_DOUBLE)) return ret.AddError(DECODE_CONFIDENCE_FORMAT_INVALID);
+
+    cv::Mat depth_data;
+    cv::Mat confidence_data;
+    depth_map->Unsafe_GetOpenCVData(&depth_data);
+    confidence->Unsafe_GetOpenCVData(&confidence_data);
+
+    // Collect the confidence of every pixel which produced a point
+    std::vector<unsigned char> point_confidence;
+    point_confidence.reserve((size_t) point_cloud.GetCount());
+    for(unsigned int y = 0; y < rows; y++){
+        const unsigned char *row = confidence_data.ptr<unsigned char>(y);
+        for(unsigned int x = 0; x < columns; x++){
+            const double depth = (format == dlp::Image::Format::MONO_FLOAT) ? depth_data.ptr<float>(y)[x] :
+                                                                              depth_data.ptr<double>(y)[x];
+            if(depth > 0) point_confidence.push_back(row[x]);
+        }
+    }
+
+    // Refuse to guess if the pairing does not hold
+    if(point_confidence.size() != point_cloud.GetCount()) return ret.AddError(DECODE_CONFIDENCE_POINT_COUNT_MISMATCH);
+
+    std::ofstream file(filename.c_str(),std::ios::out | std::ios::trunc);
+    if(!file.is_open()) return ret.AddError(DECODE_CONFIDENCE_FILE_OPEN_FAILED);
+
+    file << std::setprecision(10);
+    for(unsigned long long iPoint = 0; iPoint < point_cloud.GetCount(); iPoint++){
+        dlp::Point point;
+        point_cloud.Get(iPoint,&point);
+        file << point.x << delimiter
+             << point.y << delimiter
+             << point.z << delimiter
+             << (unsigned int) point_confidence[(size_t) iPoint] << "\n";
+    }
+
+    return ret;
+}
@@ -0,0 +1,48 @@
+/** @file       DecodeConfidence.h
+ *  @brief      Per pixel decode confidence and confidence based point filtering
+ */
+#ifndef __DECODE_CONFIDENCE_H_
+#define __DECODE_CONFIDENCE_H_
+
+#include <string>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define DECODE_CONFIDENCE_NULL_POINTER          "DECODE_CONFIDENCE_NULL_POINTER"
+#define DECODE_CONFIDENCE_NOT_AVAILABLE         "DECODE_CONFIDENCE_NOT_AVAILABLE"
+#define DECODE_CONFIDENCE_RESOLUTION_MISMATCH   "DECODE_CONFIDENCE_RESOLUTION_MISMATCH"
+#define DECODE_CONFIDENCE_FORMAT_INVALID        "DECODE_CONFIDENCE_FORMAT_INVALID"
+#define DECODE_CONFIDENCE_POINT_COUNT_MISMATCH  "DECODE_CONFIDENCE_POINT_COUNT_MISMATCH"
+#define DECODE_CONFIDENCE_FILE_OPEN_FAILED      "DECODE_CONFIDENCE_FILE_OPEN_FAILED"
+
+// Implemented next to dlp::StructuredLight by modules which rate each decoded
+// pixel. The map is MONO_UCHAR in gray levels of the weakest decision made for
+// the pixel (modulation, bit margin, or phase quality) and 0 where invalid.
+class DecodeConfidence{
+public:
+    virtual ~DecodeConfidence(){}
+
+    // Confidence of the most recent decode
+    virtual dlp::ReturnCode GetConfidenceMap(dlp::Image *confidence) const = 0;
+};
+
+// Per pixel minimum of two confidence maps, written to combined. An empty
+// combined map takes a copy of confidence.
+dlp::ReturnCode CombineConfidence(dlp::Image *confidence, dlp::Image *combined);
+
+// Sets disparity pixels with confidence below minimum to INVALID_PIXEL so
+// GeneratePointCloud never triangulates them
+dlp::ReturnCode FilterDisparityByConfidence(dlp::Image          *confidence,
+                                            const unsigned char &minimum,
+                                            dlp::DisparityMap   *disparity_map,
+                                            unsigned long long  *removed = NULL);
+
+// Saves the point cloud with the confidence of each point as a fourth column.
+// Points are paired with the pixels of the depth map which hold a depth, in
+// row major order, the same order GeneratePointCloud adds them.
+dlp::ReturnCode SaveXYZConfidence(const std::string       &filename,
+                                  const dlp::Point::Cloud &point_cloud,
+                                  dlp::Image              *depth_map,
+                                  dlp::Image              *confidence,
+                                  const char              &delimiter);
+
+#endif
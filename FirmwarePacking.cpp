@@ -0,0 +1,201 @@
+/** @file       FirmwarePacking.cpp
+ *  @brief      Parallel packing of pattern bit planes into 24-bit LCr4500 firmware images
+ */
+#include <atomic>
+#include <thread>
+#include "FirmwarePacking.h"
+#include "FrameAcquisition.h"
+
+#define CHANNEL_BITS    8
+
+// OpenCV channel (BGR order) holding bit planes [8 * i, 8 * i + 8)
+static const unsigned int PLANE_CHANNEL[FIRMWARE_IMAGE_BIT_PLANES / CHANNEL_BITS] = {1, 2, 0};
+
+static unsigned int GetBitCount(const dlp::Pattern::Bitdepth &bitdepth){
+    switch(bitdepth){
+    case dlp::Pattern::Bitdepth::MONO_1BPP: return 1;
+    case dlp::Pattern::Bitdepth::MONO_2BPP: return 2;
+    case dlp::Pattern::Bitdepth::MONO_3BPP: return 3;
+    case dlp::Pattern::Bitdepth::MONO_4BPP: return 4;
+    case dlp::Pattern::Bitdepth::MONO_5BPP: return 5;
+    case dlp::Pattern::Bitdepth::MONO_6BPP: return 6;
+    case dlp::Pattern::Bitdepth::MONO_7BPP: return 7;
+    case dlp::Pattern::Bitdepth::MONO_8BPP: return 8;
+    default:                                return 0;
+    }
+}
+
+dlp::ReturnCode PlanFirmwareImages(const dlp::Pattern::Sequence       &sequence,
+                                   std::vector<FirmwarePlaneLocation> *locations,
+                                   unsigned int                       *image_count){
+    dlp::ReturnCode ret;
+
+    if(!locations || !image_count) return ret.AddError(FIRMWARE_PACKING_NULL_POINTER);
+    if(sequence.GetCount() == 0)   return ret.AddError(FIRMWARE_PACKING_PATTERNS_EMPTY);
+
+    locations->clear();
+
+    FirmwarePlaneLocation next;
+    next.image = 0;
+    next.plane = 0;
+
+    for(unsigned int iPattern = 0; iPattern < sequence.GetCount(); iPattern++){
+        dlp::Pattern pattern;
+        sequence.Get(iPattern,&pattern);
+
+        const unsigned int bits = GetBitCount(pattern.bitdepth);
+        if(bits == 0) return ret.AddError(FIRMWARE_PACKING_BITDEPTH_INVALID);
+
+        // Move to the next channel, or image, if the pattern does not fit
+        if((next.plane % CHANNEL_BITS) + bits > CHANNEL_BITS){
+            next.plane += CHANNEL_BITS - (next.plane % CHANNEL_BITS);
+        }
+        if(next.plane >= FIRMWARE_IMAGE_BIT_PLANES){
+            next.image++;
+            next.plane = 0;
+        }
+
+        locations->push_back(next);
+        next.plane += bits;
+    }
+
+    (*image_count) = next.image + 1;
+    return ret;
+}
+
+dlp::ReturnCode CheckFirmwareLayout(const dlp::Pattern::Sequence &sequence){
+    dlp::ReturnCode ret;
+
+    std::vector<FirmwarePlaneLocation> locations;
+    unsigned int image_count;
+    ret = PlanFirmwareImages(sequence,&locations,&image_count);
+    if(ret.hasErrors()) return ret;
+
+    unsigned int bits = 0;
+    for(unsigned int iPattern = 0; iPattern < sequence.GetCount(); iPattern++){
+        dlp::Pattern pattern;
+        sequence.Get(iPattern,&pattern);
+
+        const unsigned int pattern_bits = GetBitCount(pattern.bitdepth);
+        if(iPattern == 0) bits = pattern_bits;
+        if(pattern_bits != bits) return ret.AddError(FIRMWARE_PACKING_LAYOUT_MISMATCH);
+
+        const unsigned int lut_plane = iPattern * bits;
+        if((locations[iPattern].image != lut_plane / FIRMWARE_IMAGE_BIT_PLANES) ||
+           (locations[iPattern].plane != lut_plane % FIRMWARE_IMAGE_BIT_PLANES)){
+            return ret.AddError(FIRMWARE_PACKING_LAYOUT_MISMATCH);
+        }
+    }
+
+    return ret;
+}
+
+// Composes and saves one firmware image from patterns [first, end)
+static dlp::ReturnCode PackFirmwareImage(const dlp::Pattern::Sequence             &sequence,
+                                         const std::vector<FirmwarePlaneLocation> &locations,
+                                         const unsigned int                       &first,
+                                         const unsigned int                       &end,
+                                         const std::string                        &image_file){
+    dlp::ReturnCode ret;
+    cv::Mat image;
+
+    for(unsigned int iPattern = first; iPattern < end; iPattern++){
+        dlp::Pattern pattern;
+        sequence.Get(iPattern,&pattern);
+
+        if(pattern.data_type == dlp::Pattern::DataType::IMAGE_FILE){
+            ret = pattern.image_data.Load(pattern.image_file);
+            if(ret.hasErrors()) return ret;
+        }
+
+        ret = ConvertToMonochromeWithSum(&pattern.image_data,NULL);
+        if(ret.hasErrors()) return ret;
+
+        cv::Mat data;
+        pattern.image_data.Unsafe_GetOpenCVData(&data);
+
+        if(image.empty()){
+            image = cv::Mat::zeros(data.rows,data.cols,CV_8UC3);
+        }
+        else if((data.rows != image.rows) || (data.cols != image.cols)){
+            return ret.AddError(FIRMWARE_PACKING_RESOLUTION_MISMATCH);
+        }
+
+        // The most significant bits of each pixel go to the pattern planes
+        const unsigned int bits    = GetBitCount(pattern.bitdepth);
+        const unsigned int drop    = CHANNEL_BITS - bits;
+        const unsigned int shift   = locations[iPattern].plane % CHANNEL_BITS;
+        const unsigned int channel = PLANE_CHANNEL[locations[iPattern].plane / CHANNEL_BITS];
+
+        for(int y = 0; y < data.rows; y++){
+            const unsigned char *source = data.ptr<unsigned char>(y);
+            unsigned char       *target = image.ptr<unsigned char>(y) + channel;
+            for(int x = 0; x < data.cols; x++){
+                target[3 * x] |= (unsigned char)((source[x] >> drop) << shift);
+            }
+        }
+    }
+
+    dlp::Image firmware_image;
+    firmware_image.Create(image);
+    return firmware_image.Save(image_file);
+}
+
+dlp::ReturnCode PackFirmwareImages(const dlp::Pattern::Sequence &sequence,
+                                   const std::string            &file_prefix,
+                                   const unsigned int           &thread_count,
+                                   std::vector<std::string>     *image_files){
+    dlp::ReturnCode ret;
+
+    if(!image_files) return ret.AddError(FIRMWARE_PACKING_NULL_POINTER);
+
+    std::vector<FirmwarePlaneLocation> locations;
+    unsigned int image_count;
+    ret = PlanFirmwareImages(sequence,&locations,&image_count);
+    if(ret.hasErrors()) return ret;
+
+    // Patterns of each image are contiguous in the sequence
+    std::vector<unsigned int> image_first(image_count + 1,(unsigned int) locations.size());
+    for(unsigned int iPattern = (unsigned int) locations.size(); iPattern > 0; iPattern--){
+        image_first[locations[iPattern - 1].image] = iPattern - 1;
+    }
+
+    image_files->clear();
+    for(unsigned int iImage = 0; iImage < image_count; iImage++){
+        image_files->push_back(file_prefix + dlp::Number::ToString(iImage) + ".png");
+    }
+
+    unsigned int threads = thread_count;
+    if(threads == 0) threads = std::thread::hardware_concurrency();
+    if(threads == 0) threads = 1;
+    if(threads > image_count) threads = image_count;
+
+    // Images are handed out one at a time so uneven images balance out
+    std::atomic<unsigned int>     next_image(0);
+    std::vector<dlp::ReturnCode>  results(threads);
+    std::vector<std::thread>      workers;
+
+    for(unsigned int iThread = 0; iThread < threads; iThread++){
+        workers.push_back(std::thread([&,iThread](){
+            unsigned int iImage;
+            while((iImage = next_image++) < image_count){
+                dlp::ReturnCode image_ret = PackFirmwareImage(sequence,
+                                                              locations,
+                                                              image_first[iImage],
+                                                              image_first[iImage + 1],
+                                                              (*image_files)[iImage]);
+                if(image_ret.hasErrors()){
+                    results[iThread] = image_ret;
+                    return;
+                }
+            }
+        }));
+    }
+
+    for(unsigned int iThread = 0; iThread < threads; iThread++){
+        workers[iThread].join();
+        if(results[iThread].hasErrors()) ret = results[iThread];
+    }
+
+    return ret;
+}
@@ -0,0 +1,49 @@
+/** @file       FirmwarePacking.h
+ *  @brief      Parallel packing of pattern bit planes into 24-bit LCr4500 firmware images
+ */
+#ifndef __FIRMWARE_PACKING_H_
+#define __FIRMWARE_PACKING_H_
+
+#include <string>
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define FIRMWARE_PACKING_NULL_POINTER           "FIRMWARE_PACKING_NULL_POINTER"
+#define FIRMWARE_PACKING_PATTERNS_EMPTY         "FIRMWARE_PACKING_PATTERNS_EMPTY"
+#define FIRMWARE_PACKING_BITDEPTH_INVALID       "FIRMWARE_PACKING_BITDEPTH_INVALID"
+#define FIRMWARE_PACKING_RESOLUTION_MISMATCH    "FIRMWARE_PACKING_RESOLUTION_MISMATCH"
+#define FIRMWARE_PACKING_FIRMWARE_NOT_SAVED     "FIRMWARE_PACKING_FIRMWARE_NOT_SAVED"
+#define FIRMWARE_PACKING_LAYOUT_MISMATCH        "FIRMWARE_PACKING_LAYOUT_MISMATCH"
+
+#define FIRMWARE_IMAGE_BIT_PLANES   24
+
+// First bit plane of a pattern within a firmware image
+struct FirmwarePlaneLocation{
+    unsigned int image;
+    unsigned int plane;
+};
+
+// Assigns the patterns to bit planes in sequence order. Planes 0-7 are green,
+// 8-15 red, and 16-23 blue as in the DLPC350 pattern LUT, and a pattern never
+// straddles two channels.
+dlp::ReturnCode PlanFirmwareImages(const dlp::Pattern::Sequence       &sequence,
+                                   std::vector<FirmwarePlaneLocation> *locations,
+                                   unsigned int                       *image_count);
+
+// Checks the plan against the layout the SDK programs into the pattern LUT
+// when the firmware is already prepared. The LUT numbers a pattern's planes
+// from its index alone, pattern i at plane i * bits counted across images, so
+// the plan only matches when every pattern has the same bit depth of 1, 2, 4,
+// or 8 and no pattern is moved to the next channel. Other sequences have to
+// be packed by the SDK.
+dlp::ReturnCode CheckFirmwareLayout(const dlp::Pattern::Sequence &sequence);
+
+// Composes the firmware images on thread_count threads (0 uses every core)
+// and saves them as lossless PNG files named file_prefix + index. Each thread
+// holds one firmware image and one pattern at a time.
+dlp::ReturnCode PackFirmwareImages(const dlp::Pattern::Sequence &sequence,
+                                   const std::string            &file_prefix,
+                                   const unsigned int           &thread_count,
+                                   std::vector<std::string>     *image_files);
+
+#endif
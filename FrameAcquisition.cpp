@@ -0,0 +1,167 @@
+/** @file       FrameAcquisition.cpp
+ *  @brief      Camera frame acquisition with monochrome conversion and image sum fused into one pass
+ */
+#include "FrameAcquisition.h"
+
+#if defined(__SSSE3__) || defined(__AVX__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#define FRAME_ACQUISITION_SIMD
+#include <tmmintrin.h>  // Included for SSSE3 byte shuffles
+#endif
+
+// Fixed point luminance weights (sum to 256) matching the OpenCV BGR to gray conversion
+#define LUMA_WEIGHT_B   29
+#define LUMA_WEIGHT_G   150
+#define LUMA_WEIGHT_R   77
+
+// Converts one row of BGR pixels to gray and returns the sum of the gray pixels
+static unsigned long long ConvertRowBGR(const unsigned char *bgr, unsigned char *gray, const unsigned int &columns){
+    unsigned long long sum = 0;
+    unsigned int x = 0;
+
+#ifdef FRAME_ACQUISITION_SIMD
+    // Shuffle masks to deinterleave 16 BGR pixels (48 bytes) into planar B, G, and R
+    const __m128i b0 = _mm_setr_epi8( 0, 3, 6, 9,12,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1);
+    const __m128i b1 = _mm_setr_epi8(-1,-1,-1,-1,-1,-1, 2, 5, 8,11,14,-1,-1,-1,-1,-1);
+    const __m128i b2 = _mm_setr_epi8(-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 1, 4, 7,10,13);
+    const __m128i g0 = _mm_setr_epi8( 1, 4, 7,10,13,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1);
+    const __m128i g1 = _mm_setr_epi8(-1,-1,-1,-1,-1, 0, 3, 6, 9,12,15,-1,-1,-1,-1,-1);
+    const __m128i g2 = _mm_setr_epi8(-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 2, 5, 8,11,14);
+    const __m128i r0 = _mm_setr_epi8( 2, 5, 8,11,14,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1);
+    const __m128i r1 = _mm_setr_epi8(-1,-1,-1,-1,-1, 1, 4, 7,10,13,-1,-1,-1,-1,-1,-1);
+    const __m128i r2 = _mm_setr_epi8(-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 0, 3, 6, 9,12,15);
+
+    const __m128i zero     = _mm_setzero_si128();
+    const __m128i weight_b = _mm_set1_epi16(LUMA_WEIGHT_B);
+    const __m128i weight_g = _mm_set1_epi16(LUMA_WEIGHT_G);
+    const __m128i weight_r = _mm_set1_epi16(LUMA_WEIGHT_R);
+    const __m128i rounding = _mm_set1_epi16(128);
+    __m128i       sum_vec  = _mm_setzero_si128();
+
+    for(; x + 16 <= columns; x += 16){
+        const __m128i p0 = _mm_loadu_si128((const __m128i*)(bgr + 3 * x));
+        const __m128i p1 = _mm_loadu_si128((const __m128i*)(bgr + 3 * x + 16));
+        const __m128i p2 = _mm_loadu_si128((const __m128i*)(bgr + 3 * x + 32));
+
+        const __m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(p0,b0),_mm_shuffle_epi8(p1,b1)),_mm_shuffle_epi8(p2,b2));
+        const __m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(p0,g0),_mm_shuffle_epi8(p1,g1)),_mm_shuffle_epi8(p2,g2));
+        const __m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(p0,r0),_mm_shuffle_epi8(p1,r1)),_mm_shuffle_epi8(p2,r2));
+
+        // Weighted sum in 16-bit lanes, the maximum of 255 * 256 fits unsigned
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(b,zero),weight_b),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(g,zero),weight_g));
+        lo = _mm_add_epi16(lo,_mm_mullo_epi16(_mm_unpacklo_epi8(r,zero),weight_r));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo,rounding),8);
+
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(b,zero),weight_b),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(g,zero),weight_g));
+        hi = _mm_add_epi16(hi,_mm_mullo_epi16(_mm_unpackhi_epi8(r,zero),weight_r));
+        hi = _mm_srli_epi16(_mm_add_epi16(hi,rounding),8);
+
+        const __m128i y = _mm_packus_epi16(lo,hi);
+        _mm_storeu_si128((__m128i*)(gray + x),y);
+
+        // Accumulate the sum of the gray pixels in two 64-bit lanes
+        sum_vec = _mm_add_epi64(sum_vec,_mm_sad_epu8(y,zero));
+    }
+
+    unsigned long long lanes[2];
+    _mm_storeu_si128((__m128i*)lanes,sum_vec);
+    sum = lanes[0] + lanes[1];
+#endif
+
+    for(; x < columns; x++){
+        const unsigned char *pixel = bgr + 3 * x;
+        const unsigned char  y     = (unsigned char)((LUMA_WEIGHT_B * pixel[0] +
+                                                      LUMA_WEIGHT_G * pixel[1] +
+                                                      LUMA_WEIGHT_R * pixel[2] + 128) >> 8);
+        gray[x] = y;
+        sum    += y;
+    }
+
+    return sum;
+}
+
+// Returns the sum of one row of gray pixels
+static unsigned long long SumRowMono(const unsigned char *gray, const unsigned int &columns){
+    unsigned long long sum = 0;
+    unsigned int x = 0;
+
+#ifdef FRAME_ACQUISITION_SIMD
+    const __m128i zero    = _mm_setzero_si128();
+    __m128i       sum_vec = _mm_setzero_si128();
+
+    for(; x + 16 <= columns; x += 16){
+        sum_vec = _mm_add_epi64(sum_vec,_mm_sad_epu8(_mm_loadu_si128((const __m128i*)(gray + x)),zero));
+    }
+
+    unsigned long long lanes[2];
+    _mm_storeu_si128((__m128i*)lanes,sum_vec);
+    sum = lanes[0] + lanes[1];
+#endif
+
+    for(; x < columns; x++) sum += gray[x];
+
+    return sum;
+}
+
+dlp::ReturnCode ConvertToMonochromeWithSum(dlp::Image *image, double *sum){
+    dlp::ReturnCode ret;
+
+    // Check that image is NOT null
+    if(!image) return ret.AddError(FRAME_ACQUISITION_NULL_POINTER);
+    if(image->isEmpty()) return ret.AddError(FRAME_ACQUISITION_IMAGE_EMPTY);
+
+    dlp::Image::Format format;
+    image->GetDataFormat(&format);
+
+    // Only 8-bit data has a fused path, let the SDK handle everything else
+    if((format != dlp::Image::Format::MONO_UCHAR) &&
+       (format != dlp::Image::Format::RGB_UCHAR)){
+        ret = image->ConvertToMonochrome();
+        if(sum && !ret.hasErrors()) ret = image->GetSum(sum);
+        return ret;
+    }
+
+    // Nothing to convert and nobody wants the sum
+    if((format == dlp::Image::Format::MONO_UCHAR) && !sum) return ret;
+
+    cv::Mat data;
+    image->Unsafe_GetOpenCVData(&data);
+
+    unsigned long long total = 0;
+
+    if(format == dlp::Image::Format::MONO_UCHAR){
+        // The sensor already delivered monochrome so only sum the pixels
+        for(int y = 0; y < data.rows; y++){
+            total += SumRowMono(data.ptr<unsigned char>(y),data.cols);
+        }
+    }
+    else{
+        cv::Mat gray(data.rows,data.cols,CV_8UC1);
+        for(int y = 0; y < data.rows; y++){
+            total += ConvertRowBGR(data.ptr<unsigned char>(y),gray.ptr<unsigned char>(y),data.cols);
+        }
+        ret = image->Create(gray);
+    }
+
+    if(sum) (*sum) = (double) total;
+
+    return ret;
+}
+
+dlp::ReturnCode GetMonochromeFrame(dlp::Camera *camera,
+                                   const bool  &buffered,
+                                   dlp::Image  *frame,
+                                   double      *sum){
+    dlp::ReturnCode ret;
+
+    // Check that camera and image are NOT null
+    if(!camera || !frame) return ret.AddError(FRAME_ACQUISITION_NULL_POINTER);
+
+    if(buffered) ret = camera->GetFrameBuffered(frame);
+    else         ret = camera->GetFrame(frame);
+
+    if(ret.hasErrors()) return ret;
+
+    return ConvertToMonochromeWithSum(frame,sum);
+}
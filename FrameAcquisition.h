@@ -0,0 +1,28 @@
+/** @file       FrameAcquisition.h
+ *  @brief      Camera frame acquisition with monochrome conversion and image sum fused into one pass
+ */
+#ifndef __FRAME_ACQUISITION_H_
+#define __FRAME_ACQUISITION_H_
+
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define FRAME_ACQUISITION_NULL_POINTER      "FRAME_ACQUISITION_NULL_POINTER"
+#define FRAME_ACQUISITION_IMAGE_EMPTY       "FRAME_ACQUISITION_IMAGE_EMPTY"
+
+// Replaces an 8-bit color image with a newly allocated 8-bit monochrome one,
+// using fixed point luminance weights that may differ from the SDK conversion
+// by one gray level. If sum is not NULL it receives the exact integer sum of
+// the monochrome pixels computed in the same pass, not dlp::Image::GetSum().
+// Images that are already monochrome are NOT converted, only summed, and
+// other formats are converted and summed by the SDK.
+dlp::ReturnCode ConvertToMonochromeWithSum(dlp::Image *image, double *sum);
+
+// Grabs the latest (buffered == false) or next buffered (buffered == true)
+// camera frame and converts it to monochrome. Camera errors such as
+// OPENCV_CAM_IMAGE_BUFFER_EMPTY are returned unchanged.
+dlp::ReturnCode GetMonochromeFrame(dlp::Camera *camera,
+                                   const bool  &buffered,
+                                   dlp::Image  *frame,
+                                   double      *sum = NULL);
+
+#endif
@@ -0,0 +1,92 @@
+/** @file       FrameAlignment.cpp
+ *  @brief      Timestamped frame grabbing and frame to pattern sequence alignment
+ */
+#include "FrameAlignment.h"
+#include "FrameAcquisition.h"
+#include "PatternTimeline.h"
+
+FrameGrabber::FrameGrabber(){
+    this->camera_        = NULL;
+    this->keep_after_us_ = 0;
+    this->running_       = false;
+    this->preroll_sum_   = 0;
+}
+
+FrameGrabber::~FrameGrabber(){
+    this->Stop();
+}
+
+dlp::ReturnCode FrameGrabber::Start(dlp::Camera *camera, const unsigned long long &keep_after_us){
+    dlp::ReturnCode ret;
+
+    if(!camera)             return ret.AddError(FRAME_ALIGNMENT_NULL_POINTER);
+    if(this->running_)      return ret.AddError(FRAME_ALIGNMENT_ALREADY_STARTED);
+
+    this->camera_        = camera;
+    this->keep_after_us_ = keep_after_us;
+    this->preroll_sum_   = 0;
+    this->frames_.clear();
+
+    this->running_ = true;
+    this->thread_  = std::thread(&FrameGrabber::Grab,this);
+
+    return ret;
+}
+
+void FrameGrabber::Stop(){
+    this->running_ = false;
+    if(this->thread_.joinable()) this->thread_.join();
+}
+
+std::vector<TimestampedFrame>& FrameGrabber::GetFrames(){
+    return this->frames_;
+}
+
+double FrameGrabber::GetPrerollSum() const{
+    return this->preroll_sum_;
+}
+
+void FrameGrabber::Grab(){
+    TimestampedFrame frame;
+
+    while(this->running_){
+        frame.image.Clear();
+        if(GetMonochromeFrame(this->camera_,true,&frame.image,&frame.sum).hasErrors()){
+            // Buffer is empty, wait for the next frame
+            dlp::Time::Sleep::Milliseconds(1);
+            continue;
+        }
+        frame.timestamp_us = GetTimestampMicroseconds();
+
+        if(frame.timestamp_us < this->keep_after_us_){
+            this->preroll_sum_ = frame.sum;
+            continue;
+        }
+
+        this->frames_.push_back(frame);
+    }
+}
+
+int AlignByTimestamp(const std::vector<TimestampedFrame> &frames,
+                     const unsigned long long            &sequence_start_us,
+                     const unsigned int                  &pattern_count){
+    for(size_t iFrame = 0; iFrame < frames.size(); iFrame++){
+        if(frames[iFrame].timestamp_us < sequence_start_us) continue;
+        return ((frames.size() - iFrame) >= pattern_count) ? (int) iFrame : -1;
+    }
+    return -1;
+}
+
+int AlignByBrightness(const std::vector<TimestampedFrame> &frames,
+                      const double                        &preroll_sum,
+                      const unsigned int                  &pattern_count){
+    double previous_sum = preroll_sum;
+
+    for(size_t iFrame = 0; iFrame < frames.size(); iFrame++){
+        if((previous_sum != 0) && (frames[iFrame].sum > (previous_sum * FRAME_ALIGNMENT_BRIGHTNESS_STEP))){
+            return ((frames.size() - iFrame) >= pattern_count) ? (int) iFrame : -1;
+        }
+        previous_sum = frames[iFrame].sum;
+    }
+    return -1;
+}
@@ -0,0 +1,64 @@
+/** @file       FrameAlignment.h
+ *  @brief      Timestamped frame grabbing and frame to pattern sequence alignment
+ */
+#ifndef __FRAME_ALIGNMENT_H_
+#define __FRAME_ALIGNMENT_H_
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define FRAME_ALIGNMENT_NULL_POINTER        "FRAME_ALIGNMENT_NULL_POINTER"
+#define FRAME_ALIGNMENT_ALREADY_STARTED     "FRAME_ALIGNMENT_ALREADY_STARTED"
+
+// Brightness step which marks the first pattern for the fallback alignment
+#define FRAME_ALIGNMENT_BRIGHTNESS_STEP     1.1
+
+// Monochrome frame, its sum, and when it was retrieved from the camera
+struct TimestampedFrame{
+    dlp::Image         image;
+    double             sum;
+    unsigned long long timestamp_us;
+};
+
+// Retrieves buffered camera frames on its own thread while a pattern sequence
+// runs and timestamps them with GetTimestampMicroseconds. Frames retrieved
+// before keep_after_us are pre-roll and only the sum of the latest is kept.
+class FrameGrabber{
+public:
+    FrameGrabber();
+    ~FrameGrabber();
+
+    dlp::ReturnCode Start(dlp::Camera *camera, const unsigned long long &keep_after_us);
+    void Stop();
+
+    // Valid once stopped
+    std::vector<TimestampedFrame>& GetFrames();
+    double GetPrerollSum() const;
+
+private:
+    void Grab();
+
+    dlp::Camera                   *camera_;
+    unsigned long long             keep_after_us_;
+    std::atomic_bool               running_;
+    std::thread                    thread_;
+    std::vector<TimestampedFrame>  frames_;
+    double                         preroll_sum_;
+};
+
+// Index of the first frame retrieved at or after the sequence start, -1 if
+// fewer than pattern_count frames follow it
+int AlignByTimestamp(const std::vector<TimestampedFrame> &frames,
+                     const unsigned long long            &sequence_start_us,
+                     const unsigned int                  &pattern_count);
+
+// Index of the first frame brighter than the one before it by the brightness
+// step, starting from the pre-roll sum, -1 if not found or fewer than
+// pattern_count frames follow it
+int AlignByBrightness(const std::vector<TimestampedFrame> &frames,
+                      const double                        &preroll_sum,
+                      const unsigned int                  &pattern_count);
+
+#endif
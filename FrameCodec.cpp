@@ -0,0 +1,604 @@
+/** @file       FrameCodec.cpp
+ *  @brief      Lossless encoding of 8-bit camera frames and a threaded frame writer
+ *
+ *  Stream layout: per row 2 bits of predictor, then per block of up to
+ *  FRAME_CODEC_BLOCK_PIXELS residuals a 4 bit code and the residuals. Codes
+ *  0-7 are the Rice parameter k of the block, RAW stores 8 bits per residual
+ *  and ZERO stores nothing. A residual of quotient q = z >> k is q one bits, a
+ *  zero bit, and the k low bits of z, or when q reaches 16, 16 one bits and z.
+ *  Bits are packed least significant first.
+ */
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "FrameCodec.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>     // Included for _BitScanForward64
+#endif
+
+#define FRAME_CODEC_CODE_RAW        8
+#define FRAME_CODEC_CODE_ZERO       15
+#define FRAME_CODEC_ESCAPE          16      // Quotients from here are stored as 8 bits
+#define FRAME_CODEC_PREDICTOR_ROWS  8       // Rows between comparisons of every predictor
+
+struct FrameCodecHeader{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int columns;
+    unsigned int rows;
+};
+
+// Every platform this builds for is little endian, so whole words of the bit
+// buffer are copied to and from the stream
+class FrameBitWriter{
+public:
+    FrameBitWriter(unsigned char *out){
+        this->out_   = out;
+        this->used_  = 0;
+        this->bits_  = 0;
+        this->count_ = 0;
+    }
+    // At most 32 bits at a time
+    void Put(const unsigned int &value, const unsigned int &count){
+        this->bits_  |= (unsigned long long) value << this->count_;
+        this->count_ += count;
+        if(this->count_ >= 32){
+            const unsigned int word = (unsigned int) this->bits_;
+            std::memcpy(this->out_ + this->used_, &word, sizeof(word));
+            this->used_  += sizeof(word);
+            this->bits_ >>= 32;
+            this->count_ -= 32;
+        }
+    }
+    unsigned long long Finish(){
+        while(this->count_ > 0){
+            this->out_[this->used_++] = (unsigned char) this->bits_;
+            this->bits_ >>= 8;
+            this->count_ = (this->count_ > 8) ? this->count_ - 8 : 0;
+        }
+        this->bits_ = 0;
+        return this->used_;
+    }
+private:
+    unsigned char      *out_;
+    unsigned long long  used_;
+    unsigned long long  bits_;
+    unsigned int        count_;
+};
+
+static inline unsigned int CountTrailingZeros(const unsigned long long &value){
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (unsigned int) index;
+#elif defined(__GNUC__)
+    return (unsigned int) __builtin_ctzll(value);
+#else
+    unsigned int zeros = 0;
+    while(!((value >> zeros) & 1)) zeros++;
+    return zeros;
+#endif
+}
+
+// Reads past the end as zero bits and remembers that it did
+class FrameBitReader{
+public:
+    FrameBitReader(const unsigned char *in, const unsigned long long &bytes){
+        this->in_      = in;
+        this->bytes_   = bytes;
+        this->next_    = 0;
+        this->bits_    = 0;
+        this->count_   = 0;
+        this->overrun_ = false;
+    }
+    // Tops the buffer up to at least 56 bits while the stream lasts
+    void Refill(){
+        if(this->next_ + 8 <= this->bytes_){
+            unsigned long long word;
+            std::memcpy(&word, this->in_ + this->next_, sizeof(word));
+            this->bits_  |= word << this->count_;
+            this->next_  += (63 - this->count_) >> 3;
+            this->count_ |= 56;
+            return;
+        }
+        while((this->count_ < 56) && (this->next_ < this->bytes_)){
+            this->bits_  |= (unsigned long long) this->in_[this->next_++] << this->count_;
+            this->count_ += 8;
+        }
+    }
+    // At most 32 bits at a time
+    unsigned int Get(const unsigned int &count){
+        if(this->count_ < count) this->Refill();
+        if(this->count_ < count){
+            this->overrun_ = true;
+            this->count_   = count;
+        }
+        const unsigned int value = (unsigned int)(this->bits_ & ((1ull << count) - 1));
+        this->bits_  >>= count;
+        this->count_  -= count;
+        return value;
+    }
+    // Ones before the next zero, which is consumed too, or limit ones
+    unsigned int GetUnary(const unsigned int &limit){
+        if(this->count_ <= limit) this->Refill();
+        // A full word of ones has no zero to find, the fast refill can fill all 64 bits
+        const unsigned long long zeros = ~this->bits_;
+        unsigned int ones = (zeros != 0) ? CountTrailingZeros(zeros) : limit;
+        if(ones >= limit) ones = limit;
+        const unsigned int used = (ones < limit) ? ones + 1 : ones;
+        if(used > this->count_){
+            this->overrun_ = true;
+            this->count_   = used;
+        }
+        this->bits_  >>= used;
+        this->count_  -= used;
+        return ones;
+    }
+    bool isOverrun() const{
+        return this->overrun_;
+    }
+private:
+    const unsigned char *in_;
+    unsigned long long   bytes_;
+    unsigned long long   next_;
+    unsigned long long   bits_;
+    unsigned int         count_;
+    bool                 overrun_;
+};
+
+// LOCO-I median edge detector, the gradient prediction clamped to the range
+// of the left and upper pixels. Written without branches as noise makes them
+// unpredictable.
+static inline unsigned char PredictMedian(const unsigned char &left, const unsigned char &up, const unsigned char &up_left){
+    const int low      = (left < up) ? left : up;
+    const int high     = (left < up) ? up : left;
+    const int gradient = (int) left + up - up_left;
+    const int clamped  = (gradient < low) ? low : gradient;
+    return (unsigned char)((clamped > high) ? high : clamped);
+}
+
+// Small residuals of either sign map to small codes
+static inline unsigned char ZigZag(const unsigned char &residual){
+    const signed char value = (signed char) residual;
+    return (unsigned char)((residual << 1) ^ (value >> 7));
+}
+
+static inline unsigned char UnZigZag(const unsigned char &code){
+    return (unsigned char)((code >> 1) ^ (unsigned char)(-(code & 1)));
+}
+
+// Residual codes of a row against one predictor, returning their sum. The
+// row above the first is zeros, and left of the first column is the pixel above.
+static unsigned long long PredictRow(const unsigned int     &predictor,
+                                     const unsigned char    *row,
+                                     const unsigned char    *previous,
+                                     const unsigned int     &columns,
+                                     unsigned char          *codes){
+    switch(predictor){
+    case FRAME_CODEC_PREDICT_LEFT:
+        codes[0] = ZigZag((unsigned char)(row[0] - previous[0]));
+        for(unsigned int xCol = 1; xCol < columns; xCol++) codes[xCol] = ZigZag((unsigned char)(row[xCol] - row[xCol - 1]));
+        break;
+    case FRAME_CODEC_PREDICT_UP:
+        for(unsigned int xCol = 0; xCol < columns; xCol++) codes[xCol] = ZigZag((unsigned char)(row[xCol] - previous[xCol]));
+        break;
+    case FRAME_CODEC_PREDICT_MEDIAN:
+        codes[0] = ZigZag((unsigned char)(row[0] - previous[0]));
+        for(unsigned int xCol = 1; xCol < columns; xCol++){
+            codes[xCol] = ZigZag((unsigned char)(row[xCol] - PredictMedian(row[xCol - 1], previous[xCol], previous[xCol - 1])));
+        }
+        break;
+    default:
+        for(unsigned int xCol = 0; xCol < columns; xCol++) codes[xCol] = ZigZag(row[xCol]);
+        break;
+    }
+
+    unsigned long long cost = 0;
+    for(unsigned int xCol = 0; xCol < columns; xCol++) cost += codes[xCol];
+    return cost;
+}
+
+// The inverse of PredictRow, pixel by pixel as each prediction needs the pixel before
+static void ReconstructRow(const unsigned int     &predictor,
+                           const unsigned char    *codes,
+                           const unsigned char    *previous,
+                           const unsigned int     &columns,
+                           unsigned char          *row){
+    switch(predictor){
+    case FRAME_CODEC_PREDICT_LEFT:{
+        unsigned char left = previous[0];
+        for(unsigned int xCol = 0; xCol < columns; xCol++){
+            left      = (unsigned char)(left + UnZigZag(codes[xCol]));
+            row[xCol] = left;
+        }
+        break;
+    }
+    case FRAME_CODEC_PREDICT_UP:
+        for(unsigned int xCol = 0; xCol < columns; xCol++) row[xCol] = (unsigned char)(previous[xCol] + UnZigZag(codes[xCol]));
+        break;
+    case FRAME_CODEC_PREDICT_MEDIAN:
+        row[0] = (unsigned char)(previous[0] + UnZigZag(codes[0]));
+        for(unsigned int xCol = 1; xCol < columns; xCol++){
+            row[xCol] = (unsigned char)(PredictMedian(row[xCol - 1], previous[xCol], previous[xCol - 1]) + UnZigZag(codes[xCol]));
+        }
+        break;
+    default:
+        for(unsigned int xCol = 0; xCol < columns; xCol++) row[xCol] = UnZigZag(codes[xCol]);
+        break;
+    }
+}
+
+static unsigned int GetRiceBits(const unsigned char *codes, const unsigned int &count, const unsigned int &k){
+    unsigned int bits = 0;
+    for(unsigned int iCode = 0; iCode < count; iCode++){
+        const unsigned int quotient = codes[iCode] >> k;
+        bits += (quotient < FRAME_CODEC_ESCAPE) ? quotient + 1 + k : FRAME_CODEC_ESCAPE + 8;
+    }
+    return bits;
+}
+
+static void EncodeBlock(const unsigned char *codes, const unsigned int &count, FrameBitWriter *writer){
+    unsigned int sum = 0;
+    for(unsigned int iCode = 0; iCode < count; iCode++) sum += codes[iCode];
+    if(sum == 0){
+        writer->Put(FRAME_CODEC_CODE_ZERO, 4);
+        return;
+    }
+
+    // The smallest k with count * 2^k at least the sum is the best k or one
+    // above it, as in LOCO-I
+    unsigned int k = 0;
+    while((k < FRAME_CODEC_CODE_RAW - 1) && ((count << k) < sum)) k++;
+
+    unsigned int bits = GetRiceBits(codes, count, k);
+    if(k > 0){
+        const unsigned int lower_bits = GetRiceBits(codes, count, k - 1);
+        if(lower_bits <= bits){
+            bits = lower_bits;
+            k--;
+        }
+    }
+    if(bits >= 8 * count) k = FRAME_CODEC_CODE_RAW;
+
+    writer->Put(k, 4);
+    if(k == FRAME_CODEC_CODE_RAW){
+        for(unsigned int iCode = 0; iCode < count; iCode++) writer->Put(codes[iCode], 8);
+        return;
+    }
+    for(unsigned int iCode = 0; iCode < count; iCode++){
+        const unsigned int quotient = codes[iCode] >> k;
+        if(quotient < FRAME_CODEC_ESCAPE){
+            // The ones, the zero, then the low bits in one write
+            writer->Put(((1u << quotient) - 1) | ((codes[iCode] & ((1u << k) - 1)) << (quotient + 1)), quotient + 1 + k);
+        }
+        else{
+            writer->Put(((1u << FRAME_CODEC_ESCAPE) - 1) | ((unsigned int) codes[iCode] << FRAME_CODEC_ESCAPE), FRAME_CODEC_ESCAPE + 8);
+        }
+    }
+}
+
+static bool DecodeBlock(FrameBitReader *reader, const unsigned int &count, unsigned char *codes){
+    const unsigned int k = reader->Get(4);
+    if(k == FRAME_CODEC_CODE_ZERO){
+        std::memset(codes, 0, count);
+        return true;
+    }
+    if(k == FRAME_CODEC_CODE_RAW){
+        for(unsigned int iCode = 0; iCode < count; iCode++) codes[iCode] = (unsigned char) reader->Get(8);
+        return true;
+    }
+    if(k > FRAME_CODEC_CODE_RAW) return false;
+
+    for(unsigned int iCode = 0; iCode < count; iCode++){
+        const unsigned int quotient = reader->GetUnary(FRAME_CODEC_ESCAPE);
+        unsigned int code;
+        if(quotient < FRAME_CODEC_ESCAPE) code = (quotient << k) | ((k > 0) ? reader->Get(k) : 0);
+        else                              code = reader->Get(8);
+        if(code > 255) return false;
+        codes[iCode] = (unsigned char) code;
+    }
+    return true;
+}
+
+void EncodeFramePixels(const unsigned char          *pixels,
+                       const unsigned int           &columns,
+                       const unsigned int           &rows,
+                       const unsigned long long     &stride,
+                       std::vector<unsigned char>   *encoded){
+    // Worst case is every block RAW
+    const unsigned long long blocks = (columns + FRAME_CODEC_BLOCK_PIXELS - 1) / FRAME_CODEC_BLOCK_PIXELS;
+    encoded->resize((size_t)(((unsigned long long) rows * (2 + blocks * 4 + 8ull * columns) + 7) / 8 + 8));
+
+    // Residual codes of each predictor for the current row
+    std::vector<unsigned char> codes(4 * (size_t) columns + 1);
+    std::vector<unsigned char> zeros((size_t) columns + 1, 0);
+
+    FrameBitWriter writer(&(*encoded)[0]);
+    unsigned int   predictor = FRAME_CODEC_PREDICT_NONE;
+    for(unsigned int yRow = 0; yRow < rows; yRow++){
+        const unsigned char *row      = pixels + yRow * stride;
+        const unsigned char *previous = (yRow > 0) ? row - stride : &zeros[0];
+
+        // Neighbouring rows mostly favour the same predictor, so all of them
+        // are only compared every few rows, and on the second row since the
+        // first has no row above
+        if((yRow % FRAME_CODEC_PREDICTOR_ROWS) <= 1){
+            unsigned long long best_cost = 0;
+            for(unsigned int iPredictor = 0; iPredictor < 4; iPredictor++){
+                const unsigned long long cost = PredictRow(iPredictor, row, previous, columns, &codes[iPredictor * columns]);
+                if((iPredictor == 0) || (cost < best_cost)){
+                    best_cost = cost;
+                    predictor = iPredictor;
+                }
+            }
+        }
+        else{
+            PredictRow(predictor, row, previous, columns, &codes[predictor * columns]);
+        }
+        writer.Put(predictor, 2);
+
+        const unsigned char *row_codes = &codes[predictor * columns];
+        for(unsigned int xCol = 0; xCol < columns; xCol += FRAME_CODEC_BLOCK_PIXELS){
+            const unsigned int count = ((columns - xCol) < FRAME_CODEC_BLOCK_PIXELS) ? (columns - xCol) : FRAME_CODEC_BLOCK_PIXELS;
+            EncodeBlock(row_codes + xCol, count, &writer);
+        }
+    }
+    encoded->resize((size_t) writer.Finish());
+}
+
+bool DecodeFramePixels(const unsigned char          *encoded,
+                       const unsigned long long     &bytes,
+                       const unsigned int           &columns,
+                       const unsigned int           &rows,
+                       unsigned char                *pixels){
+    FrameBitReader reader(encoded, bytes);
+    std::vector<unsigned char> codes((size_t) columns + FRAME_CODEC_BLOCK_PIXELS);
+    std::vector<unsigned char> zeros((size_t) columns + 1, 0);
+
+    for(unsigned int yRow = 0; yRow < rows; yRow++){
+        unsigned char       *row      = pixels + (unsigned long long) yRow * columns;
+        const unsigned char *previous = (yRow > 0) ? row - columns : &zeros[0];
+
+        const unsigned int predictor = reader.Get(2);
+        for(unsigned int xCol = 0; xCol < columns; xCol += FRAME_CODEC_BLOCK_PIXELS){
+            const unsigned int count = ((columns - xCol) < FRAME_CODEC_BLOCK_PIXELS) ? (columns - xCol) : FRAME_CODEC_BLOCK_PIXELS;
+            if(!DecodeBlock(&reader, count, &codes[xCol])) return false;
+        }
+        if(reader.isOverrun()) return false;
+
+        ReconstructRow(predictor, &codes[0], previous, columns, row);
+    }
+    return true;
+}
+
+dlp::ReturnCode EncodeFrame(const dlp::Image &frame, std::vector<unsigned char> *encoded){
+    dlp::ReturnCode ret;
+
+    if(!encoded) return ret.AddError(FRAME_CODEC_NULL_POINTER);
+
+    dlp::Image::Format format;
+    frame.GetDataFormat(&format);
+    if(frame.isEmpty() || (format != dlp::Image::Format::MONO_UCHAR)) return ret.AddError(FRAME_CODEC_FORMAT_INVALID);
+
+    cv::Mat data;
+    frame.GetOpenCVData(&data);
+
+    std::vector<unsigned char> body;
+    EncodeFramePixels(data.ptr<unsigned char>(0), data.cols, data.rows, (unsigned long long) data.step, &body);
+
+    FrameCodecHeader header;
+    header.magic   = FRAME_CODEC_MAGIC;
+    header.version = FRAME_CODEC_VERSION;
+    header.columns = data.cols;
+    header.rows    = data.rows;
+
+    encoded->resize(sizeof(header) + body.size());
+    std::memcpy(&(*encoded)[0], &header, sizeof(header));
+    if(!body.empty()) std::memcpy(&(*encoded)[sizeof(header)], &body[0], body.size());
+    return ret;
+}
+
+dlp::ReturnCode DecodeFrame(const unsigned char *encoded, const unsigned long long &bytes, dlp::Image *frame){
+    dlp::ReturnCode ret;
+
+    if(!encoded || !frame) return ret.AddError(FRAME_CODEC_NULL_POINTER);
+
+    FrameCodecHeader header;
+    if(bytes < sizeof(header)) return ret.AddError(FRAME_CODEC_FORMAT_INVALID);
+    std::memcpy(&header, encoded, sizeof(header));
+    if((header.magic != FRAME_CODEC_MAGIC) || (header.version != FRAME_CODEC_VERSION) ||
+       (header.columns == 0) || (header.rows == 0)){
+        return ret.AddError(FRAME_CODEC_FORMAT_INVALID);
+    }
+
+    frame->Create(header.columns, header.rows, dlp::Image::Format::MONO_UCHAR);
+    cv::Mat data;
+    frame->Unsafe_GetOpenCVData(&data);
+
+    if(!DecodeFramePixels(encoded + sizeof(header), bytes - sizeof(header), header.columns, header.rows, data.ptr<unsigned char>(0))){
+        frame->Clear();
+        return ret.AddError(FRAME_CODEC_DATA_CORRUPT);
+    }
+    return ret;
+}
+
+dlp::ReturnCode SaveFrame(const dlp::Image &frame, const std::string &filename){
+    std::vector<unsigned char> encoded;
+    dlp::ReturnCode ret = EncodeFrame(frame, &encoded);
+    if(ret.hasErrors()) return ret;
+
+    FILE *file = std::fopen(filename.c_str(), "wb");
+    if(!file) return ret.AddError(FRAME_CODEC_OPEN_FAILED);
+
+    const bool written = (std::fwrite(&encoded[0], 1, encoded.size(), file) == encoded.size());
+    if((std::fclose(file) != 0) || !written) ret.AddError(FRAME_CODEC_WRITE_FAILED);
+    return ret;
+}
+
+dlp::ReturnCode LoadFrame(const std::string &filename, dlp::Image *frame){
+    dlp::ReturnCode ret;
+
+    if(!frame) return ret.AddError(FRAME_CODEC_NULL_POINTER);
+
+    std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+    if(!file.is_open()) return ret.AddError(FRAME_CODEC_OPEN_FAILED);
+
+    const std::streamoff bytes = file.tellg();
+    if(bytes <= 0) return ret.AddError(FRAME_CODEC_FORMAT_INVALID);
+
+    std::vector<unsigned char> encoded((size_t) bytes);
+    file.seekg(0);
+    if(!file.read((char*) &encoded[0], bytes)) return ret.AddError(FRAME_CODEC_READ_FAILED);
+
+    return DecodeFrame(&encoded[0], encoded.size(), frame);
+}
+
+dlp::ReturnCode SaveImageFile(const dlp::Image      &image,
+                              const std::string     &file_base,
+                              const std::string     &format,
+                              unsigned long long    *file_bytes){
+    dlp::ReturnCode ret;
+
+    dlp::Image::Format data_format;
+    image.GetDataFormat(&data_format);
+
+    std::string filename;
+    if((format == FRAME_CODEC_FORMAT_DLPF) && (data_format == dlp::Image::Format::MONO_UCHAR)){
+        filename = file_base + FRAME_CODEC_EXTENSION;
+        ret = SaveFrame(image, filename);
+    }
+    else{
+        filename = file_base + ".bmp";
+        ret = image.Save(filename);
+    }
+
+    if(file_bytes && !ret.hasErrors()){
+        std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+        *file_bytes = file.is_open() ? (unsigned long long) file.tellg() : 0;
+    }
+    return ret;
+}
+
+dlp::ReturnCode LoadImageFile(const std::string &file_base, dlp::Image *image){
+    dlp::ReturnCode ret;
+
+    if(!image) return ret.AddError(FRAME_CODEC_NULL_POINTER);
+
+    std::ifstream encoded((file_base + FRAME_CODEC_EXTENSION).c_str(), std::ios::binary);
+    if(encoded.is_open()){
+        encoded.close();
+        return LoadFrame(file_base + FRAME_CODEC_EXTENSION, image);
+    }
+    return image->Load(file_base + ".bmp");
+}
+
+static unsigned long long GetFrameBytes(const dlp::Image &frame){
+    unsigned int columns = 0, rows = 0;
+    dlp::Image::Format format;
+    frame.GetColumns(&columns);
+    frame.GetRows(&rows);
+    frame.GetDataFormat(&format);
+    return (unsigned long long) columns * rows * ((format == dlp::Image::Format::RGB_UCHAR) ? 3 : 1);
+}
+
+
+FrameWriter::FrameWriter(){
+    this->busy_        = 0;
+    this->stopping_    = false;
+    this->frame_bytes_ = 0;
+    this->file_bytes_  = 0;
+    this->format_      = FRAME_CODEC_FORMAT_BMP;
+}
+
+// Queued frames are still saved
+FrameWriter::~FrameWriter(){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->stopping_ = true;
+    }
+    this->job_queued_.notify_all();
+    for(unsigned int iThread = 0; iThread < this->workers_.size(); iThread++){
+        this->workers_[iThread].join();
+    }
+}
+
+void FrameWriter::Start(const std::string &format, const unsigned int &threads){
+    if(this->isStarted()) return;
+
+    this->format_ = format;
+
+    unsigned int count = threads;
+    if(count == 0) count = std::thread::hardware_concurrency();
+    if(count == 0) count = 1;
+    for(unsigned int iThread = 0; iThread < count; iThread++){
+        this->workers_.push_back(std::thread(&FrameWriter::Work, this));
+    }
+}
+
+bool FrameWriter::isStarted() const{
+    return !this->workers_.empty();
+}
+
+void FrameWriter::Save(const dlp::Image &frame, const std::string &file_base){
+    Job job;
+    job.frame     = frame;
+    job.file_base = file_base;
+
+    // Without workers the frame is saved right away
+    if(!this->isStarted()){
+        unsigned long long file_bytes = 0;
+        dlp::ReturnCode ret = SaveImageFile(job.frame, job.file_base, this->format_, &file_bytes);
+
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if(ret.hasErrors() && !this->errors_.hasErrors()) this->errors_ = ret;
+        this->frame_bytes_ += GetFrameBytes(job.frame);
+        this->file_bytes_  += file_bytes;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->queue_.push_back(job);
+    }
+    this->job_queued_.notify_one();
+}
+
+dlp::ReturnCode FrameWriter::Finish(unsigned long long *frame_bytes, unsigned long long *file_bytes){
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->job_done_.wait(lock,[this]{ return this->queue_.empty() && (this->busy_ == 0); });
+
+    dlp::ReturnCode ret = this->errors_;
+    if(frame_bytes) *frame_bytes = this->frame_bytes_;
+    if(file_bytes)  *file_bytes  = this->file_bytes_;
+
+    this->errors_      = dlp::ReturnCode();
+    this->frame_bytes_ = 0;
+    this->file_bytes_  = 0;
+    return ret;
+}
+
+void FrameWriter::Work(){
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    while(true){
+        this->job_queued_.wait(lock,[this]{ return this->stopping_ || !this->queue_.empty(); });
+        if(this->queue_.empty()) return;
+
+        Job job = this->queue_.front();
+        this->queue_.pop_front();
+        this->busy_++;
+        lock.unlock();
+
+        unsigned long long file_bytes = 0;
+        dlp::ReturnCode ret = SaveImageFile(job.frame, job.file_base, this->format_, &file_bytes);
+        const unsigned long long frame_bytes = GetFrameBytes(job.frame);
+        job.frame.Clear();
+
+        lock.lock();
+        if(ret.hasErrors() && !this->errors_.hasErrors()) this->errors_ = ret;
+        this->frame_bytes_ += frame_bytes;
+        this->file_bytes_  += file_bytes;
+        this->busy_--;
+        this->job_done_.notify_all();
+    }
+}
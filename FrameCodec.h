@@ -0,0 +1,112 @@
+/** @file       FrameCodec.h
+ *  @brief      Lossless encoding of 8-bit camera frames and a threaded frame writer
+ */
+#ifndef __FRAME_CODEC_H_
+#define __FRAME_CODEC_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define FRAME_CODEC_NULL_POINTER            "FRAME_CODEC_NULL_POINTER"
+#define FRAME_CODEC_FORMAT_INVALID          "FRAME_CODEC_FORMAT_INVALID"
+#define FRAME_CODEC_OPEN_FAILED             "FRAME_CODEC_OPEN_FAILED"
+#define FRAME_CODEC_WRITE_FAILED            "FRAME_CODEC_WRITE_FAILED"
+#define FRAME_CODEC_READ_FAILED             "FRAME_CODEC_READ_FAILED"
+#define FRAME_CODEC_DATA_CORRUPT            "FRAME_CODEC_DATA_CORRUPT"
+
+#define FRAME_CODEC_MAGIC                   0x46504C44  // "DLPF"
+#define FRAME_CODEC_VERSION                 1
+#define FRAME_CODEC_EXTENSION               ".dlpf"
+
+#define FRAME_CODEC_FORMAT_BMP              "bmp"
+#define FRAME_CODEC_FORMAT_DLPF             "dlpf"
+
+// Row predictors, the encoder picks the one with the smallest residuals per row
+#define FRAME_CODEC_PREDICT_NONE            0
+#define FRAME_CODEC_PREDICT_LEFT            1
+#define FRAME_CODEC_PREDICT_UP              2
+#define FRAME_CODEC_PREDICT_MEDIAN          3   // LOCO-I median edge detector
+
+// Residuals are Rice coded in blocks of this many pixels with their own parameter
+#define FRAME_CODEC_BLOCK_PIXELS            32
+
+// Encodes rows of columns pixels, stride bytes apart. Each row is predicted
+// from its left and upper neighbours and the residuals Rice coded, a block of
+// zero residuals taking 4 bits, so flat and saturated regions cost almost
+// nothing and sensor noise costs about its entropy.
+void EncodeFramePixels(const unsigned char          *pixels,
+                       const unsigned int           &columns,
+                       const unsigned int           &rows,
+                       const unsigned long long     &stride,
+                       std::vector<unsigned char>   *encoded);
+
+// False when encoded is not a complete frame of columns x rows
+bool DecodeFramePixels(const unsigned char          *encoded,
+                       const unsigned long long     &bytes,
+                       const unsigned int           &columns,
+                       const unsigned int           &rows,
+                       unsigned char                *pixels);
+
+// A MONO_UCHAR frame with its resolution in front
+dlp::ReturnCode EncodeFrame(const dlp::Image &frame, std::vector<unsigned char> *encoded);
+dlp::ReturnCode DecodeFrame(const unsigned char *encoded, const unsigned long long &bytes, dlp::Image *frame);
+
+dlp::ReturnCode SaveFrame(const dlp::Image &frame, const std::string &filename);
+dlp::ReturnCode LoadFrame(const std::string &filename, dlp::Image *frame);
+
+// Saves file_base plus the extension of format. Frames other than MONO_UCHAR
+// are always saved as BMP. Returns the bytes written in file_bytes if given.
+dlp::ReturnCode SaveImageFile(const dlp::Image      &image,
+                              const std::string     &file_base,
+                              const std::string     &format,
+                              unsigned long long    *file_bytes = NULL);
+
+// Loads file_base.dlpf, or file_base.bmp when there is none
+dlp::ReturnCode LoadImageFile(const std::string &file_base, dlp::Image *image);
+
+// Saves frames with SaveImageFile on worker threads, so the frames of a view
+// are encoded in parallel and capture does not wait on the disk
+class FrameWriter{
+public:
+    FrameWriter();
+    ~FrameWriter();
+
+    // 0 threads uses every core
+    void Start(const std::string &format, const unsigned int &threads);
+    bool isStarted() const;
+
+    // Queues the frame, which is handed over as a capture would be
+    void Save(const dlp::Image &frame, const std::string &file_base);
+
+    // Waits for the queued frames. Returns the first error of a frame which was
+    // not saved, and the bytes of the frames and their files since the last Finish.
+    dlp::ReturnCode Finish(unsigned long long *frame_bytes, unsigned long long *file_bytes);
+
+private:
+    struct Job{
+        dlp::Image  frame;
+        std::string file_base;
+    };
+
+    void Work();
+
+    std::mutex                  mutex_;
+    std::condition_variable     job_queued_;
+    std::condition_variable     job_done_;
+    std::deque<Job>             queue_;
+    unsigned int                busy_;
+    bool                        stopping_;
+    dlp::ReturnCode             errors_;
+    unsigned long long          frame_bytes_;
+    unsigned long long          file_bytes_;
+
+    std::string                 format_;
+    std::vector<std::thread>    workers_;
+};
+
+#endif
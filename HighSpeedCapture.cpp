@@ -0,0 +1,122 @@
+/** @file       HighSpeedCapture.cpp
+ *  @brief      Pattern timing at the LCr4500 limits and matching camera trigger setup
+ */
+#include "HighSpeedCapture.h"
+
+unsigned int GetMinimumPatternPeriod(const dlp::Pattern::Bitdepth &bitdepth){
+    switch(bitdepth){
+    case dlp::Pattern::Bitdepth::MONO_1BPP: return LCR4500_MIN_PERIOD_1BPP_US;
+    case dlp::Pattern::Bitdepth::MONO_2BPP: return LCR4500_MIN_PERIOD_2BPP_US;
+    case dlp::Pattern::Bitdepth::MONO_3BPP: return LCR4500_MIN_PERIOD_3BPP_US;
+    case dlp::Pattern::Bitdepth::MONO_4BPP: return LCR4500_MIN_PERIOD_4BPP_US;
+    case dlp::Pattern::Bitdepth::MONO_5BPP: return LCR4500_MIN_PERIOD_5BPP_US;
+    case dlp::Pattern::Bitdepth::MONO_6BPP: return LCR4500_MIN_PERIOD_6BPP_US;
+    case dlp::Pattern::Bitdepth::MONO_7BPP: return LCR4500_MIN_PERIOD_7BPP_US;
+    case dlp::Pattern::Bitdepth::MONO_8BPP: return LCR4500_MIN_PERIOD_8BPP_US;
+    default:                                return 0;
+    }
+}
+
+dlp::ReturnCode SetHighSpeedTiming(const dlp::Pattern::Sequence &sequence,
+                                   const unsigned int           &requested_period_us,
+                                   dlp::Parameters              *projector_settings,
+                                   unsigned int                 *period_us){
+    dlp::ReturnCode ret;
+
+    if(!projector_settings || !period_us) return ret.AddError(HIGH_SPEED_CAPTURE_NULL_POINTER);
+    if(sequence.GetCount() == 0)          return ret.AddError(HIGH_SPEED_CAPTURE_PATTERNS_EMPTY);
+
+    // Every pattern shares the sequence period so the deepest pattern sets it
+    unsigned int minimum_period = 0;
+    unsigned int deep_patterns  = 0;
+    for(unsigned int iPattern = 0; iPattern < sequence.GetCount(); iPattern++){
+        dlp::Pattern pattern;
+        sequence.Get(iPattern,&pattern);
+
+        const unsigned int pattern_period = GetMinimumPatternPeriod(pattern.bitdepth);
+        if(pattern_period == 0) return ret.AddError(HIGH_SPEED_CAPTURE_BITDEPTH_INVALID);
+
+        if(pattern.bitdepth != dlp::Pattern::Bitdepth::MONO_1BPP) deep_patterns++;
+        if(pattern_period > minimum_period) minimum_period = pattern_period;
+    }
+
+    if(deep_patterns > 0){
+        ret.AddWarning(dlp::Number::ToString(deep_patterns) + " patterns deeper than 1 bpp limit the period to " +
+                       dlp::Number::ToString(minimum_period) + "us");
+    }
+
+    (*period_us) = (requested_period_us > minimum_period) ? requested_period_us : minimum_period;
+
+    projector_settings->Set(dlp::DLP_Platform::Parameters::SequenceExposure(*period_us));
+    projector_settings->Set(dlp::DLP_Platform::Parameters::SequencePeriod(*period_us));
+
+    return ret;
+}
+
+dlp::ReturnCode StartTriggeredCamera(dlp::Camera        *camera,
+                                     const unsigned int &period_us,
+                                     dlp::Parameters    *previous_settings){
+    dlp::ReturnCode ret;
+
+    if(!camera || !previous_settings) return ret.AddError(HIGH_SPEED_CAPTURE_NULL_POINTER);
+    if(period_us == 0)                return ret.AddError(HIGH_SPEED_CAPTURE_CAMERA_TOO_SLOW);
+
+    previous_settings->Clear();
+
+    // The projector trigger output starts each exposure. The settings are
+    // saved first so the camera can be put back as it was.
+    dlp::PG_FlyCap2_C *camera_pg = dynamic_cast<dlp::PG_FlyCap2_C*>(camera);
+    if(!camera_pg){
+        ret.AddWarning("Camera has no trigger settings, frames are captured free running");
+        return ret;
+    }
+
+    ret = camera_pg->GetSetup(previous_settings);
+    if(ret.hasErrors()) return ret;
+
+    // A shorter shutter set by the exposure control is kept
+    dlp::PG_FlyCap2_C::Parameters::ShutterTime shutter_time;
+    const float maximum_shutter_ms = HIGH_SPEED_SHUTTER_DUTY * period_us / 1000.0f;
+    if(previous_settings->Get(&shutter_time).hasErrors() || (shutter_time.Get() > maximum_shutter_ms)){
+        shutter_time.Set(maximum_shutter_ms);
+    }
+
+    dlp::Parameters trigger_settings;
+    trigger_settings.Set(dlp::PG_FlyCap2_C::Parameters::TriggerMode(true));
+    trigger_settings.Set(dlp::PG_FlyCap2_C::Parameters::TriggerSource(HIGH_SPEED_TRIGGER_SOURCE));
+    trigger_settings.Set(dlp::PG_FlyCap2_C::Parameters::AutoExposure(false));
+    trigger_settings.Set(dlp::PG_FlyCap2_C::Parameters::FrameRate(1000000.0f / period_us));
+    trigger_settings.Set(shutter_time);
+
+    ret = camera_pg->Setup(trigger_settings);
+    if(ret.hasErrors()) RestoreCamera(camera, *previous_settings);
+
+    return ret;
+}
+
+dlp::ReturnCode RestoreCamera(dlp::Camera *camera, const dlp::Parameters &previous_settings){
+    dlp::ReturnCode ret;
+
+    if(!camera) return ret.AddError(HIGH_SPEED_CAPTURE_NULL_POINTER);
+
+    // Nothing was replaced on cameras without trigger settings
+    if(previous_settings.isEmpty()) return ret;
+    return camera->Setup(previous_settings);
+}
+
+dlp::ReturnCode SetupTriggeredCamera(dlp::Camera *camera, const unsigned int &period_us){
+    dlp::ReturnCode ret;
+    dlp::Parameters previous_settings;
+
+    ret = StartTriggeredCamera(camera, period_us, &previous_settings);
+    if(ret.hasErrors()) return ret;
+
+    float frame_rate = 0;
+    camera->GetFrameRate(&frame_rate);
+    if(frame_rate < 1000000.0f / period_us) ret.AddError(HIGH_SPEED_CAPTURE_CAMERA_TOO_SLOW);
+
+    // Previews and other captures between scans run free again
+    RestoreCamera(camera, previous_settings);
+
+    return ret;
+}
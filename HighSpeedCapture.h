@@ -0,0 +1,59 @@
+/** @file       HighSpeedCapture.h
+ *  @brief      Pattern timing at the LCr4500 limits and matching camera trigger setup
+ */
+#ifndef __HIGH_SPEED_CAPTURE_H_
+#define __HIGH_SPEED_CAPTURE_H_
+
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define HIGH_SPEED_CAPTURE_NULL_POINTER         "HIGH_SPEED_CAPTURE_NULL_POINTER"
+#define HIGH_SPEED_CAPTURE_PATTERNS_EMPTY       "HIGH_SPEED_CAPTURE_PATTERNS_EMPTY"
+#define HIGH_SPEED_CAPTURE_BITDEPTH_INVALID     "HIGH_SPEED_CAPTURE_BITDEPTH_INVALID"
+#define HIGH_SPEED_CAPTURE_CAMERA_TOO_SLOW      "HIGH_SPEED_CAPTURE_CAMERA_TOO_SLOW"
+
+// Shortest LCr4500 pattern periods in microseconds for each bit depth
+#define LCR4500_MIN_PERIOD_1BPP_US      235     // 4225 Hz
+#define LCR4500_MIN_PERIOD_2BPP_US      556     // 1800 Hz
+#define LCR4500_MIN_PERIOD_3BPP_US      834     // 1200 Hz
+#define LCR4500_MIN_PERIOD_4BPP_US      1112    //  900 Hz
+#define LCR4500_MIN_PERIOD_5BPP_US      1667    //  600 Hz
+#define LCR4500_MIN_PERIOD_6BPP_US      2000    //  500 Hz
+#define LCR4500_MIN_PERIOD_7BPP_US      2500    //  400 Hz
+#define LCR4500_MIN_PERIOD_8BPP_US      8334    //  120 Hz
+
+// Fraction of the period the camera shutter may stay open so the exposure
+// ends before the next trigger
+#define HIGH_SPEED_SHUTTER_DUTY         0.8f
+
+// Camera input wired to the projector trigger output
+#define HIGH_SPEED_TRIGGER_SOURCE       0
+
+// Shortest period the LCr4500 can display a pattern of the bit depth, 0 if
+// the bit depth is not supported
+unsigned int GetMinimumPatternPeriod(const dlp::Pattern::Bitdepth &bitdepth);
+
+// Sets SequenceExposure and SequencePeriod of the projector settings to the
+// requested period, raised to the shortest period every pattern of the
+// sequence allows. A requested period of 0 takes the shortest period.
+dlp::ReturnCode SetHighSpeedTiming(const dlp::Pattern::Sequence &sequence,
+                                   const unsigned int           &requested_period_us,
+                                   dlp::Parameters              *projector_settings,
+                                   unsigned int                 *period_us);
+
+// Puts the camera in external trigger mode on HIGH_SPEED_TRIGGER_SOURCE with
+// its shutter limited to fit the period, and saves the settings it replaces in
+// previous_settings. Cameras without trigger settings are left as they are.
+dlp::ReturnCode StartTriggeredCamera(dlp::Camera        *camera,
+                                     const unsigned int &period_us,
+                                     dlp::Parameters    *previous_settings);
+
+// Sets the camera up again with the settings StartTriggeredCamera replaced,
+// so free running frames are delivered again
+dlp::ReturnCode RestoreCamera(dlp::Camera *camera, const dlp::Parameters &previous_settings);
+
+// Checks the camera can follow the projector in external trigger mode at the
+// period. The camera is left with the settings it had before either way and
+// is only triggered while a high speed sequence is captured.
+dlp::ReturnCode SetupTriggeredCamera(dlp::Camera *camera, const unsigned int &period_us);
+
+#endif
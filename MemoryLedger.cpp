@@ -0,0 +1,154 @@
+/** @file       MemoryLedger.cpp
+ *  @brief      Bytes held by the scan buffers per stage and view, and the memory budget
+ */
+#include <winsock2.h>
+#include <Windows.h>
+#include <psapi.h>
+#include <fstream>
+#include "MemoryLedger.h"
+
+static const char* const BUFFER_NAMES[MEMORY_BUFFER_COUNT] = { "captures", "packed", "disparity", "confidence",
+                                                               "point_cloud", "depth_map", "color_map" };
+
+static unsigned long long GetWorkingSet(){
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(),&counters,sizeof(counters))) return 0;
+    return counters.WorkingSetSize;
+}
+
+MemoryLedger::MemoryLedger(){
+    this->budget_    = 0;
+    this->view_      = 0;
+    this->view_peak_ = 0;
+    for(unsigned int iBuffer = 0; iBuffer < MEMORY_BUFFER_COUNT; iBuffer++) this->current_[iBuffer] = 0;
+}
+
+void MemoryLedger::SetBudget(const unsigned long long &bytes){
+    this->budget_ = bytes;
+}
+
+unsigned long long MemoryLedger::GetBudget() const{
+    return this->budget_;
+}
+
+void MemoryLedger::BeginView(const unsigned int &view){
+    this->view_      = view;
+    this->view_peak_ = this->GetCurrent();
+}
+
+void MemoryLedger::BeginStage(const std::string &name){
+    MemoryStage stage;
+    stage.name             = name;
+    stage.view             = this->view_;
+    stage.peak_total       = 0;
+    stage.peak_working_set = 0;
+    for(unsigned int iBuffer = 0; iBuffer < MEMORY_BUFFER_COUNT; iBuffer++) stage.peak[iBuffer] = 0;
+
+    this->stages_.push_back(stage);
+    this->Update();
+}
+
+void MemoryLedger::Set(const unsigned int &buffer, const unsigned long long &bytes){
+    if(buffer >= MEMORY_BUFFER_COUNT) return;
+    this->current_[buffer] = bytes;
+    this->Update();
+}
+
+void MemoryLedger::Update(){
+    const unsigned long long total = this->GetCurrent();
+    if(total > this->view_peak_) this->view_peak_ = total;
+
+    if(this->stages_.empty()) this->BeginStage("scan");
+
+    MemoryStage &stage = this->stages_.back();
+    for(unsigned int iBuffer = 0; iBuffer < MEMORY_BUFFER_COUNT; iBuffer++){
+        if(this->current_[iBuffer] > stage.peak[iBuffer]) stage.peak[iBuffer] = this->current_[iBuffer];
+    }
+    if(total > stage.peak_total) stage.peak_total = total;
+
+    const unsigned long long working_set = GetWorkingSet();
+    if(working_set > stage.peak_working_set) stage.peak_working_set = working_set;
+}
+
+unsigned long long MemoryLedger::GetCurrent() const{
+    unsigned long long total = 0;
+    for(unsigned int iBuffer = 0; iBuffer < MEMORY_BUFFER_COUNT; iBuffer++) total += this->current_[iBuffer];
+    return total;
+}
+
+unsigned long long MemoryLedger::GetViewPeak() const{
+    return this->view_peak_;
+}
+
+bool MemoryLedger::isOverBudget(const unsigned long long &additional_bytes) const{
+    return (this->budget_ > 0) && (this->GetCurrent() + additional_bytes > this->budget_);
+}
+
+dlp::ReturnCode MemoryLedger::SaveReport(const std::string &filename) const{
+    dlp::ReturnCode ret;
+
+    std::ofstream file(filename.c_str());
+    if(!file.is_open()) return ret.AddError(MEMORY_LEDGER_FILE_SAVE_FAILED);
+
+    file << "view,stage";
+    for(unsigned int iBuffer = 0; iBuffer < MEMORY_BUFFER_COUNT; iBuffer++) file << "," << BUFFER_NAMES[iBuffer];
+    file << ",total,working_set\n";
+
+    for(unsigned int iStage = 0; iStage < this->stages_.size(); iStage++){
+        const MemoryStage &stage = this->stages_[iStage];
+        file << stage.view << "," << stage.name;
+        for(unsigned int iBuffer = 0; iBuffer < MEMORY_BUFFER_COUNT; iBuffer++) file << "," << stage.peak[iBuffer];
+        file << "," << stage.peak_total << "," << stage.peak_working_set << "\n";
+
+        // The high-water marks of a view follow its last stage
+        const bool last = (iStage + 1 == this->stages_.size()) || (this->stages_[iStage + 1].view != stage.view);
+        if(!last) continue;
+
+        MemoryStage view_peak = stage;
+        for(unsigned int iView = 0; iView < iStage; iView++){
+            const MemoryStage &earlier = this->stages_[iView];
+            if(earlier.view != stage.view) continue;
+            for(unsigned int iBuffer = 0; iBuffer < MEMORY_BUFFER_COUNT; iBuffer++){
+                if(earlier.peak[iBuffer] > view_peak.peak[iBuffer]) view_peak.peak[iBuffer] = earlier.peak[iBuffer];
+            }
+            if(earlier.peak_total > view_peak.peak_total) view_peak.peak_total = earlier.peak_total;
+            if(earlier.peak_working_set > view_peak.peak_working_set) view_peak.peak_working_set = earlier.peak_working_set;
+        }
+        file << stage.view << ",view_peak";
+        for(unsigned int iBuffer = 0; iBuffer < MEMORY_BUFFER_COUNT; iBuffer++) file << "," << view_peak.peak[iBuffer];
+        file << "," << view_peak.peak_total << "," << view_peak.peak_working_set << "\n";
+    }
+
+    if(file.fail()) ret.AddError(MEMORY_LEDGER_FILE_SAVE_FAILED);
+    return ret;
+}
+
+unsigned long long MemoryLedger::GetBytes(const dlp::Image &image){
+    if(image.isEmpty()) return 0;
+
+    cv::Mat data;
+    image.GetOpenCVData(&data);
+    return (unsigned long long) data.total() * data.elemSize();
+}
+
+unsigned long long MemoryLedger::GetBytes(const dlp::Capture::Sequence &sequence){
+    // Captures which refer to a file hold no image
+    unsigned long long bytes = 0;
+    for(unsigned int iCapture = 0; iCapture < sequence.GetCount(); iCapture++){
+        dlp::Capture capture;
+        sequence.Get(iCapture, &capture);
+        if(capture.data_type == dlp::Capture::DataType::IMAGE_DATA) bytes += GetBytes(capture.image_data);
+    }
+    return bytes;
+}
+
+unsigned long long MemoryLedger::GetBytes(const dlp::DisparityMap &disparity){
+    unsigned int columns = 0, rows = 0;
+    disparity.GetColumns(&columns);
+    disparity.GetRows(&rows);
+    return (unsigned long long) columns * rows * sizeof(int);
+}
+
+unsigned long long MemoryLedger::GetBytes(const dlp::Point::Cloud &point_cloud){
+    return point_cloud.GetCount() * sizeof(dlp::Point);
+}
@@ -0,0 +1,74 @@
+/** @file       MemoryLedger.h
+ *  @brief      Bytes held by the scan buffers per stage and view, and the memory budget
+ */
+#ifndef __MEMORY_LEDGER_H_
+#define __MEMORY_LEDGER_H_
+
+#include <string>
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define MEMORY_LEDGER_FILE_SAVE_FAILED  "MEMORY_LEDGER_FILE_SAVE_FAILED"
+
+// Buffer types, columns of the report
+#define MEMORY_BUFFER_CAPTURES          0   // Capture sequences of both directions
+#define MEMORY_BUFFER_PACKED            1   // Packed bit planes of the streaming decoders
+#define MEMORY_BUFFER_DISPARITY         2   // Column and row disparity maps
+#define MEMORY_BUFFER_CONFIDENCE        3
+#define MEMORY_BUFFER_POINT_CLOUD       4
+#define MEMORY_BUFFER_DEPTH_MAP         5
+#define MEMORY_BUFFER_COLOR_MAP         6
+#define MEMORY_BUFFER_COUNT             7
+
+struct MemoryStage{
+    std::string         name;
+    unsigned int        view;
+    unsigned long long  peak[MEMORY_BUFFER_COUNT];
+    unsigned long long  peak_total;
+    unsigned long long  peak_working_set;   // Of the whole process, for comparison
+};
+
+// Tracks the bytes each buffer type holds as the scan sets them, keeping the
+// peak of every buffer and of their total per stage, and the high-water mark
+// of each view. Buffers keep their size across stages and views until set
+// again, as the scan keeps them alive.
+class MemoryLedger{
+public:
+    MemoryLedger();
+
+    // 0 is no budget
+    void SetBudget(const unsigned long long &bytes);
+    unsigned long long GetBudget() const;
+
+    // Starts the high-water mark of a view over from the bytes held now
+    void BeginView(const unsigned int &view);
+    void BeginStage(const std::string &name);
+
+    void Set(const unsigned int &buffer, const unsigned long long &bytes);
+
+    unsigned long long GetCurrent() const;
+    unsigned long long GetViewPeak() const;
+
+    // Whether holding additional bytes on top of the current ones exceeds the budget
+    bool isOverBudget(const unsigned long long &additional_bytes) const;
+
+    // One row per stage with the peak of each buffer type, and a row per view
+    // with its high-water marks
+    dlp::ReturnCode SaveReport(const std::string &filename) const;
+
+    static unsigned long long GetBytes(const dlp::Image &image);
+    static unsigned long long GetBytes(const dlp::Capture::Sequence &sequence);
+    static unsigned long long GetBytes(const dlp::DisparityMap &disparity);
+    static unsigned long long GetBytes(const dlp::Point::Cloud &point_cloud);
+
+private:
+    void Update();
+
+    unsigned long long          budget_;
+    unsigned int                view_;
+    unsigned long long          view_peak_;
+    unsigned long long          current_[MEMORY_BUFFER_COUNT];
+    std::vector<MemoryStage>    stages_;
+};
+
+#endif
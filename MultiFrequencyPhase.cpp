@@ -0,0 +1,301 @@
+/** @file       MultiFrequencyPhase.cpp
+ *  @brief      Heterodyne multi-frequency phase shifting structured light module
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "MultiFrequencyPhase.h"
+#include "FrameAcquisition.h"
+
+#define TWO_PI  6.28318530717958647692
+
+// Minimum number of phase steps which separate offset, amplitude, and phase
+#define MIN_PHASE_STEPS     3
+
+// Wraps a phase to [0, 2pi)
+static double WrapPhase(const double &phase){
+    double wrapped = fmod(phase,TWO_PI);
+    if(wrapped < 0) wrapped += TWO_PI;
+    return wrapped;
+}
+
+// Creates an 8-bit sinusoid with fringe_count periods across the projector
+static void CreateFringeImage(const unsigned int &columns,
+                              const unsigned int &rows,
+                              const bool         &vertical,
+                              const unsigned int &fringe_count,
+                              const double       &shift,
+                              dlp::Image         *image){
+
+    const unsigned int extent = vertical ? columns : rows;
+    std::vector<unsigned char> line(extent);
+
+    for(unsigned int i = 0; i < extent; i++){
+        const double phase = TWO_PI * fringe_count * i / extent + shift;
+        line[i] = (unsigned char) floor(127.5 + 127.5 * cos(phase) + 0.5);
+    }
+
+    cv::Mat data(rows,columns,CV_8UC1);
+    for(unsigned int y = 0; y < rows; y++){
+        if(vertical) memcpy(data.ptr<unsigned char>(y),&line[0],columns);
+        else         memset(data.ptr<unsigned char>(y),line[y],columns);
+    }
+
+    image->Create(data);
+}
+
+MultiFrequencyPhase::MultiFrequencyPhase(){
+    this->is_setup_             = false;
+    this->projector_set_        = false;
+    this->sequence_count_total_ = 0;
+    this->stripe_extent_        = 0;
+    this->columns_              = 0;
+    this->rows_                 = 0;
+}
+
+MultiFrequencyPhase::~MultiFrequencyPhase(){
+}
+
+dlp::ReturnCode MultiFrequencyPhase::Setup(const dlp::Parameters &settings){
+    dlp::ReturnCode ret;
+
+    // The projector resolution sets the fringe periods
+    if(!this->projector_set_) return ret.AddError(MULTI_FREQUENCY_PHASE_PROJECTOR_NOT_SET);
+
+    if(settings.Get(&this->pattern_orientation_).hasErrors()) return ret.AddError(MULTI_FREQUENCY_PHASE_ORIENTATION_MISSING);
+    if((this->pattern_orientation_.Get() != dlp::Pattern::Orientation::VERTICAL) &&
+       (this->pattern_orientation_.Get() != dlp::Pattern::Orientation::HORIZONTAL)){
+        return ret.AddError(MULTI_FREQUENCY_PHASE_ORIENTATION_INVALID);
+    }
+
+    settings.Get(&this->phase_steps_);
+    settings.Get(&this->fringe_count_1_);
+    settings.Get(&this->fringe_count_2_);
+    settings.Get(&this->fringe_count_3_);
+    settings.Get(&this->modulation_threshold_);
+
+    if(this->phase_steps_.Get() < MIN_PHASE_STEPS) return ret.AddError(MULTI_FREQUENCY_PHASE_PHASE_STEPS_INVALID);
+
+    // The final beat must be one period across the projector
+    const int f1 = (int) this->fringe_count_1_.Get();
+    const int f2 = (int) this->fringe_count_2_.Get();
+    const int f3 = (int) this->fringe_count_3_.Get();
+    if((f3 < 1) || (f2 <= f3) || (f1 <= f2) || (((f1 - f2) - (f2 - f3)) != 1)){
+        return ret.AddError(MULTI_FREQUENCY_PHASE_FRINGE_COUNTS_INVALID);
+    }
+
+    const bool vertical  = (this->pattern_orientation_.Get() == dlp::Pattern::Orientation::VERTICAL);
+    this->stripe_extent_ = vertical ? this->projector_columns_ : this->projector_rows_;
+
+    this->sequence_count_total_ = MULTI_FREQUENCY_PHASE_FREQUENCY_COUNT * this->phase_steps_.Get();
+
+    this->is_setup_ = true;
+    return ret;
+}
+
+dlp::ReturnCode MultiFrequencyPhase::GetSetup(dlp::Parameters *settings) const{
+    dlp::ReturnCode ret;
+
+    if(!settings) return ret.AddError(MULTI_FREQUENCY_PHASE_NULL_POINTER);
+
+    settings->Set(this->pattern_orientation_);
+    settings->Set(this->phase_steps_);
+    settings->Set(this->fringe_count_1_);
+    settings->Set(this->fringe_count_2_);
+    settings->Set(this->fringe_count_3_);
+    settings->Set(this->modulation_threshold_);
+
+    return ret;
+}
+
+dlp::ReturnCode MultiFrequencyPhase::GeneratePatternSequence(dlp::Pattern::Sequence *pattern_sequence){
+    dlp::ReturnCode ret;
+
+    if(!pattern_sequence) return ret.AddError(MULTI_FREQUENCY_PHASE_NULL_POINTER);
+    if(!this->isSetup())  return ret.AddError(MULTI_FREQUENCY_PHASE_NOT_SETUP);
+
+    pattern_sequence->Clear();
+
+    dlp::Pattern pattern;
+    pattern.bitdepth  = dlp::Pattern::Bitdepth::MONO_8BPP;
+    pattern.color     = dlp::Pattern::Color::WHITE;
+    pattern.data_type = dlp::Pattern::DataType::IMAGE_DATA;
+
+    const unsigned int fringe_counts[MULTI_FREQUENCY_PHASE_FREQUENCY_COUNT] = {this->fringe_count_1_.Get(),
+                                                                               this->fringe_count_2_.Get(),
+                                                                               this->fringe_count_3_.Get()};
+    const unsigned int steps = this->phase_steps_.Get();
+
+    for(unsigned int iFrequency = 0; iFrequency < MULTI_FREQUENCY_PHASE_FREQUENCY_COUNT; iFrequency++){
+        for(unsigned int iStep = 0; iStep < steps; iStep++){
+            CreateFringeImage(this->projector_columns_,
+                              this->projector_rows_,
+                              this->pattern_orientation_.Get() == dlp::Pattern::Orientation::VERTICAL,
+                              fringe_counts[iFrequency],
+                              TWO_PI * iStep / steps,
+                              &pattern.image_data);
+            pattern_sequence->Add(pattern);
+        }
+    }
+
+    pattern.image_data.Clear();
+    return ret;
+}
+
+dlp::ReturnCode MultiFrequencyPhase::DecodeCaptureSequence(dlp::Capture::Sequence *capture_sequence,
+                                                           dlp::DisparityMap      *disparity_map){
+    dlp::ReturnCode ret;
+
+    if(!capture_sequence || !disparity_map) return ret.AddError(MULTI_FREQUENCY_PHASE_NULL_POINTER);
+    if(!this->isSetup())                    return ret.AddError(MULTI_FREQUENCY_PHASE_NOT_SETUP);
+    if(capture_sequence->GetCount() != this->sequence_count_total_) return ret.AddError(MULTI_FREQUENCY_PHASE_CAPTURES_MISSING);
+
+    const unsigned int steps = this->phase_steps_.Get();
+
+    std::vector<double> sin_table(steps);
+    std::vector<double> cos_table(steps);
+    for(unsigned int iStep = 0; iStep < steps; iStep++){
+        sin_table[iStep] = sin(TWO_PI * iStep / steps);
+        cos_table[iStep] = cos(TWO_PI * iStep / steps);
+    }
+
+    // Sums are folded into a wrapped phase once each frequency is complete
+    // so only one capture is held at a time
+    std::vector<float>          sum_sin;
+    std::vector<float>          sum_cos;
+    std::vector<float>          phases[MULTI_FREQUENCY_PHASE_FREQUENCY_COUNT];
+    std::vector<unsigned char>  modulation;
+
+    this->confidence_.clear();
+
+    for(unsigned int iCapture = 0; iCapture < capture_sequence->GetCount(); iCapture++){
+        dlp::Capture capture;
+        capture_sequence->Get(iCapture,&capture);
+
+        if(capture.data_type == dlp::Capture::DataType::IMAGE_FILE){
+            capture.image_data.Load(capture.image_file);
+        }
+
+        unsigned int columns;
+        unsigned int rows;
+        capture.image_data.GetColumns(&columns);
+        capture.image_data.GetRows(&rows);
+
+        if(iCapture == 0){
+            this->columns_ = columns;
+            this->rows_    = rows;
+            sum_sin.assign((size_t) columns * rows,0);
+            sum_cos.assign((size_t) columns * rows,0);
+            modulation.assign((size_t) columns * rows,255);
+        }
+        else if((columns != this->columns_) || (rows != this->rows_)){
+            return ret.AddError(MULTI_FREQUENCY_PHASE_RESOLUTION_MISMATCH);
+        }
+
+        ret = ConvertToMonochromeWithSum(&capture.image_data,NULL);
+        if(ret.hasErrors()) return ret;
+
+        cv::Mat data;
+        capture.image_data.Unsafe_GetOpenCVData(&data);
+
+        const unsigned int frequency = iCapture / steps;
+        const unsigned int step      = iCapture % steps;
+        const float        s         = (float) sin_table[step];
+        const float        c         = (float) cos_table[step];
+
+        if(step == 0){
+            std::fill(sum_sin.begin(),sum_sin.end(),0.0f);
+            std::fill(sum_cos.begin(),sum_cos.end(),0.0f);
+        }
+
+        for(unsigned int y = 0; y < rows; y++){
+            const unsigned char *row       = data.ptr<unsigned char>(y);
+            float               *row_sin   = &sum_sin[(size_t) y * columns];
+            float               *row_cos   = &sum_cos[(size_t) y * columns];
+            for(unsigned int x = 0; x < columns; x++){
+                row_sin[x] += row[x] * s;
+                row_cos[x] += row[x] * c;
+            }
+        }
+
+        if(step + 1 < steps) continue;
+
+        // I = A + B cos(phase + shift) gives sum_sin = -N/2 B sin(phase) and
+        // sum_cos = N/2 B cos(phase)
+        phases[frequency].resize((size_t) columns * rows);
+        for(size_t i = 0; i < sum_sin.size(); i++){
+            phases[frequency][i] = (float) WrapPhase(atan2(-sum_sin[i],sum_cos[i]));
+
+            const double amplitude = 2.0 * sqrt((double) sum_sin[i] * sum_sin[i] + (double) sum_cos[i] * sum_cos[i]) / steps;
+            const unsigned char clamped = (amplitude >= 255) ? 255 : (unsigned char) amplitude;
+            if(clamped < modulation[i]) modulation[i] = clamped;
+        }
+    }
+
+    disparity_map->Create(this->columns_,this->rows_,this->pattern_orientation_.Get());
+    this->confidence_.assign((size_t) this->columns_ * this->rows_,0);
+
+    const double f1        = this->fringe_count_1_.Get();
+    const double f2        = this->fringe_count_2_.Get();
+    const double beat_12   = f1 - f2;
+    const double ratio_1   = f1 / beat_12;
+    const double extent    = this->stripe_extent_;
+    const unsigned int threshold = this->modulation_threshold_.Get();
+
+    for(unsigned int y = 0; y < this->rows_; y++){
+        for(unsigned int x = 0; x < this->columns_; x++){
+            const size_t i = (size_t) y * this->columns_ + x;
+
+            if(modulation[i] <= threshold){
+                disparity_map->Unsafe_SetPixel(x,y,dlp::DisparityMap::INVALID_PIXEL);
+                continue;
+            }
+
+            const double phase_1   = phases[0][i];
+            const double phase_12  = WrapPhase(phases[0][i] - phases[1][i]);
+            const double phase_23  = WrapPhase(phases[1][i] - phases[2][i]);
+            const double phase_123 = WrapPhase(phase_12 - phase_23);     // One period across the projector
+
+            // Unwrap the first beat with the single period, then frequency 1 with the first beat
+            const double expected_12  = beat_12 * phase_123;
+            const double unwrapped_12 = phase_12 + TWO_PI * floor((expected_12 - phase_12) / TWO_PI + 0.5);
+
+            const double expected_1  = ratio_1 * unwrapped_12;
+            const double unwrapped_1 = phase_1 + TWO_PI * floor((expected_1 - phase_1) / TWO_PI + 0.5);
+
+            // Disagreement between the levels, pi means the unwrap is a guess
+            const double error_12 = fabs(expected_12 - unwrapped_12);
+            const double error_1  = fabs(expected_1  - unwrapped_1);
+            const double error    = (error_12 > error_1) ? error_12 : error_1;
+
+            const double position = floor(unwrapped_1 * extent / (TWO_PI * f1) + 0.5);
+
+            if((error > (TWO_PI / 4)) || (position < 0) || (position >= extent)){
+                disparity_map->Unsafe_SetPixel(x,y,dlp::DisparityMap::INVALID_PIXEL);
+                continue;
+            }
+
+            disparity_map->Unsafe_SetPixel(x,y,(int) position);
+
+            const unsigned char quality = (unsigned char)(255 * (1.0 - 2.0 * error / TWO_PI));
+            this->confidence_[i] = (quality < modulation[i]) ? quality : modulation[i];
+        }
+    }
+
+    return ret;
+}
+
+dlp::ReturnCode MultiFrequencyPhase::GetConfidenceMap(dlp::Image *confidence) const{
+    dlp::ReturnCode ret;
+
+    if(!confidence)                 return ret.AddError(MULTI_FREQUENCY_PHASE_NULL_POINTER);
+    if(this->confidence_.empty())   return ret.AddError(DECODE_CONFIDENCE_NOT_AVAILABLE);
+
+    cv::Mat data(this->rows_,this->columns_,CV_8UC1);
+    for(unsigned int y = 0; y < this->rows_; y++){
+        memcpy(data.ptr<unsigned char>(y),&this->confidence_[(size_t) y * this->columns_],this->columns_);
+    }
+
+    confidence->Create(data);
+    return ret;
+}
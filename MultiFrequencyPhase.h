@@ -0,0 +1,79 @@
+/** @file       MultiFrequencyPhase.h
+ *  @brief      Heterodyne multi-frequency phase shifting structured light module
+ */
+#ifndef __MULTI_FREQUENCY_PHASE_H_
+#define __MULTI_FREQUENCY_PHASE_H_
+
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+#include "DecodeConfidence.h"
+
+#define MULTI_FREQUENCY_PHASE_NOT_SETUP                 "MULTI_FREQUENCY_PHASE_NOT_SETUP"
+#define MULTI_FREQUENCY_PHASE_NULL_POINTER              "MULTI_FREQUENCY_PHASE_NULL_POINTER"
+#define MULTI_FREQUENCY_PHASE_PROJECTOR_NOT_SET         "MULTI_FREQUENCY_PHASE_PROJECTOR_NOT_SET"
+#define MULTI_FREQUENCY_PHASE_PHASE_STEPS_INVALID       "MULTI_FREQUENCY_PHASE_PHASE_STEPS_INVALID"
+#define MULTI_FREQUENCY_PHASE_FRINGE_COUNTS_INVALID     "MULTI_FREQUENCY_PHASE_FRINGE_COUNTS_INVALID"
+#define MULTI_FREQUENCY_PHASE_CAPTURES_MISSING          "MULTI_FREQUENCY_PHASE_CAPTURES_MISSING"
+#define MULTI_FREQUENCY_PHASE_RESOLUTION_MISMATCH       "MULTI_FREQUENCY_PHASE_RESOLUTION_MISMATCH"
+#define MULTI_FREQUENCY_PHASE_ORIENTATION_MISSING       "MULTI_FREQUENCY_PHASE_ORIENTATION_MISSING"
+#define MULTI_FREQUENCY_PHASE_ORIENTATION_INVALID       "MULTI_FREQUENCY_PHASE_ORIENTATION_INVALID"
+
+#define MULTI_FREQUENCY_PHASE_FREQUENCY_COUNT   3
+
+// Three frequency heterodyne phase shifting. Each frequency is projected as
+// PhaseSteps shifted sinusoids and has FringeCount periods across the
+// projector. The beat of frequencies 1 and 2 and the beat of 2 and 3 are
+// beaten again, which needs
+//
+//   (FringeCount1 - FringeCount2) - (FringeCount2 - FringeCount3) = 1
+//
+// so the final beat is a single period over the whole projector. The phase
+// is then unwrapped from that period down to frequency 1 (temporal
+// unwrapping), without any Gray code patterns.
+//
+// The fringe orientation is the SDK's structured light PatternOrientation
+// setting, as for dlp::ThreePhase, and has to be VERTICAL or HORIZONTAL.
+//
+// Pattern sequence layout:
+//   PhaseSteps patterns of frequency 1, then frequency 2, then frequency 3.
+//   The default 4 steps take 12 patterns per direction.
+class MultiFrequencyPhase : public dlp::StructuredLight, public DecodeConfidence{
+public:
+    class Parameters{
+    public:
+        DLP_NEW_PARAMETERS_ENTRY(PhaseSteps,            "MULTI_FREQUENCY_PHASE_STEPS",                  unsigned int,   4);
+        DLP_NEW_PARAMETERS_ENTRY(FringeCount1,          "MULTI_FREQUENCY_PHASE_FRINGE_COUNT_1",         unsigned int,   70);
+        DLP_NEW_PARAMETERS_ENTRY(FringeCount2,          "MULTI_FREQUENCY_PHASE_FRINGE_COUNT_2",         unsigned int,   64);
+        DLP_NEW_PARAMETERS_ENTRY(FringeCount3,          "MULTI_FREQUENCY_PHASE_FRINGE_COUNT_3",         unsigned int,   59);
+        DLP_NEW_PARAMETERS_ENTRY(ModulationThreshold,   "MULTI_FREQUENCY_PHASE_MODULATION_THRESHOLD",   unsigned int,   5);
+    };
+
+    MultiFrequencyPhase();
+    ~MultiFrequencyPhase();
+
+    dlp::ReturnCode Setup(const dlp::Parameters &settings);
+    dlp::ReturnCode GetSetup(dlp::Parameters *settings) const;
+
+    dlp::ReturnCode GeneratePatternSequence(dlp::Pattern::Sequence *pattern_sequence);
+    dlp::ReturnCode DecodeCaptureSequence(dlp::Capture::Sequence *capture_sequence,
+                                          dlp::DisparityMap      *disparity_map);
+
+    // Lowest fringe modulation of the three frequencies, limited by how well
+    // the unwrapped phases of neighbouring frequencies agree
+    dlp::ReturnCode GetConfidenceMap(dlp::Image *confidence) const;
+
+private:
+    Parameters::PhaseSteps          phase_steps_;
+    Parameters::FringeCount1        fringe_count_1_;
+    Parameters::FringeCount2        fringe_count_2_;
+    Parameters::FringeCount3        fringe_count_3_;
+    Parameters::ModulationThreshold modulation_threshold_;
+
+    unsigned int stripe_extent_;    // Projector columns (vertical) or rows (horizontal)
+
+    unsigned int columns_;
+    unsigned int rows_;
+    std::vector<unsigned char> confidence_;
+};
+
+#endif
@@ -0,0 +1,181 @@
+/** @file       PatternCache.cpp
+ *  @brief      On disk cache of generated pattern sequences keyed by a settings hash
+ */
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include "PatternCache.h"
+
+#ifdef _WIN32
+#include <direct.h>     // Included for _mkdir
+#else
+#include <sys/stat.h>   // Included for mkdir
+#endif
+
+#define FNV_PRIME   0x100000001b3ULL
+
+// Index file identifier and version
+static const std::string PATTERN_CACHE_MAGIC = "DLPPATTERNS1";
+
+static const std::string PATTERN_CACHE_INDEX_FILE     = "index.txt";
+static const std::string PATTERN_CACHE_PROJECTOR_FILE = "projector_key.txt";
+
+// Creates a single directory level, existing directories are not an error
+static void MakeDirectory(const std::string &directory){
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(),0755);
+#endif
+}
+
+unsigned long long HashBytes(const void *data, const size_t &size, const unsigned long long &seed){
+    const unsigned char *bytes = (const unsigned char*) data;
+    unsigned long long   hash  = seed;
+    for(size_t i = 0; i < size; i++){
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+unsigned long long HashString(const std::string &text, const unsigned long long &seed){
+    return HashBytes(text.data(),text.size(),seed);
+}
+
+dlp::ReturnCode HashFile(const std::string &filename, unsigned long long *hash){
+    dlp::ReturnCode ret;
+
+    if(!hash) return ret.AddError(PATTERN_CACHE_NULL_POINTER);
+
+    (*hash) = HashString(filename,*hash);
+
+    std::ifstream file(filename.c_str(),std::ios::in | std::ios::binary);
+    if(!file.is_open()) return ret.AddError(PATTERN_CACHE_FILE_OPEN_FAILED);
+
+    std::vector<char> buffer(64 * 1024);
+    while(file.read(&buffer[0],buffer.size()) || (file.gcount() > 0)){
+        (*hash) = HashBytes(&buffer[0],(size_t) file.gcount(),*hash);
+    }
+
+    return ret;
+}
+
+std::string HashToString(const unsigned long long &hash){
+    char text[17];
+    snprintf(text,sizeof(text),"%016llx",hash);
+    return std::string(text);
+}
+
+PatternCache::PatternCache(){
+    this->directory_ = "cache/";
+}
+
+void PatternCache::SetDirectory(const std::string &directory){
+    this->directory_ = directory;
+    if(!this->directory_.empty() &&
+       (this->directory_[this->directory_.size() - 1] != '/') &&
+       (this->directory_[this->directory_.size() - 1] != '\\')) this->directory_ += "/";
+}
+
+const std::string& PatternCache::GetDirectory() const{
+    return this->directory_;
+}
+
+dlp::ReturnCode PatternCache::Load(const unsigned long long &key, dlp::Pattern::Sequence *sequence) const{
+    dlp::ReturnCode ret;
+
+    if(!sequence) return ret.AddError(PATTERN_CACHE_NULL_POINTER);
+
+    const std::string directory = this->directory_ + HashToString(key) + "/";
+
+    std::ifstream index((directory + PATTERN_CACHE_INDEX_FILE).c_str());
+    if(!index.is_open()) return ret.AddError(PATTERN_CACHE_MISS);
+
+    std::string  magic;
+    unsigned int count = 0;
+    if(!(index >> magic >> count) || (magic != PATTERN_CACHE_MAGIC)) return ret.AddError(PATTERN_CACHE_FILE_INVALID);
+
+    sequence->Clear();
+    for(unsigned int iPattern = 0; iPattern < count; iPattern++){
+        int          bitdepth;
+        int          color;
+        std::string  image_file;
+        if(!(index >> bitdepth >> color >> image_file)){
+            sequence->Clear();
+            return ret.AddError(PATTERN_CACHE_FILE_INVALID);
+        }
+
+        // A partially written cache entry is a miss
+        std::ifstream image((directory + image_file).c_str());
+        if(!image.is_open()){
+            sequence->Clear();
+            return ret.AddError(PATTERN_CACHE_MISS);
+        }
+
+        dlp::Pattern pattern;
+        pattern.bitdepth   = static_cast<dlp::Pattern::Bitdepth>(bitdepth);
+        pattern.color      = static_cast<dlp::Pattern::Color>(color);
+        pattern.data_type  = dlp::Pattern::DataType::IMAGE_FILE;
+        pattern.image_file = directory + image_file;
+        sequence->Add(pattern);
+    }
+
+    return ret;
+}
+
+dlp::ReturnCode PatternCache::Save(const unsigned long long &key, const dlp::Pattern::Sequence &sequence) const{
+    dlp::ReturnCode ret;
+
+    const std::string directory = this->directory_ + HashToString(key) + "/";
+    MakeDirectory(this->directory_);
+    MakeDirectory(directory);
+
+    // Images first so an index is only written for a complete entry
+    for(unsigned int iPattern = 0; iPattern < sequence.GetCount(); iPattern++){
+        dlp::Pattern pattern;
+        sequence.Get(iPattern,&pattern);
+
+        if(pattern.data_type == dlp::Pattern::DataType::IMAGE_FILE){
+            pattern.image_data.Load(pattern.image_file);
+        }
+
+        ret = pattern.image_data.Save(directory + "pattern_" + dlp::Number::ToString(iPattern) + ".bmp");
+        if(ret.hasErrors()) return ret;
+    }
+
+    std::ofstream index((directory + PATTERN_CACHE_INDEX_FILE).c_str(),std::ios::out | std::ios::trunc);
+    if(!index.is_open()) return ret.AddError(PATTERN_CACHE_FILE_OPEN_FAILED);
+
+    index << PATTERN_CACHE_MAGIC << " " << sequence.GetCount() << "\n";
+    for(unsigned int iPattern = 0; iPattern < sequence.GetCount(); iPattern++){
+        dlp::Pattern pattern;
+        sequence.Get(iPattern,&pattern);
+        index << (int) pattern.bitdepth << " "
+              << (int) pattern.color    << " "
+              << "pattern_" << iPattern << ".bmp\n";
+    }
+
+    return ret;
+}
+
+bool PatternCache::isProjectorCurrent(const unsigned long long &key) const{
+    std::ifstream record((this->directory_ + PATTERN_CACHE_PROJECTOR_FILE).c_str());
+    if(!record.is_open()) return false;
+
+    std::string recorded;
+    record >> recorded;
+    return recorded == HashToString(key);
+}
+
+dlp::ReturnCode PatternCache::SetProjectorKey(const unsigned long long &key) const{
+    dlp::ReturnCode ret;
+
+    MakeDirectory(this->directory_);
+
+    std::ofstream record((this->directory_ + PATTERN_CACHE_PROJECTOR_FILE).c_str(),std::ios::out | std::ios::trunc);
+    if(!record.is_open()) return ret.AddError(PATTERN_CACHE_FILE_OPEN_FAILED);
+
+    record << HashToString(key) << "\n";
+    return ret;
+}
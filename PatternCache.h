@@ -0,0 +1,52 @@
+/** @file       PatternCache.h
+ *  @brief      On disk cache of generated pattern sequences keyed by a settings hash
+ */
+#ifndef __PATTERN_CACHE_H_
+#define __PATTERN_CACHE_H_
+
+#include <string>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define PATTERN_CACHE_FILE_OPEN_FAILED      "PATTERN_CACHE_FILE_OPEN_FAILED"
+#define PATTERN_CACHE_FILE_INVALID          "PATTERN_CACHE_FILE_INVALID"
+#define PATTERN_CACHE_MISS                  "PATTERN_CACHE_MISS"
+#define PATTERN_CACHE_NULL_POINTER          "PATTERN_CACHE_NULL_POINTER"
+
+// 64-bit FNV-1a, pass the previous hash as seed to chain inputs
+#define PATTERN_CACHE_HASH_SEED     0xcbf29ce484222325ULL
+
+unsigned long long HashBytes(const void *data, const size_t &size, const unsigned long long &seed = PATTERN_CACHE_HASH_SEED);
+unsigned long long HashString(const std::string &text, const unsigned long long &seed = PATTERN_CACHE_HASH_SEED);
+
+// Hashes the contents of a file, a missing file hashes as its name only
+dlp::ReturnCode HashFile(const std::string &filename, unsigned long long *hash);
+
+std::string HashToString(const unsigned long long &hash);
+
+// Pattern sequences are saved as one image per pattern plus an index in a
+// directory named after the key. Loaded sequences reference the images as
+// IMAGE_FILE patterns so nothing is decoded until the projector needs it.
+//
+// The key of the sequence last uploaded to the projector is recorded next to
+// the cached sequences. The LCr4500 keeps its pattern images in firmware, so
+// a matching record means the upload can be skipped.
+class PatternCache{
+public:
+    PatternCache();
+
+    // Appends the trailing separator, files kept next to the cache are named
+    // from GetDirectory
+    void               SetDirectory(const std::string &directory);
+    const std::string& GetDirectory() const;
+
+    dlp::ReturnCode Load(const unsigned long long &key, dlp::Pattern::Sequence *sequence) const;
+    dlp::ReturnCode Save(const unsigned long long &key, const dlp::Pattern::Sequence &sequence) const;
+
+    bool            isProjectorCurrent(const unsigned long long &key) const;
+    dlp::ReturnCode SetProjectorKey(const unsigned long long &key) const;
+
+private:
+    std::string directory_;
+};
+
+#endif
@@ -0,0 +1,84 @@
+/** @file       PatternSlots.cpp
+ *  @brief      Captured frames held by pattern index so missing patterns can be re-captured
+ */
+#include "PatternSlots.h"
+
+PatternSlots::PatternSlots(){
+    this->next_              = 0;
+    this->saturated_percent_ = 0;
+}
+
+void PatternSlots::Reset(const unsigned int &pattern_count, const unsigned int &saturated_percent){
+    this->frames_.clear();
+    this->frames_.resize(pattern_count);
+    this->filled_.assign(pattern_count,false);
+    this->exempt_.assign(pattern_count,false);
+    this->next_              = 0;
+    this->saturated_percent_ = saturated_percent;
+}
+
+void PatternSlots::ExemptFromSaturation(const unsigned int &pattern){
+    if(pattern < this->exempt_.size()) this->exempt_[pattern] = true;
+}
+
+unsigned int PatternSlots::GetPatternCount() const{
+    return this->frames_.size();
+}
+
+dlp::ReturnCode PatternSlots::Set(const unsigned int &pattern, dlp::Image *frame){
+    dlp::ReturnCode ret;
+
+    if(!frame)                              return ret.AddError(PATTERN_SLOTS_NULL_POINTER);
+    if(pattern >= this->frames_.size())     return ret.AddError(PATTERN_SLOTS_INDEX_OUT_OF_RANGE);
+    if(frame->isEmpty())                    return ret.AddError(PATTERN_SLOTS_FRAME_EMPTY);
+
+    // Frames already taken have been decoded and cannot be replaced
+    if(pattern < this->next_)               return ret;
+
+    if((this->saturated_percent_ > 0) && !this->exempt_[pattern]){
+        unsigned int columns, rows;
+        frame->GetColumns(&columns);
+        frame->GetRows(&rows);
+
+        cv::Mat data;
+        frame->Unsafe_GetOpenCVData(&data);
+
+        unsigned long long saturated = 0;
+        for(unsigned int y = 0; y < rows; y++){
+            const unsigned char *row = data.ptr<unsigned char>(y);
+            for(unsigned int x = 0; x < columns; x++){
+                if(row[x] == 255) saturated++;
+            }
+        }
+
+        if((saturated * 100) > ((unsigned long long) columns * rows * this->saturated_percent_)){
+            return ret.AddError(PATTERN_SLOTS_FRAME_SATURATED);
+        }
+    }
+
+    this->frames_[pattern] = *frame;
+    this->filled_[pattern] = true;
+
+    return ret;
+}
+
+std::vector<unsigned int> PatternSlots::GetMissing() const{
+    std::vector<unsigned int> missing;
+    for(unsigned int iPattern = this->next_; iPattern < this->filled_.size(); iPattern++){
+        if(!this->filled_[iPattern]) missing.push_back(iPattern);
+    }
+    return missing;
+}
+
+bool PatternSlots::TakeNext(dlp::Image *frame, unsigned int *pattern){
+    if(!frame || !pattern)                      return false;
+    if(this->next_ >= this->frames_.size())     return false;
+    if(!this->filled_[this->next_])             return false;
+
+    *frame   = this->frames_[this->next_];
+    *pattern = this->next_;
+    this->frames_[this->next_].Clear();
+    this->next_++;
+
+    return true;
+}
@@ -0,0 +1,50 @@
+/** @file       PatternSlots.h
+ *  @brief      Captured frames held by pattern index so missing patterns can be re-captured
+ */
+#ifndef __PATTERN_SLOTS_H_
+#define __PATTERN_SLOTS_H_
+
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define PATTERN_SLOTS_NULL_POINTER          "PATTERN_SLOTS_NULL_POINTER"
+#define PATTERN_SLOTS_INDEX_OUT_OF_RANGE    "PATTERN_SLOTS_INDEX_OUT_OF_RANGE"
+#define PATTERN_SLOTS_FRAME_EMPTY           "PATTERN_SLOTS_FRAME_EMPTY"
+#define PATTERN_SLOTS_FRAME_SATURATED       "PATTERN_SLOTS_FRAME_SATURATED"
+
+// Frames of a pattern sequence by pattern index. Frames are taken back out in
+// pattern order up to the first pattern without a frame, so the streaming
+// decoders only hold frames captured ahead of a missing pattern.
+class PatternSlots{
+public:
+    PatternSlots();
+
+    // A frame with more than saturated_percent of its pixels at full scale is
+    // rejected, 0 accepts every frame
+    void Reset(const unsigned int &pattern_count, const unsigned int &saturated_percent);
+
+    // Frames of the pattern are never rejected as saturated, for white
+    // references which are bright by design. Cleared by Reset.
+    void ExemptFromSaturation(const unsigned int &pattern);
+
+    unsigned int GetPatternCount() const;
+
+    // Stores the monochrome frame of a pattern, replacing any earlier frame
+    dlp::ReturnCode Set(const unsigned int &pattern, dlp::Image *frame);
+
+    // Patterns still without a frame which have not been taken
+    std::vector<unsigned int> GetMissing() const;
+
+    // Moves the next frame in pattern order out of its slot, false when the
+    // next pattern has no frame yet or every frame has been taken
+    bool TakeNext(dlp::Image *frame, unsigned int *pattern);
+
+private:
+    std::vector<dlp::Image> frames_;
+    std::vector<bool>       filled_;
+    std::vector<bool>       exempt_;
+    unsigned int            next_;
+    unsigned int            saturated_percent_;
+};
+
+#endif
@@ -0,0 +1,55 @@
+/** @file       PatternTimeline.cpp
+ *  @brief      Host time line of a pattern sequence running on the projector
+ */
+#include <chrono>
+#include "PatternTimeline.h"
+
+unsigned long long GetTimestampMicroseconds(){
+    return (unsigned long long) std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PatternTimeline::PatternTimeline(){
+    this->pattern_count_ = 0;
+    this->period_us_     = 0;
+    this->start_us_      = 0;
+}
+
+void PatternTimeline::Start(const unsigned int       &pattern_count,
+                            const unsigned long long &period_us,
+                            const unsigned long long &start_us){
+    this->pattern_count_ = pattern_count;
+    this->period_us_     = period_us;
+    this->start_us_      = start_us;
+}
+
+unsigned int PatternTimeline::GetPatternCount() const{
+    return this->pattern_count_;
+}
+
+unsigned long long PatternTimeline::GetPeriod() const{
+    return this->period_us_;
+}
+
+unsigned long long PatternTimeline::GetStartTime() const{
+    return this->start_us_;
+}
+
+unsigned long long PatternTimeline::GetEndTime() const{
+    return this->start_us_ + this->pattern_count_ * this->period_us_;
+}
+
+unsigned long long PatternTimeline::GetPatternStartTime(const unsigned int &pattern) const{
+    return this->start_us_ + pattern * this->period_us_;
+}
+
+int PatternTimeline::GetPatternAt(const unsigned long long &time_us) const{
+    if((this->period_us_ == 0) || (time_us < this->start_us_) || (time_us >= this->GetEndTime())) return -1;
+    return (int)((time_us - this->start_us_) / this->period_us_);
+}
+
+int PatternTimeline::GetPatternDuring(const unsigned long long &begin_us, const unsigned long long &end_us) const{
+    const int pattern = this->GetPatternAt(begin_us);
+    if((pattern < 0) || (this->GetPatternAt(end_us) != pattern)) return -1;
+    return pattern;
+}
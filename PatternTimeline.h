@@ -0,0 +1,43 @@
+/** @file       PatternTimeline.h
+ *  @brief      Host time line of a pattern sequence running on the projector
+ */
+#ifndef __PATTERN_TIMELINE_H_
+#define __PATTERN_TIMELINE_H_
+
+#include <vector>
+
+// Microseconds of a monotonic host clock
+unsigned long long GetTimestampMicroseconds();
+
+// Records when each pattern of a sequence started by StartPatternSequence is
+// active so camera frames can be matched to patterns by their timestamp
+// instead of displaying and waiting for every pattern from the host.
+class PatternTimeline{
+public:
+    PatternTimeline();
+
+    // Patterns are active back to back for period_us each from start_us
+    void Start(const unsigned int       &pattern_count,
+               const unsigned long long &period_us,
+               const unsigned long long &start_us);
+
+    unsigned int       GetPatternCount() const;
+    unsigned long long GetPeriod() const;
+    unsigned long long GetStartTime() const;
+    unsigned long long GetEndTime() const;
+    unsigned long long GetPatternStartTime(const unsigned int &pattern) const;
+
+    // Pattern active at a time, -1 before the first or after the last pattern
+    int GetPatternAt(const unsigned long long &time_us) const;
+
+    // Pattern active for the whole of [begin_us, end_us], -1 if the window
+    // crosses a pattern change
+    int GetPatternDuring(const unsigned long long &begin_us, const unsigned long long &end_us) const;
+
+private:
+    unsigned int       pattern_count_;
+    unsigned long long period_us_;
+    unsigned long long start_us_;
+};
+
+#endif
@@ -0,0 +1,55 @@
+/** @file       PointCloudFile.cpp
+ *  @brief      Point cloud formats the SDK does not save
+ */
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "PointCloudFile.h"
+
+#define PLY_BLOCK_BYTES     (1 << 20)
+
+dlp::ReturnCode SavePLY(const std::string       &filename,
+                        const dlp::Point::Cloud &point_cloud,
+                        const bool              &binary){
+    dlp::ReturnCode ret;
+
+    FILE *file = std::fopen(filename.c_str(), "wb");
+    if(!file) return ret.AddError(POINT_CLOUD_FILE_OPEN_FAILED);
+
+    const unsigned long long count = point_cloud.GetCount();
+
+    char header[256];
+    const int header_bytes = std::snprintf(header, sizeof(header),
+                                           "ply\nformat %s 1.0\nelement vertex %llu\n"
+                                           "property float x\nproperty float y\nproperty float z\nend_header\n",
+                                           binary ? "binary_little_endian" : "ascii", count);
+    bool written = (std::fwrite(header, 1, header_bytes, file) == (size_t) header_bytes);
+
+    // Points are formatted into a block and the block written when it fills
+    std::vector<char> block(PLY_BLOCK_BYTES);
+    size_t used = 0;
+    for(unsigned long long iPoint = 0; written && (iPoint < count); iPoint++){
+        dlp::Point point;
+        point_cloud.Get(iPoint, &point);
+
+        if(used + 128 > block.size()){
+            written = (std::fwrite(&block[0], 1, used, file) == used);
+            used    = 0;
+        }
+
+        if(binary){
+            // Every platform this builds for is little endian
+            const float xyz[3] = { (float) point.x, (float) point.y, (float) point.z };
+            std::memcpy(&block[used], xyz, sizeof(xyz));
+            used += sizeof(xyz);
+        }
+        else{
+            used += std::snprintf(&block[used], block.size() - used, "%.7g %.7g %.7g\n",
+                                  (double) point.x, (double) point.y, (double) point.z);
+        }
+    }
+    if(written && (used > 0)) written = (std::fwrite(&block[0], 1, used, file) == used);
+
+    if((std::fclose(file) != 0) || !written) ret.AddError(POINT_CLOUD_FILE_WRITE_FAILED);
+    return ret;
+}
@@ -0,0 +1,20 @@
+/** @file       PointCloudFile.h
+ *  @brief      Point cloud formats the SDK does not save
+ */
+#ifndef __POINT_CLOUD_FILE_H_
+#define __POINT_CLOUD_FILE_H_
+
+#include <string>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define POINT_CLOUD_FILE_OPEN_FAILED    "POINT_CLOUD_FILE_OPEN_FAILED"
+#define POINT_CLOUD_FILE_WRITE_FAILED   "POINT_CLOUD_FILE_WRITE_FAILED"
+
+// Saves the points as a PLY vertex list of float x y z. Binary files are
+// little endian, ASCII values keep the 7 digits a float holds. Both are
+// written in large blocks instead of one stream insertion per value.
+dlp::ReturnCode SavePLY(const std::string       &filename,
+                        const dlp::Point::Cloud &point_cloud,
+                        const bool              &binary);
+
+#endif
@@ -0,0 +1,288 @@
+/** @file       ReplayReader.cpp
+ *  @brief      Reads recorded views of captures for offline reprocessing
+ */
+#include <cstring>
+#include <utility>
+#include "ReplayReader.h"
+#include "FrameCodec.h"
+
+// Read only mapping of a whole file, closed when it goes out of scope
+class MappedFile{
+public:
+    MappedFile(const std::string &filename){
+        this->mapping_ = NULL;
+        this->base_    = NULL;
+        this->size_    = 0;
+
+        this->file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if(this->file_ == INVALID_HANDLE_VALUE) return;
+
+        LARGE_INTEGER size;
+        if(!GetFileSizeEx(this->file_, &size) || (size.QuadPart == 0)) return;
+        this->size_ = size.QuadPart;
+
+        this->mapping_ = CreateFileMappingA(this->file_, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(this->mapping_ != NULL) this->base_ = (const unsigned char*) MapViewOfFile(this->mapping_, FILE_MAP_READ, 0, 0, 0);
+    }
+    ~MappedFile(){
+        if(this->base_ != NULL) UnmapViewOfFile(this->base_);
+        if(this->mapping_ != NULL) CloseHandle(this->mapping_);
+        if(this->file_ != INVALID_HANDLE_VALUE) CloseHandle(this->file_);
+    }
+    bool isMapped() const{
+        return this->base_ != NULL;
+    }
+    const unsigned char* GetData() const{
+        return this->base_;
+    }
+    unsigned long long GetSize() const{
+        return this->size_;
+    }
+private:
+    HANDLE               file_;
+    HANDLE               mapping_;
+    const unsigned char *base_;
+    unsigned long long   size_;
+};
+
+static unsigned int ReadUInt16(const unsigned char *data){
+    return data[0] | (data[1] << 8);
+}
+
+static unsigned int ReadUInt32(const unsigned char *data){
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int) data[3] << 24);
+}
+
+// Copies the rows of an uncompressed 8-bit grayscale BMP as dlp::Image::Save
+// writes them. False for any other BMP, which is left to the SDK to load.
+static bool CopyGrayBitmap(const unsigned char *bmp, const unsigned long long &bytes, dlp::Image *image){
+    if((bytes < 54) || (bmp[0] != 'B') || (bmp[1] != 'M')) return false;
+
+    const unsigned int pixel_offset = ReadUInt32(&bmp[10]);
+    const unsigned int info_bytes   = ReadUInt32(&bmp[14]);
+    const int          columns      = (int) ReadUInt32(&bmp[18]);
+    const int          height       = (int) ReadUInt32(&bmp[22]);
+    const unsigned int bit_count    = ReadUInt16(&bmp[28]);
+    const unsigned int compression  = ReadUInt32(&bmp[30]);
+    if((bit_count != 8) || (compression != 0) || (columns <= 0) || (height == 0)) return false;
+
+    // The palette has to map every level to itself
+    const unsigned long long palette = 14 + (unsigned long long) info_bytes;
+    if(palette + 256 * 4 > bytes) return false;
+    for(unsigned int iLevel = 0; iLevel < 256; iLevel++){
+        const unsigned char *entry = &bmp[palette + iLevel * 4];
+        if((entry[0] != iLevel) || (entry[1] != iLevel) || (entry[2] != iLevel)) return false;
+    }
+
+    // Rows are padded to 4 bytes and stored bottom up unless the height is negative
+    const unsigned int       rows   = (height > 0) ? height : -height;
+    const unsigned long long stride = ((unsigned long long) columns + 3) & ~3ULL;
+    if(pixel_offset + stride * rows > bytes) return false;
+
+    image->Create(columns, rows, dlp::Image::Format::MONO_UCHAR);
+    cv::Mat pixels;
+    image->Unsafe_GetOpenCVData(&pixels);
+    for(unsigned int yRow = 0; yRow < rows; yRow++){
+        const unsigned int source_row = (height > 0) ? (rows - 1 - yRow) : yRow;
+        std::memcpy(pixels.ptr<unsigned char>(yRow), &bmp[pixel_offset + stride * source_row], columns);
+    }
+    return true;
+}
+
+
+ReplayReader::ReplayReader(){
+    this->vertical_count_   = 0;
+    this->horizontal_count_ = 0;
+    this->next_view_        = 0;
+    this->views_taken_      = 0;
+    this->prefetch_views_   = 1;
+    this->stopping_         = false;
+}
+
+ReplayReader::~ReplayReader(){
+    this->Close();
+}
+
+dlp::ReturnCode ReplayReader::OpenArchive(const std::string &filename){
+    dlp::ReturnCode ret;
+
+    this->Close();
+
+    ret = this->archive_.Open(filename);
+    if(ret.hasErrors()) return ret;
+
+    // Captures written again for the same pattern replace the earlier ones
+    std::map<unsigned int,unsigned int> view_positions;
+    for(unsigned int iEntry = 0; iEntry < this->archive_.GetEntryCount(); iEntry++){
+        ScanArchiveEntry entry;
+        this->archive_.GetEntry(iEntry, &entry);
+        if(entry.chunk.type != SCAN_ARCHIVE_CHUNK_CAPTURE) continue;
+
+        std::map<unsigned int,unsigned int>::const_iterator position = view_positions.find(entry.chunk.view);
+        if(position == view_positions.end()){
+            position = view_positions.insert(std::make_pair(entry.chunk.view, (unsigned int) this->archive_views_.size())).first;
+            this->archive_views_.push_back(entry.chunk.view);
+            this->archive_entries_.push_back(std::map<unsigned int,unsigned int>());
+        }
+        this->archive_entries_[position->second][entry.chunk.index] = iEntry;
+    }
+
+    if(this->archive_views_.empty()){
+        this->Close();
+        return ret.AddError(REPLAY_READER_NO_VIEWS);
+    }
+    return ret;
+}
+
+dlp::ReturnCode ReplayReader::OpenDirectories(const std::vector<std::string> &directories){
+    dlp::ReturnCode ret;
+
+    this->Close();
+    if(directories.empty()) return ret.AddError(REPLAY_READER_NO_VIEWS);
+
+    for(unsigned int iDirectory = 0; iDirectory < directories.size(); iDirectory++){
+        std::string directory = directories[iDirectory];
+        if(!directory.empty() && (directory.back() != '/') && (directory.back() != '\\')) directory += "/";
+        this->directories_.push_back(directory);
+    }
+    return ret;
+}
+
+void ReplayReader::Close(){
+    this->Stop();
+    this->archive_.Close();
+    this->archive_views_.clear();
+    this->archive_entries_.clear();
+    this->directories_.clear();
+}
+
+bool ReplayReader::isOpen() const{
+    return this->archive_.isOpen() || !this->directories_.empty();
+}
+
+void ReplayReader::SetPatternCounts(const unsigned int &vertical_count, const unsigned int &horizontal_count){
+    this->vertical_count_   = vertical_count;
+    this->horizontal_count_ = horizontal_count;
+}
+
+unsigned int ReplayReader::GetViewCount() const{
+    if(this->archive_.isOpen()) return (unsigned int) this->archive_views_.size();
+    return (unsigned int) this->directories_.size();
+}
+
+dlp::ReturnCode ReplayReader::LoadCapture(const unsigned int &view, const unsigned int &pattern, dlp::Capture *capture) const{
+    dlp::ReturnCode ret;
+
+    capture->data_type = dlp::Capture::DataType::IMAGE_DATA;
+
+    if(this->archive_.isOpen()){
+        const std::map<unsigned int,unsigned int> &entries = this->archive_entries_[view];
+        std::map<unsigned int,unsigned int>::const_iterator entry = entries.find(pattern);
+        if(entry == entries.end()) return ret.AddError(REPLAY_READER_CAPTURE_MISSING);
+        return this->archive_.GetImage(entry->second, &capture->image_data);
+    }
+
+    const std::string file_base = this->directories_[view] + "scan_capture_" + dlp::Number::ToString(pattern);
+
+    MappedFile encoded(file_base + FRAME_CODEC_EXTENSION);
+    if(encoded.isMapped()) return DecodeFrame(encoded.GetData(), encoded.GetSize(), &capture->image_data);
+
+    MappedFile bitmap(file_base + ".bmp");
+    if(!bitmap.isMapped()) return ret.AddError(REPLAY_READER_CAPTURE_MISSING);
+    if(CopyGrayBitmap(bitmap.GetData(), bitmap.GetSize(), &capture->image_data)) return ret;
+
+    // Color and palette bitmaps go through the SDK as ScanBenchmark loads them
+    ret = capture->image_data.Load(file_base + ".bmp");
+    if(ret.hasErrors()) return ret;
+    return capture->image_data.ConvertToMonochrome();
+}
+
+dlp::ReturnCode ReplayReader::LoadView(const unsigned int &view, ReplayView *replay_view) const{
+    dlp::ReturnCode ret;
+
+    if(!replay_view) return ret.AddError(REPLAY_READER_NULL_POINTER);
+    if(!this->isOpen()) return ret.AddError(REPLAY_READER_NOT_OPEN);
+    if(view >= this->GetViewCount()) return ret.AddError(REPLAY_READER_VIEW_INVALID);
+
+    replay_view->view = this->archive_.isOpen() ? this->archive_views_[view] : view;
+    replay_view->vertical.Clear();
+    replay_view->horizontal.Clear();
+
+    const unsigned int pattern_count = this->vertical_count_ + this->horizontal_count_;
+    for(unsigned int iPattern = 0; iPattern < pattern_count; iPattern++){
+        dlp::Capture capture;
+        ret = this->LoadCapture(view, iPattern, &capture);
+        if(ret.hasErrors()) return ret;
+
+        if(iPattern < this->vertical_count_) replay_view->vertical.Add(capture);
+        else                                 replay_view->horizontal.Add(capture);
+    }
+    return ret;
+}
+
+void ReplayReader::Start(const unsigned int &prefetch_views, const unsigned int &threads){
+    this->Stop();
+
+    this->next_view_      = 0;
+    this->views_taken_    = 0;
+    this->prefetch_views_ = (prefetch_views > 0) ? prefetch_views : 1;
+    this->stopping_       = false;
+
+    unsigned int loader_count = (threads > 0) ? threads : std::thread::hardware_concurrency();
+    if(loader_count == 0)                   loader_count = 1;
+    if(loader_count > this->GetViewCount()) loader_count = this->GetViewCount();
+
+    for(unsigned int iLoader = 0; iLoader < loader_count; iLoader++){
+        this->loaders_.push_back(std::thread(&ReplayReader::Load, this));
+    }
+}
+
+void ReplayReader::Load(){
+    while(true){
+        const unsigned int view = this->next_view_++;
+        if(view >= this->GetViewCount()) return;
+
+        ReplayView replay_view;
+        replay_view.ret = this->LoadView(view, &replay_view);
+
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        this->view_taken_.wait(lock, [this]{ return this->stopping_ || (this->loaded_.size() < this->prefetch_views_); });
+        if(this->stopping_) return;
+        this->loaded_.push_back(std::move(replay_view));
+        this->view_loaded_.notify_one();
+    }
+}
+
+bool ReplayReader::Next(ReplayView *replay_view){
+    if(!replay_view) return false;
+
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->view_loaded_.wait(lock, [this]{ return this->stopping_ || !this->loaded_.empty() ||
+                                                 (this->views_taken_ >= this->GetViewCount()); });
+    if(this->loaded_.empty()) return false;
+
+    *replay_view = std::move(this->loaded_.front());
+    this->loaded_.pop_front();
+    this->views_taken_++;
+    this->view_taken_.notify_one();
+
+    // Wakes the other decoding threads once there is nothing left to wait for
+    if(this->views_taken_ >= this->GetViewCount()) this->view_loaded_.notify_all();
+    return true;
+}
+
+void ReplayReader::Stop(){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->stopping_ = true;
+    }
+    this->view_taken_.notify_all();
+    this->view_loaded_.notify_all();
+
+    for(unsigned int iLoader = 0; iLoader < this->loaders_.size(); iLoader++){
+        this->loaders_[iLoader].join();
+    }
+    this->loaders_.clear();
+    this->loaded_.clear();
+}
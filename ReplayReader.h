@@ -0,0 +1,94 @@
+/** @file       ReplayReader.h
+ *  @brief      Reads recorded views of captures for offline reprocessing
+ */
+#ifndef __REPLAY_READER_H_
+#define __REPLAY_READER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+#include "ScanArchive.h"
+
+#define REPLAY_READER_NULL_POINTER          "REPLAY_READER_NULL_POINTER"
+#define REPLAY_READER_NOT_OPEN              "REPLAY_READER_NOT_OPEN"
+#define REPLAY_READER_NO_VIEWS              "REPLAY_READER_NO_VIEWS"
+#define REPLAY_READER_VIEW_INVALID          "REPLAY_READER_VIEW_INVALID"
+#define REPLAY_READER_CAPTURE_MISSING       "REPLAY_READER_CAPTURE_MISSING"
+
+// The captures of one view split into the sequences the decoders take
+struct ReplayView{
+    unsigned int            view;       // Archive view, or the position of its directory
+    dlp::Capture::Sequence  vertical;
+    dlp::Capture::Sequence  horizontal;
+    dlp::ReturnCode         ret;        // Why the view did not load
+};
+
+// Loads views of captures saved by ScanObject, either the capture chunks of a
+// scan archive or directories of scan_capture_<pattern> files. Archives and
+// image files are mapped and each frame is copied once from the mapping into
+// its capture, DLPF files decoding straight into it, so no image file parser
+// or intermediate buffer is involved. Started, loader threads fill a bounded
+// queue ahead of the decoders so the next views are ready when one finishes.
+class ReplayReader{
+public:
+    ReplayReader();
+    ~ReplayReader();
+
+    // Every view of the archive with captures
+    dlp::ReturnCode OpenArchive(const std::string &filename);
+
+    // One view per directory, in the order given
+    dlp::ReturnCode OpenDirectories(const std::vector<std::string> &directories);
+
+    void Close();
+    bool isOpen() const;
+
+    // Patterns as ScanObject numbers them, the first vertical_count vertical
+    void SetPatternCounts(const unsigned int &vertical_count, const unsigned int &horizontal_count);
+
+    unsigned int GetViewCount() const;
+
+    // Loads one view on the calling thread, views may be loaded concurrently
+    dlp::ReturnCode LoadView(const unsigned int &view, ReplayView *replay_view) const;
+
+    // Loads every view on threads, keeping at most prefetch_views loaded views
+    // waiting for Next. 0 threads uses every core.
+    void Start(const unsigned int &prefetch_views, const unsigned int &threads);
+
+    // Takes the next loaded view, in any order when there are several loader
+    // threads. Returns false when every view has been taken. May be called
+    // from several decoding threads.
+    bool Next(ReplayView *replay_view);
+
+    void Stop();
+
+private:
+    dlp::ReturnCode LoadCapture(const unsigned int &view, const unsigned int &pattern, dlp::Capture *capture) const;
+    void Load();
+
+    ScanArchiveReader                                  archive_;
+    std::vector<unsigned int>                          archive_views_;
+    std::vector< std::map<unsigned int,unsigned int> > archive_entries_;   // Pattern to entry per view
+    std::vector<std::string>                           directories_;
+
+    unsigned int                vertical_count_;
+    unsigned int                horizontal_count_;
+
+    std::mutex                  mutex_;
+    std::condition_variable     view_loaded_;
+    std::condition_variable     view_taken_;
+    std::deque<ReplayView>      loaded_;
+    std::atomic<unsigned int>   next_view_;
+    unsigned int                views_taken_;
+    unsigned int                prefetch_views_;
+    bool                        stopping_;
+    std::vector<std::thread>    loaders_;
+};
+
+#endif
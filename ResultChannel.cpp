@@ -0,0 +1,266 @@
+/** @file       ResultChannel.cpp
+ *  @brief      Scan results published to local consumers through shared memory
+ */
+#include <chrono>
+#include <new>
+#include "ResultChannel.h"
+
+static unsigned long long AlignSize(const unsigned long long &size){
+    return (size + RESULT_CHANNEL_ALIGNMENT - 1) / RESULT_CHANNEL_ALIGNMENT * RESULT_CHANNEL_ALIGNMENT;
+}
+
+static unsigned long long GetArraySize(const unsigned int &columns, const unsigned int &rows){
+    return AlignSize((unsigned long long) columns * rows * sizeof(float));
+}
+
+ResultChannel::ResultChannel(){
+    this->mapping_  = NULL;
+    this->memory_   = NULL;
+    this->header_   = NULL;
+    this->writable_ = false;
+}
+
+ResultChannel::~ResultChannel(){
+    this->Close();
+}
+
+dlp::ReturnCode ResultChannel::Create(const std::string  &name,
+                                      const unsigned int &segment_count,
+                                      const unsigned int &columns,
+                                      const unsigned int &rows){
+    dlp::ReturnCode ret;
+
+    this->Close();
+
+    if((segment_count == 0) || (columns == 0) || (rows == 0)) return ret.AddError(RESULT_CHANNEL_SIZE_INVALID);
+
+    // Segment header followed by the x, y, z, and depth arrays
+    const unsigned long long segment_size = AlignSize(sizeof(ResultSegmentHeader)) + 4 * GetArraySize(columns,rows);
+    const unsigned long long total_size   = AlignSize(sizeof(ResultChannelHeader)) + segment_count * segment_size;
+
+    this->mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE,NULL,PAGE_READWRITE,
+                                        (DWORD)(total_size >> 32),(DWORD)(total_size & 0xFFFFFFFF),
+                                        name.c_str());
+    if(!this->mapping_) return ret.AddError(RESULT_CHANNEL_CREATE_FAILED);
+    const bool existing = (GetLastError() == ERROR_ALREADY_EXISTS);
+
+    this->memory_ = (unsigned char*) MapViewOfFile(this->mapping_,FILE_MAP_ALL_ACCESS,0,0,0);
+    if(!this->memory_){
+        this->Close();
+        return ret.AddError(RESULT_CHANNEL_CREATE_FAILED);
+    }
+
+    // A consumer still holds the channel of an earlier run, continue its
+    // sequence if the layout is the same
+    if(existing){
+        ResultChannelHeader *header = (ResultChannelHeader*) this->memory_;
+        if((header->magic         != RESULT_CHANNEL_MAGIC)   ||
+           (header->version       != RESULT_CHANNEL_VERSION) ||
+           (header->segment_count != segment_count)          ||
+           (header->columns       != columns)                ||
+           (header->rows          != rows)){
+            this->Close();
+            return ret.AddError(RESULT_CHANNEL_IN_USE);
+        }
+        this->header_   = header;
+        this->writable_ = true;
+        this->name_     = name;
+        return ret;
+    }
+
+    // Mark every segment empty before consumers can see a valid header
+    for(unsigned int iSegment = 0; iSegment < segment_count; iSegment++){
+        unsigned char *segment = this->memory_ + AlignSize(sizeof(ResultChannelHeader)) + iSegment * segment_size;
+        ResultSegmentHeader *segment_header = new (segment) ResultSegmentHeader;
+        segment_header->sequence.store(0,std::memory_order_relaxed);
+        segment_header->result = 0;
+    }
+
+    this->header_ = new (this->memory_) ResultChannelHeader;
+    this->header_->version       = RESULT_CHANNEL_VERSION;
+    this->header_->segment_count = segment_count;
+    this->header_->columns       = columns;
+    this->header_->rows          = rows;
+    this->header_->segment_size  = segment_size;
+    this->header_->published.store(0,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->header_->magic         = RESULT_CHANNEL_MAGIC;
+
+    this->writable_ = true;
+    this->name_     = name;
+
+    return ret;
+}
+
+dlp::ReturnCode ResultChannel::Open(const std::string &name){
+    dlp::ReturnCode ret;
+
+    this->Close();
+
+    this->mapping_ = OpenFileMappingA(FILE_MAP_READ,FALSE,name.c_str());
+    if(!this->mapping_) return ret.AddError(RESULT_CHANNEL_OPEN_FAILED);
+
+    this->memory_ = (unsigned char*) MapViewOfFile(this->mapping_,FILE_MAP_READ,0,0,0);
+    if(!this->memory_){
+        this->Close();
+        return ret.AddError(RESULT_CHANNEL_OPEN_FAILED);
+    }
+
+    this->header_ = (ResultChannelHeader*) this->memory_;
+    if((this->header_->magic   != RESULT_CHANNEL_MAGIC) ||
+       (this->header_->version != RESULT_CHANNEL_VERSION)){
+        this->Close();
+        return ret.AddError(RESULT_CHANNEL_VERSION_MISMATCH);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    this->writable_ = false;
+    this->name_     = name;
+
+    return ret;
+}
+
+bool ResultChannel::isOpen() const{
+    return this->header_ != NULL;
+}
+
+void ResultChannel::Close(){
+    if(this->memory_)  UnmapViewOfFile(this->memory_);
+    if(this->mapping_) CloseHandle(this->mapping_);
+
+    this->mapping_  = NULL;
+    this->memory_   = NULL;
+    this->header_   = NULL;
+    this->writable_ = false;
+    this->name_.clear();
+}
+
+std::string ResultChannel::GetName() const{
+    return this->name_;
+}
+
+unsigned int ResultChannel::GetSegmentCount() const{
+    return this->header_ ? this->header_->segment_count : 0;
+}
+
+unsigned int ResultChannel::GetColumns() const{
+    return this->header_ ? this->header_->columns : 0;
+}
+
+unsigned int ResultChannel::GetRows() const{
+    return this->header_ ? this->header_->rows : 0;
+}
+
+ResultSegmentHeader* ResultChannel::GetSegment(const unsigned long long &result) const{
+    const unsigned long long segment = (result - 1) % this->header_->segment_count;
+    return (ResultSegmentHeader*)(this->memory_ + AlignSize(sizeof(ResultChannelHeader)) + segment * this->header_->segment_size);
+}
+
+float* ResultChannel::GetSegmentData(ResultSegmentHeader *segment, const unsigned int &array) const{
+    return (float*)((unsigned char*) segment + AlignSize(sizeof(ResultSegmentHeader)) +
+                    array * GetArraySize(this->header_->columns,this->header_->rows));
+}
+
+dlp::ReturnCode ResultChannel::Publish(const dlp::Point::Cloud &point_cloud,
+                                       dlp::Image              *depth_map,
+                                       const unsigned int      &view){
+    dlp::ReturnCode ret;
+
+    if(!depth_map)          return ret.AddError(RESULT_CHANNEL_NULL_POINTER);
+    if(!this->isOpen())     return ret.AddError(RESULT_CHANNEL_NOT_OPEN);
+    if(!this->writable_)    return ret.AddError(RESULT_CHANNEL_READ_ONLY);
+
+    unsigned int columns, rows;
+    depth_map->GetColumns(&columns);
+    depth_map->GetRows(&rows);
+    if((columns != this->header_->columns) || (rows != this->header_->rows)) return ret.AddError(RESULT_CHANNEL_RESOLUTION_MISMATCH);
+
+    const unsigned long long point_count = point_cloud.GetCount();
+    if(point_count > (unsigned long long) columns * rows) return ret.AddError(RESULT_CHANNEL_SIZE_INVALID);
+
+    dlp::Image::Format format;
+    depth_map->GetDataFormat(&format);
+    if((format != dlp::Image::Format::MONO_FLOAT) &&
+       (format != dlp::Image::Format::MONO_DOUBLE)) return ret.AddError(RESULT_CHANNEL_FORMAT_INVALID);
+
+    const unsigned long long result  = this->header_->published.load(std::memory_order_relaxed) + 1;
+    ResultSegmentHeader     *segment = this->GetSegment(result);
+
+    // Odd sequence while writing, readers holding the old result see it change
+    segment->sequence.store(2 * result - 1,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    float *x = this->GetSegmentData(segment,0);
+    float *y = this->GetSegmentData(segment,1);
+    float *z = this->GetSegmentData(segment,2);
+    float *depth = this->GetSegmentData(segment,3);
+
+    for(unsigned long long iPoint = 0; iPoint < point_count; iPoint++){
+        dlp::Point point;
+        point_cloud.Get(iPoint,&point);
+        x[iPoint] = (float) point.x;
+        y[iPoint] = (float) point.y;
+        z[iPoint] = (float) point.z;
+    }
+
+    cv::Mat depth_data;
+    depth_map->Unsafe_GetOpenCVData(&depth_data);
+    for(unsigned int yPixel = 0; yPixel < rows; yPixel++){
+        float *depth_row = depth + (unsigned long long) yPixel * columns;
+        if(format == dlp::Image::Format::MONO_FLOAT){
+            const float *row = depth_data.ptr<float>(yPixel);
+            for(unsigned int xPixel = 0; xPixel < columns; xPixel++) depth_row[xPixel] = row[xPixel];
+        }
+        else{
+            const double *row = depth_data.ptr<double>(yPixel);
+            for(unsigned int xPixel = 0; xPixel < columns; xPixel++) depth_row[xPixel] = (float) row[xPixel];
+        }
+    }
+
+    segment->result       = result;
+    segment->timestamp_ms = (unsigned long long) std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count();
+    segment->view         = view;
+    segment->point_count  = (unsigned int) point_count;
+    segment->columns      = columns;
+    segment->rows         = rows;
+
+    segment->sequence.store(2 * result,std::memory_order_release);
+    this->header_->published.store(result,std::memory_order_release);
+
+    return ret;
+}
+
+unsigned long long ResultChannel::GetPublishedCount() const{
+    if(!this->isOpen()) return 0;
+    return this->header_->published.load(std::memory_order_acquire);
+}
+
+bool ResultChannel::GetResult(const unsigned long long &result, ResultView *view) const{
+    if(!view || !this->isOpen() || (result == 0)) return false;
+
+    ResultSegmentHeader *segment = this->GetSegment(result);
+    if(segment->sequence.load(std::memory_order_acquire) != 2 * result) return false;
+
+    view->result       = result;
+    view->timestamp_ms = segment->timestamp_ms;
+    view->view         = segment->view;
+    view->point_count  = segment->point_count;
+    view->columns      = segment->columns;
+    view->rows         = segment->rows;
+    view->x            = this->GetSegmentData(segment,0);
+    view->y            = this->GetSegmentData(segment,1);
+    view->z            = this->GetSegmentData(segment,2);
+    view->depth        = this->GetSegmentData(segment,3);
+    view->segment      = segment;
+
+    // The metadata was read before the check in isValid()
+    return this->isValid(*view);
+}
+
+bool ResultChannel::isValid(const ResultView &view) const{
+    if(!view.segment) return false;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return view.segment->sequence.load(std::memory_order_relaxed) == 2 * view.result;
+}
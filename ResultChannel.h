@@ -0,0 +1,118 @@
+/** @file       ResultChannel.h
+ *  @brief      Scan results published to local consumers through shared memory
+ */
+#ifndef __RESULT_CHANNEL_H_
+#define __RESULT_CHANNEL_H_
+
+#include <winsock2.h>
+#include <Windows.h>
+#include <atomic>
+#include <string>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define RESULT_CHANNEL_NULL_POINTER         "RESULT_CHANNEL_NULL_POINTER"
+#define RESULT_CHANNEL_NOT_OPEN             "RESULT_CHANNEL_NOT_OPEN"
+#define RESULT_CHANNEL_READ_ONLY            "RESULT_CHANNEL_READ_ONLY"
+#define RESULT_CHANNEL_SIZE_INVALID         "RESULT_CHANNEL_SIZE_INVALID"
+#define RESULT_CHANNEL_CREATE_FAILED        "RESULT_CHANNEL_CREATE_FAILED"
+#define RESULT_CHANNEL_IN_USE               "RESULT_CHANNEL_IN_USE"
+#define RESULT_CHANNEL_OPEN_FAILED          "RESULT_CHANNEL_OPEN_FAILED"
+#define RESULT_CHANNEL_VERSION_MISMATCH     "RESULT_CHANNEL_VERSION_MISMATCH"
+#define RESULT_CHANNEL_RESOLUTION_MISMATCH  "RESULT_CHANNEL_RESOLUTION_MISMATCH"
+#define RESULT_CHANNEL_FORMAT_INVALID       "RESULT_CHANNEL_FORMAT_INVALID"
+
+#define RESULT_CHANNEL_DEFAULT_NAME         "Local\\dlp_lcr4500_scan_results"
+#define RESULT_CHANNEL_MAGIC                0x4C434452
+#define RESULT_CHANNEL_VERSION              1
+#define RESULT_CHANNEL_ALIGNMENT            64
+
+// The sequence counters are shared between processes
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Result channel counters must be lock free");
+
+// Start of the mapping, followed by segment_count segments of segment_size bytes
+struct ResultChannelHeader{
+    unsigned int                    magic;
+    unsigned int                    version;
+    unsigned int                    segment_count;
+    unsigned int                    columns;
+    unsigned int                    rows;
+    unsigned long long              segment_size;
+    std::atomic<unsigned long long> published;      // Results completely written
+};
+
+// Start of a segment, followed by the x, y, z, and depth float arrays of
+// columns * rows entries each. Result n is written to segment (n-1) % count;
+// its sequence is 2n-1 while the writer fills it and 2n once it is complete.
+struct ResultSegmentHeader{
+    std::atomic<unsigned long long> sequence;
+    unsigned long long              result;
+    unsigned long long              timestamp_ms;
+    unsigned int                    view;
+    unsigned int                    point_count;
+    unsigned int                    columns;
+    unsigned int                    rows;
+};
+
+// Result read in place from the mapping. The arrays stay valid only while
+// ResultChannel::isValid() holds; check it after using them.
+struct ResultView{
+    unsigned long long  result;
+    unsigned long long  timestamp_ms;
+    unsigned int        view;
+    unsigned int        point_count;
+    unsigned int        columns;
+    unsigned int        rows;
+    const float         *x;
+    const float         *y;
+    const float         *z;
+    const float         *depth;
+
+    const ResultSegmentHeader *segment;
+};
+
+// Ring of preallocated result segments in a named file mapping. One scanner
+// publishes, any number of local processes read without locks or files.
+class ResultChannel{
+public:
+    ResultChannel();
+    ~ResultChannel();
+
+    // Producer side, sized for one point per camera pixel
+    dlp::ReturnCode Create(const std::string  &name,
+                           const unsigned int &segment_count,
+                           const unsigned int &columns,
+                           const unsigned int &rows);
+
+    // Consumer side, maps an existing channel read only
+    dlp::ReturnCode Open(const std::string &name);
+
+    bool isOpen() const;
+    void Close();
+
+    std::string  GetName() const;
+    unsigned int GetSegmentCount() const;
+    unsigned int GetColumns() const;
+    unsigned int GetRows() const;
+
+    dlp::ReturnCode Publish(const dlp::Point::Cloud &point_cloud,
+                            dlp::Image              *depth_map,
+                            const unsigned int      &view);
+
+    unsigned long long GetPublishedCount() const;
+
+    // False if the result is not published yet or was already overwritten
+    bool GetResult(const unsigned long long &result, ResultView *view) const;
+    bool isValid(const ResultView &view) const;
+
+private:
+    ResultSegmentHeader* GetSegment(const unsigned long long &result) const;
+    float* GetSegmentData(ResultSegmentHeader *segment, const unsigned int &array) const;
+
+    HANDLE                  mapping_;
+    unsigned char          *memory_;
+    ResultChannelHeader    *header_;
+    bool                    writable_;
+    std::string             name_;
+};
+
+#endif
@@ -0,0 +1,729 @@
+/** @file       ScanArchive.cpp
+ *  @brief      Append-only single file archive of a scan session
+ *
+ *  Layout: a file header, chunks of a ScanArchiveChunk header and its payload
+ *  padded to SCAN_ARCHIVE_ALIGNMENT, then the index of every chunk and the
+ *  trailer pointing at it.
+ */
+#include <cstring>
+#include <ctime>
+#include "ScanArchive.h"
+
+#define SCAN_ARCHIVE_WRITE_PIECE    (1u << 30)  // WriteFile takes a 32 bit count
+#define SCAN_ARCHIVE_HASH_BITS      14
+#define SCAN_ARCHIVE_MIN_MATCH      4
+#define SCAN_ARCHIVE_LAST_LITERALS  5           // The LZ4 block format ends with literals
+#define SCAN_ARCHIVE_MATCH_LIMIT    12          // No match may start in the last 12 bytes
+
+struct ScanArchiveHeader{
+    unsigned int        magic;
+    unsigned int        version;
+    unsigned long long  created;
+};
+
+static unsigned long long Align(const unsigned long long &offset){
+    return (offset + SCAN_ARCHIVE_ALIGNMENT - 1) & ~((unsigned long long) SCAN_ARCHIVE_ALIGNMENT - 1);
+}
+
+static unsigned int GetElementBytes(const unsigned int &element){
+    switch(element){
+    case SCAN_ARCHIVE_ELEMENT_MONO_UCHAR:   return 1;
+    case SCAN_ARCHIVE_ELEMENT_RGB_UCHAR:    return 3;
+    case SCAN_ARCHIVE_ELEMENT_MONO_FLOAT:   return sizeof(float);
+    case SCAN_ARCHIVE_ELEMENT_DISPARITY:    return sizeof(int);
+    case SCAN_ARCHIVE_ELEMENT_POINT:        return 3 * sizeof(double);
+    default:                                return 0;
+    }
+}
+
+static bool isChunkValid(const ScanArchiveChunk &chunk, const unsigned long long &offset, const unsigned long long &end){
+    if(chunk.magic != SCAN_ARCHIVE_CHUNK_MAGIC) return false;
+    if(GetElementBytes(chunk.element) == 0) return false;
+    if(chunk.raw_bytes != (unsigned long long) chunk.columns * chunk.rows * GetElementBytes(chunk.element)) return false;
+    if(chunk.compression == SCAN_ARCHIVE_COMPRESSION_NONE){
+        if(chunk.stored_bytes != chunk.raw_bytes) return false;
+    }
+    else if(chunk.compression != SCAN_ARCHIVE_COMPRESSION_LZ) return false;
+    if(offset + sizeof(ScanArchiveChunk) > end) return false;
+    return chunk.stored_bytes <= end - offset - sizeof(ScanArchiveChunk);
+}
+
+// The index from the trailer, when the file ends with a complete one
+static bool ReadIndexFooter(const unsigned char          *base,
+                            const unsigned long long     &size,
+                            std::vector<ScanArchiveEntry> *entries,
+                            unsigned long long           *end){
+    if(size < sizeof(ScanArchiveHeader) + sizeof(ScanArchiveTrailer)) return false;
+
+    ScanArchiveTrailer trailer;
+    std::memcpy(&trailer, base + size - sizeof(trailer), sizeof(trailer));
+    if((trailer.magic != SCAN_ARCHIVE_INDEX_MAGIC) || (trailer.version != SCAN_ARCHIVE_VERSION)) return false;
+    if(trailer.index_offset < sizeof(ScanArchiveHeader)) return false;
+    if(trailer.index_offset > size - sizeof(trailer)) return false;
+    if(trailer.entry_count != (size - sizeof(trailer) - trailer.index_offset) / sizeof(ScanArchiveEntry)) return false;
+    if(trailer.index_offset + trailer.entry_count * sizeof(ScanArchiveEntry) + sizeof(trailer) != size) return false;
+
+    entries->resize((size_t) trailer.entry_count);
+    for(unsigned long long iEntry = 0; iEntry < trailer.entry_count; iEntry++){
+        ScanArchiveEntry &entry = (*entries)[(size_t) iEntry];
+        std::memcpy(&entry, base + trailer.index_offset + iEntry * sizeof(ScanArchiveEntry), sizeof(entry));
+        if(!isChunkValid(entry.chunk, entry.offset, trailer.index_offset)) return false;
+    }
+    *end = trailer.index_offset;
+    return true;
+}
+
+// Without a trailer the chunks are walked from the start until one is incomplete
+static void ReadIndexChunks(const unsigned char          *base,
+                            const unsigned long long     &size,
+                            std::vector<ScanArchiveEntry> *entries,
+                            unsigned long long           *end){
+    entries->clear();
+
+    unsigned long long offset = sizeof(ScanArchiveHeader);
+    while(offset + sizeof(ScanArchiveChunk) <= size){
+        ScanArchiveEntry entry;
+        std::memcpy(&entry.chunk, base + offset, sizeof(entry.chunk));
+        if(!isChunkValid(entry.chunk, offset, size)) break;
+
+        entry.offset = offset;
+        entries->push_back(entry);
+        offset = Align(offset + sizeof(ScanArchiveChunk) + entry.chunk.stored_bytes);
+    }
+    *end = (offset < size) ? offset : size;
+}
+
+static unsigned int ReadWord(const unsigned char *data){
+    unsigned int word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+static unsigned char *PutLength(unsigned long long length, unsigned char *out){
+    while(length >= 255){
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = (unsigned char) length;
+    return out;
+}
+
+// Greedy single pass LZ4 block compressor. Returns 0 when the block would not
+// be smaller than capacity, in which case the chunk is stored as is.
+static unsigned long long CompressBlock(const unsigned char        *in,
+                                        const unsigned long long   &in_bytes,
+                                        unsigned char              *out,
+                                        const unsigned long long   &capacity,
+                                        std::vector<unsigned int>  *table){
+    table->assign(1 << SCAN_ARCHIVE_HASH_BITS, 0);
+
+    unsigned char *op     = out;
+    unsigned char *op_end = out + capacity;
+
+    unsigned long long anchor = 0;
+    unsigned long long ip     = 0;
+    unsigned long long misses = 0;
+    const unsigned long long match_start_limit = (in_bytes > SCAN_ARCHIVE_MATCH_LIMIT) ? in_bytes - SCAN_ARCHIVE_MATCH_LIMIT : 0;
+    const unsigned long long match_end_limit   = (in_bytes > SCAN_ARCHIVE_LAST_LITERALS) ? in_bytes - SCAN_ARCHIVE_LAST_LITERALS : 0;
+
+    while(ip < match_start_limit){
+        const unsigned int sequence = ReadWord(in + ip);
+        const unsigned int hash     = (sequence * 2654435761u) >> (32 - SCAN_ARCHIVE_HASH_BITS);
+        const unsigned long long candidate = (*table)[hash];   // Positions are stored plus one so zero is empty
+        (*table)[hash] = (unsigned int)(ip + 1);
+
+        if((candidate == 0) || (ip + 1 - candidate > 65535) || (ReadWord(in + candidate - 1) != sequence)){
+            // Incompressible stretches are skipped faster the longer they run
+            ip += 1 + (misses++ >> 6);
+            continue;
+        }
+
+        unsigned long long match = candidate - 1;
+        while((ip > anchor) && (match > 0) && (in[ip - 1] == in[match - 1])){
+            ip--;
+            match--;
+        }
+        unsigned long long length = SCAN_ARCHIVE_MIN_MATCH;
+        while((ip + length < match_end_limit) && (in[match + length] == in[ip + length])) length++;
+
+        const unsigned long long literals = ip - anchor;
+        if((unsigned long long)(op_end - op) < 1 + literals / 255 + 1 + literals + 2 + length / 255 + 1) return 0;
+
+        unsigned char *token = op++;
+        *token = (unsigned char)(((literals < 15) ? literals : 15) << 4);
+        if(literals >= 15) op = PutLength(literals - 15, op);
+        std::memcpy(op, in + anchor, (size_t) literals);
+        op += literals;
+
+        const unsigned int offset = (unsigned int)(ip - match);
+        *op++ = (unsigned char)(offset & 0xFF);
+        *op++ = (unsigned char)(offset >> 8);
+
+        const unsigned long long match_length = length - SCAN_ARCHIVE_MIN_MATCH;
+        *token |= (unsigned char)((match_length < 15) ? match_length : 15);
+        if(match_length >= 15) op = PutLength(match_length - 15, op);
+
+        ip    += length;
+        anchor = ip;
+        misses = 0;
+    }
+
+    const unsigned long long literals = in_bytes - anchor;
+    if((unsigned long long)(op_end - op) < 1 + literals / 255 + 1 + literals) return 0;
+    *op++ = (unsigned char)(((literals < 15) ? literals : 15) << 4);
+    if(literals >= 15) op = PutLength(literals - 15, op);
+    std::memcpy(op, in + anchor, (size_t) literals);
+    op += literals;
+
+    return (unsigned long long)(op - out);
+}
+
+// Bounds checked LZ4 block decoder, false unless exactly out_bytes come out
+static bool DecompressBlock(const unsigned char        *in,
+                            const unsigned long long   &in_bytes,
+                            unsigned char              *out,
+                            const unsigned long long   &out_bytes){
+    unsigned long long ip = 0;
+    unsigned long long op = 0;
+
+    while(ip < in_bytes){
+        const unsigned char token = in[ip++];
+
+        unsigned long long literals = token >> 4;
+        if(literals == 15){
+            unsigned char more;
+            do{
+                if(ip >= in_bytes) return false;
+                more = in[ip++];
+                literals += more;
+            } while(more == 255);
+        }
+        if((literals > in_bytes - ip) || (literals > out_bytes - op)) return false;
+        std::memcpy(out + op, in + ip, (size_t) literals);
+        ip += literals;
+        op += literals;
+
+        if(ip == in_bytes) break;   // The last sequence has no match
+
+        if(in_bytes - ip < 2) return false;
+        const unsigned long long offset = in[ip] | (in[ip + 1] << 8);
+        ip += 2;
+        if((offset == 0) || (offset > op)) return false;
+
+        unsigned long long length = token & 15;
+        if(length == 15){
+            unsigned char more;
+            do{
+                if(ip >= in_bytes) return false;
+                more = in[ip++];
+                length += more;
+            } while(more == 255);
+        }
+        length += SCAN_ARCHIVE_MIN_MATCH;
+        if(length > out_bytes - op) return false;
+
+        // Byte by byte, the match may overlap what it is copying
+        const unsigned char *match = out + op - offset;
+        for(unsigned long long iByte = 0; iByte < length; iByte++) out[op + iByte] = match[iByte];
+        op += length;
+    }
+    return op == out_bytes;
+}
+
+static bool GetImageElement(const dlp::Image &image, unsigned int *element){
+    dlp::Image::Format format;
+    image.GetDataFormat(&format);
+    switch(format){
+    case dlp::Image::Format::MONO_UCHAR:    *element = SCAN_ARCHIVE_ELEMENT_MONO_UCHAR; return true;
+    case dlp::Image::Format::RGB_UCHAR:     *element = SCAN_ARCHIVE_ELEMENT_RGB_UCHAR;  return true;
+    case dlp::Image::Format::MONO_FLOAT:    *element = SCAN_ARCHIVE_ELEMENT_MONO_FLOAT; return true;
+    default:                                return false;
+    }
+}
+
+
+ScanArchive::ScanArchive(){
+    this->file_     = INVALID_HANDLE_VALUE;
+    this->compress_ = false;
+    this->view_     = 0;
+    this->end_      = 0;
+    this->footer_   = false;
+}
+
+ScanArchive::~ScanArchive(){
+    this->Close();
+}
+
+dlp::ReturnCode ScanArchive::Open(const std::string &filename){
+    dlp::ReturnCode ret;
+
+    if(this->isOpen()) this->Close();
+
+    this->file_ = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(this->file_ == INVALID_HANDLE_VALUE) return ret.AddError(SCAN_ARCHIVE_OPEN_FAILED);
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(this->file_, &size)){
+        this->Close();
+        return ret.AddError(SCAN_ARCHIVE_OPEN_FAILED);
+    }
+
+    this->entries_.clear();
+    if(size.QuadPart == 0){
+        ScanArchiveHeader header;
+        header.magic   = SCAN_ARCHIVE_MAGIC;
+        header.version = SCAN_ARCHIVE_VERSION;
+        header.created = (unsigned long long) std::time(NULL);
+
+        this->end_ = 0;
+        ret = this->Write(&header, sizeof(header));
+        if(ret.hasErrors()){
+            this->Close();
+            return ret;
+        }
+        this->end_    = sizeof(header);
+        this->footer_ = false;
+        return this->Flush();
+    }
+
+    // Chunks are appended after the last complete chunk of an existing
+    // archive. Anything else is refused rather than overwritten.
+    ScanArchiveReader reader;
+    ret = reader.Open(filename);
+    if(ret.hasErrors()){
+        CloseHandle(this->file_);
+        this->file_ = INVALID_HANDLE_VALUE;
+        return ret;
+    }
+
+    this->entries_.resize(reader.GetEntryCount());
+    for(unsigned int iEntry = 0; iEntry < reader.GetEntryCount(); iEntry++){
+        reader.GetEntry(iEntry, &this->entries_[iEntry]);
+    }
+    this->end_    = reader.GetChunkEnd();
+    this->footer_ = true;
+    reader.Close();
+
+    return ret;
+}
+
+dlp::ReturnCode ScanArchive::Close(){
+    dlp::ReturnCode ret;
+
+    if(!this->isOpen()) return ret;
+
+    ret = this->Flush();
+    CloseHandle(this->file_);
+
+    this->file_ = INVALID_HANDLE_VALUE;
+    this->end_  = 0;
+    this->entries_.clear();
+    this->buffer_.clear();
+    this->buffer_.shrink_to_fit();
+    return ret;
+}
+
+bool ScanArchive::isOpen() const{
+    return this->file_ != INVALID_HANDLE_VALUE;
+}
+
+void ScanArchive::SetCompression(const bool &compress){
+    this->compress_ = compress;
+}
+
+void ScanArchive::SetView(const unsigned int &view){
+    this->view_ = view;
+}
+
+dlp::ReturnCode ScanArchive::AppendImage(const unsigned int &type, const unsigned int &index, const dlp::Image &image){
+    dlp::ReturnCode ret;
+
+    ScanArchiveChunk chunk;
+    if(image.isEmpty() || !GetImageElement(image, &chunk.element)) return ret.AddError(SCAN_ARCHIVE_FORMAT_INVALID);
+
+    cv::Mat data;
+    image.GetOpenCVData(&data);
+
+    chunk.type    = type;
+    chunk.index   = index;
+    chunk.columns = data.cols;
+    chunk.rows    = data.rows;
+
+    if(data.isContinuous()) return this->AppendChunk(chunk, data.ptr<unsigned char>(0));
+
+    const size_t row_bytes = (size_t) data.cols * GetElementBytes(chunk.element);
+    this->buffer_.resize(row_bytes * data.rows);
+    for(int iRow = 0; iRow < data.rows; iRow++){
+        std::memcpy(&this->buffer_[iRow * row_bytes], data.ptr<unsigned char>(iRow), row_bytes);
+    }
+    return this->AppendChunk(chunk, &this->buffer_[0]);
+}
+
+dlp::ReturnCode ScanArchive::AppendDisparityMap(const unsigned int &type, const dlp::DisparityMap &disparity_map){
+    dlp::ReturnCode ret;
+
+    if(disparity_map.isEmpty()) return ret.AddError(SCAN_ARCHIVE_FORMAT_INVALID);
+
+    ScanArchiveChunk chunk;
+    chunk.type    = type;
+    chunk.index   = 0;
+    chunk.element = SCAN_ARCHIVE_ELEMENT_DISPARITY;
+    disparity_map.GetColumns(&chunk.columns);
+    disparity_map.GetRows(&chunk.rows);
+
+    this->buffer_.resize((size_t) chunk.columns * chunk.rows * sizeof(int));
+    int *pixels = (int*) &this->buffer_[0];
+    for(unsigned int yRow = 0; yRow < chunk.rows; yRow++){
+        for(unsigned int xCol = 0; xCol < chunk.columns; xCol++){
+            disparity_map.Unsafe_GetPixel(xCol, yRow, &pixels[yRow * chunk.columns + xCol]);
+        }
+    }
+    return this->AppendChunk(chunk, &this->buffer_[0]);
+}
+
+dlp::ReturnCode ScanArchive::AppendPointCloud(const dlp::Point::Cloud &point_cloud){
+    ScanArchiveChunk chunk;
+    chunk.type    = SCAN_ARCHIVE_CHUNK_POINT_CLOUD;
+    chunk.index   = 0;
+    chunk.element = SCAN_ARCHIVE_ELEMENT_POINT;
+    chunk.columns = (unsigned int) point_cloud.GetCount();
+    chunk.rows    = 1;
+
+    this->buffer_.resize((size_t) chunk.columns * 3 * sizeof(double) + 1);
+    double *xyz = (double*) &this->buffer_[0];
+    for(unsigned int iPoint = 0; iPoint < chunk.columns; iPoint++){
+        dlp::Point point;
+        point_cloud.Get(iPoint, &point);
+        xyz[3 * iPoint + 0] = point.x;
+        xyz[3 * iPoint + 1] = point.y;
+        xyz[3 * iPoint + 2] = point.z;
+    }
+    return this->AppendChunk(chunk, &this->buffer_[0]);
+}
+
+dlp::ReturnCode ScanArchive::Flush(){
+    dlp::ReturnCode ret;
+
+    if(!this->isOpen()) return ret.AddError(SCAN_ARCHIVE_NOT_OPEN);
+
+    LARGE_INTEGER position;
+    position.QuadPart = this->end_;
+    if(!SetFilePointerEx(this->file_, position, NULL, FILE_BEGIN)) return ret.AddError(SCAN_ARCHIVE_WRITE_FAILED);
+
+    ScanArchiveTrailer trailer;
+    trailer.index_offset = this->end_;
+    trailer.entry_count  = this->entries_.size();
+    trailer.magic        = SCAN_ARCHIVE_INDEX_MAGIC;
+    trailer.version      = SCAN_ARCHIVE_VERSION;
+
+    if(!this->entries_.empty()){
+        ret = this->Write(&this->entries_[0], this->entries_.size() * sizeof(ScanArchiveEntry));
+        if(ret.hasErrors()) return ret;
+    }
+    ret = this->Write(&trailer, sizeof(trailer));
+    if(ret.hasErrors()) return ret;
+
+    // The footer may be shorter than the one it replaces
+    if(!SetEndOfFile(this->file_) || !FlushFileBuffers(this->file_)) return ret.AddError(SCAN_ARCHIVE_WRITE_FAILED);
+
+    this->footer_ = true;
+    return ret;
+}
+
+unsigned int ScanArchive::GetEntryCount() const{
+    return (unsigned int) this->entries_.size();
+}
+
+dlp::ReturnCode ScanArchive::AppendChunk(ScanArchiveChunk chunk, const unsigned char *data){
+    dlp::ReturnCode ret;
+
+    if(!this->isOpen()) return ret.AddError(SCAN_ARCHIVE_NOT_OPEN);
+
+    // A footer left behind the new chunk could be mistaken for chunks when
+    // the archive is recovered, so it goes before anything is appended
+    if(this->footer_){
+        LARGE_INTEGER position;
+        position.QuadPart = this->end_;
+        if(!SetFilePointerEx(this->file_, position, NULL, FILE_BEGIN) || !SetEndOfFile(this->file_)){
+            return ret.AddError(SCAN_ARCHIVE_WRITE_FAILED);
+        }
+        this->footer_ = false;
+    }
+
+    chunk.magic        = SCAN_ARCHIVE_CHUNK_MAGIC;
+    chunk.view         = this->view_;
+    chunk.compression  = SCAN_ARCHIVE_COMPRESSION_NONE;
+    chunk.raw_bytes    = (unsigned long long) chunk.columns * chunk.rows * GetElementBytes(chunk.element);
+    chunk.stored_bytes = chunk.raw_bytes;
+
+    const unsigned char *payload = data;
+    std::vector<unsigned char> compressed;
+    if(this->compress_ && (chunk.raw_bytes > SCAN_ARCHIVE_MATCH_LIMIT)){
+        // Only kept when it saves space
+        std::vector<unsigned int> table;
+        compressed.resize((size_t) chunk.raw_bytes);
+        const unsigned long long bytes = CompressBlock(data, chunk.raw_bytes, &compressed[0], chunk.raw_bytes - 1, &table);
+        if(bytes > 0){
+            chunk.compression  = SCAN_ARCHIVE_COMPRESSION_LZ;
+            chunk.stored_bytes = bytes;
+            payload            = &compressed[0];
+        }
+    }
+
+    ScanArchiveEntry entry;
+    entry.chunk  = chunk;
+    entry.offset = this->end_;
+
+    const unsigned long long padding = Align(chunk.stored_bytes) - chunk.stored_bytes;
+    const unsigned char zeros[SCAN_ARCHIVE_ALIGNMENT] = { 0 };
+
+    ret = this->Write(&chunk, sizeof(chunk));
+    if(!ret.hasErrors() && (chunk.stored_bytes > 0)) ret = this->Write(payload, chunk.stored_bytes);
+    if(!ret.hasErrors() && (padding > 0))            ret = this->Write(zeros, padding);
+    if(ret.hasErrors()) return ret;
+
+    this->end_ = Align(entry.offset + sizeof(chunk) + chunk.stored_bytes);
+    this->entries_.push_back(entry);
+    return ret;
+}
+
+// Writes at the end of the last chunk, the file pointer follows each write
+dlp::ReturnCode ScanArchive::Write(const void *data, const unsigned long long &bytes){
+    dlp::ReturnCode ret;
+
+    const unsigned char *next = (const unsigned char*) data;
+    unsigned long long remaining = bytes;
+    while(remaining > 0){
+        const DWORD piece = (DWORD)((remaining < SCAN_ARCHIVE_WRITE_PIECE) ? remaining : SCAN_ARCHIVE_WRITE_PIECE);
+        DWORD written = 0;
+        if(!WriteFile(this->file_, next, piece, &written, NULL) || (written != piece)){
+            return ret.AddError(SCAN_ARCHIVE_WRITE_FAILED);
+        }
+        next      += written;
+        remaining -= written;
+    }
+    return ret;
+}
+
+
+ScanArchiveReader::ScanArchiveReader(){
+    this->file_      = INVALID_HANDLE_VALUE;
+    this->mapping_   = NULL;
+    this->base_      = NULL;
+    this->size_      = 0;
+    this->chunk_end_ = 0;
+}
+
+ScanArchiveReader::~ScanArchiveReader(){
+    this->Close();
+}
+
+dlp::ReturnCode ScanArchiveReader::Open(const std::string &filename){
+    dlp::ReturnCode ret;
+
+    this->Close();
+
+    // The writer may hold the file open while it is read
+    this->file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(this->file_ == INVALID_HANDLE_VALUE) return ret.AddError(SCAN_ARCHIVE_OPEN_FAILED);
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(this->file_, &size) || (size.QuadPart < (long long) sizeof(ScanArchiveHeader))){
+        this->Close();
+        return ret.AddError(SCAN_ARCHIVE_FILE_INVALID);
+    }
+    this->size_ = size.QuadPart;
+
+    this->mapping_ = CreateFileMappingA(this->file_, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(this->mapping_ != NULL) this->base_ = (const unsigned char*) MapViewOfFile(this->mapping_, FILE_MAP_READ, 0, 0, 0);
+    if(this->base_ == NULL){
+        this->Close();
+        return ret.AddError(SCAN_ARCHIVE_MAP_FAILED);
+    }
+
+    ScanArchiveHeader header;
+    std::memcpy(&header, this->base_, sizeof(header));
+    if((header.magic != SCAN_ARCHIVE_MAGIC) || (header.version != SCAN_ARCHIVE_VERSION)){
+        this->Close();
+        return ret.AddError(SCAN_ARCHIVE_FILE_INVALID);
+    }
+
+    if(!ReadIndexFooter(this->base_, this->size_, &this->entries_, &this->chunk_end_)){
+        ReadIndexChunks(this->base_, this->size_, &this->entries_, &this->chunk_end_);
+    }
+    return ret;
+}
+
+void ScanArchiveReader::Close(){
+    if(this->base_ != NULL) UnmapViewOfFile(this->base_);
+    if(this->mapping_ != NULL) CloseHandle(this->mapping_);
+    if(this->file_ != INVALID_HANDLE_VALUE) CloseHandle(this->file_);
+
+    this->file_      = INVALID_HANDLE_VALUE;
+    this->mapping_   = NULL;
+    this->base_      = NULL;
+    this->size_      = 0;
+    this->chunk_end_ = 0;
+    this->entries_.clear();
+}
+
+bool ScanArchiveReader::isOpen() const{
+    return this->base_ != NULL;
+}
+
+unsigned int ScanArchiveReader::GetEntryCount() const{
+    return (unsigned int) this->entries_.size();
+}
+
+dlp::ReturnCode ScanArchiveReader::GetEntry(const unsigned int &entry, ScanArchiveEntry *archive_entry) const{
+    dlp::ReturnCode ret;
+
+    if(!archive_entry) return ret.AddError(SCAN_ARCHIVE_NULL_POINTER);
+    if(entry >= this->entries_.size()) return ret.AddError(SCAN_ARCHIVE_ENTRY_INVALID);
+
+    *archive_entry = this->entries_[entry];
+    return ret;
+}
+
+dlp::ReturnCode ScanArchiveReader::Find(const unsigned int &type, const unsigned int &view, const unsigned int &index, unsigned int *entry) const{
+    dlp::ReturnCode ret;
+
+    if(!entry) return ret.AddError(SCAN_ARCHIVE_NULL_POINTER);
+
+    for(unsigned int iEntry = (unsigned int) this->entries_.size(); iEntry > 0; iEntry--){
+        const ScanArchiveChunk &chunk = this->entries_[iEntry - 1].chunk;
+        if((chunk.type == type) && (chunk.view == view) && (chunk.index == index)){
+            *entry = iEntry - 1;
+            return ret;
+        }
+    }
+    return ret.AddError(SCAN_ARCHIVE_ENTRY_NOT_FOUND);
+}
+
+dlp::ReturnCode ScanArchiveReader::GetImage(const unsigned int &entry, dlp::Image *image) const{
+    dlp::ReturnCode ret;
+
+    if(!image) return ret.AddError(SCAN_ARCHIVE_NULL_POINTER);
+    if(entry >= this->entries_.size()) return ret.AddError(SCAN_ARCHIVE_ENTRY_INVALID);
+
+    const ScanArchiveChunk &chunk = this->entries_[entry].chunk;
+    dlp::Image::Format format;
+    switch(chunk.element){
+    case SCAN_ARCHIVE_ELEMENT_MONO_UCHAR:   format = dlp::Image::Format::MONO_UCHAR;    break;
+    case SCAN_ARCHIVE_ELEMENT_RGB_UCHAR:    format = dlp::Image::Format::RGB_UCHAR;     break;
+    case SCAN_ARCHIVE_ELEMENT_MONO_FLOAT:   format = dlp::Image::Format::MONO_FLOAT;    break;
+    default:                                return ret.AddError(SCAN_ARCHIVE_FORMAT_INVALID);
+    }
+
+    std::vector<unsigned char> payload;
+    const unsigned char *data;
+    ret = this->GetPayload(entry, &payload, &data);
+    if(ret.hasErrors()) return ret;
+
+    image->Create(chunk.columns, chunk.rows, format);
+    cv::Mat pixels;
+    image->Unsafe_GetOpenCVData(&pixels);
+
+    const size_t row_bytes = (size_t) chunk.columns * GetElementBytes(chunk.element);
+    for(unsigned int yRow = 0; yRow < chunk.rows; yRow++){
+        std::memcpy(pixels.ptr<unsigned char>(yRow), data + yRow * row_bytes, row_bytes);
+    }
+    return ret;
+}
+
+dlp::ReturnCode ScanArchiveReader::GetDisparityMap(const unsigned int &entry, dlp::DisparityMap *disparity_map) const{
+    dlp::ReturnCode ret;
+
+    if(!disparity_map) return ret.AddError(SCAN_ARCHIVE_NULL_POINTER);
+    if(entry >= this->entries_.size()) return ret.AddError(SCAN_ARCHIVE_ENTRY_INVALID);
+
+    const ScanArchiveChunk &chunk = this->entries_[entry].chunk;
+    if(chunk.element != SCAN_ARCHIVE_ELEMENT_DISPARITY) return ret.AddError(SCAN_ARCHIVE_FORMAT_INVALID);
+
+    std::vector<unsigned char> payload;
+    const unsigned char *data;
+    ret = this->GetPayload(entry, &payload, &data);
+    if(ret.hasErrors()) return ret;
+
+    disparity_map->Create(chunk.columns, chunk.rows,
+                          (chunk.type == SCAN_ARCHIVE_CHUNK_ROW_DISPARITY) ? dlp::Pattern::Orientation::HORIZONTAL :
+                                                                             dlp::Pattern::Orientation::VERTICAL);
+    for(unsigned int yRow = 0; yRow < chunk.rows; yRow++){
+        for(unsigned int xCol = 0; xCol < chunk.columns; xCol++){
+            int value;
+            std::memcpy(&value, data + ((size_t) yRow * chunk.columns + xCol) * sizeof(int), sizeof(int));
+            disparity_map->Unsafe_SetPixel(xCol, yRow, value);
+        }
+    }
+    return ret;
+}
+
+dlp::ReturnCode ScanArchiveReader::GetPointCloud(const unsigned int &entry, dlp::Point::Cloud *point_cloud) const{
+    dlp::ReturnCode ret;
+
+    if(!point_cloud) return ret.AddError(SCAN_ARCHIVE_NULL_POINTER);
+    if(entry >= this->entries_.size()) return ret.AddError(SCAN_ARCHIVE_ENTRY_INVALID);
+
+    const ScanArchiveChunk &chunk = this->entries_[entry].chunk;
+    if(chunk.element != SCAN_ARCHIVE_ELEMENT_POINT) return ret.AddError(SCAN_ARCHIVE_FORMAT_INVALID);
+
+    std::vector<unsigned char> payload;
+    const unsigned char *data;
+    ret = this->GetPayload(entry, &payload, &data);
+    if(ret.hasErrors()) return ret;
+
+    point_cloud->Clear();
+    for(unsigned int iPoint = 0; iPoint < chunk.columns; iPoint++){
+        double xyz[3];
+        std::memcpy(xyz, data + (size_t) iPoint * sizeof(xyz), sizeof(xyz));
+
+        dlp::Point point;
+        point.x = xyz[0];
+        point.y = xyz[1];
+        point.z = xyz[2];
+        point_cloud->Add(point);
+    }
+    return ret;
+}
+
+dlp::ReturnCode ScanArchiveReader::GetData(const unsigned int &entry, const unsigned char **data, unsigned long long *bytes) const{
+    dlp::ReturnCode ret;
+
+    if(!data || !bytes) return ret.AddError(SCAN_ARCHIVE_NULL_POINTER);
+    if(entry >= this->entries_.size()) return ret.AddError(SCAN_ARCHIVE_ENTRY_INVALID);
+
+    const ScanArchiveEntry &archive_entry = this->entries_[entry];
+    if(archive_entry.chunk.compression != SCAN_ARCHIVE_COMPRESSION_NONE) return ret.AddError(SCAN_ARCHIVE_COMPRESSED);
+
+    *data  = this->base_ + archive_entry.offset + sizeof(ScanArchiveChunk);
+    *bytes = archive_entry.chunk.raw_bytes;
+    return ret;
+}
+
+unsigned long long ScanArchiveReader::GetChunkEnd() const{
+    return this->chunk_end_;
+}
+
+// Points data at the mapping, or at payload once it is decompressed there
+dlp::ReturnCode ScanArchiveReader::GetPayload(const unsigned int &entry, std::vector<unsigned char> *payload, const unsigned char **data) const{
+    dlp::ReturnCode ret;
+
+    if(!this->isOpen()) return ret.AddError(SCAN_ARCHIVE_NOT_OPEN);
+
+    const ScanArchiveEntry &archive_entry = this->entries_[entry];
+    const unsigned char *stored = this->base_ + archive_entry.offset + sizeof(ScanArchiveChunk);
+
+    if(archive_entry.chunk.compression == SCAN_ARCHIVE_COMPRESSION_NONE){
+        *data = stored;
+        return ret;
+    }
+
+    payload->resize((size_t) archive_entry.chunk.raw_bytes + 1);
+    if(!DecompressBlock(stored, archive_entry.chunk.stored_bytes, &(*payload)[0], archive_entry.chunk.raw_bytes)){
+        return ret.AddError(SCAN_ARCHIVE_DATA_CORRUPT);
+    }
+    *data = &(*payload)[0];
+    return ret;
+}
@@ -0,0 +1,153 @@
+/** @file       ScanArchive.h
+ *  @brief      Append-only single file archive of a scan session
+ */
+#ifndef __SCAN_ARCHIVE_H_
+#define __SCAN_ARCHIVE_H_
+
+#include <winsock2.h>
+#include <Windows.h>
+#include <string>
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define SCAN_ARCHIVE_NULL_POINTER           "SCAN_ARCHIVE_NULL_POINTER"
+#define SCAN_ARCHIVE_NOT_OPEN               "SCAN_ARCHIVE_NOT_OPEN"
+#define SCAN_ARCHIVE_OPEN_FAILED            "SCAN_ARCHIVE_OPEN_FAILED"
+#define SCAN_ARCHIVE_FILE_INVALID           "SCAN_ARCHIVE_FILE_INVALID"
+#define SCAN_ARCHIVE_WRITE_FAILED           "SCAN_ARCHIVE_WRITE_FAILED"
+#define SCAN_ARCHIVE_MAP_FAILED             "SCAN_ARCHIVE_MAP_FAILED"
+#define SCAN_ARCHIVE_FORMAT_INVALID         "SCAN_ARCHIVE_FORMAT_INVALID"
+#define SCAN_ARCHIVE_ENTRY_INVALID          "SCAN_ARCHIVE_ENTRY_INVALID"
+#define SCAN_ARCHIVE_ENTRY_NOT_FOUND        "SCAN_ARCHIVE_ENTRY_NOT_FOUND"
+#define SCAN_ARCHIVE_DATA_CORRUPT           "SCAN_ARCHIVE_DATA_CORRUPT"
+#define SCAN_ARCHIVE_COMPRESSED             "SCAN_ARCHIVE_COMPRESSED"
+
+#define SCAN_ARCHIVE_MAGIC                  0x41504C44  // "DLPA"
+#define SCAN_ARCHIVE_CHUNK_MAGIC            0x4B4E4843  // "CHNK"
+#define SCAN_ARCHIVE_INDEX_MAGIC            0x58444E49  // "INDX"
+#define SCAN_ARCHIVE_VERSION                1
+#define SCAN_ARCHIVE_ALIGNMENT              8           // Payloads start 8 byte aligned in the mapping
+
+// Chunk types
+#define SCAN_ARCHIVE_CHUNK_CAPTURE          1   // Index is the pattern
+#define SCAN_ARCHIVE_CHUNK_COLUMN_DISPARITY 2
+#define SCAN_ARCHIVE_CHUNK_ROW_DISPARITY    3
+#define SCAN_ARCHIVE_CHUNK_CONFIDENCE       4
+#define SCAN_ARCHIVE_CHUNK_DEPTH_MAP        5
+#define SCAN_ARCHIVE_CHUNK_COLOR_MAP        6
+#define SCAN_ARCHIVE_CHUNK_POINT_CLOUD      7
+
+// Payload elements, stored row after row without padding
+#define SCAN_ARCHIVE_ELEMENT_MONO_UCHAR     1
+#define SCAN_ARCHIVE_ELEMENT_RGB_UCHAR      2
+#define SCAN_ARCHIVE_ELEMENT_MONO_FLOAT     3
+#define SCAN_ARCHIVE_ELEMENT_DISPARITY      4   // int per pixel
+#define SCAN_ARCHIVE_ELEMENT_POINT          5   // double x, y, z per point, columns is the count
+
+#define SCAN_ARCHIVE_COMPRESSION_NONE       0
+#define SCAN_ARCHIVE_COMPRESSION_LZ         1   // LZ4 block format
+
+// Written in front of every payload and repeated in the index
+struct ScanArchiveChunk{
+    unsigned int        magic;
+    unsigned int        type;
+    unsigned int        view;
+    unsigned int        index;
+    unsigned int        columns;
+    unsigned int        rows;
+    unsigned int        element;
+    unsigned int        compression;
+    unsigned long long  raw_bytes;
+    unsigned long long  stored_bytes;
+};
+
+struct ScanArchiveEntry{
+    ScanArchiveChunk    chunk;
+    unsigned long long  offset;     // Of the chunk header
+};
+
+// Last bytes of the file, the index entries start at index_offset
+struct ScanArchiveTrailer{
+    unsigned long long  index_offset;
+    unsigned long long  entry_count;
+    unsigned int        magic;
+    unsigned int        version;
+};
+
+// Appends chunks to one file per session. The index footer is written by
+// Flush and Close and overwritten by the next chunk, so an archive left
+// without one by a crash is recovered from its chunk headers when it is
+// opened again.
+class ScanArchive{
+public:
+    ScanArchive();
+    ~ScanArchive();
+
+    // Creates the file, or appends to an existing archive
+    dlp::ReturnCode Open(const std::string &filename);
+    dlp::ReturnCode Close();
+    bool isOpen() const;
+
+    void SetCompression(const bool &compress);
+    void SetView(const unsigned int &view);
+
+    dlp::ReturnCode AppendImage(const unsigned int &type, const unsigned int &index, const dlp::Image &image);
+    dlp::ReturnCode AppendDisparityMap(const unsigned int &type, const dlp::DisparityMap &disparity_map);
+    dlp::ReturnCode AppendPointCloud(const dlp::Point::Cloud &point_cloud);
+
+    // Writes the index footer so everything appended so far is readable
+    dlp::ReturnCode Flush();
+
+    unsigned int GetEntryCount() const;
+
+private:
+    dlp::ReturnCode AppendChunk(ScanArchiveChunk chunk, const unsigned char *data);
+    dlp::ReturnCode Write(const void *data, const unsigned long long &bytes);
+
+    HANDLE                          file_;
+    bool                            compress_;
+    unsigned int                    view_;
+    unsigned long long              end_;           // Where the next chunk goes
+    bool                            footer_;        // An index footer follows end_
+    std::vector<ScanArchiveEntry>   entries_;
+    std::vector<unsigned char>      buffer_;        // Payload being packed or compressed
+};
+
+// Maps an archive read only for random access to its chunks
+class ScanArchiveReader{
+public:
+    ScanArchiveReader();
+    ~ScanArchiveReader();
+
+    dlp::ReturnCode Open(const std::string &filename);
+    void Close();
+    bool isOpen() const;
+
+    unsigned int GetEntryCount() const;
+    dlp::ReturnCode GetEntry(const unsigned int &entry, ScanArchiveEntry *archive_entry) const;
+
+    // The last matching chunk wins, as a later file of the same name would
+    dlp::ReturnCode Find(const unsigned int &type, const unsigned int &view, const unsigned int &index, unsigned int *entry) const;
+
+    dlp::ReturnCode GetImage(const unsigned int &entry, dlp::Image *image) const;
+    dlp::ReturnCode GetDisparityMap(const unsigned int &entry, dlp::DisparityMap *disparity_map) const;
+    dlp::ReturnCode GetPointCloud(const unsigned int &entry, dlp::Point::Cloud *point_cloud) const;
+
+    // Uncompressed payloads in place, valid until Close
+    dlp::ReturnCode GetData(const unsigned int &entry, const unsigned char **data, unsigned long long *bytes) const;
+
+    // Where the chunks stop, at the footer or at the first incomplete chunk
+    unsigned long long GetChunkEnd() const;
+
+private:
+    dlp::ReturnCode GetPayload(const unsigned int &entry, std::vector<unsigned char> *payload, const unsigned char **data) const;
+
+    HANDLE                          file_;
+    HANDLE                          mapping_;
+    const unsigned char            *base_;
+    unsigned long long              size_;
+    unsigned long long              chunk_end_;
+    std::vector<ScanArchiveEntry>   entries_;
+};
+
+#endif
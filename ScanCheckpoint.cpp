@@ -0,0 +1,182 @@
+/** @file       ScanCheckpoint.cpp
+ *  @brief      Progress of a multi-view scan session kept on disk for resuming it
+ *
+ *  File layout, one entry per line:
+ *      DLP_SCAN_CHECKPOINT 1
+ *      VIEWS <view count>
+ *      NEXT_VIEW <view>
+ *      TABLE_STEP <steps turned> <angle>
+ *      SETTINGS <settings hash>
+ *      DIRECTORY <data directory>
+ *      ARCHIVE <file, empty without an archive>
+ *      VIEW <view>
+ *      OUTPUT <view> <file>
+ */
+#include <winsock2.h>
+#include <Windows.h>
+#include <fstream>
+#include <sstream>
+#include "ScanCheckpoint.h"
+
+ScanCheckpoint::ScanCheckpoint(){
+    this->Start(0, "", "", "");
+}
+
+void ScanCheckpoint::Start(const unsigned int &view_count,
+                           const std::string  &directory,
+                           const std::string  &settings,
+                           const std::string  &archive_file){
+    this->view_count_   = view_count;
+    this->next_view_    = 1;
+    this->table_step_   = 0;
+    this->directory_    = directory;
+    this->settings_     = settings;
+    this->archive_file_ = archive_file;
+    this->saved_views_.clear();
+}
+
+dlp::ReturnCode ScanCheckpoint::Load(const std::string &filename){
+    dlp::ReturnCode ret;
+
+    std::ifstream file(filename.c_str());
+    if(!file.is_open()) return ret.AddError(SCAN_CHECKPOINT_FILE_OPEN_FAILED);
+
+    std::string  magic;
+    unsigned int version = 0;
+    if(!(file >> magic >> version) || (magic != SCAN_CHECKPOINT_MAGIC) || (version != SCAN_CHECKPOINT_VERSION)){
+        return ret.AddError(SCAN_CHECKPOINT_FILE_INVALID);
+    }
+
+    ScanCheckpoint loaded;
+    std::string    line;
+    std::getline(file, line);
+    while(std::getline(file, line)){
+        if(!line.empty() && (line[line.size() - 1] == '\r')) line.erase(line.size() - 1);
+        if(line.empty()) continue;
+
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+
+        bool valid = true;
+        if(key == "VIEWS")              valid = !!(fields >> loaded.view_count_);
+        else if(key == "NEXT_VIEW")     valid = !!(fields >> loaded.next_view_);
+        else if(key == "TABLE_STEP")    valid = !!(fields >> loaded.table_step_);
+        else if(key == "SETTINGS")      valid = !!(fields >> loaded.settings_);
+        else if(key == "DIRECTORY")     std::getline(fields >> std::ws, loaded.directory_);
+        else if(key == "ARCHIVE")       std::getline(fields >> std::ws, loaded.archive_file_);
+        else if(key == "VIEW"){
+            ScanCheckpointView view;
+            valid = !!(fields >> view.view);
+            loaded.saved_views_.push_back(view);
+        }
+        else if(key == "OUTPUT"){
+            unsigned int view = 0;
+            std::string  output;
+            valid = !!(fields >> view) && !loaded.saved_views_.empty() && (loaded.saved_views_.back().view == view);
+            if(valid) std::getline(fields >> std::ws, output);
+            if(valid) loaded.saved_views_.back().outputs.push_back(output);
+        }
+        else valid = false;
+
+        if(!valid) return ret.AddError(SCAN_CHECKPOINT_FILE_INVALID);
+    }
+
+    if((loaded.view_count_ == 0) || (loaded.next_view_ == 0) || (loaded.next_view_ > loaded.view_count_ + 1)){
+        return ret.AddError(SCAN_CHECKPOINT_FILE_INVALID);
+    }
+
+    *this = loaded;
+    return ret;
+}
+
+dlp::ReturnCode ScanCheckpoint::Save(const std::string &filename) const{
+    dlp::ReturnCode ret;
+
+    // Written next to the checkpoint and moved over it, so it is never partial
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary.c_str(), std::ios::out | std::ios::trunc);
+        if(!file.is_open()) return ret.AddError(SCAN_CHECKPOINT_FILE_OPEN_FAILED);
+
+        file << SCAN_CHECKPOINT_MAGIC << " " << SCAN_CHECKPOINT_VERSION << "\n";
+        file << "VIEWS " << this->view_count_ << "\n";
+        file << "NEXT_VIEW " << this->next_view_ << "\n";
+        file << "TABLE_STEP " << this->table_step_ << " " << this->GetTableAngle() << "\n";
+        file << "SETTINGS " << this->settings_ << "\n";
+        file << "DIRECTORY " << this->directory_ << "\n";
+        file << "ARCHIVE " << this->archive_file_ << "\n";
+        for(unsigned int iView = 0; iView < this->saved_views_.size(); iView++){
+            const ScanCheckpointView &view = this->saved_views_[iView];
+            file << "VIEW " << view.view << "\n";
+            for(unsigned int iOutput = 0; iOutput < view.outputs.size(); iOutput++){
+                file << "OUTPUT " << view.view << " " << view.outputs[iOutput] << "\n";
+            }
+        }
+
+        file.flush();
+        if(file.fail()) return ret.AddError(SCAN_CHECKPOINT_WRITE_FAILED);
+    }
+
+    if(!MoveFileExA(temporary.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)){
+        return ret.AddError(SCAN_CHECKPOINT_WRITE_FAILED);
+    }
+    return ret;
+}
+
+void ScanCheckpoint::FinishView(const unsigned int &view, const bool &saved, const std::vector<std::string> &outputs){
+    // Views after one which was not saved are rescanned with it
+    if(!saved || (view != this->next_view_)) return;
+    this->next_view_ = view + 1;
+
+    ScanCheckpointView saved_view;
+    saved_view.view    = view;
+    saved_view.outputs = outputs;
+    this->saved_views_.push_back(saved_view);
+}
+
+void ScanCheckpoint::TurnTable(){
+    this->table_step_++;
+}
+
+unsigned int ScanCheckpoint::GetViewCount() const{
+    return this->view_count_;
+}
+
+unsigned int ScanCheckpoint::GetNextView() const{
+    return this->next_view_;
+}
+
+unsigned int ScanCheckpoint::GetTableStep() const{
+    return this->table_step_;
+}
+
+float ScanCheckpoint::GetTableAngle() const{
+    if(this->view_count_ == 0) return 0;
+    return (float)(this->table_step_ % this->view_count_) * 360.0f / this->view_count_;
+}
+
+bool ScanCheckpoint::isComplete() const{
+    return this->next_view_ > this->view_count_;
+}
+
+bool ScanCheckpoint::isJob(const std::string &directory, const std::string &settings) const{
+    return !this->settings_.empty() && (this->directory_ == directory) && (this->settings_ == settings);
+}
+
+const std::string& ScanCheckpoint::GetArchiveFile() const{
+    return this->archive_file_;
+}
+
+const std::vector<ScanCheckpointView>& ScanCheckpoint::GetSavedViews() const{
+    return this->saved_views_;
+}
+
+unsigned int ScanCheckpoint::GetResumeSteps() const{
+    if(this->view_count_ == 0) return 0;
+
+    // The table stands at the view after the last one it turned from
+    const unsigned int target = (this->next_view_ - 1) % this->view_count_;
+    const unsigned int at     = this->table_step_ % this->view_count_;
+    return (target + this->view_count_ - at) % this->view_count_;
+}
@@ -0,0 +1,75 @@
+/** @file       ScanCheckpoint.h
+ *  @brief      Progress of a multi-view scan session kept on disk for resuming it
+ */
+#ifndef __SCAN_CHECKPOINT_H_
+#define __SCAN_CHECKPOINT_H_
+
+#include <string>
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define SCAN_CHECKPOINT_FILE_OPEN_FAILED    "SCAN_CHECKPOINT_FILE_OPEN_FAILED"
+#define SCAN_CHECKPOINT_FILE_INVALID        "SCAN_CHECKPOINT_FILE_INVALID"
+#define SCAN_CHECKPOINT_WRITE_FAILED        "SCAN_CHECKPOINT_WRITE_FAILED"
+
+#define SCAN_CHECKPOINT_MAGIC               "DLP_SCAN_CHECKPOINT"
+#define SCAN_CHECKPOINT_VERSION             2
+#define SCAN_CHECKPOINT_FILE                "scan_checkpoint.txt"
+#define SCAN_CHECKPOINT_SETTINGS_FILE       "scan_checkpoint_settings.txt"
+
+// A view and the files its results were saved to
+struct ScanCheckpointView{
+    unsigned int                view;
+    std::vector<std::string>    outputs;
+};
+
+// Views are numbered from 1 and the turntable turns one step of 360 / views
+// degrees after each of them, so the step it has reached since the session
+// started gives its angle. The session is keyed by its data directory and a
+// hash of its settings so another job writing to the same directory does not
+// pick it up. The file is replaced as a whole on every Save, a crash leaves
+// either the previous or the new checkpoint.
+class ScanCheckpoint{
+public:
+    ScanCheckpoint();
+
+    // A new session of view_count views of the job, with the archive its views go to if any
+    void Start(const unsigned int &view_count,
+               const std::string  &directory,
+               const std::string  &settings,
+               const std::string  &archive_file);
+
+    dlp::ReturnCode Load(const std::string &filename);
+    dlp::ReturnCode Save(const std::string &filename) const;
+
+    // The view was scanned, with the files saved for it when it succeeded. The
+    // session only moves past saved views, a resume rescans from the first
+    // view which was not saved.
+    void FinishView(const unsigned int &view, const bool &saved, const std::vector<std::string> &outputs);
+
+    // The turntable acknowledged a step
+    void TurnTable();
+
+    unsigned int GetViewCount() const;
+    unsigned int GetNextView() const;
+    unsigned int GetTableStep() const;
+    float        GetTableAngle() const;
+    bool         isComplete() const;
+    bool         isJob(const std::string &directory, const std::string &settings) const;
+    const std::string& GetArchiveFile() const;
+    const std::vector<ScanCheckpointView>& GetSavedViews() const;
+
+    // Steps taking the table from where it stopped to the next view
+    unsigned int GetResumeSteps() const;
+
+private:
+    unsigned int                    view_count_;
+    unsigned int                    next_view_;
+    unsigned int                    table_step_;
+    std::string                     directory_;
+    std::string                     settings_;
+    std::string                     archive_file_;
+    std::vector<ScanCheckpointView> saved_views_;
+};
+
+#endif
@@ -0,0 +1,181 @@
+/** @file       ScanDaemon.cpp
+ *  @brief      Scan job queue served over a local named pipe
+ */
+#include <cstdlib>
+#include <sstream>
+#include "ScanDaemon.h"
+
+ScanDaemon::ScanDaemon(){
+    this->next_id_  = 1;
+    this->stopping_ = false;
+    this->listening_.store(false);
+}
+
+ScanDaemon::~ScanDaemon(){
+    this->Stop();
+}
+
+dlp::ReturnCode ScanDaemon::Start(const std::string &pipe_name, const BatchScanJob &defaults){
+    dlp::ReturnCode ret;
+
+    if(this->listener_.joinable()) return ret.AddError(SCAN_DAEMON_ALREADY_STARTED);
+
+    this->pipe_name_ = pipe_name.empty() ? SCAN_DAEMON_DEFAULT_PIPE : pipe_name;
+    this->defaults_  = defaults;
+    this->stopping_  = false;
+    this->listening_.store(true);
+    this->listener_  = std::thread(&ScanDaemon::Listen,this);
+
+    return ret;
+}
+
+void ScanDaemon::Stop(){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->stopping_ = true;
+    }
+    this->job_queued_.notify_all();
+
+    if(!this->listener_.joinable()) return;
+
+    // The listener is blocked waiting for a client, connect once to release it
+    if(this->listening_.exchange(false)){
+        HANDLE client = CreateFile(this->pipe_name_.c_str(),GENERIC_READ | GENERIC_WRITE,0,NULL,OPEN_EXISTING,0,NULL);
+        if(client != INVALID_HANDLE_VALUE) CloseHandle(client);
+    }
+    this->listener_.join();
+}
+
+bool ScanDaemon::WaitForJob(DaemonJob *job){
+    std::unique_lock<std::mutex> lock(this->mutex_);
+
+    this->job_queued_.wait(lock,[this]{ return this->stopping_ || !this->queue_.empty(); });
+    if(this->stopping_) return false;
+
+    DaemonJob &next = this->jobs_[this->queue_.front()];
+    this->queue_.pop_front();
+    next.state = DaemonJobState::RUNNING;
+    *job = next;
+
+    return true;
+}
+
+void ScanDaemon::FinishJob(const unsigned int &id, const unsigned int &views_saved, const int &exit_code){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    std::map<unsigned int,DaemonJob>::iterator job = this->jobs_.find(id);
+    if(job == this->jobs_.end()) return;
+
+    job->second.views_saved = views_saved;
+    job->second.exit_code   = exit_code;
+    job->second.state       = (exit_code == BATCH_EXIT_SUCCESS) ? DaemonJobState::DONE : DaemonJobState::FAILED;
+
+    this->finished_.push_back(id);
+    while(this->finished_.size() > SCAN_DAEMON_FINISHED_JOBS_KEPT){
+        this->jobs_.erase(this->finished_.front());
+        this->finished_.pop_front();
+    }
+}
+
+std::string ScanDaemon::HandleRequest(const std::string &request){
+    std::istringstream tokens(request);
+    std::string command;
+    tokens >> command;
+
+    if(command == "SCAN"){
+        DaemonJob job;
+        job.scan        = this->defaults_;
+        job.state       = DaemonJobState::QUEUED;
+        job.views_saved = 0;
+        job.exit_code   = BATCH_EXIT_SUCCESS;
+
+        std::string operation, views, turn_time;
+        tokens >> operation >> views;
+        if(operation.empty() || views.empty())                      return "ERROR MISSING_ARGUMENT";
+        if(SetBatchOperation(operation,&job.scan).hasErrors())      return "ERROR " BATCH_JOB_OPERATION_INVALID;
+
+        job.scan.views = std::strtoul(views.c_str(),NULL,10);
+        if(job.scan.views == 0)                                     return "ERROR " BATCH_JOB_VIEWS_INVALID;
+
+        if(tokens >> turn_time) job.scan.turn_time_ms = std::strtoul(turn_time.c_str(),NULL,10);
+        if(tokens >> job.scan.output_directory) AppendDirectorySeparator(&job.scan.output_directory);
+
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if(this->stopping_) return "ERROR STOPPING";
+
+        job.id = this->next_id_++;
+        this->jobs_[job.id] = job;
+        this->queue_.push_back(job.id);
+        this->job_queued_.notify_one();
+
+        return "QUEUED " + std::to_string(job.id);
+    }
+    else if(command == "STATUS"){
+        unsigned int id = 0;
+        if(!(tokens >> id)) return "ERROR MISSING_ARGUMENT";
+
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        std::map<unsigned int,DaemonJob>::const_iterator job = this->jobs_.find(id);
+        if(job == this->jobs_.end()) return "ERROR UNKNOWN_JOB";
+
+        const std::string job_id = std::to_string(id);
+        switch(job->second.state){
+        case DaemonJobState::QUEUED:
+            return "QUEUED " + job_id;
+        case DaemonJobState::RUNNING:
+            return "RUNNING " + job_id;
+        case DaemonJobState::DONE:
+            return "DONE " + job_id + " " + std::to_string(job->second.views_saved) + "/" + std::to_string(job->second.scan.views);
+        case DaemonJobState::FAILED:
+        default:
+            return "FAILED " + job_id + " " + std::to_string(job->second.exit_code);
+        }
+    }
+    else if(command == "QUIT"){
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->stopping_ = true;
+        }
+        this->job_queued_.notify_all();
+        return "OK";
+    }
+
+    return "ERROR UNKNOWN_COMMAND";
+}
+
+void ScanDaemon::Listen(){
+    while(this->listening_.load()){
+        HANDLE pipe = CreateNamedPipeA(this->pipe_name_.c_str(),
+                                       PIPE_ACCESS_DUPLEX,
+                                       PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+                                       1,
+                                       SCAN_DAEMON_MAXIMUM_REQUEST,
+                                       SCAN_DAEMON_MAXIMUM_REQUEST,
+                                       0,
+                                       NULL);
+        if(pipe == INVALID_HANDLE_VALUE){
+            dlp::Time::Sleep::Milliseconds(100);
+            continue;
+        }
+
+        bool connected = ConnectNamedPipe(pipe,NULL) || (GetLastError() == ERROR_PIPE_CONNECTED);
+
+        if(connected && this->listening_.load()){
+            char  request[SCAN_DAEMON_MAXIMUM_REQUEST];
+            DWORD request_size = 0;
+
+            if(ReadFile(pipe,request,sizeof(request),&request_size,NULL) && (request_size > 0)){
+                std::string response = this->HandleRequest(std::string(request,request_size)) + "\n";
+                DWORD written = 0;
+                WriteFile(pipe,response.c_str(),(DWORD)response.size(),&written,NULL);
+                FlushFileBuffers(pipe);
+
+                // A QUIT request ends the listener as well
+                if(response == "OK\n") this->listening_.store(false);
+            }
+        }
+
+        DisconnectNamedPipe(pipe);
+        CloseHandle(pipe);
+    }
+}
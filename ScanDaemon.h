@@ -0,0 +1,79 @@
+/** @file       ScanDaemon.h
+ *  @brief      Scan job queue served over a local named pipe
+ */
+#ifndef __SCAN_DAEMON_H_
+#define __SCAN_DAEMON_H_
+
+#include <winsock2.h>
+#include <Windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+#include "BatchJob.h"
+
+#define SCAN_DAEMON_ALREADY_STARTED         "SCAN_DAEMON_ALREADY_STARTED"
+
+#define SCAN_DAEMON_DEFAULT_PIPE            "\\\\.\\pipe\\dlp_lcr4500_scanner"
+#define SCAN_DAEMON_MAXIMUM_REQUEST         1024
+
+// Finished jobs whose status can still be queried
+#define SCAN_DAEMON_FINISHED_JOBS_KEPT      256
+
+enum class DaemonJobState{
+    QUEUED,
+    RUNNING,
+    DONE,
+    FAILED
+};
+
+struct DaemonJob{
+    unsigned int    id;
+    BatchScanJob    scan;
+    DaemonJobState  state;
+    unsigned int    views_saved;
+    int             exit_code;
+};
+
+// Accepts one request line per pipe connection and answers with one line:
+//   SCAN <operation> <views> [turn_ms] [output_directory]  ->  QUEUED <id>
+//   STATUS <id>  ->  QUEUED <id> | RUNNING <id> | DONE <id> <saved>/<views> | FAILED <id> <exit_code>
+//   QUIT         ->  OK, no further jobs are started
+// Malformed requests are answered with ERROR <reason>. Jobs run one at a time
+// in request order on the thread calling WaitForJob, which owns the devices.
+class ScanDaemon{
+public:
+    ScanDaemon();
+    ~ScanDaemon();
+
+    dlp::ReturnCode Start(const std::string &pipe_name, const BatchScanJob &defaults);
+    void Stop();
+
+    // Blocks until a job is queued, false once the daemon is stopping
+    bool WaitForJob(DaemonJob *job);
+    void FinishJob(const unsigned int &id, const unsigned int &views_saved, const int &exit_code);
+
+    std::string HandleRequest(const std::string &request);
+
+private:
+    void Listen();
+
+    std::mutex                          mutex_;
+    std::condition_variable             job_queued_;
+    std::deque<unsigned int>            queue_;
+    std::deque<unsigned int>            finished_;
+    std::map<unsigned int,DaemonJob>    jobs_;
+    unsigned int                        next_id_;
+    bool                                stopping_;
+    BatchScanJob                        defaults_;
+
+    std::atomic_bool                    listening_;
+    std::thread                         listener_;
+    std::string                         pipe_name_;
+};
+
+#endif
@@ -0,0 +1,178 @@
+/** @file       ScanMask.cpp
+ *  @brief      Contrast based validity mask and sparse scan region of camera pixels
+ */
+#include "ScanMask.h"
+#include "FrameAcquisition.h"
+
+ScanRegion::ScanRegion(){
+    this->columns_     = 0;
+    this->rows_        = 0;
+    this->pixel_count_ = 0;
+}
+
+void ScanRegion::Build(const BitPlane &mask){
+    this->columns_     = mask.GetColumns();
+    this->rows_        = mask.GetRows();
+    this->pixel_count_ = 0;
+    this->runs_.clear();
+    this->row_first_run_.assign(this->rows_ + 1,0);
+
+    const unsigned int used_words = (this->columns_ + BIT_PLANE_WORD_BITS - 1) / BIT_PLANE_WORD_BITS;
+
+    for(unsigned int y = 0; y < this->rows_; y++){
+        const unsigned long long *row = mask.GetRow(y);
+        bool     in_run = false;
+        PixelRun run;
+        run.row = y;
+
+        this->row_first_run_[y] = (unsigned int) this->runs_.size();
+
+        for(unsigned int w = 0; w < used_words; w++){
+            const unsigned long long word = row[w];
+
+            // Whole words of background or foreground are the common case
+            if((word == 0) && !in_run) continue;
+            if((word == ~0ULL) && in_run) continue;
+
+            for(unsigned int i = 0; i < BIT_PLANE_WORD_BITS; i++){
+                const bool bit = ((word >> i) & 1) != 0;
+                if(bit == in_run) continue;
+
+                const unsigned int x = w * BIT_PLANE_WORD_BITS + i;
+                if(bit){
+                    run.column_begin = x;
+                }
+                else{
+                    run.column_end = x;
+                    this->runs_.push_back(run);
+                    this->pixel_count_ += run.column_end - run.column_begin;
+                }
+                in_run = bit;
+            }
+        }
+
+        // Padding bits are zero so a run can only reach the last column
+        if(in_run){
+            run.column_end = this->columns_;
+            this->runs_.push_back(run);
+            this->pixel_count_ += run.column_end - run.column_begin;
+        }
+    }
+
+    this->row_first_run_[this->rows_] = (unsigned int) this->runs_.size();
+}
+
+void ScanRegion::Clear(){
+    this->columns_     = 0;
+    this->rows_        = 0;
+    this->pixel_count_ = 0;
+    std::vector<PixelRun>().swap(this->runs_);
+    std::vector<unsigned int>().swap(this->row_first_run_);
+}
+
+unsigned int ScanRegion::GetColumns() const{
+    return this->columns_;
+}
+
+unsigned int ScanRegion::GetRows() const{
+    return this->rows_;
+}
+
+unsigned long long ScanRegion::GetPixelCount() const{
+    return this->pixel_count_;
+}
+
+double ScanRegion::GetCoverage() const{
+    const double total = (double) this->columns_ * this->rows_;
+    return (total > 0) ? (this->pixel_count_ / total) : 0;
+}
+
+const std::vector<PixelRun>& ScanRegion::GetRuns() const{
+    return this->runs_;
+}
+
+unsigned int ScanRegion::GetFirstRun(const unsigned int &row) const{
+    return this->row_first_run_[row];
+}
+
+unsigned int ScanRegion::GetRunEnd(const unsigned int &row) const{
+    return this->row_first_run_[row + 1];
+}
+
+void ScanRegion::GetRowSpan(const unsigned int &row, unsigned int *column_begin, unsigned int *column_end) const{
+    const unsigned int first = this->row_first_run_[row];
+    const unsigned int end   = this->row_first_run_[row + 1];
+
+    if(first == end){
+        (*column_begin) = 0;
+        (*column_end)   = 0;
+    }
+    else{
+        (*column_begin) = this->runs_[first].column_begin;
+        (*column_end)   = this->runs_[end - 1].column_end;
+    }
+}
+
+dlp::ReturnCode ComputeContrastMask(dlp::Image          *white,
+                                    dlp::Image          *black,
+                                    const unsigned char &contrast_threshold,
+                                    BitPlane            *mask){
+    dlp::ReturnCode ret;
+
+    if(!white || !black || !mask)           return ret.AddError(SCAN_MASK_NULL_POINTER);
+    if(white->isEmpty() || black->isEmpty()) return ret.AddError(SCAN_MASK_IMAGE_EMPTY);
+
+    unsigned int columns, rows;
+    unsigned int black_columns, black_rows;
+    white->GetColumns(&columns);
+    white->GetRows(&rows);
+    black->GetColumns(&black_columns);
+    black->GetRows(&black_rows);
+    if((columns != black_columns) || (rows != black_rows)) return ret.AddError(SCAN_MASK_RESOLUTION_MISMATCH);
+
+    ConvertToMonochromeWithSum(white,NULL);
+    ConvertToMonochromeWithSum(black,NULL);
+
+    cv::Mat white_data;
+    cv::Mat black_data;
+    white->Unsafe_GetOpenCVData(&white_data);
+    black->Unsafe_GetOpenCVData(&black_data);
+
+    // Valid where white is brighter than black by more than the threshold
+    mask->Create(columns,rows,true);
+    for(unsigned int y = 0; y < rows; y++){
+        unsigned long long *valid = mask->GetRow(y);
+        ThresholdRowToBits(white_data.ptr<unsigned char>(y),
+                           black_data.ptr<unsigned char>(y),
+                           columns,
+                           contrast_threshold,
+                           valid,
+                           valid);
+    }
+
+    return ret;
+}
+
+dlp::ReturnCode ApplyScanRegion(const ScanRegion &region, dlp::DisparityMap *disparity_map){
+    dlp::ReturnCode ret;
+
+    if(!disparity_map) return ret.AddError(SCAN_MASK_NULL_POINTER);
+
+    unsigned int columns, rows;
+    disparity_map->GetColumns(&columns);
+    disparity_map->GetRows(&rows);
+    if((columns != region.GetColumns()) || (rows != region.GetRows())) return ret.AddError(SCAN_MASK_RESOLUTION_MISMATCH);
+
+    // Invalidate the gaps between the runs of each row
+    for(unsigned int y = 0; y < rows; y++){
+        unsigned int x = 0;
+        for(unsigned int iRun = region.GetFirstRun(y); iRun < region.GetRunEnd(y); iRun++){
+            const PixelRun &run = region.GetRuns()[iRun];
+            for(; x < run.column_begin; x++) disparity_map->SetPixel(x,y,dlp::DisparityMap::INVALID_PIXEL);
+            x = run.column_end;
+        }
+        for(; x < columns; x++) disparity_map->SetPixel(x,y,dlp::DisparityMap::INVALID_PIXEL);
+    }
+
+    return ret;
+}
@@ -0,0 +1,63 @@
+/** @file       ScanMask.h
+ *  @brief      Contrast based validity mask and sparse scan region of camera pixels
+ */
+#ifndef __SCAN_MASK_H_
+#define __SCAN_MASK_H_
+
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+#include "BitPlane.h"
+
+#define SCAN_MASK_NULL_POINTER          "SCAN_MASK_NULL_POINTER"
+#define SCAN_MASK_IMAGE_EMPTY           "SCAN_MASK_IMAGE_EMPTY"
+#define SCAN_MASK_RESOLUTION_MISMATCH   "SCAN_MASK_RESOLUTION_MISMATCH"
+
+// Horizontal run of valid pixels, column_end is exclusive
+struct PixelRun{
+    unsigned int row;
+    unsigned int column_begin;
+    unsigned int column_end;
+};
+
+// Run-length encoded region of the valid pixels in a mask. Decode,
+// thresholding, and disparity masking iterate over the runs (or the per row
+// span of the runs) so background and shadow pixels are never touched.
+class ScanRegion{
+public:
+    ScanRegion();
+
+    void Build(const BitPlane &mask);
+    void Clear();
+
+    unsigned int GetColumns() const;
+    unsigned int GetRows() const;
+    unsigned long long GetPixelCount() const;
+    double GetCoverage() const;     // Fraction of the image inside the region
+
+    const std::vector<PixelRun>& GetRuns() const;
+
+    // Runs of one row are runs_[first_run(row) .. first_run(row+1))
+    unsigned int GetFirstRun(const unsigned int &row) const;
+    unsigned int GetRunEnd(const unsigned int &row) const;
+
+    // First and one past the last valid column of a row, both 0 if the row is empty
+    void GetRowSpan(const unsigned int &row, unsigned int *column_begin, unsigned int *column_end) const;
+
+private:
+    unsigned int columns_;
+    unsigned int rows_;
+    unsigned long long pixel_count_;
+    std::vector<PixelRun>     runs_;
+    std::vector<unsigned int> row_first_run_;   // rows_ + 1 entries
+};
+
+// Marks pixels valid where white - black > contrast_threshold
+dlp::ReturnCode ComputeContrastMask(dlp::Image          *white,
+                                    dlp::Image          *black,
+                                    const unsigned char &contrast_threshold,
+                                    BitPlane            *mask);
+
+// Sets every pixel of the disparity map outside of the region to INVALID_PIXEL
+dlp::ReturnCode ApplyScanRegion(const ScanRegion &region, dlp::DisparityMap *disparity_map);
+
+#endif
@@ -0,0 +1,124 @@
+/** @file       ScanParameters.h
+ *  @brief      Scan options read from the application configuration file
+ */
+#ifndef __SCAN_PARAMETERS_H_
+#define __SCAN_PARAMETERS_H_
+
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+namespace ScanParameters{
+
+// Save the binarized 1 bpp captures of streaming Gray code scans instead of a
+// bitmap per captured frame
+DLP_NEW_PARAMETERS_ENTRY(PackedCaptureArchive,  "SCAN_PACKED_CAPTURE_ARCHIVE",  bool,   false);
+
+// White/black contrast below which pixels are masked as background or shadow
+// before triangulation, 0 disables the mask and values above 255 are clamped.
+// Streaming modules mask with their own reference patterns, others capture a
+// white and black frame first.
+DLP_NEW_PARAMETERS_ENTRY(ShadowMaskContrast,    "SCAN_SHADOW_MASK_CONTRAST",    unsigned int,   0);
+
+// Decode confidence (gray levels) below which pixels are dropped before the
+// point cloud is generated, 0 keeps every pixel. Only modules which rate
+// their pixels take part.
+DLP_NEW_PARAMETERS_ENTRY(MinimumConfidence,     "SCAN_MINIMUM_CONFIDENCE",      unsigned int,   0);
+
+// Save each point with its confidence as a fourth column (.xyzc)
+DLP_NEW_PARAMETERS_ENTRY(SaveConfidence,        "SCAN_SAVE_CONFIDENCE",         bool,   false);
+
+// Also save each point cloud as binary PLY (.ply)
+DLP_NEW_PARAMETERS_ENTRY(SavePly,               "SCAN_SAVE_PLY",                bool,   false);
+
+// Run the pattern sequence at the shortest period the LCr4500 allows for the
+// pattern bit depths with the projector triggering the camera. A period of 0
+// takes the shortest period, longer periods are used as is.
+DLP_NEW_PARAMETERS_ENTRY(HighSpeedMode,         "SCAN_HIGH_SPEED_MODE",         bool,   false);
+DLP_NEW_PARAMETERS_ENTRY(HighSpeedPeriod,       "SCAN_HIGH_SPEED_PERIOD_US",    unsigned int,   0);
+
+// Set when the projector was prepared with the high speed timing, cleared when
+// it fell back to the default timing. Not read from the configuration file.
+DLP_NEW_PARAMETERS_ENTRY(HighSpeedTiming,       "SCAN_HIGH_SPEED_TIMING",       bool,   false);
+
+// Generated pattern sequences are cached here by a hash of their settings,
+// along with the hash of the sequence last uploaded to the projector
+DLP_NEW_PARAMETERS_ENTRY(PatternCacheDirectory, "SCAN_PATTERN_CACHE_DIRECTORY", std::string,    "cache/");
+
+// Pack the LCr4500 firmware images on several threads and upload them before
+// the sequence is prepared, 0 threads uses every core
+DLP_NEW_PARAMETERS_ENTRY(ParallelFirmwarePacking, "SCAN_PARALLEL_FIRMWARE_PACKING", bool,       false);
+DLP_NEW_PARAMETERS_ENTRY(FirmwarePackingThreads,  "SCAN_FIRMWARE_PACKING_THREADS",  unsigned int, 0);
+
+// Without the hardware trigger, start the pattern sub-sequence once on the
+// projector's internal timing and match frames to patterns by timestamp
+// instead of displaying each pattern from the host
+DLP_NEW_PARAMETERS_ENTRY(BatchedPatternDisplay,   "SCAN_BATCHED_PATTERN_DISPLAY",   bool,       false);
+
+// With the hardware trigger, find the first pattern frame from the frame
+// timestamps and the time the sequence was started. The timestamps are host
+// retrieval times, so the offset is checked against the brightness step of
+// the first pattern and the step is used when they disagree.
+DLP_NEW_PARAMETERS_ENTRY(TimestampAlignment,      "SCAN_TIMESTAMP_ALIGNMENT",       bool,       false);
+
+// Patterns without a frame, or with more than the saturated percent of the
+// frame at full scale, are displayed and captured again on their own before
+// decoding. More missing patterns than the maximum discards the view. A
+// saturated percent of 0 accepts saturated frames, white references always.
+DLP_NEW_PARAMETERS_ENTRY(MaximumRecaptures,         "SCAN_MAXIMUM_RECAPTURES",          unsigned int, 8);
+DLP_NEW_PARAMETERS_ENTRY(RecaptureSaturatedPercent, "SCAN_RECAPTURE_SATURATED_PERCENT", unsigned int, 0);
+
+// Before each scan set the camera shutter, then gain, so that the brightest
+// part of the target under white is at the exposure target level
+DLP_NEW_PARAMETERS_ENTRY(AutoExposure,              "SCAN_AUTO_EXPOSURE",               bool,         false);
+DLP_NEW_PARAMETERS_ENTRY(AutoExposureTarget,        "SCAN_AUTO_EXPOSURE_TARGET",        unsigned int, 220);
+DLP_NEW_PARAMETERS_ENTRY(MaximumGain,               "SCAN_MAXIMUM_GAIN_DB",             float,        12.0);
+
+// Capture and decode the sequence again at this multiple of the exposure and
+// keep the more confident decode per pixel, 0 captures a single exposure
+DLP_NEW_PARAMETERS_ENTRY(DualExposureRatio,         "SCAN_DUAL_EXPOSURE_RATIO",         float,        0);
+
+// Scan without prompts, the target preview, or the point cloud viewer
+DLP_NEW_PARAMETERS_ENTRY(Headless,                  "SCAN_HEADLESS",                    bool,         false);
+
+// Point clouds and depth maps, and the captured pattern images
+DLP_NEW_PARAMETERS_ENTRY(DataDirectory,             "DIRECTORY_SCAN_DATA_OUTPUT",       std::string,  "output/scan_data/");
+DLP_NEW_PARAMETERS_ENTRY(ImagesDirectory,           "DIRECTORY_SCAN_IMAGES_OUTPUT",     std::string,  "output/scan_images/");
+
+// Shared memory name local consumers map the results from, empty disables it.
+// The segments are a ring so a consumer may fall behind by that many results.
+DLP_NEW_PARAMETERS_ENTRY(ResultChannelName,         "SCAN_RESULT_CHANNEL",              std::string,  "");
+DLP_NEW_PARAMETERS_ENTRY(ResultChannelSegments,     "SCAN_RESULT_CHANNEL_SEGMENTS",     unsigned int, 4);
+
+// Saves scan_trace.json (chrome://tracing) and scan_metrics.csv with the time
+// of each capture, drain, sort, decode, triangulate, save, and turntable stage
+DLP_NEW_PARAMETERS_ENTRY(TraceScan,                 "SCAN_TRACE",                       bool,         false);
+
+// Scan buffer bytes above which frames of non-streaming modules are spilled to
+// their saved files and loaded by the decoder, 0 is no budget. The report saves
+// scan_memory.csv with the peak bytes per stage and buffer type of each view.
+DLP_NEW_PARAMETERS_ENTRY(MemoryBudget,              "SCAN_MEMORY_BUDGET_MB",            unsigned int, 0);
+DLP_NEW_PARAMETERS_ENTRY(MemoryReport,              "SCAN_MEMORY_REPORT",               bool,         false);
+
+// Appends the captures, decoded maps, depth map, and point cloud of every view
+// to one scan_<date>_<time>.dlpa file per session in the data directory,
+// instead of saving them as separate image and XYZ files
+DLP_NEW_PARAMETERS_ENTRY(ArchiveScans,              "SCAN_ARCHIVE",                     bool,         false);
+DLP_NEW_PARAMETERS_ENTRY(ArchiveCompression,        "SCAN_ARCHIVE_COMPRESSION",         bool,         false);
+
+// File format of saved scan captures and calibration images, "bmp" or the
+// lossless "dlpf" frame codec, encoded on that many threads (0 is every core).
+// Spilled captures stay BMP since the decoders load them as image files.
+DLP_NEW_PARAMETERS_ENTRY(ImageFormat,               "SCAN_IMAGE_FORMAT",                std::string,  "bmp");
+DLP_NEW_PARAMETERS_ENTRY(ImageThreads,              "SCAN_IMAGE_THREADS",               unsigned int, 2);
+
+// Saves scan_checkpoint.txt in the data directory after every view and turn
+// of a multi-view session, so a session stopped by a failure can resume at its
+// first unsaved view when the same job is started again. A checkpoint is only
+// offered to a job with the same data directory, settings, and view count.
+// Interactive runs ask before resuming, headless runs resume only when the job
+// sets SCAN_CHECKPOINT_RESUME (--resume or BATCH_RESUME).
+DLP_NEW_PARAMETERS_ENTRY(CheckpointScans,           "SCAN_CHECKPOINT",                  bool,         false);
+DLP_NEW_PARAMETERS_ENTRY(ResumeScans,               "SCAN_CHECKPOINT_RESUME",           bool,         false);
+
+}
+
+#endif
@@ -0,0 +1,167 @@
+/** @file       ScanSession.cpp
+ *  @brief      Calibration, geometry, and turntable port kept loaded across scans
+ */
+#include "ScanSession.h"
+
+ScanSession::ScanSession(){
+    this->camera_viewport_ = 0;
+    this->geometry_ready_  = false;
+    this->turntable_       = INVALID_HANDLE_VALUE;
+}
+
+ScanSession::~ScanSession(){
+    this->Clear();
+}
+
+dlp::ReturnCode ScanSession::PrepareGeometry(dlp::Camera        *camera,
+                                             dlp::DLP_Platform  *projector,
+                                             const std::string  &camera_calib_data_file,
+                                             const std::string  &projector_calib_data_file,
+                                             const std::string  &geometry_settings_file){
+    dlp::ReturnCode ret;
+
+    if(!camera || !projector) return ret.AddError(SCAN_SESSION_NULL_POINTER);
+
+    unsigned int camera_columns, camera_rows;
+    unsigned int projector_columns, projector_rows;
+    camera->GetColumns(&camera_columns);
+    camera->GetRows(&camera_rows);
+    projector->GetColumns(&projector_columns);
+    projector->GetRows(&projector_rows);
+
+    return this->PrepareGeometry(camera_columns,
+                                 camera_rows,
+                                 projector_columns,
+                                 projector_rows,
+                                 camera_calib_data_file,
+                                 projector_calib_data_file,
+                                 geometry_settings_file);
+}
+
+dlp::ReturnCode ScanSession::PrepareGeometry(const unsigned int &camera_columns,
+                                             const unsigned int &camera_rows,
+                                             const unsigned int &projector_columns,
+                                             const unsigned int &projector_rows,
+                                             const std::string  &camera_calib_data_file,
+                                             const std::string  &projector_calib_data_file,
+                                             const std::string  &geometry_settings_file){
+    dlp::ReturnCode ret;
+
+    const std::string key = camera_calib_data_file + "|" + projector_calib_data_file + "|" + geometry_settings_file;
+    if(this->geometry_ready_ && (key == this->geometry_key_)) return ret;
+
+    this->geometry_.Clear();
+    this->geometry_ready_ = false;
+
+    // Check that calibrations are complete
+    dlp::Calibration::Data calibration_data_camera;
+    dlp::Calibration::Data calibration_data_projector;
+    calibration_data_camera.Load(camera_calib_data_file);
+    calibration_data_projector.Load(projector_calib_data_file);
+
+    if(!calibration_data_camera.isComplete())   return ret.AddError(SCAN_SESSION_CAMERA_CALIBRATION_INCOMPLETE);
+    if(!calibration_data_camera.isCamera())     return ret.AddError(SCAN_SESSION_CAMERA_CALIBRATION_NOT_CAMERA);
+    if(!calibration_data_projector.isComplete()) return ret.AddError(SCAN_SESSION_PROJECTOR_CALIBRATION_INCOMPLETE);
+    if(calibration_data_projector.isCamera())   return ret.AddError(SCAN_SESSION_PROJECTOR_CALIBRATION_NOT_PROJECTOR);
+
+    // Check that the device resolutions match the calibration data resolutions
+    unsigned int calibration_columns, calibration_rows;
+
+    calibration_data_camera.GetModelResolution(&calibration_columns,&calibration_rows);
+    if((calibration_columns != camera_columns) || (calibration_rows != camera_rows)) return ret.AddError(SCAN_SESSION_CAMERA_RESOLUTION_MISMATCH);
+
+    calibration_data_projector.GetModelResolution(&calibration_columns,&calibration_rows);
+    if((calibration_columns != projector_columns) || (calibration_rows != projector_rows)) return ret.AddError(SCAN_SESSION_PROJECTOR_RESOLUTION_MISMATCH);
+
+    // Construct the camera and projector geometry
+    dlp::Parameters geometry_settings;
+    geometry_settings.Load(geometry_settings_file);
+    this->geometry_.Setup(geometry_settings);
+    this->geometry_.SetDebugEnable(false);
+    this->geometry_.SetOriginView(calibration_data_projector);
+    this->geometry_.AddView(calibration_data_camera,&this->camera_viewport_);
+
+    this->geometry_key_   = key;
+    this->geometry_ready_ = true;
+
+    return ret;
+}
+
+dlp::Geometry& ScanSession::GetGeometry(){
+    return this->geometry_;
+}
+
+unsigned int ScanSession::GetCameraViewport() const{
+    return this->camera_viewport_;
+}
+
+dlp::ReturnCode ScanSession::OpenTurntable(const std::string &port, const unsigned int &turn_time_ms, HANDLE *turntable){
+    dlp::ReturnCode ret;
+
+    if(!turntable) return ret.AddError(SCAN_SESSION_NULL_POINTER);
+
+    if((this->turntable_ == INVALID_HANDLE_VALUE) || (port != this->turntable_port_)){
+        if(this->turntable_ != INVALID_HANDLE_VALUE) CloseHandle(this->turntable_);
+
+        this->turntable_      = CreateFile(port.c_str(),GENERIC_READ | GENERIC_WRITE,0,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+        this->turntable_port_ = port;
+        *turntable            = this->turntable_;
+        if(this->turntable_ == INVALID_HANDLE_VALUE) return ret.AddError(SCAN_SESSION_TURNTABLE_OPEN_FAILED);
+
+        SetupComm(this->turntable_,1024,1024);
+        DCB dcb;
+        GetCommState(this->turntable_,&dcb);
+        dcb.BaudRate = 4800;
+        dcb.ByteSize = 8;
+        dcb.Parity   = 0;
+        dcb.StopBits = 1;
+        if(!SetCommState(this->turntable_,&dcb)) return ret.AddError(SCAN_SESSION_TURNTABLE_SETUP_FAILED);
+    }
+    *turntable = this->turntable_;
+
+    // Set on every call as the turn time changes between jobs
+    COMMTIMEOUTS timeouts;
+    timeouts.ReadIntervalTimeout         = 0;
+    timeouts.ReadTotalTimeoutMultiplier  = 0;
+    timeouts.ReadTotalTimeoutConstant    = turn_time_ms + SCAN_SESSION_TURNTABLE_REPLY_MS;
+    timeouts.WriteTotalTimeoutMultiplier = 0;
+    timeouts.WriteTotalTimeoutConstant   = SCAN_SESSION_TURNTABLE_REPLY_MS;
+    if(!SetCommTimeouts(this->turntable_,&timeouts)) return ret.AddError(SCAN_SESSION_TURNTABLE_SETUP_FAILED);
+
+    return ret;
+}
+
+dlp::ReturnCode ScanSession::OpenResultChannel(const std::string  &name,
+                                               const unsigned int &segment_count,
+                                               const unsigned int &columns,
+                                               const unsigned int &rows,
+                                               ResultChannel     **channel){
+    dlp::ReturnCode ret;
+
+    if(!channel) return ret.AddError(SCAN_SESSION_NULL_POINTER);
+    *channel = NULL;
+
+    if(!this->result_channel_.isOpen() ||
+       (this->result_channel_.GetName()         != name)          ||
+       (this->result_channel_.GetSegmentCount() != segment_count) ||
+       (this->result_channel_.GetColumns()      != columns)       ||
+       (this->result_channel_.GetRows()         != rows)){
+        ret = this->result_channel_.Create(name,segment_count,columns,rows);
+        if(ret.hasErrors()) return ret;
+    }
+
+    *channel = &this->result_channel_;
+    return ret;
+}
+
+void ScanSession::Clear(){
+    this->geometry_.Clear();
+    this->geometry_ready_ = false;
+    this->geometry_key_.clear();
+
+    if(this->turntable_ != INVALID_HANDLE_VALUE) CloseHandle(this->turntable_);
+    this->turntable_ = INVALID_HANDLE_VALUE;
+    this->turntable_port_.clear();
+
+    this->result_channel_.Close();
+}
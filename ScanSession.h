@@ -0,0 +1,80 @@
+/** @file       ScanSession.h
+ *  @brief      Calibration, geometry, and turntable port kept loaded across scans
+ */
+#ifndef __SCAN_SESSION_H_
+#define __SCAN_SESSION_H_
+
+#include <winsock2.h>
+#include <Windows.h>
+#include <string>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+#include "ResultChannel.h"
+
+#define SCAN_SESSION_NULL_POINTER                       "SCAN_SESSION_NULL_POINTER"
+#define SCAN_SESSION_CAMERA_CALIBRATION_INCOMPLETE      "SCAN_SESSION_CAMERA_CALIBRATION_INCOMPLETE"
+#define SCAN_SESSION_CAMERA_CALIBRATION_NOT_CAMERA      "SCAN_SESSION_CAMERA_CALIBRATION_NOT_CAMERA"
+#define SCAN_SESSION_PROJECTOR_CALIBRATION_INCOMPLETE   "SCAN_SESSION_PROJECTOR_CALIBRATION_INCOMPLETE"
+#define SCAN_SESSION_PROJECTOR_CALIBRATION_NOT_PROJECTOR "SCAN_SESSION_PROJECTOR_CALIBRATION_NOT_PROJECTOR"
+#define SCAN_SESSION_CAMERA_RESOLUTION_MISMATCH         "SCAN_SESSION_CAMERA_RESOLUTION_MISMATCH"
+#define SCAN_SESSION_PROJECTOR_RESOLUTION_MISMATCH      "SCAN_SESSION_PROJECTOR_RESOLUTION_MISMATCH"
+#define SCAN_SESSION_TURNTABLE_OPEN_FAILED              "SCAN_SESSION_TURNTABLE_OPEN_FAILED"
+#define SCAN_SESSION_TURNTABLE_SETUP_FAILED             "SCAN_SESSION_TURNTABLE_SETUP_FAILED"
+
+#define SCAN_SESSION_TURNTABLE_REPLY_MS                 2000    // Added to the turn time for the reply
+
+// State ScanObject builds before its first scan. A session owned by the
+// caller keeps the geometry and the turntable port between calls so only the
+// capture and reconstruction are repeated.
+class ScanSession{
+public:
+    ScanSession();
+    ~ScanSession();
+
+    // Loads and checks the calibration data and constructs the geometry,
+    // nothing is reloaded while the files are the same as the last call
+    dlp::ReturnCode PrepareGeometry(dlp::Camera        *camera,
+                                    dlp::DLP_Platform  *projector,
+                                    const std::string  &camera_calib_data_file,
+                                    const std::string  &projector_calib_data_file,
+                                    const std::string  &geometry_settings_file);
+
+    // Same without devices, for replaying recorded captures
+    dlp::ReturnCode PrepareGeometry(const unsigned int &camera_columns,
+                                    const unsigned int &camera_rows,
+                                    const unsigned int &projector_columns,
+                                    const unsigned int &projector_rows,
+                                    const std::string  &camera_calib_data_file,
+                                    const std::string  &projector_calib_data_file,
+                                    const std::string  &geometry_settings_file);
+
+    dlp::Geometry& GetGeometry();
+    unsigned int   GetCameraViewport() const;
+
+    // Opens the turntable serial port at 4800 8N1 on first use. Reads and
+    // writes give up after the turn time and a margin for the reply, so a
+    // turntable which never answers fails the turn instead of blocking.
+    dlp::ReturnCode OpenTurntable(const std::string &port, const unsigned int &turn_time_ms, HANDLE *turntable);
+
+    // Creates the shared memory result channel on first use so consumers
+    // keep their mapping across scans
+    dlp::ReturnCode OpenResultChannel(const std::string  &name,
+                                      const unsigned int &segment_count,
+                                      const unsigned int &columns,
+                                      const unsigned int &rows,
+                                      ResultChannel     **channel);
+
+    void Clear();
+
+private:
+    dlp::Geometry   geometry_;
+    unsigned int    camera_viewport_;
+    bool            geometry_ready_;
+    std::string     geometry_key_;
+
+    HANDLE          turntable_;
+    std::string     turntable_port_;
+
+    ResultChannel   result_channel_;
+};
+
+#endif
@@ -0,0 +1,138 @@
+/** @file       ScanTrace.cpp
+ *  @brief      Per-stage scan timing spans with Chrome trace and CSV export
+ */
+#include <fstream>
+#include "PatternTimeline.h"
+#include "ScanTrace.h"
+
+static const char* const COUNTER_NAMES[SCAN_TRACE_COUNTER_COUNT] = { "frames", "bytes", "points" };
+
+ScanTrace::ScanTrace(){
+    this->enabled_   = false;
+    this->view_      = 0;
+    this->origin_us_ = 0;
+}
+
+void ScanTrace::SetEnabled(const bool &enabled){
+    this->enabled_ = enabled;
+}
+
+bool ScanTrace::isEnabled() const{
+    return this->enabled_;
+}
+
+void ScanTrace::SetView(const unsigned int &view){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->view_ = view;
+}
+
+unsigned int ScanTrace::GetThreadIndex(){
+    // Called with the mutex held
+    std::map<std::thread::id,unsigned int>::iterator thread = this->threads_.find(std::this_thread::get_id());
+    if(thread != this->threads_.end()) return thread->second;
+
+    const unsigned int index = (unsigned int) this->threads_.size() + 1;
+    this->threads_[std::this_thread::get_id()] = index;
+    return index;
+}
+
+unsigned int ScanTrace::Begin(const std::string &name){
+    if(!this->enabled_) return SCAN_TRACE_NO_SPAN;
+
+    const unsigned long long now = GetTimestampMicroseconds();
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if(this->spans_.empty()) this->origin_us_ = now;
+
+    TraceSpan span;
+    span.name     = name;
+    span.view     = this->view_;
+    span.thread   = this->GetThreadIndex();
+    span.start_us = now;
+    span.end_us   = now;
+    for(unsigned int iCounter = 0; iCounter < SCAN_TRACE_COUNTER_COUNT; iCounter++) span.counters[iCounter] = 0;
+
+    this->spans_.push_back(span);
+    return (unsigned int) this->spans_.size() - 1;
+}
+
+void ScanTrace::End(const unsigned int &span){
+    if(span == SCAN_TRACE_NO_SPAN) return;
+
+    const unsigned long long now = GetTimestampMicroseconds();
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if(span < this->spans_.size()) this->spans_[span].end_us = now;
+}
+
+void ScanTrace::AddCounter(const unsigned int &span, const unsigned int &counter, const unsigned long long &value){
+    if((span == SCAN_TRACE_NO_SPAN) || (counter >= SCAN_TRACE_COUNTER_COUNT)) return;
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if(span < this->spans_.size()) this->spans_[span].counters[counter] += value;
+}
+
+unsigned int ScanTrace::GetSpanCount(){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return (unsigned int) this->spans_.size();
+}
+
+void ScanTrace::Clear(){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->spans_.clear();
+    this->threads_.clear();
+    this->origin_us_ = 0;
+}
+
+dlp::ReturnCode ScanTrace::SaveChromeTrace(const std::string &filename){
+    dlp::ReturnCode ret;
+
+    std::ofstream file(filename.c_str());
+    if(!file.is_open()) return ret.AddError(SCAN_TRACE_FILE_SAVE_FAILED);
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for(unsigned int iSpan = 0; iSpan < this->spans_.size(); iSpan++){
+        const TraceSpan &span = this->spans_[iSpan];
+        if(iSpan > 0) file << ",";
+        file << "\n{\"name\":\"" << span.name << "\",\"cat\":\"scan\",\"ph\":\"X\""
+             << ",\"ts\":"  << (span.start_us - this->origin_us_)
+             << ",\"dur\":" << (span.end_us - span.start_us)
+             << ",\"pid\":1,\"tid\":" << span.thread
+             << ",\"args\":{\"view\":" << span.view;
+        for(unsigned int iCounter = 0; iCounter < SCAN_TRACE_COUNTER_COUNT; iCounter++){
+            if(span.counters[iCounter] > 0) file << ",\"" << COUNTER_NAMES[iCounter] << "\":" << span.counters[iCounter];
+        }
+        file << "}}";
+    }
+    file << "\n]}\n";
+
+    if(file.fail()) ret.AddError(SCAN_TRACE_FILE_SAVE_FAILED);
+    return ret;
+}
+
+dlp::ReturnCode ScanTrace::SaveMetrics(const std::string &filename){
+    dlp::ReturnCode ret;
+
+    std::ofstream file(filename.c_str());
+    if(!file.is_open()) return ret.AddError(SCAN_TRACE_FILE_SAVE_FAILED);
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    file << "view,span,thread,start_ms,duration_ms";
+    for(unsigned int iCounter = 0; iCounter < SCAN_TRACE_COUNTER_COUNT; iCounter++) file << "," << COUNTER_NAMES[iCounter];
+    file << "\n";
+
+    for(unsigned int iSpan = 0; iSpan < this->spans_.size(); iSpan++){
+        const TraceSpan &span = this->spans_[iSpan];
+        file << span.view << "," << span.name << "," << span.thread << ","
+             << (span.start_us - this->origin_us_) / 1000.0 << ","
+             << (span.end_us - span.start_us) / 1000.0;
+        for(unsigned int iCounter = 0; iCounter < SCAN_TRACE_COUNTER_COUNT; iCounter++) file << "," << span.counters[iCounter];
+        file << "\n";
+    }
+
+    if(file.fail()) ret.AddError(SCAN_TRACE_FILE_SAVE_FAILED);
+    return ret;
+}
@@ -0,0 +1,70 @@
+/** @file       ScanTrace.h
+ *  @brief      Per-stage scan timing spans with Chrome trace and CSV export
+ */
+#ifndef __SCAN_TRACE_H_
+#define __SCAN_TRACE_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define SCAN_TRACE_FILE_SAVE_FAILED     "SCAN_TRACE_FILE_SAVE_FAILED"
+
+// Returned by Begin while tracing is disabled, End and AddCounter ignore it
+#define SCAN_TRACE_NO_SPAN              0xFFFFFFFF
+
+// Counters every span carries, shown as args in the trace and columns in the CSV
+#define SCAN_TRACE_COUNTER_FRAMES       0
+#define SCAN_TRACE_COUNTER_BYTES        1
+#define SCAN_TRACE_COUNTER_POINTS       2
+#define SCAN_TRACE_COUNTER_COUNT        3
+
+struct TraceSpan{
+    std::string         name;
+    unsigned int        view;
+    unsigned int        thread;
+    unsigned long long  start_us;
+    unsigned long long  end_us;
+    unsigned long long  counters[SCAN_TRACE_COUNTER_COUNT];
+};
+
+// Records named spans of the scan stages from any thread. Spans are timed
+// with GetTimestampMicroseconds and reported relative to the first span.
+class ScanTrace{
+public:
+    ScanTrace();
+
+    void SetEnabled(const bool &enabled);
+    bool isEnabled() const;
+
+    // View index added to every span begun after it
+    void SetView(const unsigned int &view);
+
+    unsigned int Begin(const std::string &name);
+    void End(const unsigned int &span);
+    void AddCounter(const unsigned int &span, const unsigned int &counter, const unsigned long long &value);
+
+    unsigned int GetSpanCount();
+    void Clear();
+
+    // Chrome trace event format, open with chrome://tracing or Perfetto
+    dlp::ReturnCode SaveChromeTrace(const std::string &filename);
+
+    // One row per span: view, span, thread, start, duration, and the counters
+    dlp::ReturnCode SaveMetrics(const std::string &filename);
+
+private:
+    unsigned int GetThreadIndex();
+
+    bool                                   enabled_;
+    unsigned int                           view_;
+    unsigned long long                     origin_us_;
+    std::vector<TraceSpan>                 spans_;
+    std::map<std::thread::id,unsigned int> threads_;
+    std::mutex                             mutex_;
+};
+
+#endif
@@ -0,0 +1,622 @@
+/** @file       SceneRenderer.cpp
+ *  @brief      Renders the camera frames a structured light scan would capture
+ */
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "SceneRenderer.h"
+
+static RenderVector MakeVector(const double &x, const double &y, const double &z){
+    RenderVector vector;
+    vector.x = x;
+    vector.y = y;
+    vector.z = z;
+    return vector;
+}
+
+static RenderVector Add(const RenderVector &a, const RenderVector &b){
+    return MakeVector(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+static RenderVector Subtract(const RenderVector &a, const RenderVector &b){
+    return MakeVector(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+static RenderVector Scale(const RenderVector &a, const double &scale){
+    return MakeVector(a.x * scale, a.y * scale, a.z * scale);
+}
+
+static double Dot(const RenderVector &a, const RenderVector &b){
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static RenderVector Cross(const RenderVector &a, const RenderVector &b){
+    return MakeVector(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static RenderVector Normalize(const RenderVector &a){
+    const double length = std::sqrt(Dot(a,a));
+    return (length > 0) ? Scale(a, 1.0 / length) : a;
+}
+
+// Row major 3x3 times vector, or the transpose times vector
+static RenderVector Rotate(const double rotation[9], const RenderVector &a, const bool &transpose){
+    if(transpose){
+        return MakeVector(rotation[0] * a.x + rotation[3] * a.y + rotation[6] * a.z,
+                          rotation[1] * a.x + rotation[4] * a.y + rotation[7] * a.z,
+                          rotation[2] * a.x + rotation[5] * a.y + rotation[8] * a.z);
+    }
+    return MakeVector(rotation[0] * a.x + rotation[1] * a.y + rotation[2] * a.z,
+                      rotation[3] * a.x + rotation[4] * a.y + rotation[5] * a.z,
+                      rotation[6] * a.x + rotation[7] * a.y + rotation[8] * a.z);
+}
+
+/******************************************************************************
+ *  Surfaces
+ *****************************************************************************/
+
+PlaneSurface::PlaneSurface(const RenderVector &point, const RenderVector &normal){
+    this->point_  = point;
+    this->normal_ = Normalize(normal);
+}
+
+bool PlaneSurface::Intersect(const RenderVector &origin, const RenderVector &direction, const double &minimum_distance,
+                             double *distance, RenderVector *normal) const{
+    const double facing = Dot(this->normal_, direction);
+    if(std::fabs(facing) < 1e-12) return false;
+
+    const double hit = Dot(this->normal_, Subtract(this->point_, origin)) / facing;
+    if(hit <= minimum_distance) return false;
+
+    *distance = hit;
+    *normal   = this->normal_;
+    return true;
+}
+
+SphereSurface::SphereSurface(const RenderVector &center, const double &radius){
+    this->center_ = center;
+    this->radius_ = radius;
+}
+
+bool SphereSurface::Intersect(const RenderVector &origin, const RenderVector &direction, const double &minimum_distance,
+                              double *distance, RenderVector *normal) const{
+    const RenderVector offset = Subtract(origin, this->center_);
+    const double b = Dot(offset, direction);
+    const double c = Dot(offset, offset) - this->radius_ * this->radius_;
+    const double discriminant = b * b - c;
+    if(discriminant < 0) return false;
+
+    const double root = std::sqrt(discriminant);
+    double hit = -b - root;
+    if(hit <= minimum_distance) hit = -b + root;
+    if(hit <= minimum_distance) return false;
+
+    *distance = hit;
+    *normal   = Normalize(Subtract(Add(origin, Scale(direction, hit)), this->center_));
+    return true;
+}
+
+dlp::ReturnCode MeshSurface::Load(const std::string &obj_file){
+    dlp::ReturnCode ret;
+
+    std::ifstream file(obj_file.c_str());
+    if(!file.is_open()) return ret.AddError(SCENE_RENDERER_MESH_LOAD_FAILED);
+
+    this->vertices_.clear();
+    this->triangles_.clear();
+
+    std::string line;
+    while(std::getline(file,line)){
+        std::istringstream tokens(line);
+        std::string type;
+        tokens >> type;
+
+        if(type == "v"){
+            RenderVector vertex;
+            if(tokens >> vertex.x >> vertex.y >> vertex.z) this->vertices_.push_back(vertex);
+        }
+        else if(type == "f"){
+            // Polygons are split into a fan of triangles, v/vt/vn keeps the v
+            std::vector<unsigned int> face;
+            std::string corner;
+            while(tokens >> corner){
+                const long index = std::strtol(corner.c_str(),NULL,10);
+                if(index > 0)      face.push_back((unsigned int)(index - 1));
+                else if(index < 0) face.push_back((unsigned int)(this->vertices_.size() + index));
+            }
+            for(unsigned int iCorner = 2; iCorner < face.size(); iCorner++){
+                this->triangles_.push_back(face[0]);
+                this->triangles_.push_back(face[iCorner - 1]);
+                this->triangles_.push_back(face[iCorner]);
+            }
+        }
+    }
+
+    for(unsigned int iIndex = 0; iIndex < this->triangles_.size(); iIndex++){
+        if(this->triangles_[iIndex] >= this->vertices_.size()){
+            this->triangles_.clear();
+            return ret.AddError(SCENE_RENDERER_MESH_LOAD_FAILED);
+        }
+    }
+    if(this->triangles_.empty()) return ret.AddError(SCENE_RENDERER_MESH_LOAD_FAILED);
+
+    this->minimum_ = this->vertices_.front();
+    this->maximum_ = this->vertices_.front();
+    for(unsigned int iVertex = 1; iVertex < this->vertices_.size(); iVertex++){
+        const RenderVector &vertex = this->vertices_[iVertex];
+        this->minimum_ = MakeVector(std::fmin(this->minimum_.x, vertex.x), std::fmin(this->minimum_.y, vertex.y), std::fmin(this->minimum_.z, vertex.z));
+        this->maximum_ = MakeVector(std::fmax(this->maximum_.x, vertex.x), std::fmax(this->maximum_.y, vertex.y), std::fmax(this->maximum_.z, vertex.z));
+    }
+
+    return ret;
+}
+
+unsigned int MeshSurface::GetTriangleCount() const{
+    return (unsigned int)(this->triangles_.size() / 3);
+}
+
+bool MeshSurface::Intersect(const RenderVector &origin, const RenderVector &direction, const double &minimum_distance,
+                            double *distance, RenderVector *normal) const{
+    // Rays missing the bounding box skip the triangles
+    double enter = -1e300, leave = 1e300;
+    const double origins[3]    = {origin.x, origin.y, origin.z};
+    const double directions[3] = {direction.x, direction.y, direction.z};
+    const double minimums[3]   = {this->minimum_.x, this->minimum_.y, this->minimum_.z};
+    const double maximums[3]   = {this->maximum_.x, this->maximum_.y, this->maximum_.z};
+    for(unsigned int iAxis = 0; iAxis < 3; iAxis++){
+        if(std::fabs(directions[iAxis]) < 1e-12){
+            if((origins[iAxis] < minimums[iAxis]) || (origins[iAxis] > maximums[iAxis])) return false;
+            continue;
+        }
+        double near = (minimums[iAxis] - origins[iAxis]) / directions[iAxis];
+        double far  = (maximums[iAxis] - origins[iAxis]) / directions[iAxis];
+        if(near > far) std::swap(near,far);
+        if(near > enter) enter = near;
+        if(far  < leave) leave = far;
+    }
+    if((enter > leave) || (leave <= minimum_distance)) return false;
+
+    // Moller-Trumbore against every triangle, the nearest hit wins
+    bool   found   = false;
+    double nearest = 1e300;
+    for(unsigned int iTriangle = 0; iTriangle < this->triangles_.size(); iTriangle += 3){
+        const RenderVector &a = this->vertices_[this->triangles_[iTriangle]];
+        const RenderVector &b = this->vertices_[this->triangles_[iTriangle + 1]];
+        const RenderVector &c = this->vertices_[this->triangles_[iTriangle + 2]];
+
+        const RenderVector edge_1 = Subtract(b,a);
+        const RenderVector edge_2 = Subtract(c,a);
+        const RenderVector p      = Cross(direction, edge_2);
+        const double determinant  = Dot(edge_1, p);
+        if(std::fabs(determinant) < 1e-12) continue;
+
+        const RenderVector s = Subtract(origin, a);
+        const double u = Dot(s, p) / determinant;
+        if((u < 0) || (u > 1)) continue;
+
+        const RenderVector q = Cross(s, edge_1);
+        const double v = Dot(direction, q) / determinant;
+        if((v < 0) || (u + v > 1)) continue;
+
+        const double hit = Dot(edge_2, q) / determinant;
+        if((hit <= minimum_distance) || (hit >= nearest)) continue;
+
+        nearest = hit;
+        *normal = Normalize(Cross(edge_1, edge_2));
+        found   = true;
+    }
+
+    if(found) *distance = nearest;
+    return found;
+}
+
+/******************************************************************************
+ *  Renderer
+ *****************************************************************************/
+
+static dlp::ReturnCode LoadDevice(const dlp::Calibration::Data &calibration, RenderDevice *device){
+    dlp::ReturnCode ret;
+
+    cv::Mat intrinsic, extrinsic, distortion;
+    double  reprojection_error;
+    calibration.GetData(&intrinsic, &extrinsic, &distortion, &reprojection_error);
+    calibration.GetModelResolution(&device->columns, &device->rows);
+
+    if((intrinsic.rows != 3) || (intrinsic.cols != 3) ||
+       (extrinsic.rows != 2) || (extrinsic.cols != 3)) return ret.AddError(SCENE_RENDERER_CALIBRATION_INVALID);
+
+    device->fx = intrinsic.ptr<double>(0)[0];
+    device->cx = intrinsic.ptr<double>(0)[2];
+    device->fy = intrinsic.ptr<double>(1)[1];
+    device->cy = intrinsic.ptr<double>(1)[2];
+
+    // k1 k2 p1 p2 k3, missing terms are zero
+    const unsigned int terms = (unsigned int) distortion.total();
+    for(unsigned int iTerm = 0; iTerm < 5; iTerm++){
+        device->distortion[iTerm] = (iTerm < terms) ? distortion.ptr<double>(0)[iTerm] : 0;
+    }
+
+    // The extrinsic rows are the rotation vector and the translation
+    const double *rotation_vector = extrinsic.ptr<double>(0);
+    const double *translation     = extrinsic.ptr<double>(1);
+    for(unsigned int iAxis = 0; iAxis < 3; iAxis++) device->translation[iAxis] = translation[iAxis];
+
+    const double angle = std::sqrt(rotation_vector[0] * rotation_vector[0] +
+                                   rotation_vector[1] * rotation_vector[1] +
+                                   rotation_vector[2] * rotation_vector[2]);
+    double kx = 0, ky = 0, kz = 0;
+    if(angle > 1e-12){
+        kx = rotation_vector[0] / angle;
+        ky = rotation_vector[1] / angle;
+        kz = rotation_vector[2] / angle;
+    }
+    const double c = std::cos(angle), s = std::sin(angle), t = 1 - c;
+    device->rotation[0] = t * kx * kx + c;      device->rotation[1] = t * kx * ky - s * kz; device->rotation[2] = t * kx * kz + s * ky;
+    device->rotation[3] = t * kx * ky + s * kz; device->rotation[4] = t * ky * ky + c;      device->rotation[5] = t * ky * kz - s * kx;
+    device->rotation[6] = t * kx * kz - s * ky; device->rotation[7] = t * ky * kz + s * kx; device->rotation[8] = t * kz * kz + c;
+
+    return ret;
+}
+
+static void Distort(const RenderDevice &device, const double &x, const double &y, double *distorted_x, double *distorted_y){
+    const double k1 = device.distortion[0], k2 = device.distortion[1];
+    const double p1 = device.distortion[2], p2 = device.distortion[3];
+    const double k3 = device.distortion[4];
+    const double r2 = x * x + y * y;
+    const double radial = 1 + ((k3 * r2 + k2) * r2 + k1) * r2;
+    *distorted_x = x * radial + 2 * p1 * x * y + p2 * (r2 + 2 * x * x);
+    *distorted_y = y * radial + p1 * (r2 + 2 * y * y) + 2 * p2 * x * y;
+}
+
+// Iterative inverse of Distort, as cv::undistortPoints does it
+static void Undistort(const RenderDevice &device, const double &distorted_x, const double &distorted_y, double *x, double *y){
+    const double k1 = device.distortion[0], k2 = device.distortion[1];
+    const double p1 = device.distortion[2], p2 = device.distortion[3];
+    const double k3 = device.distortion[4];
+    *x = distorted_x;
+    *y = distorted_y;
+    for(unsigned int iIteration = 0; iIteration < 10; iIteration++){
+        const double r2 = (*x) * (*x) + (*y) * (*y);
+        const double inverse_radial = 1 / (1 + ((k3 * r2 + k2) * r2 + k1) * r2);
+        const double dx = 2 * p1 * (*x) * (*y) + p2 * (r2 + 2 * (*x) * (*x));
+        const double dy = p1 * (r2 + 2 * (*y) * (*y)) + 2 * p2 * (*x) * (*y);
+        *x = (distorted_x - dx) * inverse_radial;
+        *y = (distorted_y - dy) * inverse_radial;
+    }
+}
+
+static int GetBitCount(const dlp::Pattern::Bitdepth &bitdepth){
+    switch(bitdepth){
+    case dlp::Pattern::Bitdepth::MONO_1BPP: return 1;
+    case dlp::Pattern::Bitdepth::MONO_2BPP: return 2;
+    case dlp::Pattern::Bitdepth::MONO_3BPP: return 3;
+    case dlp::Pattern::Bitdepth::MONO_4BPP: return 4;
+    case dlp::Pattern::Bitdepth::MONO_5BPP: return 5;
+    case dlp::Pattern::Bitdepth::MONO_6BPP: return 6;
+    case dlp::Pattern::Bitdepth::MONO_7BPP: return 7;
+    case dlp::Pattern::Bitdepth::MONO_8BPP: return 8;
+    default:                                return 0;
+    }
+}
+
+static void GaussianBlurRows(const std::vector<float> &kernel, const unsigned int &columns, const unsigned int &rows,
+                             const bool &vertical, const std::vector<float> &source, std::vector<float> *destination){
+    const int radius = (int) kernel.size() / 2;
+    for(unsigned int y = 0; y < rows; y++){
+        for(unsigned int x = 0; x < columns; x++){
+            float sum = 0;
+            for(int iTap = -radius; iTap <= radius; iTap++){
+                // Edges are clamped
+                int xs = (int) x, ys = (int) y;
+                if(vertical) ys += iTap;
+                else         xs += iTap;
+                if(xs < 0) xs = 0;
+                if(ys < 0) ys = 0;
+                if(xs >= (int) columns) xs = columns - 1;
+                if(ys >= (int) rows)    ys = rows - 1;
+                sum += kernel[iTap + radius] * source[(unsigned long long) ys * columns + xs];
+            }
+            (*destination)[(unsigned long long) y * columns + x] = sum;
+        }
+    }
+}
+
+SceneRenderer::SceneRenderer(){
+    this->is_setup_    = false;
+    this->frame_count_ = 0;
+}
+
+dlp::ReturnCode SceneRenderer::Setup(const dlp::Parameters            &settings,
+                                     const dlp::Calibration::Data     &camera_calibration,
+                                     const dlp::Calibration::Data     &projector_calibration,
+                                     const RenderSurface              *surface){
+    dlp::ReturnCode ret;
+
+    this->is_setup_ = false;
+    if(!surface) return ret.AddError(SCENE_RENDERER_SURFACE_MISSING);
+
+    ret = LoadDevice(camera_calibration, &this->camera_);
+    if(ret.hasErrors()) return ret;
+    ret = LoadDevice(projector_calibration, &this->projector_);
+    if(ret.hasErrors()) return ret;
+
+    Parameters::CameraColumns   camera_columns;
+    Parameters::CameraRows      camera_rows;
+    Parameters::Albedo          albedo;
+    Parameters::ProjectorGain   projector_gain;
+    Parameters::AmbientLevel    ambient_level;
+    Parameters::BlurSigma       blur_sigma;
+    Parameters::ReadNoise       read_noise;
+    Parameters::ShotNoiseGain   shot_noise_gain;
+    Parameters::NoiseSeed       noise_seed;
+    settings.Get(&camera_columns);
+    settings.Get(&camera_rows);
+    settings.Get(&albedo);
+    settings.Get(&projector_gain);
+    settings.Get(&ambient_level);
+    settings.Get(&blur_sigma);
+    settings.Get(&read_noise);
+    settings.Get(&shot_noise_gain);
+    settings.Get(&noise_seed);
+
+    this->albedo_          = albedo.Get();
+    this->projector_gain_  = projector_gain.Get();
+    this->ambient_level_   = ambient_level.Get();
+    this->blur_sigma_      = blur_sigma.Get();
+    this->read_noise_      = read_noise.Get();
+    this->shot_noise_gain_ = shot_noise_gain.Get();
+    this->noise_seed_      = noise_seed.Get();
+    this->frame_count_     = 0;
+
+    // Render at another resolution with the same field of view
+    if((camera_columns.Get() > 0) && (camera_rows.Get() > 0)){
+        const double scale_x = (double) camera_columns.Get() / this->camera_.columns;
+        const double scale_y = (double) camera_rows.Get()    / this->camera_.rows;
+        this->camera_.fx *= scale_x;
+        this->camera_.cx  = (this->camera_.cx + 0.5) * scale_x - 0.5;
+        this->camera_.fy *= scale_y;
+        this->camera_.cy  = (this->camera_.cy + 0.5) * scale_y - 0.5;
+        this->camera_.columns = camera_columns.Get();
+        this->camera_.rows    = camera_rows.Get();
+    }
+
+    // Camera to projector: X_p = R_p * R_c' * (X_c - t_c) + t_p
+    const RenderVector camera_translation = MakeVector(this->camera_.translation[0], this->camera_.translation[1], this->camera_.translation[2]);
+    const RenderVector projector_translation = MakeVector(this->projector_.translation[0], this->projector_.translation[1], this->projector_.translation[2]);
+    const RenderVector camera_origin = Add(Rotate(this->projector_.rotation, Rotate(this->camera_.rotation, Scale(camera_translation, -1), true), false),
+                                           projector_translation);
+
+    const unsigned long long pixels = (unsigned long long) this->camera_.columns * this->camera_.rows;
+    this->projector_x_.assign(pixels, -1);
+    this->projector_y_.assign(pixels, -1);
+    this->shading_.assign(pixels, 0);
+    this->points_.assign(pixels, MakeVector(0,0,0));
+    this->hit_.assign(pixels, 0);
+
+    for(unsigned int y = 0; y < this->camera_.rows; y++){
+        for(unsigned int x = 0; x < this->camera_.columns; x++){
+            const unsigned long long pixel = (unsigned long long) y * this->camera_.columns + x;
+
+            double ray_x, ray_y;
+            Undistort(this->camera_, (x - this->camera_.cx) / this->camera_.fx, (y - this->camera_.cy) / this->camera_.fy, &ray_x, &ray_y);
+            const RenderVector direction = Normalize(Rotate(this->projector_.rotation,
+                                                            Rotate(this->camera_.rotation, MakeVector(ray_x, ray_y, 1), true), false));
+
+            double       distance;
+            RenderVector normal;
+            if(!surface->Intersect(camera_origin, direction, 0, &distance, &normal)) continue;
+
+            const RenderVector point = Add(camera_origin, Scale(direction, distance));
+            if(Dot(normal, direction) > 0) normal = Scale(normal, -1);
+
+            this->hit_[pixel]    = 1;
+            this->points_[pixel] = point;
+            if(point.z <= 0) continue;
+
+            // Points the projector cannot see get ambient light only
+            const double       point_distance = std::sqrt(Dot(point,point));
+            const RenderVector light          = Scale(point, 1.0 / point_distance);
+            double       blocker;
+            RenderVector blocker_normal;
+            if(surface->Intersect(MakeVector(0,0,0), light, 0, &blocker, &blocker_normal) &&
+               (blocker < point_distance * (1 - 1e-6) - 1e-3)) continue;
+
+            double projected_x, projected_y;
+            Distort(this->projector_, point.x / point.z, point.y / point.z, &projected_x, &projected_y);
+            projected_x = this->projector_.fx * projected_x + this->projector_.cx;
+            projected_y = this->projector_.fy * projected_y + this->projector_.cy;
+            if((projected_x < 0) || (projected_y < 0) ||
+               (projected_x > this->projector_.columns - 1) || (projected_y > this->projector_.rows - 1)) continue;
+
+            const double incidence = -Dot(normal, light);
+            if(incidence <= 0) continue;
+
+            this->projector_x_[pixel] = (float) projected_x;
+            this->projector_y_[pixel] = (float) projected_y;
+            this->shading_[pixel]     = (float)(this->albedo_ * this->projector_gain_ * incidence);
+        }
+    }
+
+    this->is_setup_ = true;
+    return ret;
+}
+
+unsigned int SceneRenderer::GetColumns() const{
+    return this->camera_.columns;
+}
+
+unsigned int SceneRenderer::GetRows() const{
+    return this->camera_.rows;
+}
+
+dlp::ReturnCode SceneRenderer::RenderPattern(const dlp::Pattern &pattern, dlp::Image *frame){
+    dlp::ReturnCode ret;
+
+    if(!frame)           return ret.AddError(SCENE_RENDERER_NULL_POINTER);
+    if(!this->is_setup_) return ret.AddError(SCENE_RENDERER_NOT_SETUP);
+
+    // Projector image as 8 bit monochrome
+    dlp::Image projected;
+    if(pattern.data_type == dlp::Pattern::DataType::IMAGE_DATA){
+        cv::Mat data;
+        pattern.image_data.GetOpenCVData(&data);
+        projected.Create(data);
+    }
+    else if(pattern.data_type == dlp::Pattern::DataType::IMAGE_FILE){
+        if(projected.Load(pattern.image_file).hasErrors()) return ret.AddError(SCENE_RENDERER_PATTERN_LOAD_FAILED);
+    }
+    else{
+        return ret.AddError(SCENE_RENDERER_PATTERN_TYPE_INVALID);
+    }
+
+    dlp::Image::Format format;
+    projected.GetDataFormat(&format);
+    if(format != dlp::Image::Format::MONO_UCHAR) projected.ConvertToMonochrome();
+
+    cv::Mat projected_data;
+    projected.Unsafe_GetOpenCVData(&projected_data);
+
+    unsigned int projected_columns, projected_rows;
+    projected.GetColumns(&projected_columns);
+    projected.GetRows(&projected_rows);
+    if((projected_columns != this->projector_.columns) || (projected_rows != this->projector_.rows)){
+        return ret.AddError(SCENE_RENDERER_CALIBRATION_INVALID);
+    }
+
+    // Patterns below 8 bits may hold their levels unscaled
+    float level_scale = 1;
+    const int bits = GetBitCount(pattern.bitdepth);
+    if((bits > 0) && (bits < 8)){
+        unsigned char maximum = 0;
+        for(unsigned int y = 0; y < projected_rows; y++){
+            const unsigned char *row = projected_data.ptr<unsigned char>(y);
+            for(unsigned int x = 0; x < projected_columns; x++) if(row[x] > maximum) maximum = row[x];
+        }
+        if(maximum <= (1 << bits) - 1) level_scale = 255.0f / ((1 << bits) - 1);
+    }
+
+    // Reflected projector light plus ambient light
+    const unsigned int columns = this->camera_.columns;
+    const unsigned int rows    = this->camera_.rows;
+    std::vector<float> radiance((unsigned long long) columns * rows, 0);
+    for(unsigned long long pixel = 0; pixel < radiance.size(); pixel++){
+        if(!this->hit_[pixel]) continue;
+
+        float value = this->albedo_ * this->ambient_level_;
+        if(this->shading_[pixel] > 0){
+            const float px = this->projector_x_[pixel];
+            const float py = this->projector_y_[pixel];
+            const unsigned int x0 = (unsigned int) px;
+            const unsigned int y0 = (unsigned int) py;
+            const unsigned int x1 = (x0 + 1 < projected_columns) ? x0 + 1 : x0;
+            const unsigned int y1 = (y0 + 1 < projected_rows)    ? y0 + 1 : y0;
+            const float fx = px - x0;
+            const float fy = py - y0;
+            const unsigned char *row_0 = projected_data.ptr<unsigned char>(y0);
+            const unsigned char *row_1 = projected_data.ptr<unsigned char>(y1);
+            const float level = (1 - fy) * ((1 - fx) * row_0[x0] + fx * row_0[x1]) +
+                                fy       * ((1 - fx) * row_1[x0] + fx * row_1[x1]);
+            value += this->shading_[pixel] * level * level_scale;
+        }
+        radiance[pixel] = value;
+    }
+
+    // Defocus as a separable Gaussian
+    if(this->blur_sigma_ > 0){
+        const int radius = (int) std::ceil(3 * this->blur_sigma_);
+        std::vector<float> kernel(2 * radius + 1);
+        float kernel_sum = 0;
+        for(int iTap = -radius; iTap <= radius; iTap++){
+            kernel[iTap + radius] = std::exp(-(iTap * iTap) / (2 * this->blur_sigma_ * this->blur_sigma_));
+            kernel_sum += kernel[iTap + radius];
+        }
+        for(unsigned int iTap = 0; iTap < kernel.size(); iTap++) kernel[iTap] /= kernel_sum;
+
+        std::vector<float> blurred(radiance.size());
+        GaussianBlurRows(kernel, columns, rows, false, radiance, &blurred);
+        GaussianBlurRows(kernel, columns, rows, true,  blurred, &radiance);
+    }
+
+    // Shot and read noise, every frame has its own repeatable seed
+    std::mt19937 generator(this->noise_seed_ + this->frame_count_++);
+    std::normal_distribution<float> normal(0, 1);
+
+    frame->Clear();
+    frame->Create(columns, rows, dlp::Image::Format::MONO_UCHAR);
+    cv::Mat frame_data;
+    frame->Unsafe_GetOpenCVData(&frame_data);
+
+    for(unsigned int y = 0; y < rows; y++){
+        unsigned char *row = frame_data.ptr<unsigned char>(y);
+        for(unsigned int x = 0; x < columns; x++){
+            float value = radiance[(unsigned long long) y * columns + x];
+            const float noise_variance = this->shot_noise_gain_ * value + this->read_noise_ * this->read_noise_;
+            if(noise_variance > 0) value += std::sqrt(noise_variance) * normal(generator);
+
+            if(value < 0)   value = 0;
+            if(value > 255) value = 255;
+            row[x] = (unsigned char)(value + 0.5f);
+        }
+    }
+
+    return ret;
+}
+
+dlp::ReturnCode SceneRenderer::RenderPatternSequence(const dlp::Pattern::Sequence &patterns,
+                                                     dlp::Capture::Sequence       *captures){
+    dlp::ReturnCode ret;
+
+    if(!captures)        return ret.AddError(SCENE_RENDERER_NULL_POINTER);
+    if(!this->is_setup_) return ret.AddError(SCENE_RENDERER_NOT_SETUP);
+
+    for(unsigned int iPattern = 0; iPattern < patterns.GetCount(); iPattern++){
+        dlp::Pattern pattern;
+        patterns.Get(iPattern, &pattern);
+
+        dlp::Capture capture;
+        capture.data_type  = dlp::Capture::DataType::IMAGE_DATA;
+        capture.pattern_id = iPattern;
+        ret = this->RenderPattern(pattern, &capture.image_data);
+        if(ret.hasErrors()) return ret;
+
+        captures->Add(capture);
+    }
+
+    return ret;
+}
+
+dlp::ReturnCode SceneRenderer::GetGroundTruth(dlp::Image *depth_map, dlp::Point::Cloud *point_cloud) const{
+    dlp::ReturnCode ret;
+
+    if(!depth_map || !point_cloud) return ret.AddError(SCENE_RENDERER_NULL_POINTER);
+    if(!this->is_setup_)           return ret.AddError(SCENE_RENDERER_NOT_SETUP);
+
+    depth_map->Clear();
+    depth_map->Create(this->camera_.columns, this->camera_.rows, dlp::Image::Format::MONO_FLOAT);
+    point_cloud->Clear();
+
+    cv::Mat depth_data;
+    depth_map->Unsafe_GetOpenCVData(&depth_data);
+
+    for(unsigned int y = 0; y < this->camera_.rows; y++){
+        float *row = depth_data.ptr<float>(y);
+        for(unsigned int x = 0; x < this->camera_.columns; x++){
+            const unsigned long long pixel = (unsigned long long) y * this->camera_.columns + x;
+            row[x] = 0;
+            if(!this->hit_[pixel]) continue;
+
+            const RenderVector &surface_point = this->points_[pixel];
+            row[x] = (float) surface_point.z;
+
+            dlp::Point point;
+            point.x = surface_point.x;
+            point.y = surface_point.y;
+            point.z = surface_point.z;
+            point_cloud->Add(point);
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,143 @@
+/** @file       SceneRenderer.h
+ *  @brief      Renders the camera frames a structured light scan would capture
+ */
+#ifndef __SCENE_RENDERER_H_
+#define __SCENE_RENDERER_H_
+
+#include <string>
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+
+#define SCENE_RENDERER_NULL_POINTER             "SCENE_RENDERER_NULL_POINTER"
+#define SCENE_RENDERER_NOT_SETUP                "SCENE_RENDERER_NOT_SETUP"
+#define SCENE_RENDERER_CALIBRATION_INVALID      "SCENE_RENDERER_CALIBRATION_INVALID"
+#define SCENE_RENDERER_SURFACE_MISSING          "SCENE_RENDERER_SURFACE_MISSING"
+#define SCENE_RENDERER_MESH_LOAD_FAILED         "SCENE_RENDERER_MESH_LOAD_FAILED"
+#define SCENE_RENDERER_PATTERN_TYPE_INVALID     "SCENE_RENDERER_PATTERN_TYPE_INVALID"
+#define SCENE_RENDERER_PATTERN_LOAD_FAILED      "SCENE_RENDERER_PATTERN_LOAD_FAILED"
+
+struct RenderVector{
+    double x;
+    double y;
+    double z;
+};
+
+// Surface in the coordinates of the geometry origin, the projector, which is
+// also the frame of the point clouds the scan produces
+class RenderSurface{
+public:
+    virtual ~RenderSurface(){}
+
+    // Nearest hit along the ray at a distance above minimum_distance
+    virtual bool Intersect(const RenderVector &origin,
+                           const RenderVector &direction,
+                           const double       &minimum_distance,
+                           double             *distance,
+                           RenderVector       *normal) const = 0;
+};
+
+class PlaneSurface : public RenderSurface{
+public:
+    PlaneSurface(const RenderVector &point, const RenderVector &normal);
+    bool Intersect(const RenderVector &origin, const RenderVector &direction, const double &minimum_distance,
+                   double *distance, RenderVector *normal) const;
+private:
+    RenderVector point_;
+    RenderVector normal_;
+};
+
+class SphereSurface : public RenderSurface{
+public:
+    SphereSurface(const RenderVector &center, const double &radius);
+    bool Intersect(const RenderVector &origin, const RenderVector &direction, const double &minimum_distance,
+                   double *distance, RenderVector *normal) const;
+private:
+    RenderVector center_;
+    double       radius_;
+};
+
+// Triangle mesh from the v and f lines of a Wavefront OBJ file
+class MeshSurface : public RenderSurface{
+public:
+    dlp::ReturnCode Load(const std::string &obj_file);
+    unsigned int GetTriangleCount() const;
+    bool Intersect(const RenderVector &origin, const RenderVector &direction, const double &minimum_distance,
+                   double *distance, RenderVector *normal) const;
+private:
+    std::vector<RenderVector> vertices_;
+    std::vector<unsigned int> triangles_;
+    RenderVector              minimum_;
+    RenderVector              maximum_;
+};
+
+// Pinhole model with OpenCV k1 k2 p1 p2 k3 distortion and the pose from the
+// calibration board to the device
+struct RenderDevice{
+    unsigned int columns;
+    unsigned int rows;
+    double       fx, fy, cx, cy;
+    double       distortion[5];
+    double       rotation[9];
+    double       translation[3];
+};
+
+// Ray casts every camera pixel once into the scene, then renders each
+// pattern by sampling the projector image where that pixel's surface point
+// projects, with Lambertian shading, ambient light, defocus blur, and shot
+// and read noise. The surface points give the ground truth of the scan.
+class SceneRenderer{
+public:
+    class Parameters{
+    public:
+        DLP_NEW_PARAMETERS_ENTRY(CameraColumns,     "RENDER_CAMERA_COLUMNS",    unsigned int,   0);
+        DLP_NEW_PARAMETERS_ENTRY(CameraRows,        "RENDER_CAMERA_ROWS",       unsigned int,   0);
+        DLP_NEW_PARAMETERS_ENTRY(Albedo,            "RENDER_ALBEDO",            float,          0.8);
+        DLP_NEW_PARAMETERS_ENTRY(ProjectorGain,     "RENDER_PROJECTOR_GAIN",    float,          1.0);
+        DLP_NEW_PARAMETERS_ENTRY(AmbientLevel,      "RENDER_AMBIENT_LEVEL",     float,          10.0);
+        DLP_NEW_PARAMETERS_ENTRY(BlurSigma,         "RENDER_BLUR_SIGMA",        float,          0.7);
+        DLP_NEW_PARAMETERS_ENTRY(ReadNoise,         "RENDER_READ_NOISE",        float,          1.5);
+        DLP_NEW_PARAMETERS_ENTRY(ShotNoiseGain,     "RENDER_SHOT_NOISE_GAIN",   float,          0.1);
+        DLP_NEW_PARAMETERS_ENTRY(NoiseSeed,         "RENDER_NOISE_SEED",        unsigned int,   1);
+    };
+
+    SceneRenderer();
+
+    // A camera resolution other than the calibrated one scales the intrinsics
+    dlp::ReturnCode Setup(const dlp::Parameters            &settings,
+                          const dlp::Calibration::Data     &camera_calibration,
+                          const dlp::Calibration::Data     &projector_calibration,
+                          const RenderSurface              *surface);
+
+    dlp::ReturnCode RenderPatternSequence(const dlp::Pattern::Sequence &patterns,
+                                          dlp::Capture::Sequence       *captures);
+    dlp::ReturnCode RenderPattern(const dlp::Pattern &pattern, dlp::Image *frame);
+
+    // Depth is z in the projector frame, 0 where the surface was not hit
+    dlp::ReturnCode GetGroundTruth(dlp::Image *depth_map, dlp::Point::Cloud *point_cloud) const;
+
+    unsigned int GetColumns() const;
+    unsigned int GetRows() const;
+
+private:
+    bool                        is_setup_;
+    RenderDevice                camera_;
+    RenderDevice                projector_;
+
+    float                       albedo_;
+    float                       projector_gain_;
+    float                       ambient_level_;
+    float                       blur_sigma_;
+    float                       read_noise_;
+    float                       shot_noise_gain_;
+    unsigned int                noise_seed_;
+    unsigned int                frame_count_;
+
+    // Per camera pixel: projector coordinate, shading, and surface point
+    std::vector<float>          projector_x_;
+    std::vector<float>          projector_y_;
+    std::vector<float>          shading_;
+    std::vector<RenderVector>   points_;
+    std::vector<unsigned char>  hit_;
+};
+
+#endif
@@ -0,0 +1,472 @@
+/** @file       StreamingGrayCode.cpp
+ *  @brief      Gray code structured light module that decodes captures as they arrive
+ */
+#include <cstring>
+#include <cstdlib>
+#include "StreamingGrayCode.h"
+#include "FrameAcquisition.h"
+
+// Number of white/black reference captures at the start of the sequence
+#define REFERENCE_CAPTURE_COUNT     2
+
+// Maximum bits which fit the per pixel code accumulator
+#define MAX_BIT_COUNT               16
+
+// Lowers the confidence to |a - b| << shift, saturated to 255
+static void UpdateConfidenceRow(const unsigned char *a,
+                                const unsigned char *b,
+                                const unsigned int  &count,
+                                const unsigned int  &shift,
+                                unsigned char       *confidence){
+    for(unsigned int x = 0; x < count; x++){
+        const unsigned int margin = (unsigned int)((a[x] > b[x]) ? (a[x] - b[x]) : (b[x] - a[x])) << shift;
+        if(margin < confidence[x]) confidence[x] = (unsigned char) margin;
+    }
+}
+
+// Creates a 1-bit pattern image. A negative bit creates a solid white image.
+static void CreatePatternImage(const unsigned int &columns,
+                               const unsigned int &rows,
+                               const bool         &vertical,
+                               const int          &bit,
+                               const unsigned int &bit_count,
+                               const bool         &inverted,
+                               dlp::Image         *image){
+
+    const unsigned int extent = vertical ? columns : rows;
+    std::vector<unsigned char> line(extent,255);
+
+    // Stripe index of each projector column (or row) and its Gray code bit
+    if(bit >= 0){
+        for(unsigned int i = 0; i < extent; i++){
+            const unsigned int stripe = (unsigned int)(((unsigned long long) i << bit_count) / extent);
+            const unsigned int gray   = stripe ^ (stripe >> 1);
+            line[i] = ((gray >> (bit_count - 1 - bit)) & 1) ? 255 : 0;
+        }
+    }
+
+    if(inverted){
+        for(unsigned int i = 0; i < extent; i++) line[i] = 255 - line[i];
+    }
+
+    cv::Mat data(rows,columns,CV_8UC1);
+    for(unsigned int y = 0; y < rows; y++){
+        if(vertical) memcpy(data.ptr<unsigned char>(y),&line[0],columns);
+        else         memset(data.ptr<unsigned char>(y),line[y],columns);
+    }
+
+    image->Create(data);
+}
+
+StreamingGrayCode::StreamingGrayCode(){
+    this->is_setup_             = false;
+    this->projector_set_        = false;
+    this->sequence_count_total_ = 0;
+    this->stripe_extent_        = 0;
+    this->decoding_             = false;
+    this->columns_              = 0;
+    this->rows_                 = 0;
+    this->captures_added_       = 0;
+}
+
+StreamingGrayCode::~StreamingGrayCode(){
+}
+
+dlp::ReturnCode StreamingGrayCode::Setup(const dlp::Parameters &settings){
+    dlp::ReturnCode ret;
+
+    // The projector resolution sets the stripe widths
+    if(!this->projector_set_) return ret.AddError(STREAMING_GRAY_CODE_PROJECTOR_NOT_SET);
+
+    if(settings.Get(&this->pattern_orientation_).hasErrors()) return ret.AddError(STREAMING_GRAY_CODE_ORIENTATION_MISSING);
+    if((this->pattern_orientation_.Get() != dlp::Pattern::Orientation::VERTICAL) &&
+       (this->pattern_orientation_.Get() != dlp::Pattern::Orientation::HORIZONTAL)){
+        return ret.AddError(STREAMING_GRAY_CODE_ORIENTATION_INVALID);
+    }
+
+    settings.Get(&this->bit_count_);
+    settings.Get(&this->include_inverted_);
+    settings.Get(&this->pixel_threshold_);
+    settings.Get(&this->contrast_threshold_);
+
+    const bool vertical  = (this->pattern_orientation_.Get() == dlp::Pattern::Orientation::VERTICAL);
+    this->stripe_extent_ = vertical ? this->projector_columns_ : this->projector_rows_;
+
+    // Limit the bits to what the projector can resolve
+    unsigned int max_bits = 0;
+    while(((1u << max_bits) < this->stripe_extent_) && (max_bits < MAX_BIT_COUNT)) max_bits++;
+
+    if((this->bit_count_.Get() == 0) || (this->bit_count_.Get() > max_bits)){
+        this->bit_count_.Set(max_bits);
+        ret.AddWarning("Streaming Gray code bit count limited to " + dlp::Number::ToString(max_bits));
+    }
+
+    this->sequence_count_total_ = REFERENCE_CAPTURE_COUNT +
+                                  this->bit_count_.Get() * (this->include_inverted_.Get() ? 2 : 1);
+
+    this->is_setup_ = true;
+    return ret;
+}
+
+dlp::ReturnCode StreamingGrayCode::GetSetup(dlp::Parameters *settings) const{
+    dlp::ReturnCode ret;
+
+    if(!settings) return ret.AddError(STREAMING_GRAY_CODE_NULL_POINTER);
+
+    settings->Set(this->pattern_orientation_);
+    settings->Set(this->bit_count_);
+    settings->Set(this->include_inverted_);
+    settings->Set(this->pixel_threshold_);
+    settings->Set(this->contrast_threshold_);
+
+    return ret;
+}
+
+dlp::ReturnCode StreamingGrayCode::GeneratePatternSequence(dlp::Pattern::Sequence *pattern_sequence){
+    dlp::ReturnCode ret;
+
+    if(!pattern_sequence) return ret.AddError(STREAMING_GRAY_CODE_NULL_POINTER);
+    if(!this->isSetup())  return ret.AddError(STREAMING_GRAY_CODE_NOT_SETUP);
+
+    pattern_sequence->Clear();
+
+    dlp::Pattern pattern;
+    pattern.bitdepth  = dlp::Pattern::Bitdepth::MONO_1BPP;
+    pattern.color     = dlp::Pattern::Color::WHITE;
+    pattern.data_type = dlp::Pattern::DataType::IMAGE_DATA;
+
+    const unsigned int columns = this->projector_columns_;
+    const unsigned int rows    = this->projector_rows_;
+    const bool         vertical = (this->pattern_orientation_.Get() == dlp::Pattern::Orientation::VERTICAL);
+
+    // White and black reference patterns
+    CreatePatternImage(columns,rows,vertical,-1,this->bit_count_.Get(),false,&pattern.image_data);
+    pattern_sequence->Add(pattern);
+
+    CreatePatternImage(columns,rows,vertical,-1,this->bit_count_.Get(),true,&pattern.image_data);
+    pattern_sequence->Add(pattern);
+
+    // Gray code bit patterns, most significant bit first
+    for(unsigned int bit = 0; bit < this->bit_count_.Get(); bit++){
+        CreatePatternImage(columns,rows,vertical,bit,this->bit_count_.Get(),false,&pattern.image_data);
+        pattern_sequence->Add(pattern);
+
+        if(this->include_inverted_.Get()){
+            CreatePatternImage(columns,rows,vertical,bit,this->bit_count_.Get(),true,&pattern.image_data);
+            pattern_sequence->Add(pattern);
+        }
+    }
+
+    pattern.image_data.Clear();
+    return ret;
+}
+
+dlp::ReturnCode StreamingGrayCode::DecodeCaptureSequence(dlp::Capture::Sequence *capture_sequence,
+                                                         dlp::DisparityMap      *disparity_map){
+    dlp::ReturnCode ret;
+
+    if(!capture_sequence || !disparity_map) return ret.AddError(STREAMING_GRAY_CODE_NULL_POINTER);
+    if(capture_sequence->GetCount() != this->sequence_count_total_) return ret.AddError(STREAMING_GRAY_CODE_CAPTURES_MISSING);
+
+    // The batch decode is the incremental decode fed from the sequence
+    for(unsigned int iCapture = 0; iCapture < capture_sequence->GetCount(); iCapture++){
+        dlp::Capture capture;
+        capture_sequence->Get(iCapture,&capture);
+
+        if(capture.data_type == dlp::Capture::DataType::IMAGE_FILE){
+            capture.image_data.Load(capture.image_file);
+        }
+
+        if(iCapture == 0){
+            unsigned int columns;
+            unsigned int rows;
+            capture.image_data.GetColumns(&columns);
+            capture.image_data.GetRows(&rows);
+
+            ret = this->BeginDecode(columns,rows);
+            if(ret.hasErrors()) return ret;
+        }
+
+        ret = this->AddCapture(&capture.image_data);
+        if(ret.hasErrors()) return ret;
+    }
+
+    return this->EndDecode(disparity_map);
+}
+
+dlp::ReturnCode StreamingGrayCode::BeginDecode(const unsigned int &columns, const unsigned int &rows){
+    dlp::ReturnCode ret;
+
+    if(!this->isSetup()) return ret.AddError(STREAMING_GRAY_CODE_NOT_SETUP);
+
+    this->columns_        = columns;
+    this->rows_           = rows;
+    this->captures_added_ = 0;
+
+    this->packed_.Create(columns,rows);
+    this->region_.Clear();
+    this->threshold_.assign((size_t) columns * rows,0);
+    this->pending_.clear();
+    this->confidence_.assign((size_t) columns * rows,0);
+
+    this->decoding_ = true;
+    return ret;
+}
+
+dlp::ReturnCode StreamingGrayCode::AddCapture(dlp::Image *capture){
+    dlp::ReturnCode ret;
+
+    if(!capture)                                              return ret.AddError(STREAMING_GRAY_CODE_NULL_POINTER);
+    if(!this->decoding_)                                      return ret.AddError(STREAMING_GRAY_CODE_DECODE_NOT_STARTED);
+    if(this->captures_added_ >= this->sequence_count_total_)  return ret.AddError(STREAMING_GRAY_CODE_TOO_MANY_CAPTURES);
+
+    unsigned int columns;
+    unsigned int rows;
+    capture->GetColumns(&columns);
+    capture->GetRows(&rows);
+    if((columns != this->columns_) || (rows != this->rows_)) return ret.AddError(STREAMING_GRAY_CODE_RESOLUTION_MISMATCH);
+
+    // Decoding operates on 8-bit monochrome data
+    ret = ConvertToMonochromeWithSum(capture,NULL);
+    if(ret.hasErrors()) return ret;
+
+    cv::Mat data;
+    capture->Unsafe_GetOpenCVData(&data);
+
+    const unsigned int  index     = this->captures_added_;
+    const unsigned char threshold = (unsigned char) this->pixel_threshold_.Get();
+    const unsigned char contrast  = (unsigned char) this->contrast_threshold_.Get();
+    BitPlane           *valid     = this->packed_.GetValidMask();
+
+    if(index == 0){
+        // White reference
+        for(unsigned int y = 0; y < this->rows_; y++){
+            memcpy(&this->threshold_[y * this->columns_],data.ptr<unsigned char>(y),this->columns_);
+        }
+    }
+    else if(index == 1){
+        // Black reference, pixels where white is not brighter than black by
+        // more than the contrast threshold are background or shadow
+        BitPlane brighter;
+        brighter.Create(this->columns_,1);
+
+        for(unsigned int y = 0; y < this->rows_; y++){
+            const unsigned char *black  = data.ptr<unsigned char>(y);
+            unsigned char       *white  = &this->threshold_[y * this->columns_];
+            unsigned long long  *mask   = valid->GetRow(y);
+            unsigned long long  *bright = brighter.GetRow(0);
+
+            ThresholdRowToBits(white,black,this->columns_,contrast,bright,mask);
+            for(unsigned int w = 0; w < valid->GetWordsPerRow(); w++) mask[w] &= bright[w];
+
+            unsigned char *confidence = &this->confidence_[y * this->columns_];
+            for(unsigned int x = 0; x < this->columns_; x++){
+                confidence[x] = (white[x] > black[x]) ? (unsigned char)(white[x] - black[x]) : 0;
+                white[x] = (unsigned char)(((unsigned int) white[x] + black[x] + 1) >> 1);
+            }
+        }
+
+        // Only the pixels in this region are thresholded from here on
+        this->region_.Build(*valid);
+    }
+    else if(this->include_inverted_.Get() && (((index - REFERENCE_CAPTURE_COUNT) & 1) == 0)){
+        // Hold the pattern until its inverse arrives
+        this->pending_.resize((size_t) this->columns_ * this->rows_);
+        for(unsigned int y = 0; y < this->rows_; y++){
+            unsigned int x_begin, x_end;
+            this->region_.GetRowSpan(y,&x_begin,&x_end);
+            if(x_begin == x_end) continue;
+
+            memcpy(&this->pending_[y * this->columns_ + x_begin],data.ptr<unsigned char>(y) + x_begin,x_end - x_begin);
+        }
+    }
+    else{
+        BitPlane plane;
+        plane.Create(this->columns_,this->rows_);
+
+        for(unsigned int y = 0; y < this->rows_; y++){
+
+            // Skip the background, starting on a word boundary of the packed row
+            unsigned int x_begin, x_end;
+            this->region_.GetRowSpan(y,&x_begin,&x_end);
+            if(x_begin == x_end) continue;
+
+            x_begin -= x_begin % BIT_PLANE_WORD_BITS;
+
+            const size_t       offset = (size_t) y * this->columns_ + x_begin;
+            const unsigned int word   = x_begin / BIT_PLANE_WORD_BITS;
+
+            if(this->include_inverted_.Get()){
+                // Compare against the inverse, too little difference means noise
+                ThresholdRowToBits(&this->pending_[offset],
+                                   data.ptr<unsigned char>(y) + x_begin,
+                                   x_end - x_begin,
+                                   threshold,
+                                   plane.GetRow(y) + word,
+                                   valid->GetRow(y) + word);
+
+                UpdateConfidenceRow(&this->pending_[offset],
+                                    data.ptr<unsigned char>(y) + x_begin,
+                                    x_end - x_begin,
+                                    0,
+                                    &this->confidence_[offset]);
+            }
+            else{
+                // Compare against the white/black midpoint
+                ThresholdRowToBits(data.ptr<unsigned char>(y) + x_begin,
+                                   &this->threshold_[offset],
+                                   x_end - x_begin,
+                                   0,
+                                   plane.GetRow(y) + word,
+                                   NULL);
+
+                // Distance from the midpoint is half the pattern/inverse difference
+                UpdateConfidenceRow(data.ptr<unsigned char>(y) + x_begin,
+                                    &this->threshold_[offset],
+                                    x_end - x_begin,
+                                    1,
+                                    &this->confidence_[offset]);
+            }
+        }
+
+        this->packed_.AddBitPlane(plane);
+    }
+
+    this->captures_added_++;
+
+    // The 8-bit buffers are no longer needed once the last bit is packed
+    if(this->isDecodeComplete()){
+        std::vector<unsigned char>().swap(this->pending_);
+        std::vector<unsigned char>().swap(this->threshold_);
+    }
+
+    return ret;
+}
+
+dlp::ReturnCode StreamingGrayCode::EndDecode(dlp::DisparityMap *disparity_map){
+    dlp::ReturnCode ret;
+
+    if(!disparity_map)              return ret.AddError(STREAMING_GRAY_CODE_NULL_POINTER);
+    if(!this->decoding_)            return ret.AddError(STREAMING_GRAY_CODE_DECODE_NOT_STARTED);
+    if(!this->isDecodeComplete())   return ret.AddError(STREAMING_GRAY_CODE_CAPTURES_MISSING);
+
+    this->decoding_ = false;
+    return this->DecodePackedCaptures(this->packed_,disparity_map);
+}
+
+dlp::ReturnCode StreamingGrayCode::DecodePackedCaptures(const PackedCaptureSequence &captures,
+                                                        dlp::DisparityMap           *disparity_map) const{
+    dlp::ReturnCode ret;
+
+    if(!disparity_map)                                      return ret.AddError(STREAMING_GRAY_CODE_NULL_POINTER);
+    if(!this->isSetup())                                    return ret.AddError(STREAMING_GRAY_CODE_NOT_SETUP);
+    if(captures.GetCount() != this->bit_count_.Get())       return ret.AddError(STREAMING_GRAY_CODE_CAPTURES_MISSING);
+
+    const unsigned int columns    = captures.GetColumns();
+    const unsigned int rows       = captures.GetRows();
+    const unsigned int bit_count  = captures.GetCount();
+
+    disparity_map->Create(columns,rows,this->pattern_orientation_.Get());
+
+    // Only the words covering valid pixels are decoded
+    ScanRegion region;
+    region.Build(*captures.GetValidMask());
+
+    std::vector<const unsigned long long*> planes(bit_count);
+    unsigned int codes[BIT_PLANE_WORD_BITS];
+
+    for(unsigned int y = 0; y < rows; y++){
+        const unsigned long long *valid = captures.GetValidMask()->GetRow(y);
+        for(unsigned int bit = 0; bit < bit_count; bit++) planes[bit] = captures.GetBitPlane(bit)->GetRow(y);
+
+        unsigned int x_begin, x_end;
+        region.GetRowSpan(y,&x_begin,&x_end);
+
+        const unsigned int word_begin = x_begin / BIT_PLANE_WORD_BITS;
+        const unsigned int word_end   = (x_end + BIT_PLANE_WORD_BITS - 1) / BIT_PLANE_WORD_BITS;
+
+        for(unsigned int x = 0; x < word_begin * BIT_PLANE_WORD_BITS; x++){
+            disparity_map->SetPixel(x,y,dlp::DisparityMap::INVALID_PIXEL);
+        }
+        for(unsigned int x = word_end * BIT_PLANE_WORD_BITS; x < columns; x++){
+            disparity_map->SetPixel(x,y,dlp::DisparityMap::INVALID_PIXEL);
+        }
+
+        for(unsigned int w = word_begin; w < word_end; w++){
+
+            // Gray to binary for 64 pixels at once: each binary plane is the
+            // previous binary plane XOR the Gray plane, MSB first
+            unsigned long long binary = 0;
+            memset(codes,0,sizeof(codes));
+
+            for(unsigned int bit = 0; bit < bit_count; bit++){
+                binary ^= planes[bit][w];
+                for(unsigned int i = 0; i < BIT_PLANE_WORD_BITS; i++){
+                    codes[i] = (codes[i] << 1) | (unsigned int)((binary >> i) & 1);
+                }
+            }
+
+            // Convert each stripe index to the projector pixel at the stripe center
+            const unsigned int x_start = w * BIT_PLANE_WORD_BITS;
+            const unsigned int x_end   = (x_start + BIT_PLANE_WORD_BITS < columns) ? (x_start + BIT_PLANE_WORD_BITS) : columns;
+            for(unsigned int x = x_start; x < x_end; x++){
+                const unsigned int i = x - x_start;
+                if((valid[w] >> i) & 1){
+                    const unsigned long long stripe = codes[i];
+                    disparity_map->SetPixel(x,y,(int)(((2 * stripe + 1) * this->stripe_extent_) >> (bit_count + 1)));
+                }
+                else{
+                    disparity_map->SetPixel(x,y,dlp::DisparityMap::INVALID_PIXEL);
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+bool StreamingGrayCode::isDecoding() const{
+    return this->decoding_;
+}
+
+bool StreamingGrayCode::isDecodeComplete() const{
+    return this->decoding_ && (this->captures_added_ == this->sequence_count_total_);
+}
+
+unsigned int StreamingGrayCode::GetCapturesAdded() const{
+    return this->captures_added_;
+}
+
+const PackedCaptureSequence& StreamingGrayCode::GetPackedCaptures() const{
+    return this->packed_;
+}
+
+const ScanRegion& StreamingGrayCode::GetScanRegion() const{
+    return this->region_;
+}
+
+dlp::ReturnCode StreamingGrayCode::GetConfidenceMap(dlp::Image *confidence) const{
+    dlp::ReturnCode ret;
+
+    if(!confidence) return ret.AddError(STREAMING_GRAY_CODE_NULL_POINTER);
+    if(this->confidence_.empty() || (this->captures_added_ != this->sequence_count_total_)){
+        return ret.AddError(DECODE_CONFIDENCE_NOT_AVAILABLE);
+    }
+
+    // Pixels which failed a margin or contrast test have no confidence
+    const BitPlane *valid = this->packed_.GetValidMask();
+
+    cv::Mat data(this->rows_,this->columns_,CV_8UC1);
+    for(unsigned int y = 0; y < this->rows_; y++){
+        const unsigned long long *mask   = valid->GetRow(y);
+        const unsigned char      *source = &this->confidence_[y * this->columns_];
+        unsigned char            *target = data.ptr<unsigned char>(y);
+
+        for(unsigned int x = 0; x < this->columns_; x++){
+            target[x] = ((mask[x / BIT_PLANE_WORD_BITS] >> (x % BIT_PLANE_WORD_BITS)) & 1) ? source[x] : 0;
+        }
+    }
+
+    confidence->Create(data);
+    return ret;
+}
@@ -0,0 +1,106 @@
+/** @file       StreamingGrayCode.h
+ *  @brief      Gray code structured light module that decodes captures as they arrive
+ */
+#ifndef __STREAMING_GRAY_CODE_H_
+#define __STREAMING_GRAY_CODE_H_
+
+#include <vector>
+#include <dlp_sdk.hpp>  // Included for DPL Structured Light SDK
+#include "BitPlane.h"
+#include "ScanMask.h"
+#include "DecodeConfidence.h"
+
+#define STREAMING_GRAY_CODE_NOT_SETUP               "STREAMING_GRAY_CODE_NOT_SETUP"
+#define STREAMING_GRAY_CODE_NULL_POINTER            "STREAMING_GRAY_CODE_NULL_POINTER"
+#define STREAMING_GRAY_CODE_PROJECTOR_NOT_SET       "STREAMING_GRAY_CODE_PROJECTOR_NOT_SET"
+#define STREAMING_GRAY_CODE_DECODE_NOT_STARTED      "STREAMING_GRAY_CODE_DECODE_NOT_STARTED"
+#define STREAMING_GRAY_CODE_TOO_MANY_CAPTURES       "STREAMING_GRAY_CODE_TOO_MANY_CAPTURES"
+#define STREAMING_GRAY_CODE_CAPTURES_MISSING        "STREAMING_GRAY_CODE_CAPTURES_MISSING"
+#define STREAMING_GRAY_CODE_RESOLUTION_MISMATCH     "STREAMING_GRAY_CODE_RESOLUTION_MISMATCH"
+#define STREAMING_GRAY_CODE_ORIENTATION_MISSING     "STREAMING_GRAY_CODE_ORIENTATION_MISSING"
+#define STREAMING_GRAY_CODE_ORIENTATION_INVALID     "STREAMING_GRAY_CODE_ORIENTATION_INVALID"
+
+// Gray code module with the same role as dlp::GrayCode but with an incremental
+// decoder. Each capture is thresholded as it arrives into a 1 bpp bit plane and
+// a packed validity mask, so only the packed planes, the threshold image, and at
+// most one pending capture are held instead of the whole capture sequence. The
+// Gray to binary conversion runs on the packed 64 pixel words.
+//
+// The orientation is the SDK's structured light PatternOrientation setting read
+// by dlp::GrayCode, so the same settings file configures either module. It has
+// to be VERTICAL or HORIZONTAL and Setup fails without it.
+//
+// Pattern sequence layout:
+//   white, black, then one pattern per bit (MSB first) each followed by its
+//   inverse when IncludeInverted is set.
+//
+// The confidence of a pixel is its white - black modulation limited by the
+// smallest bit margin, |pattern - inverse| or twice |pattern - midpoint|.
+class StreamingGrayCode : public dlp::StructuredLight, public DecodeConfidence{
+public:
+    class Parameters{
+    public:
+        DLP_NEW_PARAMETERS_ENTRY(BitCount,          "STREAMING_GRAY_CODE_BIT_COUNT",            unsigned int,   8);
+        DLP_NEW_PARAMETERS_ENTRY(IncludeInverted,   "STREAMING_GRAY_CODE_INCLUDE_INVERTED",     bool,           true);
+        DLP_NEW_PARAMETERS_ENTRY(PixelThreshold,    "STREAMING_GRAY_CODE_PIXEL_THRESHOLD",      unsigned int,   5);
+        DLP_NEW_PARAMETERS_ENTRY(ContrastThreshold, "STREAMING_GRAY_CODE_CONTRAST_THRESHOLD",   unsigned int,   5);
+    };
+
+    StreamingGrayCode();
+    ~StreamingGrayCode();
+
+    dlp::ReturnCode Setup(const dlp::Parameters &settings);
+    dlp::ReturnCode GetSetup(dlp::Parameters *settings) const;
+
+    dlp::ReturnCode GeneratePatternSequence(dlp::Pattern::Sequence *pattern_sequence);
+    dlp::ReturnCode DecodeCaptureSequence(dlp::Capture::Sequence *capture_sequence,
+                                          dlp::DisparityMap      *disparity_map);
+
+    // Incremental decode interface. Captures must be added in pattern sequence
+    // order and may be released by the caller as soon as AddCapture returns.
+    dlp::ReturnCode BeginDecode(const unsigned int &columns, const unsigned int &rows);
+    dlp::ReturnCode AddCapture(dlp::Image *capture);
+    dlp::ReturnCode EndDecode(dlp::DisparityMap *disparity_map);
+
+    bool         isDecoding() const;
+    bool         isDecodeComplete() const;
+    unsigned int GetCapturesAdded() const;
+
+    // Binarized captures of the most recent decode, valid until the next BeginDecode
+    const PackedCaptureSequence& GetPackedCaptures() const;
+
+    // Pixels with enough white/black contrast, known once the black reference
+    // has been added. Later captures are only thresholded inside this region.
+    const ScanRegion& GetScanRegion() const;
+
+    // Confidence of the most recent incremental decode, archived captures
+    // decoded with DecodePackedCaptures have none
+    dlp::ReturnCode GetConfidenceMap(dlp::Image *confidence) const;
+
+    // Decodes previously binarized captures, e.g. from a saved archive
+    dlp::ReturnCode DecodePackedCaptures(const PackedCaptureSequence &captures,
+                                         dlp::DisparityMap           *disparity_map) const;
+
+private:
+
+    Parameters::BitCount        bit_count_;
+    Parameters::IncludeInverted include_inverted_;
+    Parameters::PixelThreshold  pixel_threshold_;
+    Parameters::ContrastThreshold contrast_threshold_;
+
+    unsigned int stripe_extent_;    // Projector columns (vertical) or rows (horizontal)
+
+    // Decode state
+    bool         decoding_;
+    unsigned int columns_;
+    unsigned int rows_;
+    unsigned int captures_added_;
+
+    PackedCaptureSequence       packed_;        // Validity mask and one Gray code bit plane per bit
+    ScanRegion                  region_;        // Runs of pixels with enough contrast
+    std::vector<unsigned char>  threshold_;     // White capture until black arrives, then the midpoint
+    std::vector<unsigned char>  pending_;       // Pattern capture waiting for its inverse
+    std::vector<unsigned char>  confidence_;    // Modulation, then lowered by each bit margin
+};
+
+#endif
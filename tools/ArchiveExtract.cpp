@@ -0,0 +1,122 @@
+/** @file       ArchiveExtract.cpp
+ *  @brief      Lists a scan archive or extracts one view of it
+ *
+ *  Usage: ArchiveExtract <archive.dlpa> [view output directory]
+ *
+ *  Without a view every chunk is listed. With one, its captures are saved as
+ *  scan_capture_<pattern>.bmp, the layout ScanBenchmark replays, together with
+ *  the color map, confidence map, and point cloud of the view.
+ *  Built as its own executable together with ScanArchive.cpp.
+ */
+#include <winsock2.h>
+#include <Windows.h>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <dlp_sdk.hpp>
+#include "../ScanArchive.h"
+
+static const char *GetChunkName(const unsigned int &type){
+    switch(type){
+    case SCAN_ARCHIVE_CHUNK_CAPTURE:            return "capture";
+    case SCAN_ARCHIVE_CHUNK_COLUMN_DISPARITY:   return "column_disparity";
+    case SCAN_ARCHIVE_CHUNK_ROW_DISPARITY:      return "row_disparity";
+    case SCAN_ARCHIVE_CHUNK_CONFIDENCE:         return "confidence";
+    case SCAN_ARCHIVE_CHUNK_DEPTH_MAP:          return "depth_map";
+    case SCAN_ARCHIVE_CHUNK_COLOR_MAP:          return "color_map";
+    case SCAN_ARCHIVE_CHUNK_POINT_CLOUD:        return "point_cloud";
+    default:                                    return "unknown";
+    }
+}
+
+static void ListArchive(const ScanArchiveReader &reader){
+    unsigned long long raw_bytes    = 0;
+    unsigned long long stored_bytes = 0;
+
+    std::cout << "view,type,index,columns,rows,raw_bytes,stored_bytes" << std::endl;
+    for(unsigned int iEntry = 0; iEntry < reader.GetEntryCount(); iEntry++){
+        ScanArchiveEntry entry;
+        reader.GetEntry(iEntry, &entry);
+        std::cout << entry.chunk.view << "," << GetChunkName(entry.chunk.type) << "," << entry.chunk.index << ","
+                  << entry.chunk.columns << "," << entry.chunk.rows << ","
+                  << entry.chunk.raw_bytes << "," << entry.chunk.stored_bytes << std::endl;
+        raw_bytes    += entry.chunk.raw_bytes;
+        stored_bytes += entry.chunk.stored_bytes;
+    }
+
+    std::cout << reader.GetEntryCount() << " chunks, " << raw_bytes << " bytes stored in " << stored_bytes;
+    if(raw_bytes > 0) std::cout << " (" << std::fixed << std::setprecision(1) << 100.0 * stored_bytes / raw_bytes << "%)";
+    std::cout << std::endl;
+}
+
+static dlp::ReturnCode ExtractView(const ScanArchiveReader &reader,
+                                   const unsigned int      &view,
+                                   const std::string       &output_directory,
+                                   unsigned int            *extracted){
+    dlp::ReturnCode ret;
+
+    // A chunk written again for the same view and index replaces the earlier one
+    for(unsigned int iEntry = 0; iEntry < reader.GetEntryCount(); iEntry++){
+        ScanArchiveEntry entry;
+        reader.GetEntry(iEntry, &entry);
+        if(entry.chunk.view != view) continue;
+
+        std::string filename = output_directory;
+        switch(entry.chunk.type){
+        case SCAN_ARCHIVE_CHUNK_CAPTURE:    filename += "scan_capture_" + dlp::Number::ToString(entry.chunk.index) + ".bmp"; break;
+        case SCAN_ARCHIVE_CHUNK_CONFIDENCE: filename += "confidence_map.bmp";   break;
+        case SCAN_ARCHIVE_CHUNK_COLOR_MAP:  filename += "color_map.bmp";        break;
+        case SCAN_ARCHIVE_CHUNK_POINT_CLOUD:filename += "point_cloud.xyz";      break;
+        default:                            continue;   // Disparity and depth maps have no image file
+        }
+
+        if(entry.chunk.type == SCAN_ARCHIVE_CHUNK_POINT_CLOUD){
+            dlp::Point::Cloud point_cloud;
+            ret = reader.GetPointCloud(iEntry, &point_cloud);
+            if(!ret.hasErrors()) ret = point_cloud.SaveXYZ(filename, ' ');
+        }
+        else{
+            dlp::Image image;
+            ret = reader.GetImage(iEntry, &image);
+            if(!ret.hasErrors()) ret = image.Save(filename);
+        }
+        if(ret.hasErrors()) return ret;
+        (*extracted)++;
+    }
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2){
+        std::cout << "Usage: ArchiveExtract <archive.dlpa> [view output directory]" << std::endl;
+        return 2;
+    }
+
+    ScanArchiveReader reader;
+    dlp::ReturnCode ret = reader.Open(argv[1]);
+    if(ret.hasErrors()){
+        std::cout << "Archive " << argv[1] << " did NOT open: " << ret.ToString() << std::endl;
+        return 2;
+    }
+
+    if(argc < 4){
+        ListArchive(reader);
+        return 0;
+    }
+
+    std::string output_directory = argv[3];
+    if(output_directory.back() != '/' && output_directory.back() != '\\') output_directory += "/";
+    CreateDirectoryA(output_directory.c_str(), NULL);
+
+    unsigned int extracted = 0;
+    ret = ExtractView(reader, std::atoi(argv[2]), output_directory, &extracted);
+    if(ret.hasErrors()){
+        std::cout << "View " << argv[2] << " NOT extracted: " << ret.ToString() << std::endl;
+        return 2;
+    }
+
+    std::cout << "Extracted " << extracted << " files of view " << argv[2] << " to " << output_directory << std::endl;
+    return 0;
+}
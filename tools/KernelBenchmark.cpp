@@ -0,0 +1,604 @@
+/** @file       KernelBenchmark.cpp
+ *  @brief      Times the hot scan kernels in isolation across sizes and threads
+ *
+ *  Usage: KernelBenchmark [kernel benchmark config] [--filter=text]
+ *
+ *  Each kernel of ScanObject runs on synthetic inputs of every configured
+ *  camera resolution with every configured thread count. As with Google
+ *  Benchmark's Threads(n), each thread runs its own instance of the kernel on
+ *  the shared inputs, and the iterations grow until a run takes the minimum
+ *  time. The report gives the time per iteration, items per second, and the
+ *  scaling against one thread, and is also saved as CSV. Only kernels whose
+ *  name contains the filter text run. Built as its own executable together
+ *  with StreamingGrayCode.cpp, MultiFrequencyPhase.cpp, BitPlane.cpp,
+ *  ScanMask.cpp, DecodeConfidence.cpp, FrameAcquisition.cpp, PointCloudFile.cpp,
+ *  ScanSession.cpp, ResultChannel.cpp, AutoExposure.cpp, PatternTimeline.cpp,
+ *  and FrameCodec.cpp.
+ *
+ *  Kernels:
+ *    threshold     ThresholdRowToBits of a frame against its reference, pixels
+ *    gray_decode   StreamingGrayCode incremental decode of 8 bits, pixels
+ *    phase_decode  MultiFrequencyPhase decode of 3 x 4 steps, pixels
+ *    triangulate   Geometry::GeneratePointCloud of a column disparity, pixels
+ *    colorize      Geometry::ConvertDistanceMapToColor, pixels
+ *    frame_encode  EncodeFramePixels of a pattern frame, pixels
+ *    frame_decode  DecodeFramePixels of a pattern frame, pixels
+ *    save_xyz      Point::Cloud::SaveXYZ, points
+ *    save_ply      SavePLY binary, points
+ *    save_ply_ascii SavePLY ASCII, points
+ */
+#include <winsock2.h>
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dlp_sdk.hpp>
+#include "../BitPlane.h"
+#include "../FrameCodec.h"
+#include "../MultiFrequencyPhase.h"
+#include "../PatternTimeline.h"
+#include "../PointCloudFile.h"
+#include "../ScanSession.h"
+#include "../StreamingGrayCode.h"
+
+namespace KernelBenchmark{
+
+// Camera resolutions as columns x rows, and thread counts where max is every core
+DLP_NEW_PARAMETERS_ENTRY(Sizes,                     "KERNEL_BENCHMARK_SIZES",               std::string,  "640x480,1280x1024,1920x1200");
+DLP_NEW_PARAMETERS_ENTRY(Threads,                   "KERNEL_BENCHMARK_THREADS",             std::string,  "1,2,4,max");
+DLP_NEW_PARAMETERS_ENTRY(MinimumTime,               "KERNEL_BENCHMARK_MINIMUM_TIME_MS",     unsigned int, 500);
+
+DLP_NEW_PARAMETERS_ENTRY(CalibDataFileCamera,       "CALIBRATION_DATA_FILE_CAMERA",         std::string,  "calibration/data/camera.xml");
+DLP_NEW_PARAMETERS_ENTRY(CalibDataFileProjector,    "CALIBRATION_DATA_FILE_PROJECTOR",      std::string,  "calibration/data/projector.xml");
+DLP_NEW_PARAMETERS_ENTRY(ConfigFileGeometry,        "CONFIG_FILE_GEOMETRY",                 std::string,  "config/geometry.txt");
+
+DLP_NEW_PARAMETERS_ENTRY(OutputDirectory,           "KERNEL_BENCHMARK_OUTPUT_DIRECTORY",    std::string,  "benchmark/kernels/");
+DLP_NEW_PARAMETERS_ENTRY(ResultsFile,               "KERNEL_BENCHMARK_RESULTS",             std::string,  "benchmark/kernels.csv");
+
+}
+
+static const char* const KERNEL_NAMES[] = { "threshold", "gray_decode", "phase_decode", "triangulate",
+                                            "colorize", "frame_encode", "frame_decode",
+                                            "save_xyz", "save_ply", "save_ply_ascii" };
+#define KERNEL_COUNT    10
+
+// Inputs of one camera resolution, shared read only by every thread
+struct KernelInputs{
+    unsigned int            columns;
+    unsigned int            rows;
+    unsigned int            projector_columns;
+    unsigned int            projector_rows;
+    dlp::DLP_Platform      *projector;
+
+    dlp::Image              frame;
+    dlp::Image              reference;
+    dlp::Capture::Sequence  gray_captures;
+    dlp::Capture::Sequence  phase_captures;
+    dlp::DisparityMap       column_disparity;
+    dlp::Image              depth_map;
+    dlp::Point::Cloud       point_cloud;
+
+    std::string             camera_calib_data_file;
+    std::string             projector_calib_data_file;
+    std::string             geometry_settings_file;
+    std::string             output_directory;
+};
+
+struct KernelResult{
+    std::string         kernel;
+    unsigned int        columns;
+    unsigned int        rows;
+    unsigned int        threads;
+    unsigned long long  iterations;
+    double              ns_per_iteration;
+    double              items_per_s;
+    double              scaling;
+};
+
+// One thread's instance of a kernel. Prepare is not timed.
+class Kernel{
+public:
+    virtual ~Kernel(){}
+    virtual dlp::ReturnCode Prepare(const KernelInputs &inputs, const unsigned int &thread) = 0;
+    virtual unsigned long long Run() = 0;   // Returns the items processed
+};
+
+class ThresholdKernel : public Kernel{
+public:
+    dlp::ReturnCode Prepare(const KernelInputs &inputs, const unsigned int &/*thread*/){
+        inputs.frame.GetOpenCVData(&this->frame_);
+        inputs.reference.GetOpenCVData(&this->reference_);
+        this->bits_.Create(inputs.columns, inputs.rows);
+        this->valid_.Create(inputs.columns, inputs.rows, true);
+        return dlp::ReturnCode();
+    }
+    unsigned long long Run(){
+        for(unsigned int y = 0; y < this->bits_.GetRows(); y++){
+            ThresholdRowToBits(this->frame_.ptr<unsigned char>(y), this->reference_.ptr<unsigned char>(y),
+                               this->bits_.GetColumns(), 5, this->bits_.GetRow(y), this->valid_.GetRow(y));
+        }
+        return (unsigned long long) this->bits_.GetColumns() * this->bits_.GetRows();
+    }
+private:
+    cv::Mat  frame_;
+    cv::Mat  reference_;
+    BitPlane bits_;
+    BitPlane valid_;
+};
+
+// Module settings for vertical patterns, every other entry at its default
+static dlp::Parameters GetVerticalSettings(){
+    dlp::Parameters settings;
+    settings.Set(dlp::StructuredLight::Parameters::PatternOrientation(dlp::Pattern::Orientation::VERTICAL));
+    return settings;
+}
+
+class GrayDecodeKernel : public Kernel{
+public:
+    dlp::ReturnCode Prepare(const KernelInputs &inputs, const unsigned int &/*thread*/){
+        this->captures_ = &inputs.gray_captures;
+        this->pixels_   = (unsigned long long) inputs.columns * inputs.rows;
+        this->module_.SetDlpPlatform(*inputs.projector);
+        return this->module_.Setup(GetVerticalSettings());
+    }
+    unsigned long long Run(){
+        dlp::DisparityMap disparity;
+        dlp::Capture      capture;
+        this->captures_->Get(0, &capture);
+        unsigned int columns, rows;
+        capture.image_data.GetColumns(&columns);
+        capture.image_data.GetRows(&rows);
+        this->module_.BeginDecode(columns, rows);
+        for(unsigned int iCapture = 0; iCapture < this->captures_->GetCount(); iCapture++){
+            this->captures_->Get(iCapture, &capture);
+            this->module_.AddCapture(&capture.image_data);
+        }
+        this->module_.EndDecode(&disparity);
+        return this->pixels_;
+    }
+private:
+    const dlp::Capture::Sequence *captures_;
+    unsigned long long            pixels_;
+    StreamingGrayCode             module_;
+};
+
+class PhaseDecodeKernel : public Kernel{
+public:
+    dlp::ReturnCode Prepare(const KernelInputs &inputs, const unsigned int &/*thread*/){
+        this->captures_ = inputs.phase_captures;
+        this->pixels_   = (unsigned long long) inputs.columns * inputs.rows;
+        this->module_.SetDlpPlatform(*inputs.projector);
+        return this->module_.Setup(GetVerticalSettings());
+    }
+    unsigned long long Run(){
+        dlp::DisparityMap disparity;
+        this->module_.DecodeCaptureSequence(&this->captures_, &disparity);
+        return this->pixels_;
+    }
+private:
+    dlp::Capture::Sequence captures_;
+    unsigned long long     pixels_;
+    MultiFrequencyPhase    module_;
+};
+
+class TriangulateKernel : public Kernel{
+public:
+    dlp::ReturnCode Prepare(const KernelInputs &inputs, const unsigned int &/*thread*/){
+        this->disparity_ = &inputs.column_disparity;
+        this->pixels_    = (unsigned long long) inputs.columns * inputs.rows;
+        return this->session_.PrepareGeometry(inputs.columns, inputs.rows, inputs.projector_columns, inputs.projector_rows,
+                                              inputs.camera_calib_data_file, inputs.projector_calib_data_file,
+                                              inputs.geometry_settings_file);
+    }
+    unsigned long long Run(){
+        dlp::Point::Cloud point_cloud;
+        dlp::Image        depth_map;
+        this->session_.GetGeometry().GeneratePointCloud(this->session_.GetCameraViewport(), *this->disparity_, &point_cloud, &depth_map);
+        return this->pixels_;
+    }
+private:
+    const dlp::DisparityMap *disparity_;
+    unsigned long long       pixels_;
+    ScanSession              session_;
+};
+
+class ColorizeKernel : public Kernel{
+public:
+    dlp::ReturnCode Prepare(const KernelInputs &inputs, const unsigned int &/*thread*/){
+        this->depth_map_ = &inputs.depth_map;
+        this->pixels_    = (unsigned long long) inputs.columns * inputs.rows;
+        return dlp::ReturnCode();
+    }
+    unsigned long long Run(){
+        dlp::Image color_map;
+        dlp::Geometry::ConvertDistanceMapToColor(*this->depth_map_, &color_map);
+        return this->pixels_;
+    }
+private:
+    const dlp::Image   *depth_map_;
+    unsigned long long  pixels_;
+};
+
+class FrameEncodeKernel : public Kernel{
+public:
+    dlp::ReturnCode Prepare(const KernelInputs &inputs, const unsigned int &/*thread*/){
+        inputs.frame.GetOpenCVData(&this->frame_);
+        return dlp::ReturnCode();
+    }
+    unsigned long long Run(){
+        EncodeFramePixels(this->frame_.data, this->frame_.cols, this->frame_.rows, (unsigned long long) this->frame_.step, &this->encoded_);
+        return (unsigned long long) this->frame_.cols * this->frame_.rows;
+    }
+private:
+    cv::Mat                    frame_;
+    std::vector<unsigned char> encoded_;
+};
+
+class FrameDecodeKernel : public Kernel{
+public:
+    dlp::ReturnCode Prepare(const KernelInputs &inputs, const unsigned int &/*thread*/){
+        cv::Mat frame;
+        inputs.frame.GetOpenCVData(&frame);
+        this->columns_ = frame.cols;
+        this->rows_    = frame.rows;
+        this->pixels_.resize((unsigned long long) this->columns_ * this->rows_);
+        EncodeFramePixels(frame.data, this->columns_, this->rows_, (unsigned long long) frame.step, &this->encoded_);
+        return dlp::ReturnCode();
+    }
+    unsigned long long Run(){
+        DecodeFramePixels(this->encoded_.data(), this->encoded_.size(), this->columns_, this->rows_, this->pixels_.data());
+        return this->pixels_.size();
+    }
+private:
+    unsigned int               columns_;
+    unsigned int               rows_;
+    std::vector<unsigned char> encoded_;
+    std::vector<unsigned char> pixels_;
+};
+
+// Writes to its own file per thread so the threads do not share a handle
+class SaveKernel : public Kernel{
+public:
+    enum class Format { XYZ, PLY_BINARY, PLY_ASCII };
+
+    SaveKernel(const Format &format){
+        this->format_ = format;
+    }
+    dlp::ReturnCode Prepare(const KernelInputs &inputs, const unsigned int &thread){
+        this->point_cloud_ = &inputs.point_cloud;
+        this->filename_    = inputs.output_directory + "kernel_" + dlp::Number::ToString(thread) +
+                             ((this->format_ == Format::XYZ) ? ".xyz" : ".ply");
+        return dlp::ReturnCode();
+    }
+    unsigned long long Run(){
+        if(this->format_ == Format::XYZ) this->point_cloud_->SaveXYZ(this->filename_, ' ');
+        else                             SavePLY(this->filename_, *this->point_cloud_, this->format_ == Format::PLY_BINARY);
+        return this->point_cloud_->GetCount();
+    }
+private:
+    Format                   format_;
+    const dlp::Point::Cloud *point_cloud_;
+    std::string              filename_;
+};
+
+static Kernel* CreateKernel(const std::string &name){
+    if(name == "threshold")      return new ThresholdKernel();
+    if(name == "gray_decode")    return new GrayDecodeKernel();
+    if(name == "phase_decode")   return new PhaseDecodeKernel();
+    if(name == "triangulate")    return new TriangulateKernel();
+    if(name == "colorize")       return new ColorizeKernel();
+    if(name == "frame_encode")   return new FrameEncodeKernel();
+    if(name == "frame_decode")   return new FrameDecodeKernel();
+    if(name == "save_xyz")       return new SaveKernel(SaveKernel::Format::XYZ);
+    if(name == "save_ply")       return new SaveKernel(SaveKernel::Format::PLY_BINARY);
+    if(name == "save_ply_ascii") return new SaveKernel(SaveKernel::Format::PLY_ASCII);
+    return NULL;
+}
+
+static std::vector<std::string> SplitList(const std::string &list){
+    std::vector<std::string> values;
+    std::istringstream fields(list);
+    std::string value;
+    while(std::getline(fields,value,',')){
+        value.erase(std::remove(value.begin(),value.end(),' '),value.end());
+        if(!value.empty()) values.push_back(value);
+    }
+    return values;
+}
+
+// Camera frame of a projector pattern over a flat target filling the view,
+// with the stripes between 20 and 230 gray levels
+static void RenderPatternFrame(const dlp::Pattern &pattern, const unsigned int &columns, const unsigned int &rows, dlp::Image *frame){
+    cv::Mat pattern_data;
+    pattern.image_data.GetOpenCVData(&pattern_data);
+
+    frame->Create(columns, rows, dlp::Image::Format::MONO_UCHAR);
+    cv::Mat frame_data;
+    frame->Unsafe_GetOpenCVData(&frame_data);
+
+    const bool color = (pattern_data.channels() == 3);
+    for(unsigned int y = 0; y < rows; y++){
+        const unsigned char *source = pattern_data.ptr<unsigned char>((int)((unsigned long long) y * pattern_data.rows / rows));
+        unsigned char       *target = frame_data.ptr<unsigned char>(y);
+        for(unsigned int x = 0; x < columns; x++){
+            const unsigned int px    = (unsigned int)((unsigned long long) x * pattern_data.cols / columns);
+            const unsigned int level = color ? source[3 * px + 1] : source[px];
+            target[x] = (unsigned char)(20 + level * 210 / 255);
+        }
+    }
+}
+
+static dlp::ReturnCode RenderCaptures(dlp::StructuredLight   *module,
+                                      const unsigned int     &columns,
+                                      const unsigned int     &rows,
+                                      dlp::Capture::Sequence *captures){
+    dlp::ReturnCode ret;
+
+    dlp::Pattern::Sequence patterns;
+    ret = module->GeneratePatternSequence(&patterns);
+    if(ret.hasErrors()) return ret;
+
+    captures->Clear();
+    for(unsigned int iPattern = 0; iPattern < patterns.GetCount(); iPattern++){
+        dlp::Pattern pattern;
+        patterns.Get(iPattern, &pattern);
+
+        dlp::Capture capture;
+        capture.data_type  = dlp::Capture::DataType::IMAGE_DATA;
+        capture.pattern_id = iPattern;
+        RenderPatternFrame(pattern, columns, rows, &capture.image_data);
+        captures->Add(capture);
+    }
+    return ret;
+}
+
+static dlp::ReturnCode PrepareInputs(KernelInputs *inputs){
+    dlp::ReturnCode ret;
+
+    const unsigned int columns = inputs->columns;
+    const unsigned int rows    = inputs->rows;
+
+    // Decoded once here, which also gives the disparity the triangulation uses
+    StreamingGrayCode gray_code;
+    gray_code.SetDlpPlatform(*inputs->projector);
+    ret = gray_code.Setup(GetVerticalSettings());
+    if(!ret.hasErrors()) ret = RenderCaptures(&gray_code, columns, rows, &inputs->gray_captures);
+    if(!ret.hasErrors()) ret = gray_code.DecodeCaptureSequence(&inputs->gray_captures, &inputs->column_disparity);
+    if(ret.hasErrors()) return ret;
+
+    MultiFrequencyPhase phase;
+    phase.SetDlpPlatform(*inputs->projector);
+    ret = phase.Setup(GetVerticalSettings());
+    if(!ret.hasErrors()) ret = RenderCaptures(&phase, columns, rows, &inputs->phase_captures);
+    if(ret.hasErrors()) return ret;
+
+    // The most significant bit against the midpoint of white and black
+    dlp::Capture white, black, bit;
+    inputs->gray_captures.Get(0, &white);
+    inputs->gray_captures.Get(1, &black);
+    inputs->gray_captures.Get(2, &bit);
+    inputs->frame = bit.image_data;
+
+    cv::Mat white_data, black_data, reference_data;
+    white.image_data.GetOpenCVData(&white_data);
+    black.image_data.GetOpenCVData(&black_data);
+    inputs->reference.Create(columns, rows, dlp::Image::Format::MONO_UCHAR);
+    inputs->reference.Unsafe_GetOpenCVData(&reference_data);
+    for(unsigned int y = 0; y < rows; y++){
+        for(unsigned int x = 0; x < columns; x++){
+            reference_data.ptr<unsigned char>(y)[x] = (unsigned char)((white_data.ptr<unsigned char>(y)[x] +
+                                                                       black_data.ptr<unsigned char>(y)[x]) / 2);
+        }
+    }
+
+    // A tilted plane as the depth map, and its points
+    cv::Mat depth_data;
+    inputs->depth_map.Create(columns, rows, dlp::Image::Format::MONO_FLOAT);
+    inputs->depth_map.Unsafe_GetOpenCVData(&depth_data);
+    inputs->point_cloud.Clear();
+    for(unsigned int y = 0; y < rows; y++){
+        for(unsigned int x = 0; x < columns; x++){
+            dlp::Point point;
+            point.x = (x - columns / 2.0) * 0.5;
+            point.y = (y - rows / 2.0) * 0.5;
+            point.z = 400.0 + 200.0 * x / columns + 50.0 * y / rows;
+            depth_data.ptr<float>(y)[x] = (float) point.z;
+            inputs->point_cloud.Add(point);
+        }
+    }
+
+    return ret;
+}
+
+// Runs every thread's instance for the same number of iterations, growing the
+// iterations until the wall time of the run reaches the minimum time
+static dlp::ReturnCode RunKernel(const std::string  &name,
+                                 const KernelInputs &inputs,
+                                 const unsigned int &threads,
+                                 const unsigned int &minimum_time_ms,
+                                 KernelResult       *result){
+    dlp::ReturnCode ret;
+
+    std::vector<Kernel*> kernels;
+    for(unsigned int iThread = 0; iThread < threads; iThread++){
+        kernels.push_back(CreateKernel(name));
+        ret = kernels.back()->Prepare(inputs, iThread);
+        if(ret.hasErrors()) break;
+        kernels.back()->Run();     // Warm up, first touch of the buffers
+    }
+
+    unsigned long long iterations = 1;
+    unsigned long long elapsed_us = 0;
+    unsigned long long items      = 0;
+    while(!ret.hasErrors()){
+        std::vector<unsigned long long> thread_items(threads, 0);
+        std::vector<std::thread>        workers;
+        std::atomic<bool>               go(false);
+
+        for(unsigned int iThread = 0; iThread < threads; iThread++){
+            workers.push_back(std::thread([&, iThread](){
+                while(!go.load()) std::this_thread::yield();
+                for(unsigned long long iIteration = 0; iIteration < iterations; iIteration++){
+                    thread_items[iThread] += kernels[iThread]->Run();
+                }
+            }));
+        }
+
+        const unsigned long long start_us = GetTimestampMicroseconds();
+        go.store(true);
+        for(unsigned int iThread = 0; iThread < threads; iThread++) workers[iThread].join();
+        elapsed_us = GetTimestampMicroseconds() - start_us;
+
+        items = 0;
+        for(unsigned int iThread = 0; iThread < threads; iThread++) items += thread_items[iThread];
+
+        const unsigned long long minimum_us = (unsigned long long) minimum_time_ms * 1000;
+        if((elapsed_us >= minimum_us) || (iterations >= 1000000000ULL)) break;
+
+        // Aim 40% past the minimum, at least doubling
+        unsigned long long next = iterations * 2;
+        if(elapsed_us > 0){
+            const unsigned long long estimate = (unsigned long long)(iterations * 1.4 * minimum_us / elapsed_us);
+            if(estimate > next) next = estimate;
+        }
+        iterations = next;
+    }
+
+    for(unsigned int iKernel = 0; iKernel < kernels.size(); iKernel++) delete kernels[iKernel];
+    if(ret.hasErrors()) return ret;
+
+    result->kernel           = name;
+    result->columns          = inputs.columns;
+    result->rows             = inputs.rows;
+    result->threads          = threads;
+    result->iterations       = iterations;
+    result->ns_per_iteration = elapsed_us * 1000.0 / iterations;
+    result->items_per_s      = (elapsed_us > 0) ? items * 1000000.0 / elapsed_us : 0;
+    result->scaling          = 0;
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string config_file = "kernel_benchmark_config.txt";
+    std::string filter;
+    for(int iArg = 1; iArg < argc; iArg++){
+        const std::string argument = argv[iArg];
+        if(argument.compare(0, 9, "--filter=") == 0) filter      = argument.substr(9);
+        else                                         config_file = argument;
+    }
+
+    dlp::Parameters settings;
+    if(settings.Load(config_file).hasErrors()){
+        std::cout << "Kernel benchmark configuration " << config_file << " did NOT load, using the defaults" << std::endl;
+    }
+
+    KernelBenchmark::Sizes                   sizes;
+    KernelBenchmark::Threads                 thread_counts;
+    KernelBenchmark::MinimumTime             minimum_time;
+    KernelBenchmark::CalibDataFileCamera     calib_data_file_camera;
+    KernelBenchmark::CalibDataFileProjector  calib_data_file_projector;
+    KernelBenchmark::ConfigFileGeometry      config_file_geometry;
+    KernelBenchmark::OutputDirectory         output_directory;
+    KernelBenchmark::ResultsFile             results_file;
+    settings.Get(&sizes);
+    settings.Get(&thread_counts);
+    settings.Get(&minimum_time);
+    settings.Get(&calib_data_file_camera);
+    settings.Get(&calib_data_file_projector);
+    settings.Get(&config_file_geometry);
+    settings.Get(&output_directory);
+    settings.Get(&results_file);
+
+    std::vector<unsigned int> threads;
+    const std::vector<std::string> thread_list = SplitList(thread_counts.Get());
+    for(unsigned int iThread = 0; iThread < thread_list.size(); iThread++){
+        unsigned int count = (thread_list[iThread] == "max") ? std::thread::hardware_concurrency() :
+                                                               (unsigned int) std::atoi(thread_list[iThread].c_str());
+        if(count == 0) count = 1;
+        if(std::find(threads.begin(),threads.end(),count) == threads.end()) threads.push_back(count);
+    }
+
+    CreateDirectoryA(output_directory.Get().c_str(), NULL);
+
+    // The projector is not connected, it only supplies the pattern resolution
+    dlp::LCr4500 projector;
+    unsigned int projector_columns, projector_rows;
+    projector.GetColumns(&projector_columns);
+    projector.GetRows(&projector_rows);
+
+    std::vector<KernelResult> results;
+    std::cout << std::left << std::setw(44) << "kernel" << std::right << std::setw(16) << "time/iter"
+              << std::setw(14) << "iterations" << std::setw(16) << "items/s" << std::setw(10) << "scaling" << std::endl;
+
+    const std::vector<std::string> size_list = SplitList(sizes.Get());
+    for(unsigned int iSize = 0; iSize < size_list.size(); iSize++){
+        KernelInputs inputs;
+        inputs.columns                   = (unsigned int) std::atoi(size_list[iSize].c_str());
+        inputs.rows                      = (unsigned int) std::atoi(size_list[iSize].substr(size_list[iSize].find('x') + 1).c_str());
+        inputs.projector_columns         = projector_columns;
+        inputs.projector_rows            = projector_rows;
+        inputs.projector                 = &projector;
+        inputs.camera_calib_data_file    = calib_data_file_camera.Get();
+        inputs.projector_calib_data_file = calib_data_file_projector.Get();
+        inputs.geometry_settings_file    = config_file_geometry.Get();
+        inputs.output_directory          = output_directory.Get();
+        if((inputs.columns == 0) || (inputs.rows == 0) || (size_list[iSize].find('x') == std::string::npos)){
+            std::cout << "Size " << size_list[iSize] << " skipped, expected columns x rows" << std::endl;
+            continue;
+        }
+
+        dlp::ReturnCode ret = PrepareInputs(&inputs);
+        if(ret.hasErrors()){
+            std::cout << "Size " << size_list[iSize] << " skipped, inputs NOT prepared: " << ret.ToString() << std::endl;
+            continue;
+        }
+
+        for(unsigned int iKernel = 0; iKernel < KERNEL_COUNT; iKernel++){
+            const std::string kernel = KERNEL_NAMES[iKernel];
+            if(!filter.empty() && (kernel.find(filter) == std::string::npos)) continue;
+
+            double single_thread_items_per_s = 0;
+            for(unsigned int iThread = 0; iThread < threads.size(); iThread++){
+                const std::string name = kernel + "/" + size_list[iSize] + "/threads:" + dlp::Number::ToString(threads[iThread]);
+
+                KernelResult result;
+                ret = RunKernel(kernel, inputs, threads[iThread], minimum_time.Get(), &result);
+                if(ret.hasErrors()){
+                    std::cout << std::left << std::setw(44) << name << " skipped: " << ret.ToString() << std::endl;
+                    break;
+                }
+
+                // Items per second against perfect scaling of the one thread rate
+                if(threads[iThread] == 1) single_thread_items_per_s = result.items_per_s;
+                if(single_thread_items_per_s > 0) result.scaling = result.items_per_s / (single_thread_items_per_s * threads[iThread]);
+                results.push_back(result);
+
+                std::cout << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(3)
+                          << std::setw(13) << result.ns_per_iteration / 1000000.0 << " ms"
+                          << std::setw(14) << result.iterations
+                          << std::setw(16) << std::setprecision(0) << result.items_per_s
+                          << std::setw(10) << std::setprecision(2) << result.scaling << std::endl;
+            }
+        }
+    }
+
+    std::ofstream file(results_file.Get().c_str());
+    file << "kernel,columns,rows,threads,iterations,ns_per_iteration,items_per_s,scaling\n";
+    for(unsigned int iResult = 0; iResult < results.size(); iResult++){
+        const KernelResult &result = results[iResult];
+        file << result.kernel << "," << result.columns << "," << result.rows << "," << result.threads << ","
+             << result.iterations << "," << result.ns_per_iteration << "," << result.items_per_s << ","
+             << result.scaling << "\n";
+    }
+    if(file.fail()) std::cout << "Results NOT saved to " << results_file.Get() << std::endl;
+
+    return results.empty() ? 2 : 0;
+}
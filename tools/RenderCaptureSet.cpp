@@ -0,0 +1,207 @@
+/** @file       RenderCaptureSet.cpp
+ *  @brief      Renders a synthetic capture set with its ground truth
+ *
+ *  Usage: RenderCaptureSet [render config]
+ *
+ *  Generates the vertical then horizontal pattern sequences of the configured
+ *  algorithm, renders the frames the camera would capture of a plane, sphere,
+ *  or OBJ mesh, and saves them as scan_capture_<pattern>.bmp, the layout
+ *  ScanBenchmark replays. The ground truth point cloud and depth map are saved
+ *  next to them. Built as its own executable together with SceneRenderer.cpp.
+ */
+#include <winsock2.h>
+#include <Windows.h>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <dlp_sdk.hpp>
+#include "../SceneRenderer.h"
+
+namespace Render{
+
+DLP_NEW_PARAMETERS_ENTRY(Algorithm,                 "RENDER_ALGORITHM",                     std::string,  "gray_code");
+DLP_NEW_PARAMETERS_ENTRY(AlgorithmVertical,         "RENDER_ALGORITHM_VERTICAL",            std::string,  "config/algorithm_vertical.txt");
+DLP_NEW_PARAMETERS_ENTRY(AlgorithmHorizontal,       "RENDER_ALGORITHM_HORIZONTAL",          std::string,  "config/algorithm_horizontal.txt");
+
+DLP_NEW_PARAMETERS_ENTRY(CalibDataFileCamera,       "CALIBRATION_DATA_FILE_CAMERA",         std::string,  "calibration/data/camera.xml");
+DLP_NEW_PARAMETERS_ENTRY(CalibDataFileProjector,    "CALIBRATION_DATA_FILE_PROJECTOR",      std::string,  "calibration/data/projector.xml");
+
+// plane, sphere, or mesh, placed in the projector frame
+DLP_NEW_PARAMETERS_ENTRY(Surface,                   "RENDER_SURFACE",                       std::string,  "plane");
+DLP_NEW_PARAMETERS_ENTRY(PlaneDistance,             "RENDER_PLANE_DISTANCE",                float,        500);
+DLP_NEW_PARAMETERS_ENTRY(PlaneTiltX,                "RENDER_PLANE_TILT_X",                  float,        0);
+DLP_NEW_PARAMETERS_ENTRY(PlaneTiltY,                "RENDER_PLANE_TILT_Y",                  float,        0);
+DLP_NEW_PARAMETERS_ENTRY(SphereCenterX,             "RENDER_SPHERE_CENTER_X",               float,        0);
+DLP_NEW_PARAMETERS_ENTRY(SphereCenterY,             "RENDER_SPHERE_CENTER_Y",               float,        0);
+DLP_NEW_PARAMETERS_ENTRY(SphereCenterZ,             "RENDER_SPHERE_CENTER_Z",               float,        500);
+DLP_NEW_PARAMETERS_ENTRY(SphereRadius,              "RENDER_SPHERE_RADIUS",                 float,        100);
+DLP_NEW_PARAMETERS_ENTRY(MeshFile,                  "RENDER_MESH_FILE",                     std::string,  "render/object.obj");
+
+DLP_NEW_PARAMETERS_ENTRY(OutputDirectory,           "RENDER_OUTPUT_DIRECTORY",              std::string,  "benchmark/gray_code/");
+
+}
+
+static RenderVector MakeVector(const double &x, const double &y, const double &z){
+    RenderVector vector;
+    vector.x = x;
+    vector.y = y;
+    vector.z = z;
+    return vector;
+}
+
+static dlp::ReturnCode SetupAlgorithm(dlp::DLP_Platform      *projector,
+                                      dlp::StructuredLight   *module,
+                                      const std::string      &settings_file,
+                                      dlp::Pattern::Sequence *patterns){
+    dlp::ReturnCode ret;
+    dlp::Parameters settings;
+
+    ret = settings.Load(settings_file);
+    if(ret.hasErrors()) return ret;
+
+    module->SetDlpPlatform(*projector);
+    ret = module->Setup(settings);
+    if(ret.hasErrors()) return ret;
+
+    return module->GeneratePatternSequence(patterns);
+}
+
+int main(int argc, char *argv[])
+{
+    const std::string config_file = (argc > 1) ? argv[1] : "render_config.txt";
+
+    dlp::Parameters settings;
+    if(settings.Load(config_file).hasErrors()){
+        std::cout << "Render configuration " << config_file << " did NOT load" << std::endl;
+        return 2;
+    }
+
+    Render::Algorithm                algorithm;
+    Render::AlgorithmVertical        algorithm_vertical;
+    Render::AlgorithmHorizontal      algorithm_horizontal;
+    Render::CalibDataFileCamera      calib_data_file_camera;
+    Render::CalibDataFileProjector   calib_data_file_projector;
+    Render::Surface                  surface_type;
+    Render::PlaneDistance            plane_distance;
+    Render::PlaneTiltX               plane_tilt_x;
+    Render::PlaneTiltY               plane_tilt_y;
+    Render::SphereCenterX            sphere_center_x;
+    Render::SphereCenterY            sphere_center_y;
+    Render::SphereCenterZ            sphere_center_z;
+    Render::SphereRadius             sphere_radius;
+    Render::MeshFile                 mesh_file;
+    Render::OutputDirectory          output_directory;
+    settings.Get(&algorithm);
+    settings.Get(&algorithm_vertical);
+    settings.Get(&algorithm_horizontal);
+    settings.Get(&calib_data_file_camera);
+    settings.Get(&calib_data_file_projector);
+    settings.Get(&surface_type);
+    settings.Get(&plane_distance);
+    settings.Get(&plane_tilt_x);
+    settings.Get(&plane_tilt_y);
+    settings.Get(&sphere_center_x);
+    settings.Get(&sphere_center_y);
+    settings.Get(&sphere_center_z);
+    settings.Get(&sphere_radius);
+    settings.Get(&mesh_file);
+    settings.Get(&output_directory);
+
+    dlp::Calibration::Data camera_calibration;
+    dlp::Calibration::Data projector_calibration;
+    if(camera_calibration.Load(calib_data_file_camera.Get()).hasErrors() ||
+       projector_calibration.Load(calib_data_file_projector.Get()).hasErrors()){
+        std::cout << "Calibration data did NOT load" << std::endl;
+        return 2;
+    }
+
+    // The projector is not connected, it only supplies the pattern resolution
+    dlp::LCr4500    projector;
+    dlp::GrayCode   gray_code_vert;
+    dlp::GrayCode   gray_code_horz;
+    dlp::ThreePhase three_phase_vert;
+    dlp::ThreePhase three_phase_horz;
+
+    dlp::StructuredLight *vertical   = &gray_code_vert;
+    dlp::StructuredLight *horizontal = &gray_code_horz;
+    if(algorithm.Get() == "three_phase"){
+        vertical   = &three_phase_vert;
+        horizontal = &three_phase_horz;
+    }
+    else if(algorithm.Get() != "gray_code"){
+        std::cout << "Unknown algorithm " << algorithm.Get() << std::endl;
+        return 2;
+    }
+
+    dlp::Pattern::Sequence vertical_patterns;
+    dlp::Pattern::Sequence horizontal_patterns;
+    dlp::ReturnCode ret = SetupAlgorithm(&projector, vertical, algorithm_vertical.Get(), &vertical_patterns);
+    if(!ret.hasErrors()) ret = SetupAlgorithm(&projector, horizontal, algorithm_horizontal.Get(), &horizontal_patterns);
+    if(ret.hasErrors()){
+        std::cout << "Patterns NOT generated: " << ret.ToString() << std::endl;
+        return 2;
+    }
+
+    PlaneSurface  plane(MakeVector(0, 0, plane_distance.Get()),
+                        MakeVector(std::tan(plane_tilt_y.Get() * 3.14159265358979 / 180.0),
+                                   std::tan(plane_tilt_x.Get() * 3.14159265358979 / 180.0), -1));
+    SphereSurface sphere(MakeVector(sphere_center_x.Get(), sphere_center_y.Get(), sphere_center_z.Get()), sphere_radius.Get());
+    MeshSurface   mesh;
+
+    const RenderSurface *surface = &plane;
+    if(surface_type.Get() == "sphere"){
+        surface = &sphere;
+    }
+    else if(surface_type.Get() == "mesh"){
+        ret = mesh.Load(mesh_file.Get());
+        if(ret.hasErrors()){
+            std::cout << "Mesh " << mesh_file.Get() << " did NOT load: " << ret.ToString() << std::endl;
+            return 2;
+        }
+        std::cout << "Loaded " << mesh.GetTriangleCount() << " triangles" << std::endl;
+        surface = &mesh;
+    }
+    else if(surface_type.Get() != "plane"){
+        std::cout << "Unknown surface " << surface_type.Get() << std::endl;
+        return 2;
+    }
+
+    SceneRenderer renderer;
+    ret = renderer.Setup(settings, camera_calibration, projector_calibration, surface);
+    if(ret.hasErrors()){
+        std::cout << "Renderer NOT set up: " << ret.ToString() << std::endl;
+        return 2;
+    }
+
+    CreateDirectoryA(output_directory.Get().c_str(), NULL);
+
+    // Vertical patterns first, as the scan application saves a scan using both directions
+    std::cout << "Rendering " << vertical_patterns.GetCount() + horizontal_patterns.GetCount() << " frames at "
+              << renderer.GetColumns() << "x" << renderer.GetRows() << "..." << std::endl;
+
+    dlp::Capture::Sequence captures;
+    ret = renderer.RenderPatternSequence(vertical_patterns, &captures);
+    if(!ret.hasErrors()) ret = renderer.RenderPatternSequence(horizontal_patterns, &captures);
+    if(ret.hasErrors()){
+        std::cout << "Frames NOT rendered: " << ret.ToString() << std::endl;
+        return 2;
+    }
+
+    for(unsigned int iCapture = 0; iCapture < captures.GetCount(); iCapture++){
+        dlp::Capture capture;
+        captures.Get(iCapture, &capture);
+        capture.image_data.Save(output_directory.Get() + "scan_capture_" + dlp::Number::ToString(iCapture) + ".bmp");
+    }
+
+    dlp::Image        depth_map;
+    dlp::Point::Cloud point_cloud;
+    dlp::Image        color_map;
+    renderer.GetGroundTruth(&depth_map, &point_cloud);
+    dlp::Geometry::ConvertDistanceMapToColor(depth_map, &color_map);
+    color_map.Save(output_directory.Get() + "ground_truth_color_map.bmp");
+    point_cloud.SaveXYZ(output_directory.Get() + "ground_truth_point_cloud.xyz", ' ');
+
+    std::cout << "Saved " << captures.GetCount() << " frames and " << point_cloud.GetCount()
+              << " ground truth points to " << output_directory.Get() << std::endl;
+    return 0;
+}
@@ -0,0 +1,324 @@
+/** @file       Reprocess.cpp
+ *  @brief      Decodes and triangulates recorded views again, several at once
+ *
+ *  Usage: Reprocess <reprocess config> <archive.dlpa | capture directory...>
+ *
+ *  The views are the captures of every view of a scan archive, or one capture
+ *  directory of scan_capture_<pattern> frames each. A ReplayReader loads the
+ *  views ahead of the decoders while REPROCESS_VIEWS views are decoded,
+ *  triangulated, and saved as view_<view>_point_cloud.ply concurrently, each
+ *  on its own thread with its own modules and geometry. Views scanned with
+ *  STREAMING_DECODE follow the streaming Gray code pattern sequence and need
+ *  REPROCESS_STREAMING_DECODE set with the Gray code algorithm. Built as its
+ *  own executable together with ReplayReader.cpp, ScanArchive.cpp,
+ *  FrameCodec.cpp, FrameAcquisition.cpp, ScanSession.cpp, ResultChannel.cpp,
+ *  StreamingGrayCode.cpp, BitPlane.cpp, ScanMask.cpp, MultiFrequencyPhase.cpp,
+ *  DecodeConfidence.cpp, PointCloudFile.cpp, and PatternTimeline.cpp.
+ */
+#include <winsock2.h>
+#include <Windows.h>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dlp_sdk.hpp>
+#include "../MultiFrequencyPhase.h"
+#include "../PatternTimeline.h"
+#include "../PointCloudFile.h"
+#include "../ReplayReader.h"
+#include "../ScanSession.h"
+#include "../StreamingGrayCode.h"
+
+namespace Reprocess{
+
+// 0 is Gray code, 1 three-phase, and 2 multi-frequency phase as ALGORITHM_TYPE
+DLP_NEW_PARAMETERS_ENTRY(Algorithm,                 "REPROCESS_ALGORITHM",                  unsigned int, 0);
+DLP_NEW_PARAMETERS_ENTRY(SettingsVertical,          "REPROCESS_SETTINGS_VERTICAL",          std::string,  "config/algorithm_vertical.txt");
+DLP_NEW_PARAMETERS_ENTRY(SettingsHorizontal,        "REPROCESS_SETTINGS_HORIZONTAL",        std::string,  "config/algorithm_horizontal.txt");
+
+// Gray code views captured with STREAMING_DECODE, decoded by the streaming module
+DLP_NEW_PARAMETERS_ENTRY(StreamingDecode,           "REPROCESS_STREAMING_DECODE",           bool,         false);
+
+// Directions the views were captured with, vertical patterns first
+DLP_NEW_PARAMETERS_ENTRY(Vertical,                  "REPROCESS_VERTICAL",                   bool,         true);
+DLP_NEW_PARAMETERS_ENTRY(Horizontal,                "REPROCESS_HORIZONTAL",                 bool,         true);
+
+DLP_NEW_PARAMETERS_ENTRY(CalibDataFileCamera,       "CALIBRATION_DATA_FILE_CAMERA",         std::string,  "calibration/data/camera.xml");
+DLP_NEW_PARAMETERS_ENTRY(CalibDataFileProjector,    "CALIBRATION_DATA_FILE_PROJECTOR",      std::string,  "calibration/data/projector.xml");
+DLP_NEW_PARAMETERS_ENTRY(ConfigFileGeometry,        "CONFIG_FILE_GEOMETRY",                 std::string,  "config/geometry.txt");
+
+// Views decoded at once and loaded ahead of them, 0 views uses every core
+DLP_NEW_PARAMETERS_ENTRY(Views,                     "REPROCESS_VIEWS",                      unsigned int, 0);
+DLP_NEW_PARAMETERS_ENTRY(PrefetchViews,             "REPROCESS_PREFETCH_VIEWS",             unsigned int, 2);
+DLP_NEW_PARAMETERS_ENTRY(LoadThreads,               "REPROCESS_LOAD_THREADS",               unsigned int, 1);
+
+DLP_NEW_PARAMETERS_ENTRY(OutputDirectory,           "REPROCESS_OUTPUT_DIRECTORY",           std::string,  "reprocess/");
+
+}
+
+struct ReprocessSettings{
+    std::string         camera_calib_data_file;
+    std::string         projector_calib_data_file;
+    std::string         geometry_settings_file;
+    std::string         output_directory;
+    bool                use_vertical;
+    bool                use_horizontal;
+    unsigned int        projector_columns;
+    unsigned int        projector_rows;
+};
+
+// Modules and geometry of one decoding thread
+struct ReprocessWorker{
+    dlp::StructuredLight   *vertical;
+    dlp::StructuredLight   *horizontal;
+    ScanSession             session;
+    bool                    geometry_prepared;
+    unsigned int            views;
+    unsigned long long      points;
+};
+
+static dlp::StructuredLight* CreateModule(const unsigned int &algorithm, const bool &streaming_decode){
+    switch(algorithm){
+    case 0:  if(streaming_decode) return new StreamingGrayCode();
+             return new dlp::GrayCode();
+    case 1:  return new dlp::ThreePhase();
+    case 2:  return new MultiFrequencyPhase();
+    default: return NULL;
+    }
+}
+
+// Sets up both modules of a worker from their settings files
+static dlp::ReturnCode SetupModules(dlp::DLP_Platform    *projector,
+                                    dlp::StructuredLight *vertical,
+                                    const std::string    &vertical_settings_file,
+                                    dlp::StructuredLight *horizontal,
+                                    const std::string    &horizontal_settings_file){
+    dlp::ReturnCode ret;
+    dlp::Parameters vertical_settings;
+    dlp::Parameters horizontal_settings;
+
+    ret = vertical_settings.Load(vertical_settings_file);
+    if(ret.hasErrors()) return ret;
+    ret = horizontal_settings.Load(horizontal_settings_file);
+    if(ret.hasErrors()) return ret;
+
+    vertical->SetDlpPlatform(*projector);
+    horizontal->SetDlpPlatform(*projector);
+    ret = vertical->Setup(vertical_settings);
+    if(ret.hasErrors()) return ret;
+    return horizontal->Setup(horizontal_settings);
+}
+
+static dlp::ReturnCode ReprocessView(const ReprocessSettings &settings, ReplayView *view, ReprocessWorker *worker){
+    dlp::ReturnCode ret;
+
+    // The camera resolution is the resolution of the recorded frames
+    if(!worker->geometry_prepared){
+        dlp::Capture first_capture;
+        if(settings.use_vertical) view->vertical.Get(0, &first_capture);
+        else                      view->horizontal.Get(0, &first_capture);
+
+        unsigned int camera_columns = 0, camera_rows = 0;
+        first_capture.image_data.GetColumns(&camera_columns);
+        first_capture.image_data.GetRows(&camera_rows);
+        ret = worker->session.PrepareGeometry(camera_columns, camera_rows, settings.projector_columns, settings.projector_rows,
+                                              settings.camera_calib_data_file, settings.projector_calib_data_file,
+                                              settings.geometry_settings_file);
+        if(ret.hasErrors()) return ret;
+        worker->geometry_prepared = true;
+    }
+
+    dlp::DisparityMap column_disparity;
+    dlp::DisparityMap row_disparity;
+    if(settings.use_vertical){
+        ret = worker->vertical->DecodeCaptureSequence(&view->vertical, &column_disparity);
+        if(ret.hasErrors()) return ret;
+    }
+    if(settings.use_horizontal){
+        ret = worker->horizontal->DecodeCaptureSequence(&view->horizontal, &row_disparity);
+        if(ret.hasErrors()) return ret;
+    }
+    view->vertical.Clear();
+    view->horizontal.Clear();
+
+    dlp::Point::Cloud point_cloud;
+    dlp::Image        depth_map;
+    if(settings.use_vertical && settings.use_horizontal){
+        ret = worker->session.GetGeometry().GeneratePointCloud(worker->session.GetCameraViewport(), column_disparity, row_disparity, &point_cloud, &depth_map);
+    }
+    else if(settings.use_vertical){
+        ret = worker->session.GetGeometry().GeneratePointCloud(worker->session.GetCameraViewport(), column_disparity, &point_cloud, &depth_map);
+    }
+    else{
+        ret = worker->session.GetGeometry().GeneratePointCloud(worker->session.GetCameraViewport(), row_disparity, &point_cloud, &depth_map);
+    }
+    if(ret.hasErrors()) return ret;
+
+    ret = SavePLY(settings.output_directory + "view_" + dlp::Number::ToString(view->view) + "_point_cloud.ply", point_cloud, true);
+    if(ret.hasErrors()) return ret;
+
+    worker->views++;
+    worker->points += point_cloud.GetCount();
+    return ret;
+}
+
+static void RunWorker(const ReprocessSettings &settings, ReplayReader *reader, ReprocessWorker *worker,
+                      std::mutex *print_mutex, unsigned int *failed){
+    ReplayView view;
+    while(reader->Next(&view)){
+        dlp::ReturnCode ret = view.ret;
+        if(!ret.hasErrors()) ret = ReprocessView(settings, &view, worker);
+        if(ret.hasErrors()){
+            std::lock_guard<std::mutex> lock(*print_mutex);
+            std::cout << "View " << view.view << " NOT reprocessed: " << ret.ToString() << std::endl;
+            (*failed)++;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 3){
+        std::cout << "Usage: Reprocess <reprocess config> <archive.dlpa | capture directory...>" << std::endl;
+        return 2;
+    }
+
+    dlp::Parameters config;
+    if(config.Load(argv[1]).hasErrors()){
+        std::cout << "Reprocess configuration " << argv[1] << " did NOT load" << std::endl;
+        return 2;
+    }
+
+    Reprocess::Algorithm                algorithm;
+    Reprocess::SettingsVertical         settings_vertical;
+    Reprocess::SettingsHorizontal       settings_horizontal;
+    Reprocess::StreamingDecode          streaming_decode;
+    Reprocess::Vertical                 vertical;
+    Reprocess::Horizontal               horizontal;
+    Reprocess::CalibDataFileCamera      calib_data_file_camera;
+    Reprocess::CalibDataFileProjector   calib_data_file_projector;
+    Reprocess::ConfigFileGeometry       config_file_geometry;
+    Reprocess::Views                    views;
+    Reprocess::PrefetchViews            prefetch_views;
+    Reprocess::LoadThreads              load_threads;
+    Reprocess::OutputDirectory          output_directory;
+    config.Get(&algorithm);
+    config.Get(&settings_vertical);
+    config.Get(&settings_horizontal);
+    config.Get(&streaming_decode);
+    config.Get(&vertical);
+    config.Get(&horizontal);
+    config.Get(&calib_data_file_camera);
+    config.Get(&calib_data_file_projector);
+    config.Get(&config_file_geometry);
+    config.Get(&views);
+    config.Get(&prefetch_views);
+    config.Get(&load_threads);
+    config.Get(&output_directory);
+
+    if(!vertical.Get() && !horizontal.Get()){
+        std::cout << "Neither direction selected" << std::endl;
+        return 2;
+    }
+    if(algorithm.Get() > 2){
+        std::cout << "Algorithm " << algorithm.Get() << " is NOT supported" << std::endl;
+        return 2;
+    }
+    if(streaming_decode.Get() && (algorithm.Get() != 0)){
+        std::cout << "Streaming decode is only supported with the Gray code algorithm" << std::endl;
+        return 2;
+    }
+
+    // A single .dlpa argument is an archive, anything else capture directories
+    ReplayReader    reader;
+    dlp::ReturnCode ret;
+    const std::string source = argv[2];
+    if((argc == 3) && (source.size() > 5) && (source.compare(source.size() - 5, 5, ".dlpa") == 0)){
+        ret = reader.OpenArchive(source);
+    }
+    else{
+        std::vector<std::string> directories;
+        for(int iArg = 2; iArg < argc; iArg++) directories.push_back(argv[iArg]);
+        ret = reader.OpenDirectories(directories);
+    }
+    if(ret.hasErrors()){
+        std::cout << "Views NOT opened: " << ret.ToString() << std::endl;
+        return 2;
+    }
+
+    // The projector is not connected, it only supplies the pattern resolution
+    dlp::LCr4500 projector;
+    ReprocessSettings settings;
+    settings.camera_calib_data_file    = calib_data_file_camera.Get();
+    settings.projector_calib_data_file = calib_data_file_projector.Get();
+    settings.geometry_settings_file    = config_file_geometry.Get();
+    settings.output_directory          = output_directory.Get();
+    settings.use_vertical              = vertical.Get();
+    settings.use_horizontal            = horizontal.Get();
+    projector.GetColumns(&settings.projector_columns);
+    projector.GetRows(&settings.projector_rows);
+    CreateDirectoryA(settings.output_directory.c_str(), NULL);
+
+    unsigned int worker_count = (views.Get() > 0) ? views.Get() : std::thread::hardware_concurrency();
+    if(worker_count == 0)                    worker_count = 1;
+    if(worker_count > reader.GetViewCount()) worker_count = reader.GetViewCount();
+
+    // Modules are set up here, the workers only decode
+    std::vector<ReprocessWorker*> workers;
+    for(unsigned int iWorker = 0; iWorker < worker_count; iWorker++){
+        ReprocessWorker *worker = new ReprocessWorker();
+        worker->vertical          = CreateModule(algorithm.Get(), streaming_decode.Get());
+        worker->horizontal        = CreateModule(algorithm.Get(), streaming_decode.Get());
+        worker->geometry_prepared = false;
+        worker->views             = 0;
+        worker->points            = 0;
+        workers.push_back(worker);
+
+        ret = SetupModules(&projector, worker->vertical, settings_vertical.Get(), worker->horizontal, settings_horizontal.Get());
+        if(ret.hasErrors()){
+            std::cout << "Modules NOT set up: " << ret.ToString() << std::endl;
+            break;
+        }
+    }
+
+    unsigned int failed = 0;
+    if(!ret.hasErrors()){
+        const unsigned int vertical_count   = workers[0]->vertical->GetTotalPatternCount();
+        const unsigned int horizontal_count = workers[0]->horizontal->GetTotalPatternCount();
+        reader.SetPatternCounts(settings.use_vertical ? vertical_count : 0, settings.use_horizontal ? horizontal_count : 0);
+
+        std::cout << "Reprocessing " << reader.GetViewCount() << " views, " << worker_count << " at once..." << std::endl;
+        const unsigned long long start_us = GetTimestampMicroseconds();
+
+        std::mutex print_mutex;
+        std::vector<std::thread> threads;
+        // Every worker has a view waiting besides the ones prefetched
+        reader.Start(prefetch_views.Get() + worker_count, load_threads.Get());
+        for(unsigned int iWorker = 0; iWorker < worker_count; iWorker++){
+            threads.push_back(std::thread(RunWorker, std::cref(settings), &reader, workers[iWorker], &print_mutex, &failed));
+        }
+        for(unsigned int iWorker = 0; iWorker < threads.size(); iWorker++) threads[iWorker].join();
+        reader.Stop();
+
+        const double elapsed_s = (GetTimestampMicroseconds() - start_us) / 1000000.0;
+        unsigned int       views_done = 0;
+        unsigned long long points     = 0;
+        for(unsigned int iWorker = 0; iWorker < workers.size(); iWorker++){
+            views_done += workers[iWorker]->views;
+            points     += workers[iWorker]->points;
+        }
+        std::cout << "Reprocessed " << views_done << " views with " << points << " points in " << elapsed_s << "s";
+        if(elapsed_s > 0) std::cout << ", " << views_done / elapsed_s << " views/s";
+        std::cout << std::endl;
+    }
+
+    for(unsigned int iWorker = 0; iWorker < workers.size(); iWorker++){
+        delete workers[iWorker]->vertical;
+        delete workers[iWorker]->horizontal;
+        delete workers[iWorker];
+    }
+
+    if(ret.hasErrors()) return 2;
+    return (failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+/** @file       ResultChannelConsumer.cpp
+ *  @brief      Reference consumer of the shared memory scan result channel
+ *
+ *  Usage: ResultChannelConsumer [channel name] [result count]
+ *
+ *  Maps the channel the scan application publishes to (SCAN_RESULT_CHANNEL)
+ *  and prints a summary of every new result as it arrives, reading the point
+ *  cloud and depth map in place. Built as its own executable together with
+ *  ResultChannel.cpp.
+ */
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "../ResultChannel.h"
+
+int main(int argc, char *argv[])
+{
+    const std::string        name  = (argc > 1) ? argv[1] : RESULT_CHANNEL_DEFAULT_NAME;
+    const unsigned long long count = (argc > 2) ? std::strtoull(argv[2],NULL,10) : 0;
+
+    ResultChannel channel;
+    dlp::ReturnCode ret = channel.Open(name);
+    while(ret.hasErrors()){
+        std::cout << "Waiting for result channel " << name << "..." << std::endl;
+        dlp::Time::Sleep::Milliseconds(1000);
+        ret = channel.Open(name);
+    }
+
+    std::cout << "Mapped " << name << ", " << channel.GetSegmentCount() << " segments of "
+              << channel.GetColumns() << "x" << channel.GetRows() << std::endl;
+
+    // Only results published after the consumer started are read
+    unsigned long long next     = channel.GetPublishedCount() + 1;
+    unsigned long long received = 0;
+
+    while((count == 0) || (received < count)){
+        const unsigned long long published = channel.GetPublishedCount();
+        if(published < next){
+            dlp::Time::Sleep::Milliseconds(10);
+            continue;
+        }
+
+        // Skip ahead when the producer lapped the ring
+        if(published - next >= channel.GetSegmentCount()){
+            std::cout << "Missed " << (published - channel.GetSegmentCount() + 1 - next) << " results" << std::endl;
+            next = published - channel.GetSegmentCount() + 1;
+        }
+
+        ResultView result;
+        if(!channel.GetResult(next,&result)){
+            next++;
+            continue;
+        }
+
+        double x_sum = 0, y_sum = 0, z_sum = 0;
+        for(unsigned int iPoint = 0; iPoint < result.point_count; iPoint++){
+            x_sum += result.x[iPoint];
+            y_sum += result.y[iPoint];
+            z_sum += result.z[iPoint];
+        }
+
+        float depth_min = 0, depth_max = 0;
+        bool  depth_found = false;
+        const unsigned long long pixels = (unsigned long long) result.columns * result.rows;
+        for(unsigned long long iPixel = 0; iPixel < pixels; iPixel++){
+            const float depth = result.depth[iPixel];
+            if(depth <= 0) continue;
+            if(!depth_found || (depth < depth_min)) depth_min = depth;
+            if(!depth_found || (depth > depth_max)) depth_max = depth;
+            depth_found = true;
+        }
+
+        // The segment may have been rewritten while it was read
+        if(!channel.isValid(result)){
+            std::cout << "Result " << next << " overwritten while reading" << std::endl;
+            next++;
+            continue;
+        }
+
+        std::cout << "Result " << result.result << " view " << result.view
+                  << ": " << result.point_count << " points";
+        if(result.point_count > 0){
+            std::cout << ", centroid (" << x_sum / result.point_count << ", "
+                      << y_sum / result.point_count << ", "
+                      << z_sum / result.point_count << ")";
+        }
+        std::cout << ", depth " << depth_min << " to " << depth_max << std::endl;
+
+        next++;
+        received++;
+    }
+
+    return 0;
+}
@@ -0,0 +1,468 @@
+/** @file       ScanBenchmark.cpp
+ *  @brief      Replays recorded capture sets through the scan reconstruction path
+ *
+ *  Usage: ScanBenchmark [benchmark config] [--save-baseline]
+ *
+ *  Each capture set is a directory of scan_capture_<pattern> frames, BMP or
+ *  DLPF, as the scan application saves them for a scan using both directions,
+ *  vertical patterns first. Gray code and three-phase sets are decoded
+ *  vertical only, horizontal only, and both, then fused when the modules rate
+ *  their decode, triangulated, and saved the way ScanObject does. Per stage
+ *  the benchmark reports throughput, p50 and p99 latency, the most the stage
+ *  grew the working set, and the process peak RSS reached by its end, and
+ *  compares the p50 against a stored baseline. The process peak only rises,
+ *  so it is the largest stage so far, not this one. Built as its own
+ *  executable together with ScanSession.cpp, ResultChannel.cpp,
+ *  AutoExposure.cpp, DecodeConfidence.cpp, FrameAcquisition.cpp,
+ *  PatternTimeline.cpp, and FrameCodec.cpp; the exit code is 1 on a regression.
+ */
+#include <winsock2.h>
+#include <Windows.h>
+#include <psapi.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dlp_sdk.hpp>
+#include "../AutoExposure.h"
+#include "../DecodeConfidence.h"
+#include "../FrameCodec.h"
+#include "../PatternTimeline.h"
+#include "../ScanSession.h"
+
+namespace Benchmark{
+
+DLP_NEW_PARAMETERS_ENTRY(GrayCodeCaptures,          "BENCHMARK_GRAY_CODE_CAPTURES",         std::string,  "benchmark/gray_code/");
+DLP_NEW_PARAMETERS_ENTRY(GrayCodeVertical,          "BENCHMARK_GRAY_CODE_VERTICAL",         std::string,  "config/algorithm_vertical.txt");
+DLP_NEW_PARAMETERS_ENTRY(GrayCodeHorizontal,        "BENCHMARK_GRAY_CODE_HORIZONTAL",       std::string,  "config/algorithm_horizontal.txt");
+DLP_NEW_PARAMETERS_ENTRY(ThreePhaseCaptures,        "BENCHMARK_THREE_PHASE_CAPTURES",       std::string,  "benchmark/three_phase/");
+DLP_NEW_PARAMETERS_ENTRY(ThreePhaseVertical,        "BENCHMARK_THREE_PHASE_VERTICAL",       std::string,  "config/algorithm_three_phase_vertical.txt");
+DLP_NEW_PARAMETERS_ENTRY(ThreePhaseHorizontal,      "BENCHMARK_THREE_PHASE_HORIZONTAL",     std::string,  "config/algorithm_three_phase_horizontal.txt");
+
+DLP_NEW_PARAMETERS_ENTRY(CalibDataFileCamera,       "CALIBRATION_DATA_FILE_CAMERA",         std::string,  "calibration/data/camera.xml");
+DLP_NEW_PARAMETERS_ENTRY(CalibDataFileProjector,    "CALIBRATION_DATA_FILE_PROJECTOR",      std::string,  "calibration/data/projector.xml");
+DLP_NEW_PARAMETERS_ENTRY(ConfigFileGeometry,        "CONFIG_FILE_GEOMETRY",                 std::string,  "config/geometry.txt");
+
+DLP_NEW_PARAMETERS_ENTRY(Iterations,                "BENCHMARK_ITERATIONS",                 unsigned int, 10);
+DLP_NEW_PARAMETERS_ENTRY(OutputDirectory,           "BENCHMARK_OUTPUT_DIRECTORY",           std::string,  "benchmark/output/");
+DLP_NEW_PARAMETERS_ENTRY(BaselineFile,              "BENCHMARK_BASELINE",                   std::string,  "benchmark/baseline.csv");
+DLP_NEW_PARAMETERS_ENTRY(RegressionPercent,         "BENCHMARK_REGRESSION_PERCENT",         float,        10);
+
+}
+
+// Latencies of one stage of one case
+struct StageSamples{
+    std::vector<double> latency_ms;
+    unsigned long long  items;
+    unsigned long long  working_set_growth;
+    unsigned long long  process_peak_rss;
+};
+
+struct StageResult{
+    std::string         name;
+    double              items_per_s;
+    double              p50_ms;
+    double              p99_ms;
+    unsigned long long  working_set_growth;
+    unsigned long long  process_peak_rss;
+};
+
+static unsigned long long GetWorkingSet(){
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(),&counters,sizeof(counters))) return 0;
+    return counters.WorkingSetSize;
+}
+
+static unsigned long long GetProcessPeakRss(){
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(),&counters,sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize;
+}
+
+static double GetPercentile(std::vector<double> values, const double &percentile){
+    if(values.empty()) return 0;
+    std::sort(values.begin(),values.end());
+    const unsigned int index = (unsigned int)(percentile / 100.0 * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+// Times one stage and records its items, how much it grew the working set,
+// and the process peak RSS after it
+class StageTimer{
+public:
+    StageTimer(StageSamples *samples){
+        this->samples_           = samples;
+        this->start_working_set_ = GetWorkingSet();
+        this->start_us_          = GetTimestampMicroseconds();
+    }
+    void Stop(const unsigned long long &items){
+        this->samples_->latency_ms.push_back((GetTimestampMicroseconds() - this->start_us_) / 1000.0);
+        this->samples_->items += items;
+
+        const unsigned long long working_set = GetWorkingSet();
+        if((working_set > this->start_working_set_) &&
+           (working_set - this->start_working_set_ > this->samples_->working_set_growth)){
+            this->samples_->working_set_growth = working_set - this->start_working_set_;
+        }
+        this->samples_->process_peak_rss = GetProcessPeakRss();
+    }
+private:
+    StageSamples       *samples_;
+    unsigned long long  start_working_set_;
+    unsigned long long  start_us_;
+};
+
+static dlp::ReturnCode LoadCaptures(const std::string      &directory,
+                                    const unsigned int     &first,
+                                    const unsigned int     &count,
+                                    dlp::Capture::Sequence *sequence){
+    dlp::ReturnCode ret;
+
+    sequence->Clear();
+    for(unsigned int iPattern = first; iPattern < first + count; iPattern++){
+        dlp::Capture capture;
+        capture.data_type = dlp::Capture::DataType::IMAGE_DATA;
+        ret = LoadImageFile(directory + "scan_capture_" + dlp::Number::ToString(iPattern), &capture.image_data);
+        if(ret.hasErrors()) return ret;
+        capture.image_data.ConvertToMonochrome();
+        sequence->Add(capture);
+    }
+    return ret;
+}
+
+static unsigned long long GetPixelCount(const dlp::DisparityMap &disparity){
+    unsigned int columns = 0, rows = 0;
+    disparity.GetColumns(&columns);
+    disparity.GetRows(&rows);
+    return (unsigned long long) columns * rows;
+}
+
+// Runs one algorithm and direction combination and appends its stage results
+static dlp::ReturnCode RunCase(const std::string      &case_name,
+                               const std::string      &captures,
+                               dlp::StructuredLight   *vertical,
+                               dlp::StructuredLight   *horizontal,
+                               const bool             &use_vertical,
+                               const bool             &use_horizontal,
+                               ScanSession            *session,
+                               const unsigned int     &iterations,
+                               const std::string      &output_directory,
+                               std::vector<StageResult> *results){
+    dlp::ReturnCode ret;
+
+    const unsigned int vertical_count   = vertical->GetTotalPatternCount();
+    const unsigned int horizontal_count = horizontal->GetTotalPatternCount();
+
+    std::map<std::string,StageSamples> samples;
+    const char* const stage_names[] = { "load", "decode_vertical", "decode_horizontal", "fuse", "triangulate", "save" };
+    for(unsigned int iStage = 0; iStage < 6; iStage++){
+        samples[stage_names[iStage]].items              = 0;
+        samples[stage_names[iStage]].working_set_growth = 0;
+        samples[stage_names[iStage]].process_peak_rss   = 0;
+    }
+
+    for(unsigned int iIteration = 0; iIteration < iterations; iIteration++){
+        dlp::Capture::Sequence vertical_scan;
+        dlp::Capture::Sequence horizontal_scan;
+
+        StageTimer load(&samples["load"]);
+        if(use_vertical)   ret = LoadCaptures(captures, 0, vertical_count, &vertical_scan);
+        if(!ret.hasErrors() && use_horizontal) ret = LoadCaptures(captures, vertical_count, horizontal_count, &horizontal_scan);
+        if(ret.hasErrors()) return ret;
+        load.Stop(vertical_scan.GetCount() + horizontal_scan.GetCount());
+
+        dlp::DisparityMap column_disparity;
+        dlp::DisparityMap row_disparity;
+        if(use_vertical){
+            StageTimer decode(&samples["decode_vertical"]);
+            ret = vertical->DecodeCaptureSequence(&vertical_scan, &column_disparity);
+            if(ret.hasErrors()) return ret;
+            decode.Stop(vertical_scan.GetCount());
+        }
+        if(use_horizontal){
+            StageTimer decode(&samples["decode_horizontal"]);
+            ret = horizontal->DecodeCaptureSequence(&horizontal_scan, &row_disparity);
+            if(ret.hasErrors()) return ret;
+            decode.Stop(horizontal_scan.GetCount());
+        }
+        vertical_scan.Clear();
+        horizontal_scan.Clear();
+
+        // Fused as a dual exposure scan would be, with the recorded set as both
+        // exposures. The first exposure only seeds the fused maps, so the stage
+        // times the second. Modules without decode confidence scan one exposure.
+        DecodeConfidence *rated_vertical   = dynamic_cast<DecodeConfidence*>(vertical);
+        DecodeConfidence *rated_horizontal = dynamic_cast<DecodeConfidence*>(horizontal);
+        dlp::DisparityMap fused_column_disparity = column_disparity;
+        dlp::DisparityMap fused_row_disparity    = row_disparity;
+        if((!use_vertical || rated_vertical) && (!use_horizontal || rated_horizontal)){
+            dlp::Image confidence;
+            dlp::Image combined_confidence;
+            if(use_vertical)   ret = rated_vertical->GetConfidenceMap(&confidence);
+            if(!ret.hasErrors() && use_vertical)   ret = CombineConfidence(&confidence, &combined_confidence);
+            if(!ret.hasErrors() && use_horizontal) ret = rated_horizontal->GetConfidenceMap(&confidence);
+            if(!ret.hasErrors() && use_horizontal) ret = CombineConfidence(&confidence, &combined_confidence);
+            if(ret.hasErrors()) return ret;
+
+            dlp::Image fused_confidence;
+            fused_column_disparity.Clear();
+            fused_row_disparity.Clear();
+            ret = FuseExposureDecodes(&column_disparity, &row_disparity, &combined_confidence, &fused_column_disparity, &fused_row_disparity, &fused_confidence);
+            if(ret.hasErrors()) return ret;
+
+            StageTimer fuse(&samples["fuse"]);
+            ret = FuseExposureDecodes(&column_disparity, &row_disparity, &combined_confidence, &fused_column_disparity, &fused_row_disparity, &fused_confidence);
+            if(ret.hasErrors()) return ret;
+            fuse.Stop(GetPixelCount(fused_column_disparity) + GetPixelCount(fused_row_disparity));
+        }
+
+        dlp::Point::Cloud point_cloud;
+        dlp::Image        depth_map;
+        StageTimer triangulate(&samples["triangulate"]);
+        if(use_vertical && use_horizontal){
+            session->GetGeometry().GeneratePointCloud(session->GetCameraViewport(), fused_column_disparity, fused_row_disparity, &point_cloud, &depth_map);
+        }
+        else if(use_vertical){
+            session->GetGeometry().GeneratePointCloud(session->GetCameraViewport(), fused_column_disparity, &point_cloud, &depth_map);
+        }
+        else{
+            session->GetGeometry().GeneratePointCloud(session->GetCameraViewport(), fused_row_disparity, &point_cloud, &depth_map);
+        }
+        triangulate.Stop(point_cloud.GetCount());
+
+        dlp::Image color_map;
+        StageTimer save(&samples["save"]);
+        dlp::Geometry::ConvertDistanceMapToColor(depth_map, &color_map);
+        color_map.Save(output_directory + case_name + "_color_map.bmp");
+        point_cloud.SaveXYZ(output_directory + case_name + "_point_cloud.xyz", ' ');
+        save.Stop(point_cloud.GetCount());
+    }
+
+    for(unsigned int iStage = 0; iStage < 6; iStage++){
+        const StageSamples &stage = samples[stage_names[iStage]];
+        if(stage.latency_ms.empty()) continue;
+
+        double total_ms = 0;
+        for(unsigned int iSample = 0; iSample < stage.latency_ms.size(); iSample++) total_ms += stage.latency_ms[iSample];
+
+        StageResult result;
+        result.name               = case_name + "/" + stage_names[iStage];
+        result.items_per_s        = (total_ms > 0) ? stage.items * 1000.0 / total_ms : 0;
+        result.p50_ms             = GetPercentile(stage.latency_ms, 50);
+        result.p99_ms             = GetPercentile(stage.latency_ms, 99);
+        result.working_set_growth = stage.working_set_growth;
+        result.process_peak_rss   = stage.process_peak_rss;
+        results->push_back(result);
+    }
+
+    return ret;
+}
+
+// Sets up both modules of an algorithm from their settings files
+static dlp::ReturnCode SetupModules(dlp::DLP_Platform    *projector,
+                                    dlp::StructuredLight *vertical,
+                                    const std::string    &vertical_settings_file,
+                                    dlp::StructuredLight *horizontal,
+                                    const std::string    &horizontal_settings_file){
+    dlp::ReturnCode ret;
+    dlp::Parameters vertical_settings;
+    dlp::Parameters horizontal_settings;
+
+    ret = vertical_settings.Load(vertical_settings_file);
+    if(ret.hasErrors()) return ret;
+    ret = horizontal_settings.Load(horizontal_settings_file);
+    if(ret.hasErrors()) return ret;
+
+    vertical->SetDlpPlatform(*projector);
+    horizontal->SetDlpPlatform(*projector);
+
+    ret = vertical->Setup(vertical_settings);
+    if(ret.hasErrors()) return ret;
+    return horizontal->Setup(horizontal_settings);
+}
+
+static std::map<std::string,double> LoadBaseline(const std::string &filename){
+    std::map<std::string,double> baseline;
+    std::ifstream file(filename.c_str());
+    std::string line;
+
+    std::getline(file,line);    // Header
+    while(std::getline(file,line)){
+        std::istringstream fields(line);
+        std::string name, items_per_s, p50_ms;
+        std::getline(fields,name,',');
+        std::getline(fields,items_per_s,',');
+        std::getline(fields,p50_ms,',');
+        if(!name.empty()) baseline[name] = std::atof(p50_ms.c_str());
+    }
+    return baseline;
+}
+
+static bool SaveBaseline(const std::string &filename, const std::vector<StageResult> &results){
+    std::ofstream file(filename.c_str());
+    if(!file.is_open()) return false;
+
+    file << "stage,items_per_s,p50_ms,p99_ms,working_set_growth_bytes,process_peak_rss_bytes\n";
+    for(unsigned int iResult = 0; iResult < results.size(); iResult++){
+        const StageResult &result = results[iResult];
+        file << result.name << "," << result.items_per_s << "," << result.p50_ms << ","
+             << result.p99_ms << "," << result.working_set_growth << "," << result.process_peak_rss << "\n";
+    }
+    return !file.fail();
+}
+
+int main(int argc, char *argv[])
+{
+    std::string config_file   = "benchmark_config.txt";
+    bool        save_baseline = false;
+    for(int iArg = 1; iArg < argc; iArg++){
+        const std::string argument = argv[iArg];
+        if(argument == "--save-baseline") save_baseline = true;
+        else                              config_file   = argument;
+    }
+
+    dlp::Parameters settings;
+    if(settings.Load(config_file).hasErrors()){
+        std::cout << "Benchmark configuration " << config_file << " did NOT load" << std::endl;
+        return 2;
+    }
+
+    Benchmark::GrayCodeCaptures         gray_code_captures;
+    Benchmark::GrayCodeVertical         gray_code_vertical;
+    Benchmark::GrayCodeHorizontal       gray_code_horizontal;
+    Benchmark::ThreePhaseCaptures       three_phase_captures;
+    Benchmark::ThreePhaseVertical       three_phase_vertical;
+    Benchmark::ThreePhaseHorizontal     three_phase_horizontal;
+    Benchmark::CalibDataFileCamera      calib_data_file_camera;
+    Benchmark::CalibDataFileProjector   calib_data_file_projector;
+    Benchmark::ConfigFileGeometry       config_file_geometry;
+    Benchmark::Iterations               iterations;
+    Benchmark::OutputDirectory          output_directory;
+    Benchmark::BaselineFile             baseline_file;
+    Benchmark::RegressionPercent        regression_percent;
+    settings.Get(&gray_code_captures);
+    settings.Get(&gray_code_vertical);
+    settings.Get(&gray_code_horizontal);
+    settings.Get(&three_phase_captures);
+    settings.Get(&three_phase_vertical);
+    settings.Get(&three_phase_horizontal);
+    settings.Get(&calib_data_file_camera);
+    settings.Get(&calib_data_file_projector);
+    settings.Get(&config_file_geometry);
+    settings.Get(&iterations);
+    settings.Get(&output_directory);
+    settings.Get(&baseline_file);
+    settings.Get(&regression_percent);
+
+    CreateDirectoryA(output_directory.Get().c_str(), NULL);
+
+    // The projector is not connected, it only supplies the pattern resolution
+    dlp::LCr4500    projector;
+    dlp::GrayCode   gray_code_vert;
+    dlp::GrayCode   gray_code_horz;
+    dlp::ThreePhase three_phase_vert;
+    dlp::ThreePhase three_phase_horz;
+
+    struct Algorithm{
+        std::string           name;
+        std::string           captures;
+        dlp::StructuredLight *vertical;
+        std::string           vertical_settings;
+        dlp::StructuredLight *horizontal;
+        std::string           horizontal_settings;
+    };
+    const Algorithm algorithms[] = {
+        { "gray_code",   gray_code_captures.Get(),   &gray_code_vert,   gray_code_vertical.Get(),   &gray_code_horz,   gray_code_horizontal.Get()   },
+        { "three_phase", three_phase_captures.Get(), &three_phase_vert, three_phase_vertical.Get(), &three_phase_horz, three_phase_horizontal.Get() }
+    };
+
+    std::vector<StageResult> results;
+    ScanSession session;
+
+    for(unsigned int iAlgorithm = 0; iAlgorithm < 2; iAlgorithm++){
+        const Algorithm &algorithm = algorithms[iAlgorithm];
+
+        dlp::ReturnCode ret = SetupModules(&projector, algorithm.vertical, algorithm.vertical_settings, algorithm.horizontal, algorithm.horizontal_settings);
+        if(ret.hasErrors()){
+            std::cout << algorithm.name << " skipped, modules NOT set up: " << ret.ToString() << std::endl;
+            continue;
+        }
+
+        // The camera resolution is the resolution of the recorded frames
+        dlp::Image first_frame;
+        if(LoadImageFile(algorithm.captures + "scan_capture_0", &first_frame).hasErrors()){
+            std::cout << algorithm.name << " skipped, no capture set in " << algorithm.captures << std::endl;
+            continue;
+        }
+        unsigned int camera_columns, camera_rows, projector_columns, projector_rows;
+        first_frame.GetColumns(&camera_columns);
+        first_frame.GetRows(&camera_rows);
+        projector.GetColumns(&projector_columns);
+        projector.GetRows(&projector_rows);
+
+        ret = session.PrepareGeometry(camera_columns, camera_rows, projector_columns, projector_rows,
+                                      calib_data_file_camera.Get(), calib_data_file_projector.Get(), config_file_geometry.Get());
+        if(ret.hasErrors()){
+            std::cout << "Geometry NOT constructed: " << ret.ToString() << std::endl;
+            return 2;
+        }
+
+        const char* const directions[] = { "vertical", "horizontal", "both" };
+        for(unsigned int iDirection = 0; iDirection < 3; iDirection++){
+            const std::string case_name = algorithm.name + "_" + directions[iDirection];
+            std::cout << "Running " << case_name << "..." << std::endl;
+
+            ret = RunCase(case_name, algorithm.captures, algorithm.vertical, algorithm.horizontal,
+                          iDirection != 1, iDirection != 0, &session, iterations.Get(), output_directory.Get(), &results);
+            if(ret.hasErrors()) std::cout << case_name << " failed: " << ret.ToString() << std::endl;
+        }
+    }
+
+    if(results.empty()){
+        std::cout << "No capture sets replayed" << std::endl;
+        return 2;
+    }
+
+    // Report and compare against the baseline
+    const std::map<std::string,double> baseline = LoadBaseline(baseline_file.Get());
+    unsigned int regressions = 0;
+
+    std::cout << std::endl << std::left << std::setw(36) << "stage"
+              << std::right << std::setw(14) << "items/s" << std::setw(12) << "p50 ms"
+              << std::setw(12) << "p99 ms" << std::setw(12) << "grew MB" << std::setw(16) << "proc peak MB"
+              << std::setw(12) << "vs base" << std::endl;
+    for(unsigned int iResult = 0; iResult < results.size(); iResult++){
+        const StageResult &result = results[iResult];
+        std::cout << std::left << std::setw(36) << result.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(14) << result.items_per_s << std::setw(12) << result.p50_ms
+                  << std::setw(12) << result.p99_ms << std::setw(12) << result.working_set_growth / 1048576.0
+                  << std::setw(16) << result.process_peak_rss / 1048576.0;
+
+        std::map<std::string,double>::const_iterator base = baseline.find(result.name);
+        if((base != baseline.end()) && (base->second > 0)){
+            const double change = 100.0 * (result.p50_ms - base->second) / base->second;
+            std::cout << std::setw(11) << std::showpos << change << std::noshowpos << "%";
+            if(change > regression_percent.Get()){
+                std::cout << "  REGRESSION";
+                regressions++;
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    if(save_baseline){
+        if(SaveBaseline(baseline_file.Get(), results)) std::cout << "Baseline saved to " << baseline_file.Get() << std::endl;
+        else                                           std::cout << "Baseline NOT saved" << std::endl;
+    }
+
+    if(regressions > 0){
+        std::cout << regressions << " stages slower than the baseline by more than " << regression_percent.Get() << "%" << std::endl;
+        return 1;
+    }
+    return 0;
+}